@@ -0,0 +1,102 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+/**
+ * Microbenchmark of the fixed-schema request decoder and response encoder of client/message_codec.hpp against the
+ * nlohmann path they replace, and of the compact response format. It is not part of the client's build, compile it from the client's directory with:
+ *   g++ -std=c++11 -O2 -Iinclude -Ilibraries bench/message_codec_bench.cpp src/client/message_codec.cpp
+ * Usage: message_codec_bench [iterations]
+ */
+
+#include "client/message_codec.hpp"
+#include "constants/response_packet.hpp"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+template<typename F>
+double nanosecondsPerCall(unsigned long int iterations, F f) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned long int i = 0; i < iterations; i++) {
+		f();
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+std::string randomHex(unsigned long int bytes) {
+	static const char HEX_DIGITS[] = "0123456789ABCDEF";
+	std::string hex;
+	for (unsigned long int i = 0; i < bytes; i++) {
+		hex.push_back(HEX_DIGITS[std::rand() & 0x0F]);
+		hex.push_back(HEX_DIGITS[std::rand() & 0x0F]);
+	}
+	return hex;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	using namespace client;
+	unsigned long int iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+	volatile unsigned long int sink = 0; // keeps the conversions from being optimized out
+
+	std::printf("%-8s %14s %14s %14s %14s %14s %10s %14s\n", "bytes", "decode json", "decode", "encode json", "encode", "encode compact", "identical", "compact bytes");
+	const unsigned long int sizes[] = { 5, 16, 261, 1024, 65536 };
+	for (unsigned long int size : sizes) {
+		nlohmann::json jrequest = { { "id", 123456 }, { "request", 4 }, { "data", randomHex(size) }, { "timeout", 30000 } };
+		std::string request = jrequest.dump();
+		ResponsePacket response_packet = { .response = randomHex(size) + "9000" };
+		unsigned long int count = std::max(1UL, iterations * 16 / size);
+
+		double decode_json = nanosecondsPerCall(count, [&] {
+			nlohmann::json parsed = nlohmann::json::parse(request);
+			sink += parsed.value("id", 0UL) + parsed["request"].get<int>() + parsed["timeout"].get<unsigned long>();
+			sink += parsed["data"].get_ref<const std::string&>().size();
+		});
+		RequestMessage message;
+		double decode = nanosecondsPerCall(count, [&] {
+			sink += decodeRequest(request, &message) ? message.id + message.request + message.timeout + message.data.size() : 0;
+		});
+		std::string json_text;
+		double encode_json = nanosecondsPerCall(count, [&] {
+			nlohmann::json jresponse = response_packet;
+			jresponse["id"] = 123456UL;
+			json_text = jresponse.dump();
+			sink += json_text.size();
+		});
+		std::string text;
+		double encode = nanosecondsPerCall(count, [&] {
+			encodeResponse(response_packet, 123456UL, -1, false, &text);
+			sink += text.size();
+		});
+		std::string compact_text;
+		double encode_compact = nanosecondsPerCall(count, [&] {
+			encodeResponse(response_packet, 123456UL, -1, true, &compact_text);
+			sink += compact_text.size();
+		});
+		std::printf("%-8lu %11.1f ns %11.1f ns %11.1f ns %11.1f ns %11.1f ns %10s %6lu/%-7lu\n", size, decode_json, decode, encode_json, encode, encode_compact,
+				text == json_text ? "yes" : "NO", (unsigned long) compact_text.size(), (unsigned long) text.size());
+	}
+	return sink == 0;
+}
@@ -0,0 +1,115 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+/**
+ * Microbenchmark of the hexadecimal conversions of utils/type_converter.hpp against the former stringstream and sprintf
+ * based implementation. It is not part of the client's build, compile it from the client's directory with:
+ *   g++ -std=c++11 -O2 [-mavx2 | -mssse3 | -DTYPE_CONVERTER_SCALAR] -Iinclude -Ilibraries bench/type_converter_bench.cpp
+ * Usage: type_converter_bench [iterations]
+ */
+
+#include "terminal/terminals/utils/type_converter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+unsigned char* legacyStringToUnsignedChar(std::string data, unsigned long int* length) {
+	data.erase(std::remove_if(data.begin(), data.end(), ::isspace), data.end());
+	std::stringstream ss;
+	for (unsigned long int i = 0; i < data.length(); i++) {
+		if (i != 0 && i % 2 == 0) {
+			ss << " ";
+		}
+		ss << data[i];
+	}
+	std::istringstream hex_chars_stream(ss.str());
+	std::vector<unsigned char> bytes;
+	unsigned int c;
+	while (hex_chars_stream >> std::hex >> c) {
+		bytes.push_back(c);
+	}
+	unsigned char* ustr = new unsigned char[bytes.size()];
+	std::copy(bytes.begin(), bytes.end(), ustr);
+	*length = bytes.size();
+	return ustr;
+}
+
+std::string legacyUnsignedCharToString(unsigned char* hex, unsigned long int length) {
+	std::string hexString;
+	char buffer[4];
+	for (unsigned long int i = 0; i < length; i++) {
+		sprintf(buffer, i == length - 1 ? "%02X" : "%02X ", hex[i]);
+		hexString.append(buffer);
+	}
+	return hexString;
+}
+
+template<typename F>
+double nanosecondsPerCall(unsigned long int iterations, F f) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned long int i = 0; i < iterations; i++) {
+		f();
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	unsigned long int iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+	volatile unsigned long int sink = 0; // keeps the conversions from being optimized out
+
+	std::printf("%-8s %14s %14s %14s %14s %14s\n", "bytes", "encode legacy", "encode", "decode legacy", "decode", "decode packed");
+	const unsigned long int sizes[] = { 2, 5, 16, 64, 261, 1024, 65536 };
+	for (unsigned long int size : sizes) {
+		std::vector<unsigned char> bytes(size);
+		for (unsigned long int i = 0; i < size; i++) {
+			bytes[i] = (unsigned char) std::rand();
+		}
+		std::string spaced = utils::unsignedCharToString(bytes.data(), size);
+		std::string packed(utils::hexEncodedLength(size, '\0'), '\0');
+		utils::hexEncode(bytes.data(), size, '\0', &packed[0]);
+		std::vector<char> hex(spaced.size());
+		std::vector<unsigned char> decoded(utils::hexDecodedCapacity(spaced.size()));
+		unsigned long int count = std::max(1UL, iterations * 16 / size);
+
+		double encode_legacy = nanosecondsPerCall(count, [&] { sink += legacyUnsignedCharToString(bytes.data(), size).size(); });
+		double encode = nanosecondsPerCall(count, [&] { sink += utils::hexEncode(bytes.data(), size, ' ', hex.data()); });
+		double decode_legacy = nanosecondsPerCall(count, [&] {
+			unsigned long int length;
+			delete[] legacyStringToUnsignedChar(spaced, &length);
+			sink += length;
+		});
+		double decode = nanosecondsPerCall(count, [&] {
+			unsigned long int length;
+			sink += utils::hexDecode(spaced.data(), spaced.size(), decoded.data(), &length) ? length : 0;
+		});
+		double decode_packed = nanosecondsPerCall(count, [&] {
+			unsigned long int length;
+			sink += utils::hexDecode(packed.data(), packed.size(), decoded.data(), &length) ? length : 0;
+		});
+		std::printf("%-8lu %11.1f ns %11.1f ns %11.1f ns %11.1f ns %11.1f ns\n", size, encode_legacy, encode, decode_legacy, decode, decode_packed);
+	}
+	return sink == 0;
+}
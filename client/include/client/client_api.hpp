@@ -21,6 +21,7 @@
 #include "client/client_engine.hpp"
 #include "client/requests/flyweight_requests.hpp"
 #include "constants/callback.hpp"
+#include "constants/event_type.hpp"
 #include "constants/response_packet.hpp"
 #include "terminal/flyweight_terminal_factory.hpp"
 
@@ -62,11 +63,46 @@ public:
 	 */
 	ResponsePacket connectClient(const char* reader, const char* ip, const char* port);
 
+	/**
+	 * connectAllReaders - connect to every configured or available reader and to the server over a single connection.
+	 * @return a ResponsePacket struct containing either the list of connected readers or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket connectAllReaders(const char* ip, const char* port);
+
 	/**
 	 * disconnectClient - disconnect the client from the server and disconnect the terminal.
 	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
 	 */
 	ResponsePacket disconnectClient();
+
+	/**
+	 * sendEvent - send an event of the client to the server, which passes it to its event callback and queue.
+	 * The client must send events ("monitor_events" enabled or "load_event_threshold" set).
+	 * @param event the event's type.
+	 * @param data the event's data (see constants/event_type.hpp).
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket sendEvent(EventType event, std::string data);
+
+	/**
+	 * dumpFlightRecorder - write the last requests' events kept by the flight recorder to a file.
+	 * The file is decoded by the server's tools/flight_decoder.cpp into text or into a Chrome trace.
+	 * @param path the file to write.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket dumpFlightRecorder(std::string path);
+
+	/**
+	 * getStats - return the counters of the client since it was created.
+	 * The "response" field contains, formatted in json, the number of requests, errors, timeouts and requests in flight with the latency
+	 * percentiles in microseconds, as a whole and by request code ("requests_by_code"), the results by error code ("errors_by_code")
+	 * and the bytes exchanged with the server ("wire").
+	 * When "contention_stats" is enabled, "contention" holds the wait and hold times of the instrumented locks and the threads'
+	 * counts and CPU times, by purpose.
+	 * The same counters are served in the Prometheus text format when "metrics_port" is set.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket getStats();
 };
 
 } /* namespace client */
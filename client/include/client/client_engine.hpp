@@ -19,29 +19,75 @@
 #define CLIENT_ENGINE_HPP_
 
 #include "client/client_tcp_socket.hpp"
+#include "client/message_codec.hpp"
+#include "client/reader_channel.hpp"
 #include "client/requests/flyweight_requests.hpp"
 #include "constants/callback.hpp"
+#include "constants/event_type.hpp"
+#include "constants/request_code.hpp"
 #include "config/config_wrapper.hpp"
 #include "constants/response_packet.hpp"
+#include "metrics/contention_reporter.hpp"
+#include "metrics/lock_stats.hpp"
+#include "metrics/metrics_http_server.hpp"
+#include "metrics/request_stats.hpp"
+#include "recorder/flight_recorder.hpp"
 #include "terminal/flyweight_terminal_factory.hpp"
+#include "terminal/terminal_executor.hpp"
+#include "terminal/terminal_state.hpp"
 #include "terminal/terminals/terminal.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <future>
+#include <map>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace client {
 
 class ClientEngine {
 private:
 	ConfigWrapper& config_ = ConfigWrapper::getInstance();
-	ClientTCPSocket* socket_;
-	ITerminalLayer* terminal_;
+	FlightRecorder& recorder_ = FlightRecorder::getInstance();
+	ClientTCPSocket* socket_ = NULL;
+	ITerminalLayer* terminal_ = NULL;
+	ITerminalFactory* terminal_factory_ = NULL;
+	ITerminalFactory* recording_factory_ = NULL;
+	TerminalExecutor executor_;
+	TerminalStateCache state_cache_;
+	std::vector<ReaderChannel*> channels_;
+	bool multi_reader_ = false;
+	InstrumentedMutex send_mutex_ { "send_mutex" };
 	std::thread requests_thread_;
-	std::vector<std::future<ResponsePacket>> pending_futures_;
 	std::atomic<bool> connected_ { false };
 	std::atomic<bool> initialized_ { false };
+	bool auto_reconnect_ = false;
+	int reconnect_max_attempts_ = 0;
+	long reconnect_initial_delay_ = 0;
+	long reconnect_max_delay_ = 0;
+	std::chrono::milliseconds terminal_idle_delay_ { 0 };
+	bool monitor_events_ = false;
+	bool compact_responses_ = false;
+	std::size_t load_event_threshold_ = 0;
+	std::atomic<bool> overloaded_ { false };
+	std::string ip_, port_, reader_;
+	std::string resume_token_;
+	int id_client_ = 0;
+	unsigned long last_request_id_ = 0;
+	std::string last_response_;
+	std::map<int, std::vector<unsigned char>> scripts_;
+	InstrumentedMutex scripts_mutex_ { "scripts_mutex" };
+	int next_script_handle_ = 0;
 	FlyweightRequests requests_;
+	RequestStats total_stats_; // all the requests received from the server
+	RequestStats request_stats_[REQ_COUNT]; // requests by RequestCode
+	ErrorStats error_stats_;
+	std::atomic<uint64_t> events_sent_ { 0 };
+	std::chrono::steady_clock::time_point started_ = std::chrono::steady_clock::now();
+	MetricsHttpServer metrics_server_;
+	ContentionReporter contention_reporter_;
 	Callback notifyConnectionLost_, notifyRequestReceived_, notifyResponseSent_;
 public:
 	ClientEngine(Callback notifyConnectionLost, Callback notifyRequestReceived, Callback notifyResponseSent) {
@@ -51,8 +97,27 @@ public:
 	}
 
 	~ClientEngine() {
-		delete terminal_;
+		metrics_server_.stop();
+		// the terminal is released on the thread that owns its handles
+		executor_.execute([this]() {
+			delete terminal_;
+			terminal_ = NULL;
+			ResponsePacket response_packet;
+			return response_packet;
+		});
+		executor_.stop();
+		for (ReaderChannel* channel : channels_) {
+			channel->executor.execute([channel]() {
+				delete channel->terminal;
+				channel->terminal = NULL;
+				ResponsePacket response_packet;
+				return response_packet;
+			});
+			channel->executor.stop();
+			delete channel;
+		}
 		delete socket_;
+		delete recording_factory_;
 	}
 
 	/**
@@ -81,6 +146,17 @@ public:
 	 */
 	ResponsePacket connectClient(const char* reader, const char* ip, const char* port);
 
+	/**
+	 * connectAllReaders - connect to every reader and register each of them as a client over a single connection to the server.
+	 * The readers are the ones listed in the "readers" configuration value (separated by '|'), or all the available readers.
+	 * Each reader has its own terminal instance and requests on different readers are executed in parallel.
+	 * The "response" field contains the channel and name of each connected reader: Channel|ReaderName|...|...
+	 * @param ip the ip to connect to.
+	 * @param port the port to connect to.
+	 * @return a ResponsePacket struct containing either the list of connected readers or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket connectAllReaders(const char* ip, const char* port);
+
 	/**
 	 * disconnectClient - disconnect the cliet from the server and disconnect the terminal.
 	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
@@ -106,8 +182,167 @@ public:
 	 * @param stop_flag the new value of the stop flag.
 	 */
 	void setConnectedFlag(bool stop_flag);
+
+	/**
+	 * getTerminalQueueDepth - return the number of requests waiting for the terminal.
+	 * In multi-reader mode, the requests waiting for all the readers are counted.
+	 * @return the terminal executor's queue depth.
+	 */
+	std::size_t getTerminalQueueDepth();
+
+	/**
+	 * getStats - return the counters of the client since it was created: requests, errors by code, timeouts, requests in flight,
+	 * bytes on the wire and latency percentiles, as a whole and by RequestCode.
+	 * The "response" field contains the counters formatted in json, the latencies are in microseconds.
+	 * @return a ResponsePacket struct containing the counters.
+	 */
+	ResponsePacket getStats();
+
+	/**
+	 * notifyEvent - send an event of the client to the server, without any reader.
+	 * The client must send events ("monitor_events" enabled or "load_event_threshold" set) for the server to receive them.
+	 * @param event the event's type.
+	 * @param data the event's data (see constants/event_type.hpp).
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket notifyEvent(EventType event, std::string data);
+
+	/**
+	 * storeScript - keep a compiled script until the client is disconnected.
+	 * The scripts are shared by all the readers of the client.
+	 * @param program the compiled script.
+	 * @return the handle used to run the script, 0 if all the handles are taken.
+	 */
+	int storeScript(std::vector<unsigned char> program);
+
+	/**
+	 * findScript - retrieve a script previously stored.
+	 * @param handle the script's handle.
+	 * @param program the compiled script.
+	 * @return a boolean indicating whether the script exists.
+	 */
+	bool findScript(int handle, std::vector<unsigned char>* program);
+
+	/**
+	 * getStateCache - retrieve the state cache of the given terminal.
+	 * @param terminal the terminal of the client or of one of its readers.
+	 * @return the terminal's state cache, NULL if the terminal is unknown.
+	 */
+	TerminalStateCache* getStateCache(ITerminalLayer* terminal);
+
+	/**
+	 * refreshTerminalState - read the card state of the given terminal if it is not known by its cache.
+	 * Must be called on the terminal's executor.
+	 * @param terminal the terminal of the client or of one of its readers.
+	 */
+	void refreshTerminalState(ITerminalLayer* terminal);
 private:
 	ResponsePacket sendResult(std::string result);
+
+	/**
+	 * handleChannelRequest - queue the given request on the executor of the reader it is addressed to.
+	 * The response is sent with the request's id and channel once the reader has executed the request.
+	 * @param message the decoded request.
+	 * @param received the instant the request was received at, TIMING_NOT_STAMPED if the server did not ask for the timing.
+	 * @param started the instant the request was counted at by startStats.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket handleChannelRequest(const RequestMessage& message, long long received, long long started);
+
+	/**
+	 * startStats - count a request received from the server.
+	 * @param request_code the request's code, out of the RequestCode range if the request cannot be decoded.
+	 * @return the instant the request was counted at, passed to endStats.
+	 */
+	long long startStats(int request_code);
+
+	/**
+	 * endStats - count the result of a request started with startStats.
+	 * @param request_code the request's code.
+	 * @param response_packet the request's result.
+	 * @param started the instant returned by startStats.
+	 */
+	void endStats(int request_code, const ResponsePacket& response_packet, long long started);
+
+	/**
+	 * renderMetrics - format the counters of getStats in the Prometheus text format, served by the metrics endpoint.
+	 * @return the metrics page.
+	 */
+	std::string renderMetrics();
+
+	/**
+	 * sendChannelResult - send the response of a request addressed to a reader.
+	 * @param reader_channel the reader which executed the request, NULL if the request could not be dispatched.
+	 * @param channel the request's channel.
+	 * @param request_id the request's id.
+	 * @param response_packet the response to send.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket sendChannelResult(ReaderChannel* reader_channel, int channel, unsigned long request_id, ResponsePacket response_packet);
+
+	/**
+	 * performHandshake - send the client's name to the server.
+	 * When automatic reconnection is enabled, the handshake also carries the resume token and waits for the server to
+	 * return the client's id and token, so that the server keeps the same id across reconnections.
+	 * @return a boolean indicating whether an error occurred.
+	 */
+	bool performHandshake();
+
+	/**
+	 * reconnect - reconnect to the server with exponential backoff and jitter, keeping the terminal connected.
+	 * @return a boolean indicating whether the connection has been restored.
+	 */
+	bool reconnect();
+
+	/**
+	 * getNumber - read a numeric value of the configuration, the default value being used if the value is malformed.
+	 * @param key the configuration's key.
+	 * @param default_value the value used if the key is missing or its value is not a number of at least min.
+	 * @param min the lowest accepted value.
+	 * @return the value read.
+	 */
+	long getNumber(std::string key, const char* default_value, long min);
+
+	/**
+	 * getTerminalIdleDelay - return the time without request after which the terminals are notified that they are idle.
+	 * @return the configured idle delay.
+	 */
+	std::chrono::milliseconds getTerminalIdleDelay();
+
+	/**
+	 * startMonitoring - start notifying the server of the card and reader events of the connected terminals, if enabled.
+	 * In multi-reader mode, the readers plugged in or removed are notified by the first reader only.
+	 */
+	void startMonitoring();
+
+	/**
+	 * isMonitoring - check whether a terminal's startMonitoring started monitoring its reader.
+	 * @param response_packet the result of startMonitoring.
+	 * @return true if the card events of the reader will be notified.
+	 */
+	bool isMonitoring(const ResponsePacket& response_packet);
+
+	/**
+	 * sendEvent - send an unsolicited event to the server, from the monitoring thread of a terminal or from the client.
+	 * @param channel the channel of the reader which raised the event.
+	 * @param event the event's type.
+	 * @param reader the name of the reader concerned by the event, empty for the events of the client.
+	 * @param data the event's data (see constants/event_type.hpp).
+	 * @return a boolean indicating whether the event has been sent.
+	 */
+	bool sendEvent(int channel, EventType event, std::string reader, std::string data);
+
+	/**
+	 * reportLoad - send an EVT_LOAD event when the number of requests waiting for the terminals reaches the configured
+	 * threshold, and another one once it is back under the threshold.
+	 */
+	void reportLoad();
+
+	/**
+	 * sendsEvents - check whether the client sends events, which the server must be able to receive between two requests.
+	 * @return true if the card events are monitored or the load is reported.
+	 */
+	bool sendsEvents();
 };
 
 } /* namespace client */
@@ -18,6 +18,8 @@
 #ifndef INCLUDE_CLIENT_CLIENT_TCP_SOCKET_HPP_
 #define INCLUDE_CLIENT_CLIENT_TCP_SOCKET_HPP_
 
+#include "metrics/request_stats.hpp"
+
 #include <ws2tcpip.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -32,6 +34,7 @@ private:
 	const char* port_;
 	struct addrinfo* result_;
 	struct addrinfo hints_;
+	WireCounters counters_;
 private:
 	bool sendData(const char* data, int size);
 public:
@@ -70,6 +73,14 @@ public:
 	 * closeClient - cleanup and close socket.
 	 */
 	void closeClient();
+
+	/**
+	 * getCounters - return the bytes and packets exchanged on the socket.
+	 * @return the socket's counters.
+	 */
+	const WireCounters& getCounters() const {
+		return counters_;
+	}
 };
 
 } /* namespace client */
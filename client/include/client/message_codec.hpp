@@ -0,0 +1,79 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef CLIENT_MESSAGE_CODEC_HPP_
+#define CLIENT_MESSAGE_CODEC_HPP_
+
+#include "constants/response_packet.hpp"
+#include "nlohmann/json.hpp"
+
+#include <string>
+
+namespace client {
+
+/**
+ * RequestMessage - a request sent by the server: { "id", "request", "data", "timeout" }, the "channel" of the
+ * reader it is addressed to for multi-reader clients and "timing" when the server asks for the instants of the request's stages.
+ */
+struct RequestMessage {
+	unsigned long id = 0;
+	int request = -1;
+	int channel = 0;
+	unsigned long timeout = 0;
+	bool timing = false;
+	std::string data;
+};
+
+// https://github.com/nlohmann/json#arbitrary-types-conversions
+// Used to convert the requests the fixed-schema decoder does not handle.
+inline void from_json(const nlohmann::json& j, RequestMessage& e) {
+	e.id = j.value("id", 0UL);
+	j.at("request").get_to(e.request);
+	e.channel = j.value("channel", 0);
+	j.at("timeout").get_to(e.timeout);
+	j.at("data").get_to(e.data);
+	e.timing = j.value("timing", false);
+}
+
+/**
+ * decodeRequest - decode a request with a hand-written parser of the request's fixed schema.
+ * The parser does not allocate beyond the data field, which reuses the capacity of the given message.
+ * Messages with unknown or missing fields, non-integer numbers or escapes outside the BMP are not decoded
+ * and must be converted with nlohmann instead (see from_json above).
+ * @param text the request received from the server.
+ * @param message filled with the request's fields.
+ * @return true if the request was decoded, false if it must be parsed with nlohmann.
+ */
+bool decodeRequest(const std::string& text, RequestMessage* message);
+
+/**
+ * encodeResponse - serialize a response in the format produced by nlohmann for a ResponsePacket with its id.
+ * The keys are written in nlohmann's order so that both paths produce the same text.
+ * The compact format omits the fields holding their default value and sends the interned descriptions
+ * by their index (see constants/description.hpp) in "<description key>_id" fields.
+ * The response's timing is sent as [terminal_start, terminal_end, client_send] relative to client_receive when client_receive is stamped.
+ * @param response_packet the response to serialize.
+ * @param id the id of the request.
+ * @param channel the channel of the reader which executed the request, omitted if negative.
+ * @param compact true to use the compact format.
+ * @param text filled with the serialized response, its capacity is reused.
+ */
+void encodeResponse(const ResponsePacket& response_packet, unsigned long id, int channel, bool compact, std::string* text);
+
+} /* namespace client */
+
+#endif /* CLIENT_MESSAGE_CODEC_HPP_ */
@@ -0,0 +1,52 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef CLIENT_READER_CHANNEL_HPP_
+#define CLIENT_READER_CHANNEL_HPP_
+
+#include "metrics/lock_stats.hpp"
+#include "terminal/terminal_executor.hpp"
+#include "terminal/terminal_state.hpp"
+#include "terminal/terminals/terminal.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace client {
+
+/**
+ * ReaderChannel - a reader of a multi-reader client.
+ * Each reader has its own terminal instance and executor, so that requests on different readers run in parallel
+ * while sharing the client's connection. The server addresses the reader with its channel index.
+ */
+struct ReaderChannel {
+	int channel = 0;
+	int id_client = 0;
+	std::string reader;
+	ITerminalLayer* terminal = NULL;
+	TerminalExecutor executor;
+	TerminalStateCache state_cache;
+	std::atomic<bool> connected { false };
+	InstrumentedMutex cache_mutex { "channel_cache_mutex" };
+	unsigned long last_request_id = 0;
+	std::string last_response;
+};
+
+} /* namespace client */
+
+#endif /* CLIENT_READER_CHANNEL_HPP_ */
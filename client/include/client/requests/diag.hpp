@@ -28,7 +28,14 @@ class Diag : public IRequest {
 public:
 	Diag() = default;
 	~Diag() = default;
-	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) override;
+	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) override;
+
+	/**
+	 * isStructured - check whether the json TerminalState is requested instead of the diagnostic string.
+	 * @param command the request's data, "01" for the structured diagnostic.
+	 * @return true if the structured diagnostic is requested.
+	 */
+	static bool isStructured(const Apdu& command);
 };
 
 } /* namespace client */
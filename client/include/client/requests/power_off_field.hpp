@@ -28,7 +28,7 @@ class PowerOffField : public IRequest {
 public:
 	PowerOffField() {}
 	~PowerOffField() = default;
-	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) override;
+	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) override;
 };
 
 } /* namespace client */
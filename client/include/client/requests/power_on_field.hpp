@@ -28,7 +28,7 @@ class PowerOnField : public IRequest {
 public:
 	PowerOnField() = default;
 	~PowerOnField() = default;
-	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) override;
+	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) override;
 };
 
 } /* namespace client */
@@ -33,11 +33,10 @@ public:
 	 * run - execute the request.
 	 * @param terminal configuration to terminal used to perform the request.
 	 * @param client_engine the caller.
-	 * @param command to perform if required.
-	 * @param command_length the length of the command parameter.
+	 * @param command to perform if required, the request's data.
 	 * @return a
 	 */
-	virtual ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) = 0;
+	virtual ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) = 0;
 };
 
 } /* namespace client */
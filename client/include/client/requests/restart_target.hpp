@@ -27,7 +27,7 @@ class RestartTarget : public IRequest {
 public:
 	RestartTarget() = default;
 	~RestartTarget() = default;
-	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) override;
+	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) override;
 };
 
 } /* namespace client */
@@ -28,7 +28,7 @@ class SendTypeB: public IRequest {
 public:
 	SendTypeB() = default;
 	~SendTypeB() = default;
-	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) override;
+	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) override;
 };
 
 }
@@ -28,7 +28,7 @@ class SendTypeF: public IRequest {
 public:
 	SendTypeF() = default;
 	~SendTypeF() = default;
-	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], DWORD command_length) override;
+	ResponsePacket run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) override;
 };
 
 }
@@ -0,0 +1,233 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+#ifndef SRC_APDU_HPP_
+#define SRC_APDU_HPP_
+
+#include "terminal/terminals/utils/type_converter.hpp"
+
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#define APDU_INLINE_CAPACITY 261 // short APDU: header, Lc, 255 bytes of data and Le
+
+namespace client {
+
+/**
+ * Apdu - command passed from the requests to the terminals.
+ * Short APDUs are stored inline so that no allocation is made per command, extended length APDUs fall back to the heap.
+ */
+class Apdu {
+private:
+	unsigned char inline_[APDU_INLINE_CAPACITY];
+	std::vector<unsigned char> extended_; // used when the APDU does not fit inline
+	unsigned long int length_ = 0;
+public:
+	Apdu() = default;
+
+	Apdu(const unsigned char* bytes, unsigned long int length) {
+		assign(bytes, length);
+	}
+
+	Apdu(std::initializer_list<unsigned char> bytes) {
+		assign(bytes.begin(), bytes.size());
+	}
+
+	Apdu(const Apdu& other) {
+		assign(other.data(), other.size());
+	}
+
+	Apdu(Apdu&& other) {
+		*this = std::move(other);
+	}
+
+	Apdu& operator=(const Apdu& other) {
+		if (this != &other) {
+			assign(other.data(), other.size());
+		}
+		return *this;
+	}
+
+	Apdu& operator=(Apdu&& other) {
+		if (this == &other) {
+			return *this;
+		}
+		if (other.length_ > APDU_INLINE_CAPACITY) {
+			extended_ = std::move(other.extended_);
+			length_ = other.length_;
+		} else {
+			assign(other.data(), other.size());
+		}
+		other.length_ = 0;
+		return *this;
+	}
+
+	/**
+	 * assign - replace the content of the APDU.
+	 * @param bytes the APDU's bytes.
+	 * @param length the number of bytes.
+	 */
+	void assign(const unsigned char* bytes, unsigned long int length) {
+		resize(0);
+		resize(length);
+		if (length > 0) {
+			memcpy(data(), bytes, length);
+		}
+	}
+
+	/**
+	 * assignHex - replace the content of the APDU with the given hexadecimal string (see utils::hexDecode).
+	 * @param hex the hexadecimal string.
+	 * @return false if the string is not valid hexadecimal data, the APDU is empty then.
+	 */
+	bool assignHex(const std::string& hex) {
+		resize(utils::hexDecodedCapacity(hex.size()));
+		unsigned long int length = 0;
+		if (!utils::hexDecode(hex.data(), hex.size(), data(), &length)) {
+			resize(0);
+			return false;
+		}
+		resize(length);
+		return true;
+	}
+
+	/**
+	 * toHex - return the APDU formatted as the terminals' responses ("00 A4 04 00").
+	 * @return the hexadecimal string.
+	 */
+	std::string toHex() const {
+		return utils::unsignedCharToString(data(), length_);
+	}
+
+	/**
+	 * resize - change the length of the APDU, the bytes kept are preserved and the added bytes are not initialized.
+	 * @param length the new length.
+	 */
+	void resize(unsigned long int length) {
+		if (length > APDU_INLINE_CAPACITY) {
+			if (length_ <= APDU_INLINE_CAPACITY) {
+				extended_.assign(inline_, inline_ + length_);
+			}
+			extended_.resize(length);
+		} else if (length_ > APDU_INLINE_CAPACITY) {
+			memcpy(inline_, extended_.data(), length);
+			extended_.clear();
+		}
+		length_ = length;
+	}
+
+	unsigned char* data() {
+		return length_ > APDU_INLINE_CAPACITY ? extended_.data() : inline_;
+	}
+
+	const unsigned char* data() const {
+		return length_ > APDU_INLINE_CAPACITY ? extended_.data() : inline_;
+	}
+
+	unsigned long int size() const {
+		return length_;
+	}
+
+	bool empty() const {
+		return length_ == 0;
+	}
+
+	unsigned char& operator[](unsigned long int i) {
+		return data()[i];
+	}
+
+	unsigned char operator[](unsigned long int i) const {
+		return data()[i];
+	}
+
+	bool operator==(const Apdu& other) const {
+		return length_ == other.length_ && (length_ == 0 || memcmp(data(), other.data(), length_) == 0);
+	}
+
+	/**
+	 * isExtended - check whether the APDU uses the extended length encoding (ISO 7816-4 cases 2E, 3E and 4E).
+	 */
+	bool isExtended() const {
+		return length_ >= 7 && data()[4] == 0x00;
+	}
+
+	unsigned char cla() const {
+		return length_ > 0 ? data()[0] : 0x00;
+	}
+
+	unsigned char ins() const {
+		return length_ > 1 ? data()[1] : 0x00;
+	}
+
+	unsigned char p1() const {
+		return length_ > 2 ? data()[2] : 0x00;
+	}
+
+	unsigned char p2() const {
+		return length_ > 3 ? data()[3] : 0x00;
+	}
+
+	/**
+	 * lc - return the length of the command data.
+	 * @return 0 if the APDU has no command data or is malformed.
+	 */
+	unsigned long int lc() const {
+		if (length_ <= 5) {
+			return 0;
+		}
+		const unsigned char* bytes = data();
+		if (!isExtended()) {
+			return length_ == 5u + bytes[4] || length_ == 6u + bytes[4] ? bytes[4] : 0;
+		}
+		unsigned long int lc = (bytes[5] << 8) | bytes[6];
+		return length_ == 7 + lc || length_ == 9 + lc ? lc : 0;
+	}
+
+	/**
+	 * le - return the maximum length of the response data, Le = 00 meaning 256 (65536 for extended length).
+	 * @return 0 if the APDU has no Le field or is malformed.
+	 */
+	unsigned long int le() const {
+		if (length_ <= 4) {
+			return 0;
+		}
+		const unsigned char* bytes = data();
+		if (!isExtended()) {
+			if (length_ != 5 && length_ != 6u + bytes[4]) {
+				return 0;
+			}
+			return bytes[length_ - 1] == 0x00 ? 256 : bytes[length_ - 1];
+		}
+		if (length_ != 7 && length_ != 9u + ((bytes[5] << 8) | bytes[6])) {
+			return 0;
+		}
+		unsigned long int le = (bytes[length_ - 2] << 8) | bytes[length_ - 1];
+		return le == 0 ? 65536 : le;
+	}
+
+	/**
+	 * body - return the command data, lc() bytes long.
+	 */
+	const unsigned char* body() const {
+		return data() + (isExtended() ? 7 : 5);
+	}
+};
+
+} /* namespace client */
+
+#endif /* SRC_APDU_HPP_ */
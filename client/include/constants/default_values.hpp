@@ -24,20 +24,62 @@ namespace client {
 #define DEFAULT_IP "127.0.0.1"
 #define DEFAULT_PORT "62111"
 #define DEFAULT_BUFLEN 1024 * 64
+#define DEFAULT_COMPACT_RESPONSES "false" // omit the fields holding their default value from the responses, requires a server supporting it
 
 /* DLL Buffer Size */
 #define DEFAULT_DLL_BUFFER_SIZE 2*1024
 #define DEFAULT_DLL_BUFFER_SIZE_EXTENDED 2*4096
+#define DEFAULT_DLL_RESULT_POOL_SIZE 64 // released results kept for reuse by the handle-based functions
 
 /* client information */
 #define DEFAULT_NAME "default_name" // client's name
 
+/* multi-reader */
+#define DEFAULT_READERS "" // readers connected by connectAllReaders separated by '|', all the available readers if empty
+
+/* terminals */
+#define DEFAULT_TERMINAL_IDLE_DELAY "1000" // milliseconds without request after which the terminal restores its default settings
+#define DEFAULT_T0_CHAINING "false" // send GET RESPONSE after 61xx and resend with the right Le after 6Cxx on the client's side
+#define DEFAULT_MONITOR_EVENTS "false" // send the card insertions and removals and the readers plugged in or removed to the server
+#define DEFAULT_LOAD_EVENT_THRESHOLD "0" // requests waiting for the terminals from which an EVT_LOAD event is sent, 0 to disable
+
+#define DEFAULT_SIMULATED_CARD "" // rule file of the SIMULATED terminal, a card answering 90 00 to every command if empty
+
+#define DEFAULT_RECORD_FILE "" // file recording every terminal call, nothing is recorded if empty
+#define DEFAULT_REPLAY_FILE "./recording.bin" // recording replayed by the REPLAY terminal
+#define DEFAULT_REPLAY_TIMING "fast" // "recorded" to replay the calls with their recorded duration, "fast" to answer immediately
+
+/* scripts */
+#define DEFAULT_SCRIPT_MAX_STEPS "10000" // maximum number of instructions executed by a script, guards against endless loops
+
+/* reconnection */
+#define DEFAULT_AUTO_RECONNECT "false" // reconnect and resume the session when the connection with the server is lost
+#define DEFAULT_RECONNECT_INITIAL_DELAY "200" // first backoff delay in milliseconds
+#define DEFAULT_RECONNECT_MAX_DELAY "10000" // maximum backoff delay in milliseconds
+#define DEFAULT_RECONNECT_MAX_ATTEMPTS "20" // attempts before giving up, 0 to retry forever
+
 /* logs */
 #define DEFAULT_LOG_LEVEL "info" // debug level - info or debug (more verbose)
 #define DEFAULT_LOG_DIRECTORY "./logs"
 #define DEFAULT_LOG_FILENAME "basics.csv"
 #define DEFAULT_LOG_MAX_SIZE "1000000" // maximum bytes for each log file
 #define DEFAULT_LOG_MAX_FILES "10" // log files number for the rolling
+#define DEFAULT_LOG_ASYNC "true" // records written by a background thread instead of the logging threads
+#define DEFAULT_LOG_BUFFER_SIZE "1024" // records waiting to be written for each logging thread, the next ones are dropped
+#define DEFAULT_LOG_FLUSH_INTERVAL 20 // milliseconds between two writes of the waiting records
+
+/* flight recorder */
+#define DEFAULT_RECORDER_SIZE 65536 // records kept in memory, must be a power of two
+#define DEFAULT_RECORDER_FILE "./logs/flight_recorder.bin" // written when a request fails on a timeout or a network error
+#define DEFAULT_RECORDER_DUMP_ON_ERROR "true"
+#define DEFAULT_RECORDER_DUMP_INTERVAL 60 // minimum seconds between two dumps on error
+
+/* metrics */
+#define DEFAULT_METRICS_PORT "" // port of the Prometheus endpoint, empty to disable it
+#define DEFAULT_METRICS_IP "127.0.0.1" // keeps the metrics local unless another address is configured
+#define DEFAULT_METRICS_TIMEOUT 2000 // waiting time in ms for the request of a metrics scraper
+#define DEFAULT_CONTENTION_STATS "false" // wait and hold times of the locks, CPU time of the threads, read at initialization
+#define DEFAULT_CONTENTION_REPORT_INTERVAL "60" // seconds between two summaries in the logs, 0 for none
 
 } /* namespace client */
 
@@ -36,7 +36,10 @@ enum RequestCode {
 	REQ_COLD_RESET,
 	REQ_WARM_RESET,
 	REQ_POWER_OFF_FIELD,
-	REQ_POWER_ON_FIELD
+	REQ_POWER_ON_FIELD,
+	REQ_SCRIPT_LOAD,
+	REQ_SCRIPT_RUN,
+	REQ_COUNT // number of request codes, not a request
 };
 
 /**
@@ -74,6 +77,10 @@ inline const std::string requestCodeToString(RequestCode request_code) {
 		return "REQ_POWER_OFF_FIELD";
 	case REQ_POWER_ON_FIELD:
 		return "REQ_POWER_ON_FIELD";
+	case REQ_SCRIPT_LOAD:
+		return "REQ_SCRIPT_LOAD";
+	case REQ_SCRIPT_RUN:
+		return "REQ_SCRIPT_RUN";
 	default:
 		return "[Unknown Request Code]";
 	}
@@ -0,0 +1,64 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef CONSTANTS_REQUEST_TIMING_HPP_
+#define CONSTANTS_REQUEST_TIMING_HPP_
+
+#include <chrono>
+
+namespace client {
+
+#define TIMING_NOT_STAMPED -1
+
+/**
+ * RequestTiming - the instants at which a request went through the client's stages, in microseconds of the steady clock.
+ * The instants are only stamped when the server asks for them in the request ("timing": true). They are sent in the response
+ * relative to the reception of the request, as the clocks of the client and of the server are not related.
+ */
+struct RequestTiming {
+	long long client_receive = TIMING_NOT_STAMPED;
+	long long terminal_start = TIMING_NOT_STAMPED;
+	long long terminal_end = TIMING_NOT_STAMPED;
+	long long client_send = TIMING_NOT_STAMPED;
+};
+
+/**
+ * timingNow - return the current instant of the steady clock in microseconds.
+ */
+inline long long timingNow() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline long long timingElapsed(long long from, long long to) {
+	return (from == TIMING_NOT_STAMPED || to == TIMING_NOT_STAMPED) ? TIMING_NOT_STAMPED : to - from;
+}
+
+/**
+ * stampClientSend - stamp the sending of a response, right before it is encoded.
+ * @param timing the response's timing.
+ * @param received the reception of the request, TIMING_NOT_STAMPED if the server did not ask for the timing.
+ */
+inline void stampClientSend(RequestTiming* timing, long long received) {
+	if (received != TIMING_NOT_STAMPED) {
+		timing->client_receive = received;
+		timing->client_send = timingNow();
+	}
+}
+
+} /* namespace client */
+
+#endif /* CONSTANTS_REQUEST_TIMING_HPP_ */
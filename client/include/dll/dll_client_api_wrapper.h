@@ -44,6 +44,34 @@ struct ResponseDLL {
 	char err_card_description[DEFAULT_DLL_BUFFER_SIZE];
 };
 
+/**
+ * ResultField - the texts of a result, read with getResultBytes, getResultText or getResultView.
+ */
+enum ResultField {
+	RESULT_RESPONSE = 0,
+	RESULT_SERVER_DESCRIPTION,
+	RESULT_CLIENT_DESCRIPTION,
+	RESULT_TERMINAL_DESCRIPTION,
+	RESULT_CARD_DESCRIPTION,
+	RESULT_FIELD_COUNT
+};
+
+/**
+ * ResultDLL - codes and text lengths of a result of the handle-based functions (the functions suffixed with "Result").
+ * The texts are not copied into the structure: they stay in the result designated by the returned handle
+ * until the result is released with releaseResult.
+ */
+struct ResultDLL {
+	long int err_server_code;
+	long int err_client_code;
+	long int err_terminal_code;
+	long int err_card_code;
+	unsigned long int lengths[RESULT_FIELD_COUNT]; // length of each ResultField's text, without the terminating null character
+};
+
+struct ResultSlot;
+typedef ResultSlot* ResultHandle;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,13 +86,62 @@ ADDAPI void setCallbackResponseSent(client::Callback handler);
 
 ADDAPI client::ClientAPI* createClientAPI();
 ADDAPI void connectClient(client::ClientAPI* client, const char* reader, const char* ip, const char* port, ResponseDLL& response_packet);
+ADDAPI void connectAllReaders(client::ClientAPI* client, const char* ip, const char* port, ResponseDLL& response_packet);
 ADDAPI void disconnectClient(client::ClientAPI* client, ResponseDLL& response_packet_dll);
+ADDAPI void dumpFlightRecorder(client::ClientAPI* client, const char* path, ResponseDLL& response_packet_dll);
+ADDAPI void getStats(client::ClientAPI* client, ResponseDLL& response_packet_dll);
 void responsePacketForDll(client::ResponsePacket response_packet, ResponseDLL& response_packet_dll);
 
 ADDAPI void disposeClientAPI(client::ClientAPI* client);
 ADDAPI void initClient(client::ClientAPI* client, const char* jsonConfig, ResponseDLL& response_packet);
 ADDAPI void loadAndListReaders(client::ClientAPI*, ResponseDLL& response_packet);
 
+/*
+ * Handle-based functions: they fill the given ResultDLL with the codes and text lengths of the result and return its handle.
+ * The texts are read from the handle, which must be released with releaseResult once read.
+ */
+ResultHandle acquireResult(client::ResponsePacket response_packet, ResultDLL& result);
+
+ADDAPI ResultHandle initClientResult(client::ClientAPI* client, const char* jsonConfig, ResultDLL& result);
+ADDAPI ResultHandle loadAndListReadersResult(client::ClientAPI* client, ResultDLL& result);
+ADDAPI ResultHandle connectClientResult(client::ClientAPI* client, const char* reader, const char* ip, const char* port, ResultDLL& result);
+ADDAPI ResultHandle connectAllReadersResult(client::ClientAPI* client, const char* ip, const char* port, ResultDLL& result);
+ADDAPI ResultHandle disconnectClientResult(client::ClientAPI* client, ResultDLL& result);
+
+/**
+ * getResultBytes - copy the payload of a result, the bytes encoded by its hexadecimal response.
+ * @param handle the result.
+ * @param buffer the destination, at least half the response's length (lengths[RESULT_RESPONSE] / 2) long.
+ * @param length the size of the destination, nothing is copied if it is shorter than half the response's length.
+ * @return the length of the payload, or the size needed (greater than length) if the destination is too short, 0 if the response is not hexadecimal data (read it with getResultText).
+ */
+ADDAPI unsigned long getResultBytes(ResultHandle handle, unsigned char* buffer, unsigned long length);
+
+/**
+ * getResultText - copy a text of a result followed by a null character.
+ * @param handle the result.
+ * @param field the ResultField to copy.
+ * @param buffer the destination.
+ * @param size the size of the destination, the text is truncated if it is longer than size - 1.
+ * @return the length of the whole text.
+ */
+ADDAPI unsigned long getResultText(ResultHandle handle, int field, char* buffer, unsigned long size);
+
+/**
+ * getResultView - access a text of a result without copying it.
+ * @param handle the result.
+ * @param field the ResultField to access.
+ * @return the null-terminated text, valid until the result is released.
+ */
+ADDAPI const char* getResultView(ResultHandle handle, int field);
+
+/**
+ * releaseResult - release a result, which is kept in a pool for the next calls.
+ * @param handle the result, ignored if NULL.
+ */
+ADDAPI void releaseResult(ResultHandle handle);
+
+
 #ifdef __cplusplus
 }
 #endif
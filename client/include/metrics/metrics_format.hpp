@@ -0,0 +1,101 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_METRICS_FORMAT_HPP_
+#define METRICS_METRICS_FORMAT_HPP_
+
+#include "metrics/latency_histogram.hpp"
+#include "metrics/lock_stats.hpp"
+#include "metrics/request_stats.hpp"
+#include "metrics/thread_stats.hpp"
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace client {
+
+/**
+ * histogramToJson - summarize a histogram: count, mean, p50, p90, p99, p999 and max.
+ */
+nlohmann::json histogramToJson(const LatencyHistogram& histogram);
+
+/**
+ * requestStatsToJson - convert the counters of a set of requests, with the summary of their latency in microseconds.
+ */
+nlohmann::json requestStatsToJson(const RequestStats& stats);
+
+/**
+ * contentionToJson - the statistics of the instrumented locks, in nanoseconds, and of the registered threads, in microseconds.
+ */
+nlohmann::json contentionToJson();
+
+/**
+ * PrometheusWriter - builder of a metrics page in the Prometheus text format (version 0.0.4).
+ * The samples of a metric must follow its family line.
+ */
+class PrometheusWriter {
+private:
+	std::string text_;
+public:
+	/**
+	 * family - start a metric with its HELP and TYPE lines.
+	 * @param name the metric's name.
+	 * @param type counter, gauge or summary.
+	 * @param help the description of the metric.
+	 */
+	void family(const char* name, const char* type, const char* help);
+
+	/**
+	 * sample - add a sample of the current metric.
+	 * @param name the metric's name, with its suffix for the parts of a summary.
+	 * @param labels the labels built with label, separated by commas, empty for none.
+	 * @param value the sample's value.
+	 */
+	void sample(const char* name, const std::string& labels, uint64_t value);
+	void sample(const char* name, const std::string& labels, double value);
+
+	/**
+	 * summary - add the quantiles (0.5, 0.9, 0.99, 0.999), sum and count of a histogram to the current summary metric.
+	 * @param name the metric's name.
+	 * @param labels the labels common to the samples.
+	 * @param histogram the histogram.
+	 * @param scale the factor converting the histogram's values to the metric's unit.
+	 */
+	void summary(const char* name, const std::string& labels, const LatencyHistogram& histogram, double scale);
+
+	/**
+	 * label - format a label, escaping its value.
+	 * @return key="value"
+	 */
+	static std::string label(const char* key, const std::string& value);
+
+	const std::string& str() const {
+		return text_;
+	}
+};
+
+/**
+ * writeContention - add the statistics of the instrumented locks and of the registered threads to a metrics page.
+ * @param writer the metrics page.
+ * @param prefix the prefix of the metrics' names.
+ */
+void writeContention(PrometheusWriter* writer, const std::string& prefix);
+
+} /* namespace client */
+
+#endif /* METRICS_METRICS_FORMAT_HPP_ */
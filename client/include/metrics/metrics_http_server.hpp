@@ -0,0 +1,63 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_METRICS_HTTP_SERVER_HPP_
+#define METRICS_METRICS_HTTP_SERVER_HPP_
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <winsock2.h>
+
+namespace client {
+
+/**
+ * MetricsHttpServer - minimal HTTP endpoint answering GET /metrics with the page built by the given function.
+ * The requests are served one at a time on a single thread, which is enough for a Prometheus scraper.
+ */
+class MetricsHttpServer {
+private:
+	SOCKET listen_socket_ = INVALID_SOCKET;
+	std::thread thread_;
+	std::atomic<bool> stop_ { false };
+	std::function<std::string()> render_;
+public:
+	MetricsHttpServer() = default;
+	~MetricsHttpServer();
+
+	/**
+	 * start - listen on the given address and serve the metrics on a background thread.
+	 * @param ip the ip to listen to, a loopback address keeps the metrics local.
+	 * @param port the port to listen to.
+	 * @param render the function building the metrics page.
+	 * @return false if the endpoint cannot listen on the given address.
+	 */
+	bool start(const char* ip, const char* port, std::function<std::string()> render);
+
+	/**
+	 * stop - close the endpoint and wait for its thread.
+	 */
+	void stop();
+private:
+	void serve();
+	void answer(SOCKET socket);
+};
+
+} /* namespace client */
+
+#endif /* METRICS_METRICS_HTTP_SERVER_HPP_ */
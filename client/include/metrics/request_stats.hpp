@@ -0,0 +1,121 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_REQUEST_STATS_HPP_
+#define METRICS_REQUEST_STATS_HPP_
+
+#include "constants/response_packet.hpp"
+#include "metrics/latency_histogram.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace client {
+
+#define STATS_ERROR_CODES 9 // error codes counted one by one, from 0 to -8
+
+/**
+ * RequestStats - counters and latency of a set of requests (the requests of a client, of a request code), updated without lock.
+ */
+struct RequestStats {
+	std::atomic<uint64_t> requests { 0 };
+	std::atomic<uint64_t> errors { 0 }; // requests whose result holds an error code under 0
+	std::atomic<uint64_t> timeouts { 0 };
+	std::atomic<int64_t> in_flight { 0 };
+	LatencyHistogram latency; // microseconds from the start of the request to its result
+
+	void start() {
+		requests.fetch_add(1, std::memory_order_relaxed);
+		in_flight.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void end(const ResponsePacket& response_packet, long long duration) {
+		in_flight.fetch_sub(1, std::memory_order_relaxed);
+		if (firstErrorCode(response_packet) < 0) {
+			errors.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (response_packet.err_server_code == ERR_TIMEOUT || response_packet.err_client_code == ERR_TIMEOUT) {
+			timeouts.fetch_add(1, std::memory_order_relaxed);
+		}
+		latency.record(duration);
+	}
+};
+
+/**
+ * ErrorStats - number of results per error code of each layer, updated without lock.
+ * The server's and the client's codes (ErrorCode) are counted one by one, the terminal's and the card's codes only as a whole.
+ */
+struct ErrorStats {
+	std::atomic<uint64_t> server[STATS_ERROR_CODES];
+	std::atomic<uint64_t> client[STATS_ERROR_CODES];
+	std::atomic<uint64_t> other_server { 0 }; // codes beyond STATS_ERROR_CODES
+	std::atomic<uint64_t> other_client { 0 };
+	std::atomic<uint64_t> terminal { 0 };
+	std::atomic<uint64_t> card { 0 };
+
+	ErrorStats() {
+		for (int i = 0; i < STATS_ERROR_CODES; i++) {
+			server[i].store(0, std::memory_order_relaxed);
+			client[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void record(const ResponsePacket& response_packet) {
+		count(response_packet.err_server_code, server, &other_server);
+		count(response_packet.err_client_code, client, &other_client);
+		if (response_packet.err_terminal_code < 0) {
+			terminal.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (response_packet.err_card_code < 0) {
+			card.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+private:
+	static void count(long code, std::atomic<uint64_t>* codes, std::atomic<uint64_t>* other) {
+		if (code < 0 && code > -STATS_ERROR_CODES) {
+			codes[-code].fetch_add(1, std::memory_order_relaxed);
+		} else if (code < 0) {
+			other->fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+};
+
+/**
+ * WireCounters - bytes and packets exchanged on the sockets, updated without lock.
+ * The bytes include the 4-byte length prefix of each packet.
+ */
+struct WireCounters {
+	std::atomic<uint64_t> bytes_sent { 0 };
+	std::atomic<uint64_t> bytes_received { 0 };
+	std::atomic<uint64_t> packets_sent { 0 };
+	std::atomic<uint64_t> packets_received { 0 };
+
+	void sent(std::size_t size) {
+		bytes_sent.fetch_add(size + sizeof(int), std::memory_order_relaxed);
+		packets_sent.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void received(std::size_t size) {
+		bytes_received.fetch_add(size + sizeof(int), std::memory_order_relaxed);
+		packets_received.fetch_add(1, std::memory_order_relaxed);
+	}
+};
+
+} /* namespace client */
+
+#endif /* METRICS_REQUEST_STATS_HPP_ */
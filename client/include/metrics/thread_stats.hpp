@@ -0,0 +1,142 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_THREAD_STATS_HPP_
+#define METRICS_THREAD_STATS_HPP_
+
+#include "metrics/latency_histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+namespace client {
+
+/**
+ * ThreadStats - the threads started for a same purpose (accepting the connections, sending a request...), updated without lock.
+ */
+struct ThreadStats {
+	std::string name;
+	std::atomic<uint64_t> started { 0 };
+	std::atomic<uint64_t> live { 0 };
+	std::atomic<uint64_t> peak { 0 }; // maximum number of live threads
+	std::atomic<uint64_t> cpu_time { 0 }; // microseconds of CPU used by the exited threads, user and kernel
+	LatencyHistogram lifetime; // microseconds between the start and the exit of the threads
+
+	explicit ThreadStats(const std::string& name) : name(name) {}
+};
+
+/**
+ * ThreadUsage - the statistics of a ThreadStats with the CPU time of its live threads.
+ */
+struct ThreadUsage {
+	std::shared_ptr<ThreadStats> stats;
+	uint64_t cpu_time; // microseconds of CPU used by the exited and the live threads
+};
+
+/**
+ * ThreadRegistry - the threads running a ThreadScope, by name, while the instrumentation is enabled.
+ */
+class ThreadRegistry {
+private:
+	struct LiveThread {
+		ThreadStats* stats;
+		HANDLE handle; // used to read the thread's CPU time from another thread
+		std::chrono::steady_clock::time_point start;
+	};
+
+	static std::atomic<bool> enabled_;
+	std::mutex mutex_;
+	std::vector<std::shared_ptr<ThreadStats>> threads_;
+	std::map<unsigned long, LiveThread> live_;
+	unsigned long next_id_ = 0;
+	ThreadRegistry() = default;
+public:
+	static ThreadRegistry& getInstance() {
+		static ThreadRegistry instance;
+		return instance;
+	}
+
+	static bool isEnabled() {
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * setEnabled - start or stop registering the threads, the threads already running are not registered.
+	 */
+	static void setEnabled(bool enabled) {
+		enabled_.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * enter - register the calling thread.
+	 * @param name the purpose of the thread.
+	 * @return the id passed to exit.
+	 */
+	unsigned long enter(const char* name);
+
+	/**
+	 * exit - unregister the calling thread and add its CPU time and lifetime to the statistics of its name.
+	 * @param id the id returned by enter.
+	 */
+	void exit(unsigned long id);
+
+	/**
+	 * snapshot - return the statistics of all the names with the CPU time of their live threads, in the order of their creation.
+	 */
+	std::vector<ThreadUsage> snapshot();
+
+	ThreadRegistry(ThreadRegistry const&) = delete;
+	void operator=(ThreadRegistry const&) = delete;
+private:
+	ThreadStats* find(const std::string& name);
+};
+
+/**
+ * ThreadScope - registers the calling thread in the ThreadRegistry until the end of its scope, placed at the top of a thread's function.
+ * Nothing is registered when the instrumentation is disabled.
+ */
+class ThreadScope {
+private:
+	bool registered_;
+	unsigned long id_ = 0;
+public:
+	explicit ThreadScope(const char* name) : registered_(ThreadRegistry::isEnabled()) {
+		if (registered_) {
+			id_ = ThreadRegistry::getInstance().enter(name);
+		}
+	}
+
+	~ThreadScope() {
+		if (registered_) {
+			ThreadRegistry::getInstance().exit(id_);
+		}
+	}
+
+	ThreadScope(ThreadScope const&) = delete;
+	void operator=(ThreadScope const&) = delete;
+};
+
+} /* namespace client */
+
+#endif /* METRICS_THREAD_STATS_HPP_ */
@@ -0,0 +1,175 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef RECORDER_FLIGHT_RECORDER_HPP_
+#define RECORDER_FLIGHT_RECORDER_HPP_
+
+#include "constants/response_packet.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace client {
+
+/**
+ * RecorderStage - the step of the processing of a request stored in a FlightRecord.
+ * The values are shared by the client and the server and written in the dumps: only append new stages.
+ */
+enum RecorderStage {
+	STAGE_REQUEST_START = 0, // server: request passed to the engine [code: request, size: data]
+	STAGE_REQUEST_RESENT, // server: request sent again after the client reconnected
+	STAGE_REQUEST_END, // server: result returned [code: first error code, size: response]
+	STAGE_SOCKET_SEND, // packet sent [client: socket, code: 0 or -1 on error, size: bytes]
+	STAGE_SOCKET_RECEIVE, // packet received [client: socket, code: 0 or -1 on error, size: bytes]
+	STAGE_CLIENT_CONNECTED, // server: handshake completed
+	STAGE_CLIENT_DISCONNECTED, // server: client stopped
+	STAGE_EVENT, // event received or sent [code: event type]
+	STAGE_REQUEST_RECEIVED, // client: request decoded [client: channel, code: request, size: data]
+	STAGE_TERMINAL_START, // client: request started on the terminal
+	STAGE_TERMINAL_END, // client: request done by the terminal [code: first error code, size: response]
+	STAGE_RESPONSE_SENT, // client: response sent [code: first error code, size: bytes]
+	STAGE_COUNT
+};
+
+/**
+ * recorderStageToString - convert a stage to the matching string description.
+ * @param stage the stage to be converted.
+ * @return the matching string description.
+ */
+inline const char* recorderStageToString(int stage) {
+	switch (stage) {
+	case STAGE_REQUEST_START:
+		return "REQUEST_START";
+	case STAGE_REQUEST_RESENT:
+		return "REQUEST_RESENT";
+	case STAGE_REQUEST_END:
+		return "REQUEST_END";
+	case STAGE_SOCKET_SEND:
+		return "SOCKET_SEND";
+	case STAGE_SOCKET_RECEIVE:
+		return "SOCKET_RECEIVE";
+	case STAGE_CLIENT_CONNECTED:
+		return "CLIENT_CONNECTED";
+	case STAGE_CLIENT_DISCONNECTED:
+		return "CLIENT_DISCONNECTED";
+	case STAGE_EVENT:
+		return "EVENT";
+	case STAGE_REQUEST_RECEIVED:
+		return "REQUEST_RECEIVED";
+	case STAGE_TERMINAL_START:
+		return "TERMINAL_START";
+	case STAGE_TERMINAL_END:
+		return "TERMINAL_END";
+	case STAGE_RESPONSE_SENT:
+		return "RESPONSE_SENT";
+	default:
+		return "[Unknown Stage]";
+	}
+}
+
+/**
+ * FlightRecord - fixed-size binary record of the flight recorder, written as is in the dumps.
+ */
+struct FlightRecord {
+	std::uint64_t timestamp; // microseconds since 1970-01-01 UTC
+	std::uint32_t id_client;
+	std::uint32_t id_request;
+	std::uint16_t stage;
+	std::uint16_t thread; // small number given to each recording thread
+	std::int32_t code;
+	std::uint32_t size;
+	std::uint32_t reserved;
+};
+
+/**
+ * FlightRecorderHeader - header of a dump, followed by "count" FlightRecords from the oldest to the newest.
+ */
+struct FlightRecorderHeader {
+	char magic[4]; // "GPFR"
+	std::uint16_t version;
+	std::uint16_t record_size;
+	char origin[8]; // "server" or "client"
+	std::uint32_t count;
+	std::uint32_t reserved;
+};
+
+#define FLIGHT_RECORDER_MAGIC "GPFR"
+#define FLIGHT_RECORDER_VERSION 1
+
+/**
+ * FlightRecorder - always-on ring of the last DEFAULT_RECORDER_SIZE FlightRecords, cheap enough to stay enabled in production.
+ * Recording takes no lock: each slot is guarded by a sequence number, so a dump skips the slots being overwritten.
+ */
+class FlightRecorder {
+public:
+	static FlightRecorder& getInstance() {
+		static FlightRecorder instance;
+		return instance;
+	}
+
+	/**
+	 * record - store a record, the oldest one is overwritten once the ring is full.
+	 * @param stage the processing step.
+	 * @param id_client the client's id, or the channel or the socket depending on the stage.
+	 * @param id_request the request's id, 0 if unknown.
+	 * @param code the code of the stage.
+	 * @param size the size of the stage's data.
+	 */
+	void record(RecorderStage stage, unsigned long id_client, unsigned long id_request, long code = 0, std::size_t size = 0);
+
+	/**
+	 * dump - write the records to a file, readable with tools/flight_decoder.cpp of the server.
+	 * @param path the file to write.
+	 * @return true if the file has been written.
+	 */
+	bool dump(std::string path);
+
+	/**
+	 * setErrorDump - set the file written when an error is reported with dumpOnError.
+	 * @param path the file to write, empty to disable the dumps on error.
+	 */
+	void setErrorDump(std::string path);
+
+	/**
+	 * dumpOnError - write the records to the error dump file in the background, at most once per DEFAULT_RECORDER_DUMP_INTERVAL.
+	 */
+	void dumpOnError();
+private:
+	struct Slot {
+		std::atomic<std::uint64_t> sequence { 0 }; // odd while the record is written
+		FlightRecord record;
+	};
+
+	FlightRecorder();
+	std::unique_ptr<Slot[]> slots_;
+	std::atomic<std::uint64_t> next_ { 0 };
+	std::mutex error_dump_mutex_;
+	std::string error_dump_path_;
+	std::int64_t last_error_dump_ = 0;
+	std::atomic<bool> dumping_ { false };
+public:
+	FlightRecorder(FlightRecorder const&) = delete;
+	void operator=(FlightRecorder const&) = delete;
+};
+
+} /* namespace client */
+
+#endif /* RECORDER_FLIGHT_RECORDER_HPP_ */
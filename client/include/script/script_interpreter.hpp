@@ -0,0 +1,67 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_SCRIPT_INTERPRETER_HPP_
+#define SRC_SCRIPT_INTERPRETER_HPP_
+
+#include "constants/response_packet.hpp"
+#include "terminal/terminals/terminal.hpp"
+
+#include <string>
+#include <vector>
+
+namespace client {
+
+/**
+ * ScriptInterpreter - execute the APDU scripts compiled by the server (see constants/script_opcode.hpp) on a terminal.
+ * The whole script runs locally, so that a sequence of commands costs a single round trip with the server.
+ */
+class ScriptInterpreter {
+private:
+	unsigned long max_steps_;
+public:
+	ScriptInterpreter(unsigned long max_steps) {
+		this->max_steps_ = max_steps;
+	}
+	~ScriptInterpreter() = default;
+
+	/**
+	 * validate - check that the given program is well formed: known opcodes, complete operands, valid variables and jump addresses.
+	 * @param program the compiled script.
+	 * @param error the reason why the program is invalid.
+	 * @return a boolean indicating whether the program can be executed.
+	 */
+	bool validate(const std::vector<unsigned char>& program, std::string* error);
+
+	/**
+	 * run - execute the given program on the terminal.
+	 * The "response" field contains the transcript of the script formatted this way: Command|Response|...|...
+	 * The transcript is also returned when the script fails.
+	 * @param terminal the terminal to send the commands to.
+	 * @param program the compiled script, already validated.
+	 * @param variables the script's parameters, assigned to the variables $0..$n.
+	 * @return a ResponsePacket struct containing either the transcript or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket run(ITerminalLayer* terminal, const std::vector<unsigned char>& program, std::vector<std::vector<unsigned char>> variables);
+private:
+	bool matchStatusWord(const std::vector<unsigned char>& response, const unsigned char* pattern);
+	ResponsePacket scriptError(std::string transcript, std::string description);
+};
+
+} /* namespace client */
+
+#endif /* SRC_SCRIPT_INTERPRETER_HPP_ */
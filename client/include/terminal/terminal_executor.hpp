@@ -0,0 +1,136 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef TERMINAL_TERMINAL_EXECUTOR_H_
+#define TERMINAL_TERMINAL_EXECUTOR_H_
+
+#include "constants/response_packet.hpp"
+#include "metrics/lock_stats.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace client {
+
+/**
+ * TerminalExecutor - single long-lived thread owning all accesses to a terminal.
+ * PC/SC handles are bound to the thread that uses them, so every terminal call goes
+ * through this executor instead of a new thread per request.
+ */
+class TerminalExecutor {
+public:
+	enum class TaskState { QUEUED, RUNNING, DONE, CANCELLED, EXPIRED };
+
+	struct Task {
+		std::function<ResponsePacket()> work;
+		std::function<void(ResponsePacket)> on_complete;
+		std::chrono::steady_clock::time_point deadline;
+		std::atomic<TaskState> state { TaskState::QUEUED };
+		std::atomic<bool> completed { false }; // the result is delivered once, by the worker or at the deadline
+		std::promise<ResponsePacket> promise;
+		std::future<ResponsePacket> result;
+	};
+	typedef std::shared_ptr<Task> TaskHandle;
+private:
+	std::thread worker_;
+	std::deque<TaskHandle> queue_;
+	InstrumentedMutex queue_mutex_ { "executor_queue_mutex" };
+	std::condition_variable_any queue_cv_;
+	std::atomic<bool> stop_ { false };
+	std::atomic<bool> started_ { false };
+	std::function<void()> idle_handler_;
+	std::chrono::milliseconds idle_delay_ { 0 };
+	std::thread watchdog_;
+	std::condition_variable_any watchdog_cv_;
+	std::multimap<std::chrono::steady_clock::time_point, TaskHandle> watched_; // tasks completed at their deadline, even if running
+public:
+	TerminalExecutor() = default;
+	~TerminalExecutor();
+
+	/**
+	 * start - launch the worker thread and the thread completing the tasks whose deadline has passed.
+	 */
+	void start();
+
+	/**
+	 * stop - reject new work, cancel queued work and join the worker and watchdog threads.
+	 * The task being executed, if any, is allowed to complete.
+	 * Must not be called from the worker thread (a task, the idle handler or a completion callback), nor the executor destroyed there.
+	 */
+	void stop();
+
+	/**
+	 * submit - queue a work item for the worker thread.
+	 * @param work the work to be performed on the terminal.
+	 * @param timeout the time after which the work is dropped if it did not start yet.
+	 * @param on_complete called with the result once the work is done, dropped or cancelled (optional). A task with a
+	 * callback is also completed with ERR_TIMEOUT when its timeout elapses while it runs, its late result being dropped.
+	 * @return a handle used to wait for the result or to cancel the work.
+	 */
+	TaskHandle submit(std::function<ResponsePacket()> work, std::chrono::milliseconds timeout, std::function<void(ResponsePacket)> on_complete = nullptr);
+
+	/**
+	 * execute - perform the given work on the worker thread and wait for its result.
+	 * The work is run inline when called from the worker thread itself.
+	 * @param work the work to be performed on the terminal.
+	 * @return a ResponsePacket struct containing the result of the work.
+	 */
+	ResponsePacket execute(std::function<ResponsePacket()> work);
+
+	/**
+	 * cancel - cancel a work item that has not been started yet.
+	 * @param task the work item to cancel.
+	 * @return true if the work item will not be executed, false if it is already running or done.
+	 */
+	bool cancel(TaskHandle task);
+
+	/**
+	 * setIdleHandler - set the function called on the worker thread once no work has been submitted for the given delay.
+	 * The handler is called once per idle period.
+	 * @param idle_handler the function to call.
+	 * @param idle_delay the time without work after which the handler is called.
+	 */
+	void setIdleHandler(std::function<void()> idle_handler, std::chrono::milliseconds idle_delay);
+
+	/**
+	 * getQueueDepth - return the number of work items waiting to be executed.
+	 * @return the queue depth.
+	 */
+	std::size_t getQueueDepth();
+
+	/**
+	 * isWorkerThread - check whether the caller is the worker thread.
+	 * @return true if called from the worker thread.
+	 */
+	bool isWorkerThread();
+private:
+	void run();
+	void watch();
+	void complete(TaskHandle task, ResponsePacket response_packet);
+};
+
+} /* namespace client */
+
+#endif /* TERMINAL_TERMINAL_EXECUTOR_H_ */
@@ -0,0 +1,172 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef TERMINAL_TERMINAL_STATE_H_
+#define TERMINAL_TERMINAL_STATE_H_
+
+#include "constants/event_type.hpp"
+#include "constants/response_packet.hpp"
+#include "metrics/lock_stats.hpp"
+#include "nlohmann/json.hpp"
+
+#include <mutex>
+#include <string>
+
+namespace client {
+
+enum CardState {
+	CARD_UNKNOWN = 0,
+	CARD_ABSENT,
+	CARD_PRESENT,
+	CARD_SWALLOWED,
+	CARD_POWERED,
+	CARD_NEGOTIABLE,
+	CARD_SPECIFIC
+};
+
+enum CardProtocol {
+	PROTOCOL_UNKNOWN = 0,
+	PROTOCOL_RAW,
+	PROTOCOL_T0,
+	PROTOCOL_T1
+};
+
+/**
+ * TerminalState - structured diagnostic of a terminal, sent as json for a structured REQ_DIAG.
+ */
+struct TerminalState {
+	std::string reader;
+	CardState card_state = CARD_UNKNOWN;
+	CardProtocol protocol = PROTOCOL_UNKNOWN;
+	std::string atr;
+	long int last_error_code = SUCCESS;
+	std::string last_error_description = "OK";
+	unsigned long int commands = 0;
+	unsigned long int errors = 0;
+	unsigned long int resets = 0;
+	unsigned long int card_insertions = 0;
+	unsigned long int card_removals = 0;
+};
+
+// https://github.com/nlohmann/json#arbitrary-types-conversions
+// Used to serialize the TerminalState struct in JSON format.
+inline void to_json(nlohmann::json& j, const TerminalState& e) {
+	j = {
+		{ "reader", e.reader }, { "card_state", e.card_state }, { "protocol", e.protocol }, { "atr", e.atr },
+		{ "last_error_code", e.last_error_code }, { "last_error_description", e.last_error_description },
+		{ "commands", e.commands }, { "errors", e.errors }, { "resets", e.resets },
+		{ "card_insertions", e.card_insertions }, { "card_removals", e.card_removals }
+	};
+}
+
+/**
+ * TerminalStateCache - state of a terminal kept up to date with the results of the requests executed by its executor
+ * and with the card events, so that REQ_DIAG is answered without accessing the reader.
+ * The card state and protocol are read from the terminal again after a terminal error.
+ */
+class TerminalStateCache {
+private:
+	TerminalState state_;
+	bool status_known_ = false;
+	bool monitored_ = false; // the card events are received, the cached card state follows the insertions and removals
+	InstrumentedMutex mutex_ { "terminal_state_mutex" };
+public:
+	TerminalStateCache() = default;
+	~TerminalStateCache() = default;
+
+	/**
+	 * reset - forget the state of the previous reader, the counters are reset.
+	 * @param reader the reader the terminal is connected to.
+	 */
+	void reset(std::string reader);
+
+	/**
+	 * setMonitored - tell whether the reader's events are monitored, without which the card state cannot be answered from the cache.
+	 * @param monitored true while the monitoring of the terminal is running.
+	 */
+	void setMonitored(bool monitored);
+
+	/**
+	 * isMonitored - check whether the reader's events are monitored.
+	 * @return true if the card insertions and removals update the cache.
+	 */
+	bool isMonitored();
+
+	/**
+	 * invalidate - forget the card state, protocol and ATR so that they are read from the terminal again.
+	 */
+	void invalidate();
+
+	/**
+	 * setStatus - store the card state, protocol and ATR read from the terminal.
+	 * @param status the state returned by the terminal.
+	 */
+	void setStatus(TerminalState status);
+
+	/**
+	 * recordResult - update the state with the result of a request executed on the terminal.
+	 * @param request the request's code.
+	 * @param response_packet the request's result.
+	 */
+	void recordResult(int request, ResponsePacket response_packet);
+
+	/**
+	 * recordEvent - update the state with an event raised by the monitoring of the reader.
+	 * @param event the event's type.
+	 * @param data the event's data.
+	 */
+	void recordEvent(EventType event, std::string data);
+
+	/**
+	 * diag - answer a REQ_DIAG from the cached state.
+	 * The "response" field contains either the json TerminalState or the string returned by the terminals' diag.
+	 * @param structured whether the json TerminalState is returned.
+	 * @param response_packet the answer to the request.
+	 * @return false if the card state is not known or not monitored and must be read from the terminal.
+	 */
+	bool diag(bool structured, ResponsePacket* response_packet);
+
+	/**
+	 * isStatusKnown - check whether the card state, protocol and ATR are known.
+	 * @return false if they must be read from the terminal.
+	 */
+	bool isStatusKnown();
+
+	/**
+	 * getState - return a copy of the cached state.
+	 * @return the terminal's state.
+	 */
+	TerminalState getState();
+};
+
+/**
+ * cardStateToString - convert a card state to the description returned by the terminals' diag.
+ * @param card_state the card state to be converted.
+ * @return the matching description.
+ */
+std::string cardStateToString(CardState card_state);
+
+/**
+ * cardProtocolToString - convert a protocol to the description returned by the terminals' diag.
+ * @param protocol the protocol to be converted.
+ * @return the matching description.
+ */
+std::string cardProtocolToString(CardProtocol protocol);
+
+} /* namespace client */
+
+#endif /* TERMINAL_TERMINAL_STATE_H_ */
@@ -21,6 +21,7 @@
 #define DEFAULT_BUFLEN 1024 * 64
 
 #include "terminal/terminals/terminal.hpp"
+#include "terminal/terminals/pcsc_monitor.hpp"
 #include "constants/response_packet.hpp"
 
 #include <map>
@@ -37,16 +38,18 @@ private:
 	DWORD dwReaders_, dwActiveProtocol_, dwRecvLength_;
 	SCARD_IO_REQUEST pioSendPci_;
 	BYTE pbRecvBuffer_[DEFAULT_BUFLEN];
+	bool t0_chaining_ = false;
+	PCSCMonitor monitor_;
 public:
 	ExampleTerminalPCSCContact() = default;
 	~ExampleTerminalPCSCContact();
 	ResponsePacket init() override;
 	ResponsePacket loadAndListReaders() override;
 	ResponsePacket connect(const char* reader) override;
-	ResponsePacket sendCommand(unsigned char command[], unsigned long int command_length) override;
-	ResponsePacket sendTypeA(unsigned char command[], unsigned long int command_length) override;
-	ResponsePacket sendTypeB(unsigned char command[], unsigned long int command_length) override;
-	ResponsePacket sendTypeF(unsigned char command[], unsigned long int command_length) override;
+	ResponsePacket sendCommand(const Apdu& command) override;
+	ResponsePacket sendTypeA(const Apdu& command) override;
+	ResponsePacket sendTypeB(const Apdu& command) override;
+	ResponsePacket sendTypeF(const Apdu& command) override;
 	ResponsePacket diag() override;
 	ResponsePacket disconnect() override;
 	ResponsePacket isAlive() override;
@@ -55,7 +58,11 @@ public:
 	ResponsePacket warmReset() override;
 	ResponsePacket powerOFFField() override;
 	ResponsePacket powerONField() override;
+	ResponsePacket getStatus(TerminalState* state) override;
+	ResponsePacket startMonitoring(EventHandler on_event, bool watch_readers) override;
+	void stopMonitoring() override;
 private:
+	ResponsePacket transmit(const Apdu& command);
 	ResponsePacket handleErrorResponse(std::string context_message, LONG error);
 	ResponsePacket retrieveAtr(BYTE* bAttr, DWORD* cByte);
 	std::string errorToString(LONG error);
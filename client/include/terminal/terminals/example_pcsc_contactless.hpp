@@ -21,6 +21,7 @@
 #define DEFAULT_BUFLEN 1024 * 64
 
 #include "terminal/terminals/terminal.hpp"
+#include "terminal/terminals/pcsc_monitor.hpp"
 #include "constants/response_packet.hpp"
 
 #include <map>
@@ -30,6 +31,8 @@
 namespace client {
 
 class ExampleTerminalPCSCContactless: public ITerminalLayer {
+public:
+	enum class PollingMode { DEFAULT, TYPE_A, TYPE_B, UNKNOWN };
 private:
 	std::string current_reader_;
 	SCARDCONTEXT hContext_;
@@ -38,16 +41,21 @@ private:
 	DWORD dwReaders_, dwActiveProtocol_, dwRecvLength_;
 	SCARD_IO_REQUEST pioSendPci_;
 	BYTE pbRecvBuffer_[DEFAULT_BUFLEN];
+	bool t0_chaining_ = false;
+	PCSCMonitor monitor_;
+	PollingMode polling_mode_ = PollingMode::DEFAULT;
+	unsigned long int typed_commands_ = 0;
+	unsigned long int polling_transmits_ = 0;
 public:
 	ExampleTerminalPCSCContactless() = default;
 	~ExampleTerminalPCSCContactless();
 	ResponsePacket init() override;
 	ResponsePacket loadAndListReaders() override;
 	ResponsePacket connect(const char* reader) override;
-	ResponsePacket sendCommand(unsigned char command[], unsigned long int command_length) override;
-	ResponsePacket sendTypeA(unsigned char command[], unsigned long int command_length) override;
-	ResponsePacket sendTypeB(unsigned char command[], unsigned long int command_length) override;
-	ResponsePacket sendTypeF(unsigned char command[], unsigned long int command_length) override;
+	ResponsePacket sendCommand(const Apdu& command) override;
+	ResponsePacket sendTypeA(const Apdu& command) override;
+	ResponsePacket sendTypeB(const Apdu& command) override;
+	ResponsePacket sendTypeF(const Apdu& command) override;
 	ResponsePacket diag() override;
 	ResponsePacket disconnect() override;
 	ResponsePacket isAlive() override;
@@ -56,7 +64,25 @@ public:
 	ResponsePacket warmReset() override;
 	ResponsePacket powerOFFField() override;
 	ResponsePacket powerONField() override;
+	ResponsePacket getStatus(TerminalState* state) override;
+	ResponsePacket startMonitoring(EventHandler on_event, bool watch_readers) override;
+	void stopMonitoring() override;
+
+	/**
+	 * onIdle - restore the default polling (type A + type B + FeliCa) if a single type is being polled.
+	 */
+	void onIdle() override;
+
+	/**
+	 * getAvoidedPollingTransmits - return the number of polling commands saved by keeping the polling mode between typed commands.
+	 * Each typed command used to switch the polling mode and restore it afterwards.
+	 * @return the number of polling commands not sent.
+	 */
+	unsigned long int getAvoidedPollingTransmits();
 private:
+	ResponsePacket sendTyped(PollingMode mode, const Apdu& command);
+	ResponsePacket switchPollingMode(PollingMode mode);
+	ResponsePacket transmit(const Apdu& command);
 	ResponsePacket handleErrorResponse(std::string context_message, LONG error);
 	ResponsePacket retrieveAtr(BYTE* bAttr, DWORD* cByte);
 	std::string errorToString(LONG error);
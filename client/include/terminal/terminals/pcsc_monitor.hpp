@@ -0,0 +1,74 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef TERMINAL_TERMINALS_PCSC_MONITOR_H_
+#define TERMINAL_TERMINALS_PCSC_MONITOR_H_
+
+#include "terminal/terminals/terminal.hpp"
+#include "constants/response_packet.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <winscard.h>
+
+namespace client {
+
+/**
+ * PCSCMonitor - thread waiting on SCardGetStatusChange for the card insertions and removals on a reader
+ * and, through the PnP notification pseudo reader, for the readers plugged in or removed.
+ * The monitor has its own context so that it never shares the handles used by the terminal's executor.
+ */
+class PCSCMonitor {
+private:
+	SCARDCONTEXT hContext_ = 0;
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable stop_cv_;
+	std::atomic<bool> stop_ { true };
+	std::string reader_;
+	bool watch_readers_ = false;
+	ITerminalLayer::EventHandler on_event_;
+public:
+	PCSCMonitor() = default;
+	~PCSCMonitor();
+
+	/**
+	 * start - start monitoring the given reader, a monitoring already started is stopped first.
+	 * @param reader the reader whose card is monitored.
+	 * @param watch_readers whether the readers plugged in or removed are also notified.
+	 * @param on_event the function called with each event, from the monitoring thread.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket start(std::string reader, bool watch_readers, ITerminalLayer::EventHandler on_event);
+
+	/**
+	 * stop - cancel the pending SCardGetStatusChange and wait for the monitoring thread to end.
+	 */
+	void stop();
+private:
+	void run();
+	LONG listReaders(std::set<std::string>* readers);
+	void waitBeforeRetry();
+};
+
+} /* namespace client */
+
+#endif /* TERMINAL_TERMINALS_PCSC_MONITOR_H_ */
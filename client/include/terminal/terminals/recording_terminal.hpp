@@ -0,0 +1,72 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef TERMINAL_TERMINALS_RECORDING_TERMINAL_H_
+#define TERMINAL_TERMINALS_RECORDING_TERMINAL_H_
+
+#include "terminal/terminals/terminal.hpp"
+#include "terminal/terminals/utils/terminal_record.hpp"
+#include "constants/response_packet.hpp"
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace client {
+
+/**
+ * RecordingTerminal - decorator recording every call performed on a terminal, with its result and duration, to a binary file.
+ * The recording is replayed by the ReplayTerminal (see terminal/terminals/utils/terminal_record.hpp for the format).
+ */
+class RecordingTerminal: public ITerminalLayer {
+private:
+	ITerminalLayer* terminal_;
+	std::ofstream file_;
+public:
+	/**
+	 * RecordingTerminal - record the calls performed on the given terminal, which is then owned by the recorder.
+	 * @param terminal the recorded terminal.
+	 * @param path the recording's file, overwritten if it exists.
+	 */
+	RecordingTerminal(ITerminalLayer* terminal, std::string path);
+	~RecordingTerminal();
+	ResponsePacket init() override;
+	ResponsePacket loadAndListReaders() override;
+	ResponsePacket connect(const char* reader) override;
+	ResponsePacket sendCommand(const Apdu& command) override;
+	ResponsePacket sendTypeA(const Apdu& command) override;
+	ResponsePacket sendTypeB(const Apdu& command) override;
+	ResponsePacket sendTypeF(const Apdu& command) override;
+	ResponsePacket diag() override;
+	ResponsePacket disconnect() override;
+	ResponsePacket isAlive() override;
+	ResponsePacket restart() override;
+	ResponsePacket coldReset() override;
+	ResponsePacket warmReset() override;
+	ResponsePacket powerOFFField() override;
+	ResponsePacket powerONField() override;
+	void onIdle() override;
+	ResponsePacket startMonitoring(EventHandler on_event, bool watch_readers) override;
+	void stopMonitoring() override;
+private:
+	ResponsePacket record(utils::RecordMethod method, std::vector<unsigned char> argument, std::function<ResponsePacket()> call);
+};
+
+} /* namespace client */
+
+#endif /* TERMINAL_TERMINALS_RECORDING_TERMINAL_H_ */
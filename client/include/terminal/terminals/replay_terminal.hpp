@@ -0,0 +1,80 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef TERMINAL_TERMINALS_REPLAY_TERMINAL_H_
+#define TERMINAL_TERMINALS_REPLAY_TERMINAL_H_
+
+#include "terminal/terminals/terminal.hpp"
+#include "terminal/terminals/utils/terminal_record.hpp"
+#include "constants/response_packet.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace client {
+
+enum ReplayTerminalError {
+	ERR_REPLAY_FILE = -1, // the recording cannot be loaded
+	ERR_REPLAY_MISMATCH = -2, // the call differs from the recorded one
+	ERR_REPLAY_END = -3 // every recorded call has been replayed
+};
+
+/**
+ * ReplayTerminal - terminal serving the results of a recording made by the RecordingTerminal, in the recorded order.
+ * The "replay_timing" configuration value is either
+ * "recorded", to wait as long as the recorded calls took, or "fast" to answer immediately.
+ * A call differing from the next recorded one (method or command) fails, so that reruns are deterministic.
+ */
+class ReplayTerminal: public ITerminalLayer {
+private:
+	std::string path_;
+	std::shared_ptr<const std::vector<utils::TerminalRecord>> records_;
+	std::size_t position_ = 0;
+	bool recorded_timing_ = false;
+public:
+	/**
+	 * ReplayTerminal - replay the given recording.
+	 * @param path the recording's file.
+	 */
+	ReplayTerminal(std::string path) {
+		this->path_ = path;
+	}
+	~ReplayTerminal() = default;
+	ResponsePacket init() override;
+	ResponsePacket loadAndListReaders() override;
+	ResponsePacket connect(const char* reader) override;
+	ResponsePacket sendCommand(const Apdu& command) override;
+	ResponsePacket sendTypeA(const Apdu& command) override;
+	ResponsePacket sendTypeB(const Apdu& command) override;
+	ResponsePacket sendTypeF(const Apdu& command) override;
+	ResponsePacket diag() override;
+	ResponsePacket disconnect() override;
+	ResponsePacket isAlive() override;
+	ResponsePacket restart() override;
+	ResponsePacket coldReset() override;
+	ResponsePacket warmReset() override;
+	ResponsePacket powerOFFField() override;
+	ResponsePacket powerONField() override;
+private:
+	ResponsePacket replay(utils::RecordMethod method, const unsigned char* argument, unsigned long int argument_length);
+	ResponsePacket handleErrorResponse(std::string context_message, long int error);
+};
+
+} /* namespace client */
+
+#endif /* TERMINAL_TERMINALS_REPLAY_TERMINAL_H_ */
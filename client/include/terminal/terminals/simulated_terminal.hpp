@@ -0,0 +1,118 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef TERMINAL_TERMINALS_SIMULATED_TERMINAL_H_
+#define TERMINAL_TERMINALS_SIMULATED_TERMINAL_H_
+
+#include "terminal/terminals/terminal.hpp"
+#include "constants/response_packet.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace client {
+
+enum SimulatedTerminalError {
+	ERR_SIMULATED_CARD_FILE = -1, // the rule file cannot be loaded
+	ERR_SIMULATED_NO_READER = -2, // unknown reader or terminal not connected
+	ERR_SIMULATED_NO_FIELD = -3, // the field is off
+	ERR_SIMULATED_INJECTED = -4 // error injected according to the rule file's error rate
+};
+
+/**
+ * SimulatedLatency - distribution of the time taken by the simulated card to answer, in milliseconds.
+ * "fixed": value; "uniform": min and max; "normal": mean and stddev; "exponential": mean.
+ */
+struct SimulatedLatency {
+	std::string distribution = "fixed";
+	double first = 0; // value, min or mean
+	double second = 0; // max or stddev
+};
+
+/**
+ * SimulatedRule - response of the simulated card to the commands matching a pattern.
+ * The pattern is made of hexadecimal bytes, "XX" matching any byte and a final "*" matching any remaining bytes.
+ */
+struct SimulatedRule {
+	std::vector<unsigned char> pattern;
+	std::vector<bool> wildcards;
+	bool prefix = false;
+	std::string state; // state required for the rule to apply, any state if empty
+	std::string next_state; // state entered once the rule applied, unchanged if empty
+	std::string response;
+	bool has_latency = false;
+	SimulatedLatency latency;
+};
+
+/**
+ * SimulatedCard - content of a rule file, shared by all the terminals using the same file.
+ */
+struct SimulatedCard {
+	std::vector<std::string> readers;
+	std::string atr;
+	std::string warm_atr;
+	std::string default_response;
+	SimulatedLatency latency;
+	double error_rate = 0;
+	std::vector<SimulatedRule> rules;
+};
+
+/**
+ * SimulatedTerminal - terminal emulating a card from a rule file, without reader nor WinSCard.
+ * The rule file is given by the "simulated_card" configuration value, see config/simulated_card.json for its format.
+ * A card answering "90 00" to every command is emulated when no rule file is given.
+ * Resets and field power on bring the card back to its initial state, commands fail while the field is off.
+ */
+class SimulatedTerminal: public ITerminalLayer {
+private:
+	std::shared_ptr<const SimulatedCard> card_;
+	std::string current_reader_;
+	std::string state_;
+	bool connected_ = false;
+	bool field_on_ = true;
+	std::mt19937 generator_;
+public:
+	SimulatedTerminal();
+	~SimulatedTerminal() = default;
+	ResponsePacket init() override;
+	ResponsePacket loadAndListReaders() override;
+	ResponsePacket connect(const char* reader) override;
+	ResponsePacket sendCommand(const Apdu& command) override;
+	ResponsePacket sendTypeA(const Apdu& command) override;
+	ResponsePacket sendTypeB(const Apdu& command) override;
+	ResponsePacket sendTypeF(const Apdu& command) override;
+	ResponsePacket diag() override;
+	ResponsePacket disconnect() override;
+	ResponsePacket isAlive() override;
+	ResponsePacket restart() override;
+	ResponsePacket coldReset() override;
+	ResponsePacket warmReset() override;
+	ResponsePacket powerOFFField() override;
+	ResponsePacket powerONField() override;
+private:
+	ResponsePacket checkCard();
+	ResponsePacket reset(std::string atr);
+	const SimulatedRule* findRule(const Apdu& command);
+	void simulateLatency(const SimulatedLatency& latency);
+	ResponsePacket handleErrorResponse(std::string context_message, long int error);
+};
+
+} /* namespace client */
+
+#endif /* TERMINAL_TERMINALS_SIMULATED_TERMINAL_H_ */
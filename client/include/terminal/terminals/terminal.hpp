@@ -18,14 +18,21 @@ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and
 #ifndef TERMINAL_LAYER_H_
 #define TERMINAL_LAYER_H_
 
+#include "constants/apdu.hpp"
+#include "constants/event_type.hpp"
 #include "constants/response_packet.hpp"
+#include "terminal/terminal_state.hpp"
 
+#include <functional>
+#include <string>
 #include <windows.h>
 
 namespace client {
 
 class ITerminalLayer {
 public:
+	typedef std::function<void(EventType event, std::string reader, std::string data)> EventHandler;
+
 	ITerminalLayer() = default;
 	virtual ~ITerminalLayer() {};
 
@@ -53,34 +60,30 @@ public:
 	/**
 	 * sendCommand - send an APDU command to the terminal.
 	 * @param command the command to be sent to the smartcard.
-	 * @param command_length the length of the given command.
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
-	virtual ResponsePacket sendCommand(unsigned char command[],  unsigned long int command_length) = 0;
+	virtual ResponsePacket sendCommand(const Apdu& command) = 0;
 
 	/**
 	 * sendTypeA - send an APDU command over RF Type A
 	 * @param command the APDU command to be sent to the smartcard.
-	 * @param command_length the length of the given APDU command.
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
-	virtual ResponsePacket sendTypeA(unsigned char command[],  unsigned long int command_length) = 0;
+	virtual ResponsePacket sendTypeA(const Apdu& command) = 0;
 
 	/**
 	 * sendTypeB - send an APDU command over RF Type B
 	 * @param command the APDU command to be sent to the smartcard.
-	 * @param command_length the length of the given APDU command.
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
-	virtual ResponsePacket sendTypeB(unsigned char command[],  unsigned long int command_length) = 0;
+	virtual ResponsePacket sendTypeB(const Apdu& command) = 0;
 
 	/**
 	 * sendTypeF - send an APDU command over RF Type F
 	 * @param command the APDU command to be sent to the smartcard.
-	 * @param command_length the length of the given APDU command.
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
-	virtual ResponsePacket sendTypeF(unsigned char command[],  unsigned long int command_length) = 0;
+	virtual ResponsePacket sendTypeF(const Apdu& command) = 0;
 
 	/**
 	 * diag - diagnose the used terminal.
@@ -131,6 +134,43 @@ public:
  	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
 	 */
 	virtual ResponsePacket powerONField() = 0;
+
+	/**
+	 * getStatus - read the card state, protocol and ATR from the reader with a single call, used to fill the diagnostic cache.
+	 * Not supported by default: the diagnostic is then always performed by diag.
+	 * @param state the state to fill.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions, "Not supported" in the
+	 * "response" field if the terminal cannot provide its state.
+	 */
+	virtual ResponsePacket getStatus(TerminalState* state) {
+		ResponsePacket response;
+		response.response = "Not supported";
+		return response;
+	};
+
+	/**
+	 * onIdle - called when no request has been received for a while, to restore settings kept across requests.
+	 * Nothing is done by default.
+	 */
+	virtual void onIdle() {};
+
+	/**
+	 * startMonitoring - start notifying the card insertions and removals and the errors of the connected reader, on a thread of the terminal.
+	 * Not supported by default.
+	 * @param on_event the function called with each event, from the monitoring thread.
+	 * @param watch_readers whether the readers plugged in or removed are also notified.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	virtual ResponsePacket startMonitoring(EventHandler on_event, bool watch_readers) {
+		ResponsePacket response;
+		response.response = "Not supported";
+		return response;
+	};
+
+	/**
+	 * stopMonitoring - stop notifying the events and wait for the monitoring thread to end.
+	 */
+	virtual void stopMonitoring() {};
 };
 
 } /* namespace client */
@@ -0,0 +1,107 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef UTILS_APDU_CHAINING_H_
+#define UTILS_APDU_CHAINING_H_
+
+#include "constants/apdu.hpp"
+#include "constants/response_packet.hpp"
+#include "terminal/terminals/utils/type_converter.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#define MAX_CHAINED_EXCHANGES 64 // GET RESPONSE commands sent for a single command, guards against cards answering 61xx forever
+
+namespace utils {
+
+/**
+ * canCorrectLe - check whether the command ends with an Le byte (or has no body at all) that can be replaced after a 6Cxx.
+ */
+inline bool canCorrectLe(const client::Apdu& command) {
+	return command.size() == 4 || command.size() == 5 || (command.size() > 5 && command.size() == 5u + command[4] + 1);
+}
+
+/**
+ * getResponseClass - return the class byte of a GET RESPONSE on the logical channel of the given class byte (ISO 7816-4).
+ * The further interindustry classes (0x40 to 0x7F) code the channels 4 to 19 in bits 0 to 3, the first ones the channels 0 to 3 in bits 0 and 1.
+ */
+inline unsigned char getResponseClass(unsigned char cla) {
+	return (cla & 0x40) ? (cla & 0x4F) : (cla & 0x03);
+}
+
+/**
+ * transmitWithChaining - send a command and handle locally the status words of T=0 cards.
+ * 61xx is followed by GET RESPONSE commands until all the data is received, 6Cxx resends the command with Le = xx.
+ * The "response" field contains the assembled response: the data of every exchange followed by the last status word.
+ * The "transcript" field contains every exchange formatted this way: Command|Response|...|... (empty if a single exchange was needed).
+ * @param transmit the function sending a single command to the card.
+ * @param command the command to send.
+ * @return a ResponsePacket struct containing either the assembled response or error codes (under 0) and error descriptions.
+ */
+inline client::ResponsePacket transmitWithChaining(std::function<client::ResponsePacket(const client::Apdu&)> transmit, const client::Apdu& command) {
+	client::Apdu current = command;
+	client::Apdu received;
+	std::vector<unsigned char> assembled;
+	std::string transcript;
+	bool le_corrected = false;
+
+	for (int exchanges = 1; ; exchanges++) {
+		client::ResponsePacket response = transmit(current);
+		if (response.err_terminal_code < 0 || response.err_card_code < 0) {
+			return response;
+		}
+		transcript += current.toHex() + "|" + response.response + "|";
+		received.assignHex(response.response);
+
+		unsigned char sw1 = received.size() >= 2 ? received[received.size() - 2] : 0x00;
+		unsigned char sw2 = received.size() >= 2 ? received[received.size() - 1] : 0x00;
+		bool can_chain = exchanges < MAX_CHAINED_EXCHANGES;
+
+		// wrong Le: resend the same command once with the length given by the card
+		if (sw1 == 0x6C && can_chain && !le_corrected && canCorrectLe(current)) {
+			if (current.size() == 4) {
+				current.resize(5);
+			}
+			current[current.size() - 1] = sw2;
+			le_corrected = true;
+			continue;
+		}
+
+		// more data available: the status word is replaced by the data of the next GET RESPONSE
+		if (sw1 == 0x61 && can_chain) {
+			assembled.insert(assembled.end(), received.data(), received.data() + received.size() - 2);
+			current = { getResponseClass(command[0]), 0xC0, 0x00, 0x00, sw2 }; // same logical channel as the command
+			le_corrected = false;
+			continue;
+		}
+
+		assembled.insert(assembled.end(), received.data(), received.data() + received.size());
+		response.response = unsignedCharToString(assembled.data(), assembled.size());
+		if (exchanges > 1) {
+			LOG_DEBUG << "Command completed locally [exchanges:" << exchanges << "]";
+			response.transcript = transcript;
+		}
+		return response;
+	}
+}
+
+} // namespace utils
+
+#endif /* UTILS_APDU_CHAINING_H_ */
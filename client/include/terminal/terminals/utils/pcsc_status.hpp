@@ -0,0 +1,71 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef UTILS_PCSC_STATUS_H_
+#define UTILS_PCSC_STATUS_H_
+
+#include "terminal/terminal_state.hpp"
+
+#include <winscard.h>
+
+namespace utils {
+
+/**
+ * toCardState - convert the state returned by SCardStatus.
+ * @param dwState the state returned by SCardStatus.
+ * @return the matching card state.
+ */
+inline client::CardState toCardState(DWORD dwState) {
+	switch (dwState) {
+	case SCARD_ABSENT:
+		return client::CARD_ABSENT;
+	case SCARD_PRESENT:
+		return client::CARD_PRESENT;
+	case SCARD_SWALLOWED:
+		return client::CARD_SWALLOWED;
+	case SCARD_POWERED:
+		return client::CARD_POWERED;
+	case SCARD_NEGOTIABLE:
+		return client::CARD_NEGOTIABLE;
+	case SCARD_SPECIFIC:
+		return client::CARD_SPECIFIC;
+	default:
+		return client::CARD_UNKNOWN;
+	}
+}
+
+/**
+ * toCardProtocol - convert the protocol returned by SCardStatus or SCardConnect.
+ * @param dwProtocol the protocol returned by PC/SC.
+ * @return the matching protocol.
+ */
+inline client::CardProtocol toCardProtocol(DWORD dwProtocol) {
+	switch (dwProtocol) {
+	case SCARD_PROTOCOL_RAW:
+		return client::PROTOCOL_RAW;
+	case SCARD_PROTOCOL_T0:
+		return client::PROTOCOL_T0;
+	case SCARD_PROTOCOL_T1:
+		return client::PROTOCOL_T1;
+	default:
+		return client::PROTOCOL_UNKNOWN;
+	}
+}
+
+} // namespace utils
+
+#endif /* UTILS_PCSC_STATUS_H_ */
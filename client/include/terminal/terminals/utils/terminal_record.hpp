@@ -0,0 +1,197 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef UTILS_TERMINAL_RECORD_H_
+#define UTILS_TERMINAL_RECORD_H_
+
+#include "constants/response_packet.hpp"
+#include "terminal/terminals/utils/type_converter.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Binary format of the terminal recordings, all integers being little-endian:
+ *   header: "SERC" followed by the format version (1 byte)
+ *   record: method (1 byte), flags (1 byte), duration in microseconds (4 bytes),
+ *           argument length (4 bytes) and bytes (command, or reader name for connect),
+ *           response length (4 bytes) and bytes (raw bytes if RECORD_FLAG_HEX_RESPONSE, text otherwise),
+ *           if RECORD_FLAG_ERROR: terminal error code (4 bytes), description length (4 bytes) and text,
+ *                                 card error code (4 bytes), description length (4 bytes) and text
+ */
+#define RECORD_MAGIC "SERC"
+#define RECORD_FORMAT_VERSION 0x01
+#define RECORD_FLAG_ERROR 0x01
+#define RECORD_FLAG_HEX_RESPONSE 0x02
+
+namespace utils {
+
+enum RecordMethod {
+	RECORD_INIT = 0,
+	RECORD_LOAD_AND_LIST_READERS = 1,
+	RECORD_CONNECT = 2,
+	RECORD_SEND_COMMAND = 3,
+	RECORD_SEND_TYPE_A = 4,
+	RECORD_SEND_TYPE_B = 5,
+	RECORD_SEND_TYPE_F = 6,
+	RECORD_DIAG = 7,
+	RECORD_DISCONNECT = 8,
+	RECORD_IS_ALIVE = 9,
+	RECORD_RESTART = 10,
+	RECORD_COLD_RESET = 11,
+	RECORD_WARM_RESET = 12,
+	RECORD_POWER_OFF_FIELD = 13,
+	RECORD_POWER_ON_FIELD = 14
+};
+
+/**
+ * TerminalRecord - a call performed on a terminal and its result.
+ */
+struct TerminalRecord {
+	unsigned char method;
+	std::uint32_t duration_us;
+	std::vector<unsigned char> argument;
+	client::ResponsePacket response;
+};
+
+inline void writeUint32(std::ostream& out, std::uint32_t value) {
+	unsigned char bytes[4] = { (unsigned char) value, (unsigned char) (value >> 8), (unsigned char) (value >> 16), (unsigned char) (value >> 24) };
+	out.write((const char*) bytes, sizeof(bytes));
+}
+
+inline bool readUint32(std::istream& in, std::uint32_t* value) {
+	unsigned char bytes[4];
+	if (!in.read((char*) bytes, sizeof(bytes))) {
+		return false;
+	}
+	*value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((std::uint32_t) bytes[3] << 24);
+	return true;
+}
+
+inline void writeBytes(std::ostream& out, const std::string& bytes) {
+	writeUint32(out, bytes.size());
+	out.write(bytes.data(), bytes.size());
+}
+
+inline bool readBytes(std::istream& in, std::string* bytes) {
+	std::uint32_t length;
+	if (!readUint32(in, &length)) {
+		return false;
+	}
+	bytes->resize(length);
+	return length == 0 || (bool) in.read(&(*bytes)[0], length);
+}
+
+/**
+ * recordingPath - return the file of the recording of the n-th terminal created by a factory.
+ * The first terminal uses the given path, the next ones the path followed by their index (capture.bin, capture.bin.1, ...).
+ * @param path the configured recording's file.
+ * @param index the index of the terminal.
+ * @return the recording's file of the terminal.
+ */
+inline std::string recordingPath(std::string path, unsigned int index) {
+	return index == 0 ? path : path + "." + std::to_string(index);
+}
+
+/**
+ * writeRecordHeader - write the header starting every recording.
+ * @param out the recording's stream.
+ */
+inline void writeRecordHeader(std::ostream& out) {
+	out.write(RECORD_MAGIC, 4);
+	out.put(RECORD_FORMAT_VERSION);
+}
+
+/**
+ * readRecordHeader - check the header starting every recording.
+ * @param in the recording's stream.
+ * @return a boolean indicating whether the stream is a recording in a supported format.
+ */
+inline bool readRecordHeader(std::istream& in) {
+	char header[5];
+	return in.read(header, sizeof(header)) && std::string(header, 4) == RECORD_MAGIC && header[4] == RECORD_FORMAT_VERSION;
+}
+
+/**
+ * writeRecord - append a record to a recording.
+ * Hexadecimal responses ("90 00") are stored as raw bytes, which divides their size by 3.
+ * @param out the recording's stream.
+ * @param record the record to write.
+ */
+inline void writeRecord(std::ostream& out, const TerminalRecord& record) {
+	const client::ResponsePacket& response = record.response;
+	bool error = response.err_terminal_code != client::SUCCESS || response.err_card_code != client::SUCCESS;
+
+	// responses are converted back and forth to check that the conversion is lossless
+	unsigned long int length;
+	unsigned char* bytes = stringToUnsignedChar(response.response, &length);
+	std::string raw((const char*) bytes, length);
+	delete[] bytes;
+	bool hex = length > 0 && unsignedCharToString((unsigned char*) raw.data(), raw.size()) == response.response;
+
+	out.put(record.method);
+	out.put((error ? RECORD_FLAG_ERROR : 0) | (hex ? RECORD_FLAG_HEX_RESPONSE : 0));
+	writeUint32(out, record.duration_us);
+	writeBytes(out, std::string(record.argument.begin(), record.argument.end()));
+	writeBytes(out, hex ? raw : response.response);
+	if (error) {
+		writeUint32(out, (std::uint32_t) response.err_terminal_code);
+		writeBytes(out, response.err_terminal_description);
+		writeUint32(out, (std::uint32_t) response.err_card_code);
+		writeBytes(out, response.err_card_description);
+	}
+}
+
+/**
+ * readRecord - read the next record of a recording.
+ * @param in the recording's stream.
+ * @param record the record read.
+ * @return a boolean indicating whether a complete record has been read.
+ */
+inline bool readRecord(std::istream& in, TerminalRecord* record) {
+	int method = in.get();
+	int flags = in.get();
+	std::string argument, response;
+	if (method == EOF || flags == EOF || !readUint32(in, &record->duration_us) || !readBytes(in, &argument) || !readBytes(in, &response)) {
+		return false;
+	}
+
+	record->method = method;
+	record->argument.assign(argument.begin(), argument.end());
+	record->response = client::ResponsePacket();
+	record->response.response = (flags & RECORD_FLAG_HEX_RESPONSE) ? unsignedCharToString((unsigned char*) response.data(), response.size()) : response;
+	if (flags & RECORD_FLAG_ERROR) {
+		std::uint32_t terminal_code, card_code;
+		std::string terminal_description, card_description;
+		if (!readUint32(in, &terminal_code) || !readBytes(in, &terminal_description) || !readUint32(in, &card_code)
+				|| !readBytes(in, &card_description)) {
+			return false;
+		}
+		record->response.err_terminal_code = (std::int32_t) terminal_code;
+		record->response.err_terminal_description = terminal_description;
+		record->response.err_card_code = (std::int32_t) card_code;
+		record->response.err_card_description = card_description;
+	}
+	return true;
+}
+
+} // namespace utils
+
+#endif /* UTILS_TERMINAL_RECORD_H_ */
@@ -20,43 +20,308 @@
 
 #include "plog/include/plog/Log.h"
 
-#include <sstream>
 #include <string>
-#include <vector>
+
+// the kernels are selected at compile time, TYPE_CONVERTER_SCALAR forces the portable version
+#ifndef TYPE_CONVERTER_SCALAR
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TYPE_CONVERTER_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define TYPE_CONVERTER_SSSE3
+#include <tmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define TYPE_CONVERTER_AVX2
+#include <immintrin.h>
+#endif
+#endif
 
 namespace utils {
 
 /**
- * stringToUnsignedChar - convert a string to unsigned char*
- * By example: unsigned char bytes[] = { 0x0F, 0xFF, 0x44, 0x4A } <===> std::string s = "0F FF 44 4A"
- * @param data to string to convert.
- * @param length to outputed length of the unsigned char* result.
- * @return the unsigned char* data.
+ * hexEncodedLength - return the number of characters written by hexEncode.
+ * @param length the number of bytes to be converted.
+ * @param separator the character written between two bytes, '\0' for none.
+ * @return the number of characters.
+ */
+inline unsigned long int hexEncodedLength(unsigned long int length, char separator) {
+	if (length == 0) {
+		return 0;
+	}
+	return separator != '\0' ? 3 * length - 1 : 2 * length;
+}
+
+/**
+ * hexDecodedCapacity - return the size of a buffer large enough for hexDecode to convert the given number of characters.
+ * @param hex_length the number of characters to be converted.
+ * @return the number of bytes.
+ */
+inline unsigned long int hexDecodedCapacity(unsigned long int hex_length) {
+	return hex_length / 2;
+}
+
+#ifdef TYPE_CONVERTER_SSE2
+/**
+ * hexDigits - convert 16 nibbles to upper case hexadecimal digits.
+ */
+inline __m128i hexDigits(__m128i nibbles) {
+	__m128i above_nine = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), _mm_and_si128(above_nine, _mm_set1_epi8('A' - '0' - 10)));
+}
+
+/**
+ * hexValues - convert 16 hexadecimal digits to their value.
+ * @return false if one of the characters is not an hexadecimal digit.
+ */
+inline bool hexValues(__m128i chars, __m128i* values) {
+	__m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+	__m128i letters = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	__m128i is_digit = _mm_cmpeq_epi8(_mm_subs_epu8(digits, _mm_set1_epi8(9)), _mm_setzero_si128());
+	__m128i is_letter = _mm_cmpeq_epi8(_mm_subs_epu8(letters, _mm_set1_epi8(5)), _mm_setzero_si128());
+	if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF) {
+		return false;
+	}
+	*values = _mm_or_si128(_mm_and_si128(is_digit, digits), _mm_andnot_si128(is_digit, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+	return true;
+}
+
+/**
+ * hexPack - merge the values of 16 hexadecimal digits into 8 bytes, stored in the low byte of each 16 bits lane.
+ */
+inline __m128i hexPack(__m128i values) {
+	// each lane holds the high nibble in its low byte and the low nibble in its high byte
+	return _mm_or_si128(_mm_and_si128(_mm_slli_epi16(values, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(values, 8));
+}
+
+/**
+ * hexDecodeBlock - convert 32 contiguous hexadecimal digits to 16 bytes.
+ * @return false if one of the characters is not an hexadecimal digit, nothing is written then.
+ */
+inline bool hexDecodeBlock(__m128i first, __m128i second, unsigned char* bytes) {
+	__m128i first_values, second_values;
+	if (!hexValues(first, &first_values) || !hexValues(second, &second_values)) {
+		return false;
+	}
+	_mm_storeu_si128((__m128i*) bytes, _mm_packus_epi16(hexPack(first_values), hexPack(second_values)));
+	return true;
+}
+#endif
+
+/**
+ * hexNibble - return the value of an hexadecimal digit.
+ * @return -1 if the character is not an hexadecimal digit.
+ */
+inline int hexNibble(unsigned char c) {
+	if ((unsigned int) (c - '0') < 10) {
+		return c - '0';
+	}
+	c |= 0x20; // lower case
+	if ((unsigned int) (c - 'a') < 6) {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+/**
+ * hexEncode - write the upper case hexadecimal representation of the given bytes into the given buffer.
+ * By example: unsigned char bytes[] = { 0x0F, 0xFF, 0x44, 0x4A } ===> "0F FF 44 4A" with ' ' as separator, "0FFF444A" with '\0'
+ * @param bytes the bytes to be converted.
+ * @param length the number of bytes.
+ * @param separator the character written between two bytes, '\0' for none.
+ * @param hex the buffer receiving the characters, at least hexEncodedLength(length, separator) long. It is not null-terminated.
+ * @return the number of characters written.
  */
-inline unsigned char* stringToUnsignedChar(std::string data, unsigned long int* length) {
-	data.erase(remove_if(data.begin(), data.end(), isspace), data.end()); // remove spaces
+inline unsigned long int hexEncode(const unsigned char* bytes, unsigned long int length, char separator, char* hex) {
+	static const char digits[] = "0123456789ABCDEF";
+	unsigned long int i = 0;
+	char* out = hex;
 
-	std::stringstream ss;
-	for (unsigned long int i = 0; i < data.length(); i++) {
-		if (i != 0 && i % 2 == 0) {
-			ss << " ";
+#ifdef TYPE_CONVERTER_AVX2
+	if (separator == '\0') {
+		for (; i + 32 <= length; i += 32, out += 64) {
+			__m256i input = _mm256_loadu_si256((const __m256i*) (bytes + i));
+			__m256i low_nibbles = _mm256_and_si256(input, _mm256_set1_epi8(0x0F));
+			__m256i high_nibbles = _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+			__m256i above_nine = _mm256_cmpgt_epi8(low_nibbles, _mm256_set1_epi8(9));
+			__m256i low = _mm256_add_epi8(_mm256_add_epi8(low_nibbles, _mm256_set1_epi8('0')), _mm256_and_si256(above_nine, _mm256_set1_epi8('A' - '0' - 10)));
+			above_nine = _mm256_cmpgt_epi8(high_nibbles, _mm256_set1_epi8(9));
+			__m256i high = _mm256_add_epi8(_mm256_add_epi8(high_nibbles, _mm256_set1_epi8('0')), _mm256_and_si256(above_nine, _mm256_set1_epi8('A' - '0' - 10)));
+			// the unpacks work on each 128 bits lane: bytes 0-7 and 16-23, then bytes 8-15 and 24-31
+			__m256i first = _mm256_unpacklo_epi8(high, low);
+			__m256i second = _mm256_unpackhi_epi8(high, low);
+			_mm256_storeu_si256((__m256i*) out, _mm256_permute2x128_si256(first, second, 0x20));
+			_mm256_storeu_si256((__m256i*) (out + 32), _mm256_permute2x128_si256(first, second, 0x31));
 		}
-		ss << data[i];
 	}
-	data = ss.str();
-
-	std::istringstream hex_chars_stream(data);
-	std::vector<unsigned char> bytes;
-	unsigned int c;
-	int i = 0;
-	while (hex_chars_stream >> std::hex >> c) {
-		bytes.push_back(c);
-		i++;
+#endif
+
+#ifdef TYPE_CONVERTER_SSE2
+	// with a separator, the block is only converted when a byte follows it since its trailing separator is written too
+	for (; separator == '\0' ? i + 16 <= length : i + 16 < length; i += 16) {
+		__m128i input = _mm_loadu_si128((const __m128i*) (bytes + i));
+		__m128i high = hexDigits(_mm_and_si128(_mm_srli_epi16(input, 4), _mm_set1_epi8(0x0F)));
+		__m128i low = hexDigits(_mm_and_si128(input, _mm_set1_epi8(0x0F)));
+		__m128i first = _mm_unpacklo_epi8(high, low); // digits of bytes 0-7
+		__m128i second = _mm_unpackhi_epi8(high, low); // digits of bytes 8-15
+		if (separator == '\0') {
+			_mm_storeu_si128((__m128i*) out, first);
+			_mm_storeu_si128((__m128i*) (out + 16), second);
+			out += 32;
+			continue;
+		}
+#ifdef TYPE_CONVERTER_SSSE3
+		// spread the 32 digits over 48 characters, every third one being the separator
+		__m128i separators = _mm_set1_epi8(separator);
+		__m128i spread = _mm_shuffle_epi8(first, _mm_setr_epi8(0, 1, -128, 2, 3, -128, 4, 5, -128, 6, 7, -128, 8, 9, -128, 10));
+		spread = _mm_or_si128(spread, _mm_and_si128(separators, _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0)));
+		_mm_storeu_si128((__m128i*) out, spread);
+		spread = _mm_or_si128(_mm_shuffle_epi8(first, _mm_setr_epi8(11, -128, 12, 13, -128, 14, 15, -128, -128, -128, -128, -128, -128, -128, -128, -128)),
+				_mm_shuffle_epi8(second, _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, 0, 1, -128, 2, 3, -128, 4, 5)));
+		spread = _mm_or_si128(spread, _mm_and_si128(separators, _mm_setr_epi8(0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0)));
+		_mm_storeu_si128((__m128i*) (out + 16), spread);
+		spread = _mm_shuffle_epi8(second, _mm_setr_epi8(-128, 6, 7, -128, 8, 9, -128, 10, 11, -128, 12, 13, -128, 14, 15, -128));
+		spread = _mm_or_si128(spread, _mm_and_si128(separators, _mm_setr_epi8(-1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1)));
+		_mm_storeu_si128((__m128i*) (out + 32), spread);
+		out += 48;
+#else
+		char block[32];
+		_mm_storeu_si128((__m128i*) block, first);
+		_mm_storeu_si128((__m128i*) (block + 16), second);
+		for (int j = 0; j < 32; j += 2) {
+			out[0] = block[j];
+			out[1] = block[j + 1];
+			out[2] = separator;
+			out += 3;
+		}
+#endif
 	}
+#endif
+
+	for (; i < length; i++) {
+		*out++ = digits[bytes[i] >> 4];
+		*out++ = digits[bytes[i] & 0x0F];
+		if (separator != '\0' && i + 1 < length) {
+			*out++ = separator;
+		}
+	}
+	return out - hex;
+}
+
+/**
+ * hexDecode - convert an hexadecimal string to bytes, the digits being upper or lower case.
+ * White spaces are accepted as separators anywhere in the string. Any other character, or an odd number of digits, is rejected.
+ * By example: "0F FF 44 4A" or "0fff444a" ===> unsigned char bytes[] = { 0x0F, 0xFF, 0x44, 0x4A }
+ * @param hex the characters to be converted.
+ * @param hex_length the number of characters.
+ * @param bytes the buffer receiving the bytes, at least hexDecodedCapacity(hex_length) long.
+ * @param length the number of bytes written.
+ * @return false if the string is not valid hexadecimal data.
+ */
+inline bool hexDecode(const char* hex, unsigned long int hex_length, unsigned char* bytes, unsigned long int* length) {
+	unsigned long int i = 0;
+	unsigned long int written = 0;
+	unsigned long int vector_from = 0; // the blocks are tried again once the characters rejected by a block have been scanned
+	int high = -1;
+
+	while (i < hex_length) {
+#ifdef TYPE_CONVERTER_SSE2
+		if (high < 0 && i >= vector_from) {
+#ifdef TYPE_CONVERTER_AVX2
+			if (i + 64 <= hex_length) {
+				__m256i first = _mm256_loadu_si256((const __m256i*) (hex + i));
+				__m256i second = _mm256_loadu_si256((const __m256i*) (hex + i + 32));
+				__m256i valid = _mm256_set1_epi8(-1);
+				__m256i packed[2];
+				__m256i chars[2] = { first, second };
+				for (int j = 0; j < 2; j++) {
+					__m256i digits = _mm256_sub_epi8(chars[j], _mm256_set1_epi8('0'));
+					__m256i letters = _mm256_sub_epi8(_mm256_or_si256(chars[j], _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+					__m256i is_digit = _mm256_cmpeq_epi8(_mm256_subs_epu8(digits, _mm256_set1_epi8(9)), _mm256_setzero_si256());
+					__m256i is_letter = _mm256_cmpeq_epi8(_mm256_subs_epu8(letters, _mm256_set1_epi8(5)), _mm256_setzero_si256());
+					valid = _mm256_and_si256(valid, _mm256_or_si256(is_digit, is_letter));
+					__m256i values = _mm256_blendv_epi8(_mm256_add_epi8(letters, _mm256_set1_epi8(10)), digits, is_digit);
+					packed[j] = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(values, 4), _mm256_set1_epi16(0x00F0)), _mm256_srli_epi16(values, 8));
+				}
+				if ((unsigned int) _mm256_movemask_epi8(valid) == 0xFFFFFFFFu) {
+					// the pack works on each 128 bits lane, the quadwords are put back in order
+					_mm256_storeu_si256((__m256i*) (bytes + written), _mm256_permute4x64_epi64(_mm256_packus_epi16(packed[0], packed[1]), 0xD8));
+					i += 64;
+					written += 32;
+					continue;
+				}
+			}
+#endif
+			if (i + 32 <= hex_length) {
+				__m128i first = _mm_loadu_si128((const __m128i*) (hex + i));
+				__m128i second = _mm_loadu_si128((const __m128i*) (hex + i + 16));
+				if (hexDecodeBlock(first, second, bytes + written)) {
+					i += 32;
+					written += 16;
+					continue;
+				}
+			}
+#ifdef TYPE_CONVERTER_SSSE3
+			// bytes separated by single spaces, as formatted by hexEncode: "XX XX ... XX "
+			if (i + 48 <= hex_length) {
+				__m128i first = _mm_loadu_si128((const __m128i*) (hex + i));
+				__m128i second = _mm_loadu_si128((const __m128i*) (hex + i + 16));
+				__m128i third = _mm_loadu_si128((const __m128i*) (hex + i + 32));
+				__m128i spaces = _mm_set1_epi8(' ');
+				__m128i separators = _mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(first, spaces), _mm_setr_epi8(-1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1)),
+						_mm_or_si128(_mm_cmpeq_epi8(second, spaces), _mm_setr_epi8(-1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1)));
+				separators = _mm_and_si128(separators, _mm_or_si128(_mm_cmpeq_epi8(third, spaces), _mm_setr_epi8(0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0)));
+				if (_mm_movemask_epi8(separators) == 0xFFFF) {
+					__m128i first_digits = _mm_or_si128(_mm_shuffle_epi8(first, _mm_setr_epi8(0, 1, 3, 4, 6, 7, 9, 10, 12, 13, 15, -128, -128, -128, -128, -128)),
+							_mm_shuffle_epi8(second, _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 0, 2, 3, 5, 6)));
+					__m128i second_digits = _mm_or_si128(_mm_shuffle_epi8(second, _mm_setr_epi8(8, 9, 11, 12, 14, 15, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128)),
+							_mm_shuffle_epi8(third, _mm_setr_epi8(-128, -128, -128, -128, -128, -128, 1, 2, 4, 5, 7, 8, 10, 11, 13, 14)));
+					if (hexDecodeBlock(first_digits, second_digits, bytes + written)) {
+						i += 48;
+						written += 16;
+						continue;
+					}
+				}
+			}
+#endif
+			vector_from = i + 32;
+		}
+#endif
 
-	unsigned char* ustr = new unsigned char[bytes.size()];
-	std::copy(bytes.begin(), bytes.end(), ustr);
-	*length = bytes.size();
+		unsigned char c = hex[i++];
+		int nibble = hexNibble(c);
+		if (nibble < 0) {
+			if (c == ' ' || (c >= '\t' && c <= '\r')) {
+				continue;
+			}
+			return false;
+		}
+		if (high < 0) {
+			high = nibble;
+		} else {
+			bytes[written++] = (unsigned char) ((high << 4) | nibble);
+			high = -1;
+		}
+	}
+
+	*length = written;
+	return high < 0;
+}
+
+/**
+ * stringToUnsignedChar - convert a string to unsigned char*
+ * By example: unsigned char bytes[] = { 0x0F, 0xFF, 0x44, 0x4A } <===> std::string s = "0F FF 44 4A"
+ * The result is empty if the string is not valid hexadecimal data (see hexDecode).
+ * @param data to string to convert.
+ * @param length to outputed length of the unsigned char* result.
+ * @return the unsigned char* data, to be deleted by the caller.
+ */
+inline unsigned char* stringToUnsignedChar(const std::string& data, unsigned long int* length) {
+	unsigned char* ustr = new unsigned char[hexDecodedCapacity(data.size()) + 1];
+	if (!hexDecode(data.data(), data.size(), ustr, length)) {
+		*length = 0;
+	}
 	return ustr;
 }
 
@@ -67,16 +332,10 @@ inline unsigned char* stringToUnsignedChar(std::string data, unsigned long int*
  * @param length the length of the data to be converted.
  * @return the string data.
  */
-inline std::string unsignedCharToString(unsigned char* hex, unsigned long int length) {
-	std::string hexString;
-	char buffer[4];
-	for (unsigned long int i = 0; i < length; i++) {
-		if (i == length - 1) {
-			sprintf(buffer, "%02X", hex[i]);
-		} else {
-			sprintf(buffer, "%02X ", hex[i]);
-		}
-		hexString.append(buffer);
+inline std::string unsignedCharToString(const unsigned char* hex, unsigned long int length) {
+	std::string hexString(hexEncodedLength(length, ' '), '\0');
+	if (length > 0) {
+		hexEncode(hex, length, ' ', &hexString[0]);
 	}
 	return hexString;
 }
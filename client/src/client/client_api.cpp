@@ -16,6 +16,7 @@
  *********************************************************************************/
 
 #include "client/client_api.hpp"
+#include "recorder/flight_recorder.hpp"
 #include "plog/include/plog/Log.h"
 #include "plog/include/plog/Appenders/ColorConsoleAppender.h"
 
@@ -36,10 +37,31 @@ ResponsePacket ClientAPI::connectClient(const char* reader, const char* ip, cons
 	return engine_->connectClient(reader, ip, port);
 }
 
+ResponsePacket ClientAPI::connectAllReaders(const char* ip, const char* port) {
+	return engine_->connectAllReaders(ip, port);
+}
+
 ResponsePacket ClientAPI::disconnectClient() {
 	return engine_->disconnectClient();
 }
 
+ResponsePacket ClientAPI::sendEvent(EventType event, std::string data) {
+	return engine_->notifyEvent(event, data);
+}
+
+ResponsePacket ClientAPI::dumpFlightRecorder(std::string path) {
+	if (!FlightRecorder::getInstance().dump(path)) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "Failed to write the flight recorder" };
+		return response_packet;
+	}
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+ResponsePacket ClientAPI::getStats() {
+	return engine_->getStats();
+}
+
 ResponsePacket ClientAPI::loadAndListReaders() {
 	return engine_->loadAndListReaders();
 }
@@ -17,12 +17,18 @@
 
 #include "client/client_engine.hpp"
 #include "client/client_tcp_socket.hpp"
+#include "client/message_codec.hpp"
+#include "client/requests/diag.hpp"
 #include "config/config_wrapper.hpp"
 #include "constants/default_values.hpp"
 #include "constants/request_code.hpp"
+#include "constants/request_timing.hpp"
 #include "constants/response_packet.hpp"
 #include "logger/logger.hpp"
+#include "metrics/metrics_format.hpp"
+#include "metrics/thread_stats.hpp"
 #include "terminal/factories/factory.hpp"
+#include "terminal/factories/recording_factory.hpp"
 #include "terminal/flyweight_terminal_factory.hpp"
 #include "terminal/terminals/terminal.hpp"
 #include "terminal/terminals/utils/type_converter.hpp"
@@ -31,13 +37,17 @@
 #include "plog/include/plog/Appenders/ColorConsoleAppender.h"
 #include "plog/include/plog/Appenders/RollingFileAppender.h"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iostream>
 #include <map>
+#include <random>
 #include <stdio.h>
 #include <stdlib.h>
 #include <thread>
+#include <vector>
 
 namespace client {
 
@@ -51,20 +61,59 @@ ResponsePacket ClientEngine::initClient(std::string path, FlyweightTerminalFacto
 		config_.init(path);
 	}
 
-	ITerminalFactory* terminal_factory =  available_terminals.getFactory(config_.getValue("terminal"));
-	if (terminal_factory == NULL) {
+	terminal_factory_ =  available_terminals.getFactory(config_.getValue("terminal"));
+	if (terminal_factory_ == NULL) {
 		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_TERMINAL, .err_client_description = "Failed to initialize the client: terminal not found" };
 		return response_packet;
 	}
 
-	terminal_ = terminal_factory->create();
+	std::string record_file = config_.getValue("record_file", DEFAULT_RECORD_FILE);
+	if (!record_file.empty()) {
+		recording_factory_ = new RecordingFactory(terminal_factory_, record_file);
+		terminal_factory_ = recording_factory_;
+	}
+
+	terminal_ = terminal_factory_->create();
 	requests_ = available_requests;
 	socket_ = new ClientTCPSocket();
 	logger::setup(&config_);
+	recorder_.setErrorDump(config_.getValue("recorder_dump_on_error", DEFAULT_RECORDER_DUMP_ON_ERROR).compare("true") == 0 ? config_.getValue("recorder_file", DEFAULT_RECORDER_FILE) : "");
+
+	// read once: reconnect runs on the requests' thread when the link drops, where a malformed value must not throw
+	reconnect_max_attempts_ = (int) getNumber("reconnect_max_attempts", DEFAULT_RECONNECT_MAX_ATTEMPTS, 0);
+	reconnect_initial_delay_ = getNumber("reconnect_initial_delay", DEFAULT_RECONNECT_INITIAL_DELAY, 0);
+	reconnect_max_delay_ = getNumber("reconnect_max_delay", DEFAULT_RECONNECT_MAX_DELAY, 0);
+	terminal_idle_delay_ = std::chrono::milliseconds(getNumber("terminal_idle_delay", DEFAULT_TERMINAL_IDLE_DELAY, 0));
+	load_event_threshold_ = getNumber("load_event_threshold", DEFAULT_LOAD_EVENT_THRESHOLD, 0);
+
+	// the locks and the threads are measured for the whole process, the threads already running are not registered
+	if (config_.getValue("contention_stats", DEFAULT_CONTENTION_STATS).compare("true") == 0) {
+		LockRegistry::setEnabled(true);
+		ThreadRegistry::setEnabled(true);
+		long interval = std::stol(config_.getValue("contention_report_interval", DEFAULT_CONTENTION_REPORT_INTERVAL));
+		if (interval > 0) {
+			contention_reporter_.start(std::chrono::seconds(interval));
+		}
+	}
 
-	// launch terminal
+	// the metrics endpoint is optional and does not prevent the client from starting
+	std::string metrics_port = config_.getValue("metrics_port", DEFAULT_METRICS_PORT);
+	if (!metrics_port.empty()) {
+		std::string metrics_ip = config_.getValue("metrics_ip", DEFAULT_METRICS_IP);
+		if (!metrics_server_.start(metrics_ip.c_str(), metrics_port.c_str(), [this] { return renderMetrics(); })) {
+			LOG_WARNING << "Failed to serve the metrics on IP " << metrics_ip << " and port " << metrics_port;
+		}
+	}
+
+	// launch terminal, all its calls are performed on the executor's thread from now on
+	executor_.start();
+	executor_.setIdleHandler([this]() {
+		if (terminal_ != NULL) {
+			terminal_->onIdle();
+		}
+	}, getTerminalIdleDelay());
 	ResponsePacket response_packet;
-	response_packet = terminal_->init();
+	response_packet = executor_.execute(std::bind(&ITerminalLayer::init, terminal_));
 	if (response_packet.err_terminal_code != SUCCESS || response_packet.err_card_code != SUCCESS) {
 		LOG_INFO << "Client unable to be initialized";
 		return response_packet;
@@ -81,7 +130,7 @@ ResponsePacket ClientEngine::loadAndListReaders() {
 		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "Client must be initialized correctly" };
 		return response_packet;
 	}
-	return terminal_->loadAndListReaders();
+	return executor_.execute(std::bind(&ITerminalLayer::loadAndListReaders, terminal_));
 }
 
 ResponsePacket ClientEngine::connectClient(const char* reader, const char* ip, const char* port) {
@@ -96,6 +145,14 @@ ResponsePacket ClientEngine::connectClient(const char* reader, const char* ip, c
 		return response_packet;
 	}
 
+	ip_ = ip;
+	port_ = port;
+	reader_ = reader;
+	multi_reader_ = false;
+	auto_reconnect_ = config_.getValue("auto_reconnect", DEFAULT_AUTO_RECONNECT).compare("true") == 0;
+	monitor_events_ = config_.getValue("monitor_events", DEFAULT_MONITOR_EVENTS).compare("true") == 0;
+	compact_responses_ = config_.getValue("compact_responses", DEFAULT_COMPACT_RESPONSES).compare("true") == 0;
+
 	// init socket
 	LOG_INFO << "Client trying to connect on IP " << ip << " port " << port;
 	if (!socket_->initClient(ip, port)) {
@@ -110,21 +167,30 @@ ResponsePacket ClientEngine::connectClient(const char* reader, const char* ip, c
 	}
 
 	// connect to the terminal
-	packet = terminal_->connect(reader);
+	packet = executor_.execute([this, reader]() {
+		ResponsePacket response_packet = terminal_->connect(reader);
+		if (response_packet.err_card_code == SUCCESS && response_packet.err_terminal_code == SUCCESS) {
+			state_cache_.reset(reader);
+			refreshTerminalState(terminal_);
+		}
+		return response_packet;
+	});
 	if (packet.err_card_code < 0 || packet.err_terminal_code < 0) {
 		socket_ ->closeClient();
 		return packet;
 	}
 
 	// perform handshake procedure
-	std::string name = config_.getValue("name", DEFAULT_NAME).append(" - ").append(reader);
-	if (!socket_->sendPacket(name.c_str())) {
+	resume_token_.clear();
+	if (!performHandshake()) {
+		socket_->closeClient();
 		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_NETWORK, .err_client_description = "Failed to connect: failed to perform handshake" };
 		return response_packet;
 	}
 
 	connected_ = true;
 	LOG_INFO << "Client connected on IP " << ip << " port " << port;
+	startMonitoring();
 
 	// start waiting for requests on a different thread
 	std::thread thr(&ClientEngine::waitingRequests, this);
@@ -133,6 +199,134 @@ ResponsePacket ClientEngine::connectClient(const char* reader, const char* ip, c
 	return packet;
 }
 
+ResponsePacket ClientEngine::connectAllReaders(const char* ip, const char* port) {
+	if (!initialized_.load()) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "Failed to connect: client must be initialized correctly" };
+		return response_packet;
+	}
+
+	if (connected_.load()) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "Failed to connect: client is already connected" };
+		return response_packet;
+	}
+
+	// readers to connect: the configured ones or all the available ones, formatted this way: ReaderName|... or ReaderID|ReaderName|...
+	std::vector<std::string> readers;
+	std::string list_readers = config_.getValue("readers", DEFAULT_READERS);
+	bool with_ids = list_readers.empty();
+	if (with_ids) {
+		ResponsePacket response_packet = loadAndListReaders();
+		if (response_packet.err_terminal_code < 0 || response_packet.err_card_code < 0) {
+			return response_packet;
+		}
+		list_readers = response_packet.response;
+	}
+	std::size_t start = 0, end;
+	for (int i = 0; (end = list_readers.find('|', start)) != std::string::npos; i++, start = end + 1) {
+		if (!with_ids || i % 2 == 1) {
+			readers.push_back(list_readers.substr(start, end - start));
+		}
+	}
+	if (start < list_readers.size()) {
+		readers.push_back(list_readers.substr(start));
+	}
+
+	// every reader gets its own terminal, initialized and connected on its own executor
+	for (ReaderChannel* channel : channels_) {
+		channel->executor.execute([channel]() {
+			delete channel->terminal;
+			ResponsePacket response_packet;
+			return response_packet;
+		});
+		channel->executor.stop();
+		delete channel;
+	}
+	channels_.clear();
+	std::string connected_readers;
+	for (const std::string &reader : readers) {
+		ReaderChannel* channel = new ReaderChannel();
+		channel->channel = channels_.size();
+		channel->reader = reader;
+		channel->executor.start();
+
+		ResponsePacket response_packet = channel->executor.execute([this, channel]() {
+			channel->terminal = terminal_factory_->create();
+			ResponsePacket response_packet = channel->terminal->init();
+			if (response_packet.err_terminal_code < 0 || response_packet.err_card_code < 0) {
+				return response_packet;
+			}
+			response_packet = channel->terminal->connect(channel->reader.c_str());
+			if (response_packet.err_terminal_code == SUCCESS && response_packet.err_card_code == SUCCESS) {
+				channel->state_cache.reset(channel->reader);
+				refreshTerminalState(channel->terminal);
+			}
+			return response_packet;
+		});
+		if (response_packet.err_terminal_code < 0 || response_packet.err_card_code < 0) {
+			LOG_INFO << "Failed to connect reader, reader ignored [reader:" << reader << "][error:" << response_packet.err_terminal_description << "]";
+			channel->executor.execute([channel]() {
+				delete channel->terminal;
+				ResponsePacket response_packet;
+				return response_packet;
+			});
+			channel->executor.stop();
+			delete channel;
+			continue;
+		}
+		channel->executor.setIdleHandler([channel]() {
+			if (channel->terminal != NULL) {
+				channel->terminal->onIdle();
+			}
+		}, getTerminalIdleDelay());
+
+		channel->connected = true;
+		channels_.push_back(channel);
+		connected_readers += std::to_string(channel->channel) + "|" + reader + "|";
+		LOG_INFO << "Reader connected [channel:" << channel->channel << "][reader:" << reader << "]";
+	}
+
+	if (channels_.empty()) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_TERMINAL, .err_client_description = "Failed to connect: no reader available" };
+		return response_packet;
+	}
+
+	ip_ = ip;
+	port_ = port;
+	multi_reader_ = true;
+	auto_reconnect_ = config_.getValue("auto_reconnect", DEFAULT_AUTO_RECONNECT).compare("true") == 0;
+	monitor_events_ = config_.getValue("monitor_events", DEFAULT_MONITOR_EVENTS).compare("true") == 0;
+	compact_responses_ = config_.getValue("compact_responses", DEFAULT_COMPACT_RESPONSES).compare("true") == 0;
+
+	// init socket and connect to the server
+	LOG_INFO << "Client trying to connect on IP " << ip << " port " << port;
+	resume_token_.clear();
+	if (!socket_->initClient(ip, port) || !socket_->connectClient()) {
+		connected_ = true; // let disconnectClient release the readers
+		disconnectClient();
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_NETWORK, .err_client_description = "Failed to connect: check the server" };
+		return response_packet;
+	}
+
+	// perform handshake procedure, registering every reader
+	if (!performHandshake()) {
+		connected_ = true;
+		disconnectClient();
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_NETWORK, .err_client_description = "Failed to connect: failed to perform handshake" };
+		return response_packet;
+	}
+
+	connected_ = true;
+	LOG_INFO << "Client connected on IP " << ip << " port " << port << " with " << channels_.size() << " readers";
+	startMonitoring();
+
+	// start waiting for requests on a different thread
+	std::thread thr(&ClientEngine::waitingRequests, this);
+	thr.detach();
+
+	ResponsePacket response_packet = { .response = connected_readers };
+	return response_packet;
+}
+
 ResponsePacket ClientEngine::disconnectClient() {
 	if (!connected_.load()) {
 		LOG_DEBUG << "Failed to disconnect: not connected yet";
@@ -142,16 +336,39 @@ ResponsePacket ClientEngine::disconnectClient() {
 
 	connected_ = false;
 	socket_->closeClient();
-	ResponsePacket response = terminal_->disconnect();
+	ResponsePacket response;
+	if (multi_reader_) {
+		for (ReaderChannel* channel : channels_) {
+			if (channel->connected.exchange(false)) {
+				channel->state_cache.setMonitored(false);
+				response = channel->executor.execute([channel]() {
+					channel->terminal->stopMonitoring();
+					return channel->terminal->disconnect();
+				});
+			}
+		}
+	} else {
+		state_cache_.setMonitored(false);
+		response = executor_.execute([this]() {
+			terminal_->stopMonitoring();
+			return terminal_->disconnect();
+		});
+	}
+	{
+		std::lock_guard<InstrumentedMutex> guard(scripts_mutex_);
+		scripts_.clear();
+	}
 	if (notifyConnectionLost_ != 0) {
 		notifyConnectionLost_("End of connection");
 	}
 
 	LOG_INFO << "Client disconnected successfully";
+	logger::flush();
 	return response;
 }
 
 ResponsePacket ClientEngine::waitingRequests() {
+	ThreadScope scope("request_receiver");
 	char request[DEFAULT_BUFLEN];
 	bool response;
 
@@ -162,7 +379,7 @@ ResponsePacket ClientEngine::waitingRequests() {
 		response = socket_->receivePacket(request);
 		if (response) {
 			handleRequest(request);
-		} else {
+		} else if (!auto_reconnect_ || !connected_.load() || !reconnect()) {
 			disconnectClient();
 		}
 	}
@@ -174,8 +391,8 @@ ResponsePacket ClientEngine::waitingRequests() {
 }
 
 ResponsePacket ClientEngine::handleRequest(std::string request) {
-	nlohmann::json jrequest;
-	nlohmann::json jresponse;
+	long long received = timingNow();
+	RequestMessage message;
 	ResponsePacket response_packet;
 
 	LOG_INFO << "Request received from server: " << request;
@@ -183,46 +400,227 @@ ResponsePacket ClientEngine::handleRequest(std::string request) {
 		notifyRequestReceived_(request.c_str());
 	}
 
-	// build the request using json
-	try {
-		jrequest = nlohmann::json::parse(request);
-	} catch (json::parse_error &err) {
-		LOG_DEBUG << "Error while parsing the request [request:" << request << "]";
-		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_JSON_PARSING, .err_client_description = "Error while parsing the request" };
-		jresponse = response_packet;
-		return sendResult(jresponse.dump());
+	// requests of the fixed schema are decoded without building a json document, other requests go through nlohmann
+	if (!decodeRequest(request, &message)) {
+		try {
+			message = nlohmann::json::parse(request).get<RequestMessage>();
+		} catch (json::exception &err) {
+			LOG_DEBUG << "Error while parsing the request [request:" << request << "]";
+			ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_JSON_PARSING, .err_client_description = "Error while parsing the request" };
+			endStats(-1, response_packet, startStats(-1));
+			std::string result;
+			encodeResponse(response_packet, 0, -1, compact_responses_, &result);
+			std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+			return sendResult(result);
+		}
+	}
+
+	recorder_.record(STAGE_REQUEST_RECEIVED, (message.channel < 0) ? 0 : message.channel, message.id, message.request, message.data.size());
+	if (!message.timing) {
+		received = TIMING_NOT_STAMPED; // the instants are only sent when the server asks for them
+	}
+	long long started = startStats(message.request);
+
+	// requests of a multi-reader client are executed in parallel on their reader
+	if (multi_reader_) {
+		return handleChannelRequest(message, received, started);
 	}
 
-	unsigned long int length;
-	unsigned char* command = utils::stringToUnsignedChar(jrequest["data"].get<std::string>(), &length);
+	// a request already processed is sent again by the server after a reconnection: replay its response
+	unsigned long request_id = message.id;
+	if (request_id != 0 && request_id == last_request_id_ && !last_response_.empty()) {
+		LOG_INFO << "Request already processed, replaying its response [id:" << request_id << "]";
+		endStats(message.request, response_packet, started);
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+		return sendResult(last_response_);
+	}
 
 	// retrieve the request handler
-	IRequest* request_handler = requests_.getRequest(jrequest["request"]);
+	IRequest* request_handler = requests_.getRequest((RequestCode) message.request);
 
 	if (request_handler == NULL) {
 		LOG_DEBUG << "The request doesn't exist [request:" << request << "]";
 		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_REQUEST, .err_client_description = "The request doesn't exist" };
-		jresponse = response_packet;
-		return sendResult(jresponse.dump());
+		endStats(message.request, response_packet, started);
+		std::string result;
+		encodeResponse(response_packet, request_id, -1, compact_responses_, &result);
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+		return sendResult(result);
+	}
+
+	Apdu command;
+	if (!command.assignHex(message.data)) {
+		LOG_DEBUG << "Invalid hexadecimal data [request:" << request << "]";
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_REQUEST, .err_client_description = "Invalid hexadecimal data" };
+		endStats(message.request, response_packet, started);
+		std::string result;
+		encodeResponse(response_packet, request_id, -1, compact_responses_, &result);
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+		return sendResult(result);
 	}
 
-	// launch a thread to perform the request
-	auto future = std::async(std::launch::async, &IRequest::run, request_handler, terminal_, this, command, length);
+	// the diagnostic is answered from the terminal's state without waiting for the terminal
+	int request_code = message.request;
+	if (request_code == REQ_DIAG && state_cache_.diag(Diag::isStructured(command), &response_packet)) {
+		endStats(request_code, response_packet, started);
+		last_request_id_ = request_id;
+		stampClientSend(&response_packet.timing, received);
+		encodeResponse(response_packet, request_id, -1, compact_responses_, &last_response_);
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+		return sendResult(last_response_);
+	}
+
+	// queue the request on the terminal executor, which keeps the terminal's state up to date
+	std::chrono::milliseconds timeout(message.timeout);
+	TerminalExecutor::TaskHandle task = executor_.submit([this, request_handler, request_code, request_id, command, received]() {
+		recorder_.record(STAGE_TERMINAL_START, 0, request_id, request_code);
+		long long terminal_start = timingNow();
+		ResponsePacket response_packet = request_handler->run(terminal_, this, command);
+		if (received != TIMING_NOT_STAMPED) {
+			response_packet.timing.terminal_start = terminal_start;
+			response_packet.timing.terminal_end = timingNow();
+		}
+		recorder_.record(STAGE_TERMINAL_END, 0, request_id, firstErrorCode(response_packet), response_packet.response.size());
+		state_cache_.recordResult(request_code, response_packet);
+		return response_packet;
+	}, timeout);
+	LOG_DEBUG << "Request queued for the terminal [queue_depth:" << executor_.getQueueDepth() << "]";
+	reportLoad();
+
 	// block until the timeout has elapsed or the result becomes available
-	if (future.wait_for(std::chrono::milliseconds(jrequest["timeout"])) == std::future_status::timeout) {
+	if (task->result.wait_for(timeout) == std::future_status::timeout) {
 		LOG_DEBUG << "Response time from terminal has elapsed [request:" << request << "]";
-		pending_futures_.push_back(std::move(future));
-		for (long long unsigned int i = 0; i < pending_futures_.size(); i++) {
-			if (pending_futures_[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-				pending_futures_.erase(pending_futures_.begin() + i);
+		executor_.cancel(task);
+		response_packet = { .response = "KO", .err_client_code = ERR_TIMEOUT, .err_client_description = "Response time from terminal has elapsed" };
+	} else {
+		response_packet = task->result.get();
+	}
+	reportLoad();
+	endStats(request_code, response_packet, started);
+
+	// the id lets a server receiving the client's events on a separate thread match the response with its request
+	last_request_id_ = request_id;
+	stampClientSend(&response_packet.timing, received);
+	encodeResponse(response_packet, request_id, -1, compact_responses_, &last_response_);
+	recorder_.record(STAGE_RESPONSE_SENT, 0, request_id, firstErrorCode(response_packet), last_response_.size());
+	if (response_packet.err_client_code == ERR_TIMEOUT) {
+		recorder_.dumpOnError();
+	}
+	std::lock_guard<InstrumentedMutex> guard(send_mutex_); // events are sent from the terminal's monitoring thread
+	return sendResult(last_response_);
+}
+
+ResponsePacket ClientEngine::handleChannelRequest(const RequestMessage& message, long long received, long long started) {
+	int channel = message.channel;
+	unsigned long request_id = message.id;
+	if (channel < 0 || channel >= (int) channels_.size() || !channels_[channel]->connected.load()) {
+		LOG_DEBUG << "The reader is not connected [channel:" << channel << "]";
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "The reader is not connected" };
+		endStats(message.request, response_packet, started);
+		return sendChannelResult(NULL, channel, request_id, response_packet);
+	}
+	ReaderChannel* reader_channel = channels_[channel];
+
+	// a request already processed is sent again by the server after a reconnection: replay its response
+	{
+		std::lock_guard<InstrumentedMutex> guard(reader_channel->cache_mutex);
+		if (request_id != 0 && request_id == reader_channel->last_request_id && !reader_channel->last_response.empty()) {
+			LOG_INFO << "Request already processed, replaying its response [channel:" << channel << "][id:" << request_id << "]";
+			endStats(message.request, ResponsePacket(), started);
+			std::lock_guard<InstrumentedMutex> send_guard(send_mutex_);
+			return sendResult(reader_channel->last_response);
+		}
+	}
+
+	// disconnecting a reader waits for its pending requests, the connection is closed with the last reader
+	if (message.request == REQ_DISCONNECT) {
+		reader_channel->state_cache.setMonitored(false);
+		ResponsePacket response_packet = reader_channel->executor.execute([reader_channel]() {
+			reader_channel->terminal->stopMonitoring();
+			return reader_channel->terminal->disconnect();
+		});
+		reader_channel->connected = false;
+		LOG_INFO << "Reader disconnected [channel:" << channel << "][reader:" << reader_channel->reader << "]";
+		endStats(message.request, response_packet, started);
+		sendChannelResult(reader_channel, channel, request_id, response_packet);
+
+		for (ReaderChannel* other : channels_) {
+			if (other->connected.load()) {
+				return response_packet;
 			}
 		}
-		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_TIMEOUT, .err_client_description = "Response time from terminal has elapsed" };
-		jresponse = response_packet;
-	} else {
-		jresponse = future.get();
+		return disconnectClient();
+	}
+
+	IRequest* request_handler = requests_.getRequest((RequestCode) message.request);
+	if (request_handler == NULL) {
+		LOG_DEBUG << "The request doesn't exist [request:" << message.request << "][channel:" << channel << "]";
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_REQUEST, .err_client_description = "The request doesn't exist" };
+		endStats(message.request, response_packet, started);
+		return sendChannelResult(NULL, channel, request_id, response_packet);
+	}
+
+	Apdu command;
+	if (!command.assignHex(message.data)) {
+		LOG_DEBUG << "Invalid hexadecimal data [request:" << message.request << "][channel:" << channel << "]";
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_REQUEST, .err_client_description = "Invalid hexadecimal data" };
+		endStats(message.request, response_packet, started);
+		return sendChannelResult(NULL, channel, request_id, response_packet);
+	}
+
+	// the diagnostic is answered from the reader's state without waiting for the reader
+	int request_code = message.request;
+	ResponsePacket diag_packet;
+	if (request_code == REQ_DIAG && reader_channel->state_cache.diag(Diag::isStructured(command), &diag_packet)) {
+		endStats(request_code, diag_packet, started);
+		stampClientSend(&diag_packet.timing, received);
+		return sendChannelResult(reader_channel, channel, request_id, diag_packet);
 	}
-	return sendResult(jresponse.dump());
+
+	// the response is sent by the reader's executor, the next request can be received meanwhile
+	std::chrono::milliseconds timeout(message.timeout);
+	reader_channel->executor.submit([this, request_handler, reader_channel, channel, request_id, request_code, command, received]() {
+				recorder_.record(STAGE_TERMINAL_START, channel, request_id, request_code);
+				long long terminal_start = timingNow();
+				ResponsePacket response_packet = request_handler->run(reader_channel->terminal, this, command);
+				if (received != TIMING_NOT_STAMPED) {
+					response_packet.timing.terminal_start = terminal_start;
+					response_packet.timing.terminal_end = timingNow();
+				}
+				recorder_.record(STAGE_TERMINAL_END, channel, request_id, firstErrorCode(response_packet), response_packet.response.size());
+				reader_channel->state_cache.recordResult(request_code, response_packet);
+				return response_packet;
+			}, timeout,
+			[this, reader_channel, channel, request_id, request_code, received, started](ResponsePacket response_packet) {
+				endStats(request_code, response_packet, started);
+				stampClientSend(&response_packet.timing, received);
+				sendChannelResult(reader_channel, channel, request_id, response_packet);
+				reportLoad();
+			});
+	LOG_DEBUG << "Request queued for the reader [channel:" << channel << "][queue_depth:" << reader_channel->executor.getQueueDepth() << "]";
+	reportLoad();
+
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+ResponsePacket ClientEngine::sendChannelResult(ReaderChannel* reader_channel, int channel, unsigned long request_id, ResponsePacket response_packet) {
+	std::string result;
+	encodeResponse(response_packet, request_id, channel, compact_responses_, &result);
+	recorder_.record(STAGE_RESPONSE_SENT, (channel < 0) ? 0 : channel, request_id, firstErrorCode(response_packet), result.size());
+	if (response_packet.err_client_code == ERR_TIMEOUT) {
+		recorder_.dumpOnError();
+	}
+
+	if (reader_channel != NULL) {
+		std::lock_guard<InstrumentedMutex> guard(reader_channel->cache_mutex);
+		reader_channel->last_request_id = request_id;
+		reader_channel->last_response = result;
+	}
+
+	// responses of different readers are sent from their executors' threads
+	std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+	return sendResult(result);
 }
 
 ResponsePacket ClientEngine::sendResult(std::string result) {
@@ -241,4 +639,373 @@ ResponsePacket ClientEngine::sendResult(std::string result) {
 	return response_packet;
 }
 
+bool ClientEngine::performHandshake() {
+	std::string name = config_.getValue("name", DEFAULT_NAME);
+	if (!multi_reader_) {
+		name.append(" - ").append(reader_);
+	}
+	if (!auto_reconnect_ && !multi_reader_ && !sendsEvents()) {
+		return socket_->sendPacket(name.c_str());
+	}
+
+	nlohmann::json jhandshake;
+	jhandshake["name"] = name;
+	jhandshake["token"] = resume_token_;
+	if (sendsEvents()) {
+		jhandshake["events"] = true;
+	}
+	if (multi_reader_) {
+		std::vector<std::string> readers;
+		for (ReaderChannel* channel : channels_) {
+			readers.push_back(channel->reader);
+		}
+		jhandshake["readers"] = readers;
+	}
+	if (!socket_->sendPacket(jhandshake.dump().c_str())) {
+		return false;
+	}
+
+	char reply[DEFAULT_BUFLEN];
+	if (!socket_->receivePacket(reply)) {
+		LOG_DEBUG << "No handshake reply from the server";
+		return false;
+	}
+
+	try {
+		nlohmann::json jreply = nlohmann::json::parse(reply);
+		resume_token_ = jreply.at("token").get<std::string>();
+		if (multi_reader_) {
+			std::vector<int> ids = jreply.at("ids").get<std::vector<int>>();
+			for (unsigned int i = 0; i < ids.size() && i < channels_.size(); i++) {
+				channels_[i]->id_client = ids[i];
+			}
+			id_client_ = ids.empty() ? 0 : ids.front();
+		} else {
+			id_client_ = jreply.at("id").get<int>();
+		}
+	} catch (json::exception &err) {
+		LOG_DEBUG << "Error while parsing the handshake reply [reply:" << reply << "]";
+		return false;
+	}
+
+	LOG_DEBUG << "Handshake performed [id:" << id_client_ << "]";
+	return true;
+}
+
+bool ClientEngine::reconnect() {
+	int max_attempts = reconnect_max_attempts_;
+	long delay = reconnect_initial_delay_;
+	long max_delay = reconnect_max_delay_;
+	std::mt19937 generator(std::random_device{}());
+
+	// the terminal stays connected so that the card session is kept
+	{
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+		socket_->closeClient();
+	}
+	LOG_INFO << "Connection with the server lost, trying to reconnect [id:" << id_client_ << "]";
+
+	for (int attempt = 1; connected_.load() && (max_attempts == 0 || attempt <= max_attempts); attempt++) {
+		// exponential backoff, randomized between half and all of the delay so that clients do not reconnect together
+		std::uniform_int_distribution<long> jitter(delay / 2, delay);
+		std::this_thread::sleep_for(std::chrono::milliseconds(jitter(generator)));
+		delay = std::min(delay * 2, max_delay);
+
+		LOG_DEBUG << "Reconnection attempt " << attempt << " on IP " << ip_ << " port " << port_;
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_); // readers' executors send their responses on the same socket
+		if (!socket_->initClient(ip_.c_str(), port_.c_str()) || !socket_->connectClient()) {
+			continue;
+		}
+		if (!performHandshake()) {
+			socket_->closeClient();
+			continue;
+		}
+
+		LOG_INFO << "Client reconnected [id:" << id_client_ << "][attempts:" << attempt << "]";
+		return true;
+	}
+
+	LOG_INFO << "Client failed to reconnect";
+	return false;
+}
+
+std::size_t ClientEngine::getTerminalQueueDepth() {
+	if (multi_reader_) {
+		std::size_t queue_depth = 0;
+		for (ReaderChannel* channel : channels_) {
+			queue_depth += channel->executor.getQueueDepth();
+		}
+		return queue_depth;
+	}
+	return executor_.getQueueDepth();
+}
+
+ResponsePacket ClientEngine::getStats() {
+	nlohmann::json jstats = requestStatsToJson(total_stats_);
+	jstats["uptime"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started_).count();
+	jstats["events"] = events_sent_.load(std::memory_order_relaxed);
+	jstats["queue_depth"] = getTerminalQueueDepth();
+
+	nlohmann::json jerrors = { { "client", nlohmann::json::object() } };
+	for (int code = 1; code < STATS_ERROR_CODES; code++) {
+		jerrors["client"][std::to_string(-code)] = error_stats_.client[code].load(std::memory_order_relaxed);
+	}
+	jerrors["client"]["other"] = error_stats_.other_client.load(std::memory_order_relaxed);
+	jerrors["terminal"] = error_stats_.terminal.load(std::memory_order_relaxed);
+	jerrors["card"] = error_stats_.card.load(std::memory_order_relaxed);
+	jstats["errors_by_code"] = jerrors;
+
+	if (socket_ != NULL) {
+		const WireCounters& counters = socket_->getCounters();
+		jstats["wire"] = { { "bytes_sent", counters.bytes_sent.load(std::memory_order_relaxed) },
+				{ "bytes_received", counters.bytes_received.load(std::memory_order_relaxed) },
+				{ "packets_sent", counters.packets_sent.load(std::memory_order_relaxed) },
+				{ "packets_received", counters.packets_received.load(std::memory_order_relaxed) } };
+	}
+
+	nlohmann::json jcodes = nlohmann::json::object();
+	for (int code = 0; code < REQ_COUNT; code++) {
+		if (request_stats_[code].requests.load(std::memory_order_relaxed) > 0) {
+			jcodes[requestCodeToString((RequestCode) code)] = requestStatsToJson(request_stats_[code]);
+		}
+	}
+	jstats["requests_by_code"] = jcodes;
+	if (LockRegistry::isEnabled()) {
+		jstats["contention"] = contentionToJson();
+	}
+
+	ResponsePacket response_packet = { .response = jstats.dump() };
+	return response_packet;
+}
+
+long long ClientEngine::startStats(int request_code) {
+	total_stats_.start();
+	if (request_code >= 0 && request_code < REQ_COUNT) {
+		request_stats_[request_code].start();
+	}
+	return timingNow();
+}
+
+void ClientEngine::endStats(int request_code, const ResponsePacket& response_packet, long long started) {
+	long long duration = timingNow() - started;
+	total_stats_.end(response_packet, duration);
+	if (request_code >= 0 && request_code < REQ_COUNT) {
+		request_stats_[request_code].end(response_packet, duration);
+	}
+	error_stats_.record(response_packet);
+}
+
+std::string ClientEngine::renderMetrics() {
+	PrometheusWriter writer;
+	writer.family("gp_client_uptime_seconds", "gauge", "Time since the client was created.");
+	writer.sample("gp_client_uptime_seconds", "", (uint64_t) std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started_).count());
+	writer.family("gp_client_events_total", "counter", "Events sent to the server.");
+	writer.sample("gp_client_events_total", "", events_sent_.load(std::memory_order_relaxed));
+	writer.family("gp_client_terminal_queue_depth", "gauge", "Requests waiting for the terminals.");
+	writer.sample("gp_client_terminal_queue_depth", "", (uint64_t) getTerminalQueueDepth());
+
+	writer.family("gp_client_requests_total", "counter", "Requests received from the server.");
+	for (int code = 0; code < REQ_COUNT; code++) {
+		writer.sample("gp_client_requests_total", PrometheusWriter::label("request", requestCodeToString((RequestCode) code)),
+				request_stats_[code].requests.load(std::memory_order_relaxed));
+	}
+	writer.family("gp_client_request_errors_total", "counter", "Requests whose result holds an error code.");
+	for (int code = 0; code < REQ_COUNT; code++) {
+		writer.sample("gp_client_request_errors_total", PrometheusWriter::label("request", requestCodeToString((RequestCode) code)),
+				request_stats_[code].errors.load(std::memory_order_relaxed));
+	}
+	writer.family("gp_client_request_timeouts_total", "counter", "Requests which timed out on the terminal.");
+	writer.sample("gp_client_request_timeouts_total", "", total_stats_.timeouts.load(std::memory_order_relaxed));
+	writer.family("gp_client_requests_in_flight", "gauge", "Requests being executed.");
+	writer.sample("gp_client_requests_in_flight", "", (uint64_t) std::max<int64_t>(0, total_stats_.in_flight.load(std::memory_order_relaxed)));
+
+	writer.family("gp_client_errors_total", "counter", "Results by error code of the client.");
+	for (int code = 1; code < STATS_ERROR_CODES; code++) {
+		writer.sample("gp_client_errors_total", PrometheusWriter::label("layer", "client") + "," + PrometheusWriter::label("code", std::to_string(-code)),
+				error_stats_.client[code].load(std::memory_order_relaxed));
+	}
+	writer.sample("gp_client_errors_total", PrometheusWriter::label("layer", "terminal"), error_stats_.terminal.load(std::memory_order_relaxed));
+	writer.sample("gp_client_errors_total", PrometheusWriter::label("layer", "card"), error_stats_.card.load(std::memory_order_relaxed));
+
+	if (socket_ != NULL) {
+		const WireCounters& counters = socket_->getCounters();
+		writer.family("gp_client_bytes_sent_total", "counter", "Bytes sent to the server, length prefixes included.");
+		writer.sample("gp_client_bytes_sent_total", "", counters.bytes_sent.load(std::memory_order_relaxed));
+		writer.family("gp_client_bytes_received_total", "counter", "Bytes received from the server, length prefixes included.");
+		writer.sample("gp_client_bytes_received_total", "", counters.bytes_received.load(std::memory_order_relaxed));
+	}
+
+	writer.family("gp_client_request_duration_seconds", "summary", "Duration of the requests by request code, from their receipt to their result.");
+	for (int code = 0; code < REQ_COUNT; code++) {
+		if (request_stats_[code].requests.load(std::memory_order_relaxed) > 0) {
+			writer.summary("gp_client_request_duration_seconds", PrometheusWriter::label("request", requestCodeToString((RequestCode) code)),
+					request_stats_[code].latency, 1e-6);
+		}
+	}
+	if (LockRegistry::isEnabled()) {
+		writeContention(&writer, "gp_client");
+	}
+	return writer.str();
+}
+
+long ClientEngine::getNumber(std::string key, const char* default_value, long min) {
+	std::string value = config_.getValue(key, default_value);
+	try {
+		std::size_t parsed;
+		long number = std::stol(value, &parsed);
+		if (parsed == value.size() && number >= min) {
+			return number;
+		}
+	} catch (std::exception &err) {
+		// malformed or out of range, the default value is used
+	}
+	LOG_WARNING << "Invalid configuration value, default value used [key:" << key << "][value:" << value << "][default:" << default_value << "]";
+	return std::stol(default_value);
+}
+
+std::chrono::milliseconds ClientEngine::getTerminalIdleDelay() {
+	return terminal_idle_delay_;
+}
+
+void ClientEngine::startMonitoring() {
+	if (!monitor_events_) {
+		return;
+	}
+
+	if (!multi_reader_) {
+		ITerminalLayer::EventHandler on_event = [this](EventType event, std::string reader, std::string data) {
+			state_cache_.recordEvent(event, data);
+			sendEvent(0, event, reader, data);
+		};
+		ResponsePacket response_packet = executor_.execute(std::bind(&ITerminalLayer::startMonitoring, terminal_, on_event, true));
+		if (response_packet.err_terminal_code < 0) {
+			LOG_INFO << "Failed to monitor the reader [reader:" << reader_ << "][error:" << response_packet.err_terminal_description << "]";
+		}
+		state_cache_.setMonitored(isMonitoring(response_packet));
+		return;
+	}
+
+	bool watch_readers = true;
+	for (ReaderChannel* channel : channels_) {
+		ITerminalLayer::EventHandler on_event = [this, channel](EventType event, std::string reader, std::string data) {
+			channel->state_cache.recordEvent(event, data);
+			sendEvent(channel->channel, event, reader, data);
+		};
+		ResponsePacket response_packet = channel->executor.execute(std::bind(&ITerminalLayer::startMonitoring, channel->terminal, on_event, watch_readers));
+		channel->state_cache.setMonitored(isMonitoring(response_packet));
+		if (response_packet.err_terminal_code < 0) {
+			LOG_INFO << "Failed to monitor the reader [channel:" << channel->channel << "][reader:" << channel->reader << "][error:" << response_packet.err_terminal_description << "]";
+			continue;
+		}
+		watch_readers = false;
+	}
+}
+
+bool ClientEngine::isMonitoring(const ResponsePacket& response_packet) {
+	// terminals without monitoring answer "Not supported" without error
+	return response_packet.err_terminal_code == SUCCESS && response_packet.err_card_code == SUCCESS && response_packet.response.compare("Not supported") != 0;
+}
+
+bool ClientEngine::sendEvent(int channel, EventType event, std::string reader, std::string data) {
+	if (!connected_.load()) {
+		return false;
+	}
+
+	nlohmann::json jevent;
+	jevent["event"] = event;
+	jevent["reader"] = reader;
+	jevent["data"] = data;
+	if (multi_reader_) {
+		jevent["channel"] = channel;
+	}
+	std::string to_send = jevent.dump();
+
+	// an event raised while the connection with the server is lost is dropped
+	std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+	if (!socket_->sendPacket(to_send.c_str())) {
+		LOG_DEBUG << "Error during sendEvent [event:" << to_send << "]";
+		return false;
+	}
+	events_sent_.fetch_add(1, std::memory_order_relaxed);
+	LOG_INFO << "Event sent to server: " << to_send;
+	return true;
+}
+
+ResponsePacket ClientEngine::notifyEvent(EventType event, std::string data) {
+	if (!connected_.load() || !sendsEvents()) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "Failed to send the event: client must be connected and send events" };
+		return response_packet;
+	}
+	if (!sendEvent(0, event, "", data)) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_NETWORK, .err_client_description = "Failed to send the event" };
+		return response_packet;
+	}
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+void ClientEngine::reportLoad() {
+	if (load_event_threshold_ == 0) {
+		return;
+	}
+
+	std::size_t queue_depth = getTerminalQueueDepth();
+	bool overloaded = queue_depth >= load_event_threshold_;
+	if (overloaded_.exchange(overloaded) != overloaded) {
+		sendEvent(0, EVT_LOAD, "", std::to_string(queue_depth));
+	}
+}
+
+bool ClientEngine::sendsEvents() {
+	return monitor_events_ || load_event_threshold_ > 0;
+}
+
+TerminalStateCache* ClientEngine::getStateCache(ITerminalLayer* terminal) {
+	if (terminal == terminal_) {
+		return &state_cache_;
+	}
+	for (ReaderChannel* channel : channels_) {
+		if (channel->terminal == terminal) {
+			return &channel->state_cache;
+		}
+	}
+	return NULL;
+}
+
+void ClientEngine::refreshTerminalState(ITerminalLayer* terminal) {
+	TerminalStateCache* cache = getStateCache(terminal);
+	if (cache == NULL || cache->isStatusKnown()) {
+		return;
+	}
+
+	TerminalState status;
+	ResponsePacket response_packet = terminal->getStatus(&status);
+	if (response_packet.err_terminal_code == SUCCESS && response_packet.err_card_code == SUCCESS && response_packet.response.compare("Not supported") != 0) {
+		cache->setStatus(status);
+	}
+}
+
+int ClientEngine::storeScript(std::vector<unsigned char> program) {
+	std::lock_guard<InstrumentedMutex> guard(scripts_mutex_);
+	// handles are sent over 2 bytes, 0 is not a handle: after wrapping around, the handles of loaded scripts are skipped
+	for (int tries = 0; tries < 0xFFFF; tries++) {
+		next_script_handle_ = next_script_handle_ % 0xFFFF + 1;
+		if (scripts_.find(next_script_handle_) == scripts_.end()) {
+			scripts_[next_script_handle_] = program;
+			return next_script_handle_;
+		}
+	}
+	return 0;
+}
+
+bool ClientEngine::findScript(int handle, std::vector<unsigned char>* program) {
+	std::lock_guard<InstrumentedMutex> guard(scripts_mutex_);
+	auto it = scripts_.find(handle);
+	if (it == scripts_.end()) {
+		return false;
+	}
+	*program = it->second;
+	return true;
+}
+
 } /* namespace client */
@@ -19,6 +19,7 @@
 #define WIN32_LEAN_AND_MEAN
 
 #include "client/client_tcp_socket.hpp"
+#include "recorder/flight_recorder.hpp"
 #include "plog/include/plog/Log.h"
 
 #include <string>
@@ -29,6 +30,9 @@
 namespace client {
 
 bool ClientTCPSocket::initClient(const char* ip, const char* port) {
+	ip_ = ip;
+	port_ = port;
+
 	// initialises Winsock
 	int retval = WSAStartup(MAKEWORD(2, 2), &wsaData_);
 	if (retval != 0) {
@@ -78,6 +82,12 @@ bool ClientTCPSocket::connectClient() {
 		LOG_DEBUG << "Failed to connect: server unreachable" << "[ip:" << ip_ << "][port:" << port_ << "]";
 		return false;
 	}
+
+	// detects half-open connections so that the client can reconnect
+	BOOL keep_alive = TRUE;
+	if (setsockopt(client_socket_, SOL_SOCKET, SO_KEEPALIVE, (char*) &keep_alive, sizeof(keep_alive)) == SOCKET_ERROR) {
+		LOG_DEBUG << "Failed to call setsockopt() " << "[socket:" << client_socket_ << "][option:SO_KEEPALIVE][WSAError:" << WSAGetLastError() << "]";
+	}
 	return true;
 }
 
@@ -104,11 +114,17 @@ bool ClientTCPSocket::sendPacket(const char* packet) {
 	int retval = send(client_socket_, (char*) &net_packet_size, sizeof(int), 0);
 	if (retval == SOCKET_ERROR || retval == 0) {
 		LOG_DEBUG << "Failed to receive data from server -  " << "[socket:" << client_socket_ << "][buffer:" << net_packet_size << "][size:" << sizeof(int) << "][flags:" << NULL << "]";
+		FlightRecorder::getInstance().record(STAGE_SOCKET_SEND, client_socket_, 0, -1, packet_size);
 		return false;
 	}
 
 	// send packet's content
-	return sendData(packet, packet_size);
+	bool sent = sendData(packet, packet_size);
+	FlightRecorder::getInstance().record(STAGE_SOCKET_SEND, client_socket_, 0, sent ? 0 : -1, packet_size);
+	if (sent) {
+		counters_.sent(packet_size);
+	}
+	return sent;
 }
 
 bool ClientTCPSocket::receivePacket(char* packet) {
@@ -127,9 +143,12 @@ bool ClientTCPSocket::receivePacket(char* packet) {
 	retval = recv(client_socket_, packet, received_size, MSG_WAITALL); // wait all received_size bytes to be received
 	if (retval == SOCKET_ERROR || retval == 0) {
 		LOG_DEBUG << "Failed to receive data size from client -  " << "[socket:" << client_socket_ << "][buffer:" << received_size << "][size:" << sizeof(int) << "][flags:" << NULL << "]";
+		FlightRecorder::getInstance().record(STAGE_SOCKET_RECEIVE, client_socket_, 0, -1, received_size);
 		return false;
 	}
 	packet[retval] = '\0';
+	FlightRecorder::getInstance().record(STAGE_SOCKET_RECEIVE, client_socket_, 0, 0, retval);
+	counters_.received(retval);
 	return true;
 }
 
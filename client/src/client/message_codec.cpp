@@ -0,0 +1,414 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "client/message_codec.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace client {
+
+namespace {
+
+/**
+ * Scanner - cursor over a json text.
+ * Each method returns false on input the fixed-schema decoder does not handle, the caller then falls back to nlohmann.
+ */
+class Scanner {
+private:
+	const char* current_;
+	const char* end_;
+public:
+	Scanner(const char* begin, const char* end) : current_(begin), end_(end) {}
+
+	void skipSpaces() {
+		while (current_ < end_ && (*current_ == ' ' || *current_ == '\t' || *current_ == '\n' || *current_ == '\r')) {
+			current_++;
+		}
+	}
+
+	bool consume(char expected) {
+		skipSpaces();
+		if (current_ < end_ && *current_ == expected) {
+			current_++;
+			return true;
+		}
+		return false;
+	}
+
+	bool atEnd() {
+		skipSpaces();
+		return current_ == end_;
+	}
+
+	/**
+	 * readKey - read a key without escapes in place.
+	 */
+	bool readKey(const char** key, std::size_t* length) {
+		if (!consume('"')) {
+			return false;
+		}
+		const char* begin = current_;
+		while (current_ < end_ && *current_ != '"') {
+			if (*current_ == '\\') {
+				return false;
+			}
+			current_++;
+		}
+		if (current_ == end_) {
+			return false;
+		}
+		*key = begin;
+		*length = current_++ - begin;
+		return consume(':');
+	}
+
+	bool readString(std::string* value) {
+		if (!consume('"')) {
+			return false;
+		}
+		value->clear();
+		while (current_ < end_) {
+			const char* run = current_;
+			while (current_ < end_ && *current_ != '"' && *current_ != '\\' && (unsigned char) *current_ >= 0x20) {
+				current_++;
+			}
+			value->append(run, current_ - run);
+			if (current_ == end_ || (unsigned char) *current_ < 0x20) {
+				return false;
+			}
+			if (*current_++ == '"') {
+				return true;
+			}
+			if (current_ == end_) {
+				return false;
+			}
+			char escaped = *current_++;
+			switch (escaped) {
+			case '"':
+			case '\\':
+			case '/':
+				value->push_back(escaped);
+				break;
+			case 'b':
+				value->push_back('\b');
+				break;
+			case 'f':
+				value->push_back('\f');
+				break;
+			case 'n':
+				value->push_back('\n');
+				break;
+			case 'r':
+				value->push_back('\r');
+				break;
+			case 't':
+				value->push_back('\t');
+				break;
+			case 'u':
+				if (!readCodePoint(value)) {
+					return false;
+				}
+				break;
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+
+	bool readBoolean(bool* value) {
+		skipSpaces();
+		if (end_ - current_ >= 4 && std::memcmp(current_, "true", 4) == 0) {
+			current_ += 4;
+			*value = true;
+			return true;
+		}
+		if (end_ - current_ >= 5 && std::memcmp(current_, "false", 5) == 0) {
+			current_ += 5;
+			*value = false;
+			return true;
+		}
+		return false;
+	}
+
+	template<typename T>
+	bool readInteger(T* value) {
+		skipSpaces();
+		bool negative = current_ < end_ && *current_ == '-';
+		if (negative) {
+			current_++;
+		}
+		if (current_ == end_ || *current_ < '0' || *current_ > '9') {
+			return false;
+		}
+		if (*current_ == '0' && current_ + 1 < end_ && current_[1] >= '0' && current_[1] <= '9') {
+			return false; // leading zeros are not valid json
+		}
+		unsigned long long magnitude = 0;
+		int digits = 0;
+		while (current_ < end_ && *current_ >= '0' && *current_ <= '9') {
+			if (++digits > 18) {
+				return false;
+			}
+			magnitude = magnitude * 10 + (*current_++ - '0');
+		}
+		if (current_ < end_ && (*current_ == '.' || *current_ == 'e' || *current_ == 'E')) {
+			return false;
+		}
+		long long signed_value = negative ? -(long long) magnitude : (long long) magnitude;
+		if (signed_value < (long long) std::numeric_limits<T>::min() || (!negative && magnitude > (unsigned long long) std::numeric_limits<T>::max())) {
+			return false;
+		}
+		*value = (T) signed_value;
+		return true;
+	}
+private:
+	bool readCodePoint(std::string* value) {
+		if (end_ - current_ < 4) {
+			return false;
+		}
+		unsigned int code = 0;
+		for (int i = 0; i < 4; i++) {
+			char digit = *current_++;
+			code <<= 4;
+			if (digit >= '0' && digit <= '9') {
+				code |= digit - '0';
+			} else if (digit >= 'a' && digit <= 'f') {
+				code |= digit - 'a' + 10;
+			} else if (digit >= 'A' && digit <= 'F') {
+				code |= digit - 'A' + 10;
+			} else {
+				return false;
+			}
+		}
+		if (code >= 0xD800 && code <= 0xDFFF) {
+			return false; // surrogate pairs are left to nlohmann
+		}
+		if (code < 0x80) {
+			value->push_back((char) code);
+		} else if (code < 0x800) {
+			value->push_back((char) (0xC0 | (code >> 6)));
+			value->push_back((char) (0x80 | (code & 0x3F)));
+		} else {
+			value->push_back((char) (0xE0 | (code >> 12)));
+			value->push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+			value->push_back((char) (0x80 | (code & 0x3F)));
+		}
+		return true;
+	}
+};
+
+inline bool isKey(const char* key, std::size_t length, const char* expected) {
+	return std::strlen(expected) == length && std::memcmp(key, expected, length) == 0;
+}
+
+inline void appendUnsigned(std::string* text, unsigned long long value) {
+	char buffer[24];
+	char* position = buffer + sizeof(buffer);
+	do {
+		*--position = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	text->append(position, buffer + sizeof(buffer) - position);
+}
+
+inline void appendInteger(std::string* text, long long value) {
+	if (value < 0) {
+		text->push_back('-');
+		appendUnsigned(text, 0ULL - (unsigned long long) value);
+	} else {
+		appendUnsigned(text, (unsigned long long) value);
+	}
+}
+
+/**
+ * appendString - append a json string escaped the way nlohmann does.
+ */
+inline void appendString(std::string* text, const char* value, std::size_t length) {
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	text->push_back('"');
+	const char* run = value;
+	const char* end = run + length;
+	for (const char* current = run; current < end; current++) {
+		unsigned char byte = (unsigned char) *current;
+		if (byte >= 0x20 && byte != '"' && byte != '\\') {
+			continue;
+		}
+		text->append(run, current - run);
+		run = current + 1;
+		switch (byte) {
+		case '"':
+			text->append("\\\"", 2);
+			break;
+		case '\\':
+			text->append("\\\\", 2);
+			break;
+		case '\b':
+			text->append("\\b", 2);
+			break;
+		case '\f':
+			text->append("\\f", 2);
+			break;
+		case '\n':
+			text->append("\\n", 2);
+			break;
+		case '\r':
+			text->append("\\r", 2);
+			break;
+		case '\t':
+			text->append("\\t", 2);
+			break;
+		default:
+			char escaped[6] = { '\\', 'u', '0', '0', HEX_DIGITS[byte >> 4], HEX_DIGITS[byte & 0x0F] };
+			text->append(escaped, sizeof(escaped));
+			break;
+		}
+	}
+	text->append(run, end - run);
+	text->push_back('"');
+}
+
+inline void appendString(std::string* text, const std::string& value) {
+	appendString(text, value.data(), value.size());
+}
+
+/**
+ * appendKey - append the separator if needed and the given key.
+ */
+inline void appendKey(std::string* text, const char* key) {
+	if (text->back() != '{') {
+		text->push_back(',');
+	}
+	text->push_back('"');
+	text->append(key);
+	text->append("\":", 2);
+}
+
+inline void appendCode(std::string* text, const char* key, long int code, bool compact) {
+	if (!compact || code != SUCCESS) {
+		appendKey(text, key);
+		appendInteger(text, code);
+	}
+}
+
+inline void appendDescription(std::string* text, const char* key, const char* id_key, const Description& description, bool compact) {
+	if (!compact) {
+		appendKey(text, key);
+		appendString(text, description.c_str(), description.size());
+	} else if (!description.isDefault()) {
+		int id = findInternedDescription(description.c_str(), description.size());
+		if (id >= 0) {
+			appendKey(text, id_key);
+			appendInteger(text, id);
+		} else {
+			appendKey(text, key);
+			appendString(text, description.c_str(), description.size());
+		}
+	}
+}
+
+} // namespace
+
+bool decodeRequest(const std::string& text, RequestMessage* message) {
+	Scanner scanner(text.data(), text.data() + text.size());
+	bool has_request = false;
+	bool has_timeout = false;
+	bool has_data = false;
+	message->id = 0;
+	message->channel = 0;
+	message->timing = false;
+
+	if (!scanner.consume('{')) {
+		return false;
+	}
+	if (!scanner.consume('}')) {
+		do {
+			const char* key;
+			std::size_t length;
+			if (!scanner.readKey(&key, &length)) {
+				return false;
+			}
+			bool valid;
+			if (isKey(key, length, "id")) {
+				valid = scanner.readInteger(&message->id);
+			} else if (isKey(key, length, "request")) {
+				valid = has_request = scanner.readInteger(&message->request);
+			} else if (isKey(key, length, "data")) {
+				valid = has_data = scanner.readString(&message->data);
+			} else if (isKey(key, length, "timeout")) {
+				valid = has_timeout = scanner.readInteger(&message->timeout);
+			} else if (isKey(key, length, "channel")) {
+				valid = scanner.readInteger(&message->channel);
+			} else if (isKey(key, length, "timing")) {
+				valid = scanner.readBoolean(&message->timing);
+			} else {
+				return false; // unknown field
+			}
+			if (!valid) {
+				return false;
+			}
+		} while (scanner.consume(','));
+		if (!scanner.consume('}')) {
+			return false;
+		}
+	}
+	return has_request && has_data && has_timeout && scanner.atEnd();
+}
+
+void encodeResponse(const ResponsePacket& response_packet, unsigned long id, int channel, bool compact, std::string* text) {
+	text->clear();
+	text->push_back('{');
+	if (channel >= 0) {
+		appendKey(text, "channel");
+		appendInteger(text, channel);
+	}
+	appendDescription(text, "client_description", "client_description_id", response_packet.err_client_description, compact);
+	appendCode(text, "err_card_code", response_packet.err_card_code, compact);
+	appendDescription(text, "err_card_description", "err_card_description_id", response_packet.err_card_description, compact);
+	appendCode(text, "err_client_code", response_packet.err_client_code, compact);
+	appendCode(text, "err_server_code", response_packet.err_server_code, compact);
+	appendDescription(text, "err_server_description", "err_server_description_id", response_packet.err_server_description, compact);
+	appendCode(text, "err_terminal_code", response_packet.err_terminal_code, compact);
+	appendKey(text, "id");
+	appendUnsigned(text, id);
+	if (!compact || response_packet.response != "OK") {
+		appendKey(text, "response");
+		appendString(text, response_packet.response);
+	}
+	appendDescription(text, "terminal_description", "terminal_description_id", response_packet.err_terminal_description, compact);
+	const RequestTiming& timing = response_packet.timing;
+	if (timing.client_receive != TIMING_NOT_STAMPED) {
+		appendKey(text, "timing");
+		text->push_back('[');
+		appendInteger(text, timingElapsed(timing.client_receive, timing.terminal_start));
+		text->push_back(',');
+		appendInteger(text, timingElapsed(timing.client_receive, timing.terminal_end));
+		text->push_back(',');
+		appendInteger(text, timingElapsed(timing.client_receive, timing.client_send));
+		text->push_back(']');
+	}
+	if (!response_packet.transcript.empty()) {
+		appendKey(text, "transcript");
+		appendString(text, response_packet.transcript);
+	}
+	text->push_back('}');
+}
+
+} /* namespace client */
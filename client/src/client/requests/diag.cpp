@@ -16,13 +16,39 @@
  *********************************************************************************/
 
 #include "client/requests/diag.hpp"
+#include "client/client_engine.hpp"
+#include "terminal/terminal_state.hpp"
 #include "plog/include/plog/Log.h"
 
 namespace client {
 
-ResponsePacket Diag::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
+ResponsePacket Diag::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
 	LOG_INFO << "Request \"diag\" is being processed";
-	return terminal->diag();
+	TerminalStateCache* cache = client_engine->getStateCache(terminal);
+	if (cache == NULL) {
+		return terminal->diag();
+	}
+
+	// the state is only read from the terminal when it is not known anymore or when the card events are not monitored
+	bool structured = isStructured(command);
+	if (!cache->isMonitored()) {
+		cache->invalidate(); // the card may have been removed since the state was read
+	}
+	client_engine->refreshTerminalState(terminal);
+	ResponsePacket response_packet;
+	if (cache->diag(structured, &response_packet)) {
+		return response_packet;
+	}
+	if (!structured) {
+		return terminal->diag();
+	}
+	nlohmann::json jstate = cache->getState();
+	response_packet.response = jstate.dump();
+	return response_packet;
+}
+
+bool Diag::isStructured(const Apdu& command) {
+	return command.size() == 1 && command[0] == 0x01;
 }
 
 } /* namespace client */
@@ -21,7 +21,7 @@
 
 namespace client {
 
-ResponsePacket Disconnect::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
+ResponsePacket Disconnect::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
 	return client_engine->disconnectClient();
 }
 
@@ -20,7 +20,7 @@
 
 namespace client {
 
-ResponsePacket Echo::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
+ResponsePacket Echo::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
 	LOG_INFO << "Request \"echo\" is being processed";
 	return terminal->isAlive();
 }
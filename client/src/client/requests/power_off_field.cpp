@@ -20,7 +20,7 @@
 
 namespace client {
 
-ResponsePacket PowerOffField::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
+ResponsePacket PowerOffField::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
 	return terminal->powerOFFField();
 }
 
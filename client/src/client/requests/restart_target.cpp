@@ -20,7 +20,7 @@
 
 namespace client {
 
-ResponsePacket RestartTarget::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
+ResponsePacket RestartTarget::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
 	LOG_INFO << "Request \"restart target\" is being processed";
 	return terminal->restart();
 }
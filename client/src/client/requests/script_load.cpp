@@ -0,0 +1,49 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "client/client_engine.hpp"
+#include "client/requests/script_load.hpp"
+#include "script/script_interpreter.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <vector>
+
+namespace client {
+
+ResponsePacket ScriptLoad::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
+	LOG_INFO << "Request \"script load\" is being processed";
+	std::vector<unsigned char> program(command.data(), command.data() + command.size());
+
+	// the program is checked once here, so that running it needs no bounds checks
+	std::string error;
+	ScriptInterpreter interpreter(0);
+	if (!interpreter.validate(program, &error)) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_SCRIPT, .err_client_description = "Invalid script: " + error };
+		return response_packet;
+	}
+
+	int handle = client_engine->storeScript(program);
+	if (handle == 0) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_SCRIPT, .err_client_description = "Too many scripts loaded" };
+		return response_packet;
+	}
+	LOG_DEBUG << "Script loaded [handle:" << handle << "][size:" << program.size() << "]";
+	ResponsePacket response_packet = { .response = std::to_string(handle) };
+	return response_packet;
+}
+
+} /* namespace client */
@@ -0,0 +1,56 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "client/client_engine.hpp"
+#include "client/requests/script_run.hpp"
+#include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
+#include "script/script_interpreter.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <vector>
+
+namespace client {
+
+ResponsePacket ScriptRun::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
+	LOG_INFO << "Request \"script run\" is being processed";
+
+	// data: handle (2 bytes) followed by the parameters, each one prefixed with its length (1 byte)
+	std::vector<unsigned char> program;
+	if (command.size() < 2 || !client_engine->findScript((command[0] << 8) | command[1], &program)) {
+		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_SCRIPT, .err_client_description = "Unknown script handle" };
+		return response_packet;
+	}
+
+	std::vector<std::vector<unsigned char>> variables;
+	unsigned long int position = 2;
+	while (position < command.size()) {
+		unsigned long int length = command[position++];
+		if (position + length > command.size()) {
+			ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_SCRIPT, .err_client_description = "Malformed script parameters" };
+			return response_packet;
+		}
+		variables.emplace_back(command.data() + position, command.data() + position + length);
+		position += length;
+	}
+
+	unsigned long max_steps = std::stoul(ConfigWrapper::getInstance().getValue("script_max_steps", DEFAULT_SCRIPT_MAX_STEPS));
+	ScriptInterpreter interpreter(max_steps);
+	return interpreter.run(terminal, program, variables);
+}
+
+} /* namespace client */
@@ -20,8 +20,8 @@
 
 namespace client {
 
-ResponsePacket SendTypeA::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
-	return terminal->sendTypeA(command, command_length);
+ResponsePacket SendTypeA::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
+	return terminal->sendTypeA(command);
 }
 
 } /* namespace client */
@@ -20,8 +20,8 @@
 
 namespace client {
 
-ResponsePacket SendTypeB::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
-	return terminal->sendTypeB(command, command_length);
+ResponsePacket SendTypeB::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
+	return terminal->sendTypeB(command);
 }
 
 } /* namespace client */
@@ -20,8 +20,8 @@
 
 namespace client {
 
-ResponsePacket SendTypeF::run(ITerminalLayer* terminal, ClientEngine* client_engine, char unsigned command[], unsigned long int command_length) {
-	return terminal->sendTypeF(command, command_length);
+ResponsePacket SendTypeF::run(ITerminalLayer* terminal, ClientEngine* client_engine, const Apdu& command) {
+	return terminal->sendTypeF(command);
 }
 
 } /* namespace client */
@@ -26,6 +26,8 @@
 #include "client/requests/request.hpp"
 #include "client/requests/request.hpp"
 #include "client/requests/restart_target.hpp"
+#include "client/requests/script_load.hpp"
+#include "client/requests/script_run.hpp"
 #include "client/requests/send_typeA.hpp"
 #include "client/requests/send_typeB.hpp"
 #include "client/requests/send_typeF.hpp"
@@ -33,14 +35,98 @@
 #include "constants/request_code.hpp"
 #include "terminal/factories/example_factory_pcsc_contact.hpp"
 #include "terminal/factories/example_factory_pcsc_contactless.hpp"
+#include "terminal/factories/replay_factory.hpp"
+#include "terminal/factories/simulated_factory.hpp"
 #include "terminal/flyweight_terminal_factory.hpp"
 #include "terminal/terminals/example_pcsc_contact.hpp"
+#include "terminal/terminals/utils/type_converter.hpp"
 #include "dll/dll_client_api_wrapper.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 using namespace client;
 
+/**
+ * ResultSlot - a result of the handle-based functions, kept in a pool once released.
+ */
+struct ResultSlot {
+	ResponsePacket response_packet;
+};
+
+namespace {
+
+std::mutex result_pool_mutex;
+std::vector<ResultSlot*> result_pool;
+
+/**
+ * copyText - bounded copy of a text into a fixed-size buffer of the ResponseDLL struct.
+ */
+void copyText(char* destination, std::size_t size, const char* text) {
+	strncpy(destination, text, size - 1);
+	destination[size - 1] = '\0';
+}
+
+const char* resultText(ResultHandle handle, int field, std::size_t* length) {
+	const ResponsePacket& response_packet = handle->response_packet;
+	switch (field) {
+	case RESULT_RESPONSE:
+		*length = response_packet.response.size();
+		return response_packet.response.c_str();
+	case RESULT_SERVER_DESCRIPTION:
+		*length = response_packet.err_server_description.size();
+		return response_packet.err_server_description.c_str();
+	case RESULT_CLIENT_DESCRIPTION:
+		*length = response_packet.err_client_description.size();
+		return response_packet.err_client_description.c_str();
+	case RESULT_TERMINAL_DESCRIPTION:
+		*length = response_packet.err_terminal_description.size();
+		return response_packet.err_terminal_description.c_str();
+	case RESULT_CARD_DESCRIPTION:
+		*length = response_packet.err_card_description.size();
+		return response_packet.err_card_description.c_str();
+	default:
+		*length = 0;
+		return "";
+	}
+}
+
+/**
+ * initClientWithDefaults - initialize the client with the terminals and requests available from the DLL.
+ */
+ResponsePacket initClientWithDefaults(client::ClientAPI* client, const char* jsonConfig) {
+	// config available terminal factories
+	FlyweightTerminalFactory available_terminals;
+	available_terminals.addFactory("EXAMPLE_PCSC_CONTACT", new ExamplePCSCContactFactory());
+	available_terminals.addFactory("EXAMPLE_PCSC_CONTACTLESS", new ExamplePCSCContactlessFactory());
+	available_terminals.addFactory("SIMULATED", new SimulatedFactory());
+	available_terminals.addFactory("REPLAY", new ReplayFactory());
+
+	// config all requests the client can handle
+	FlyweightRequests available_requests;
+	available_requests.addRequest(REQ_COMMAND, new Command());
+	available_requests.addRequest(REQ_COMMAND_A, new SendTypeA());
+	available_requests.addRequest(REQ_COMMAND_B, new SendTypeB());
+	available_requests.addRequest(REQ_COMMAND_F, new SendTypeF());
+	available_requests.addRequest(REQ_DIAG, new Diag());
+	available_requests.addRequest(REQ_DISCONNECT, new Disconnect());
+	available_requests.addRequest(REQ_ECHO, new Echo());
+	available_requests.addRequest(REQ_RESTART, new RestartTarget());
+	available_requests.addRequest(REQ_COLD_RESET, new ColdReset());
+	available_requests.addRequest(REQ_WARM_RESET, new WarmReset());
+	available_requests.addRequest(REQ_POWER_OFF_FIELD, new PowerOffField());
+	available_requests.addRequest(REQ_POWER_ON_FIELD, new PowerOnField());
+	available_requests.addRequest(REQ_SCRIPT_LOAD, new ScriptLoad());
+	available_requests.addRequest(REQ_SCRIPT_RUN, new ScriptRun());
+
+	return client->initClient((jsonConfig != NULL) ? jsonConfig : "config/init.json", available_terminals, available_requests);
+}
+
+} // namespace
+
 void setCallbackConnectionLost(client::Callback handler) {
 	notifyConnectionLost = handler;
 }
@@ -68,28 +154,18 @@ void disconnectClient(client::ClientAPI* client, ResponseDLL& response_packet_dl
 	responsePacketForDll(response_packet, response_packet_dll);
 }
 
-void initClient(client::ClientAPI* client, const char* jsonConfig, ResponseDLL& response_packet_dll) {
-	// config available terminal factories
-	FlyweightTerminalFactory available_terminals;
-	available_terminals.addFactory("EXAMPLE_PCSC_CONTACT", new ExamplePCSCContactFactory());
-	available_terminals.addFactory("EXAMPLE_PCSC_CONTACTLESS", new ExamplePCSCContactlessFactory());
+void dumpFlightRecorder(client::ClientAPI* client, const char* path, ResponseDLL& response_packet_dll) {
+	ResponsePacket response_packet = client->dumpFlightRecorder((path != NULL) ? path : DEFAULT_RECORDER_FILE);
+	responsePacketForDll(response_packet, response_packet_dll);
+}
 
-	// config all requests the client can handle
-	FlyweightRequests available_requests;
-	available_requests.addRequest(REQ_COMMAND, new Command());
-	available_requests.addRequest(REQ_COMMAND_A, new SendTypeA());
-	available_requests.addRequest(REQ_COMMAND_B, new SendTypeB());
-	available_requests.addRequest(REQ_COMMAND_F, new SendTypeF());
-	available_requests.addRequest(REQ_DIAG, new Diag());
-	available_requests.addRequest(REQ_DISCONNECT, new Disconnect());
-	available_requests.addRequest(REQ_ECHO, new Echo());
-	available_requests.addRequest(REQ_RESTART, new RestartTarget());
-	available_requests.addRequest(REQ_COLD_RESET, new ColdReset());
-	available_requests.addRequest(REQ_WARM_RESET, new WarmReset());
-	available_requests.addRequest(REQ_POWER_OFF_FIELD, new PowerOffField());
-	available_requests.addRequest(REQ_POWER_ON_FIELD, new PowerOnField());
+void getStats(client::ClientAPI* client, ResponseDLL& response_packet_dll) {
+	ResponsePacket response_packet = client->getStats();
+	responsePacketForDll(response_packet, response_packet_dll);
+}
 
-	ResponsePacket response_packet = client->initClient((jsonConfig != NULL) ? jsonConfig : "config/init.json", available_terminals, available_requests);
+void initClient(client::ClientAPI* client, const char* jsonConfig, ResponseDLL& response_packet_dll) {
+	ResponsePacket response_packet = initClientWithDefaults(client, jsonConfig);
 	responsePacketForDll(response_packet, response_packet_dll);
 }
 
@@ -103,18 +179,110 @@ void connectClient(client::ClientAPI* client, const char* reader, const char* ip
 	responsePacketForDll(response_packet, response_packet_dll);
 }
 
+void connectAllReaders(client::ClientAPI* client, const char* ip, const char* port, ResponseDLL& response_packet_dll) {
+	ResponsePacket response_packet = client->connectAllReaders(ip, port);
+	responsePacketForDll(response_packet, response_packet_dll);
+}
+
 void responsePacketForDll(ResponsePacket response_packet, ResponseDLL& response_packet_dll) {
-	strcpy(response_packet_dll.response, response_packet.response.c_str());
+	copyText(response_packet_dll.response, DEFAULT_DLL_BUFFER_SIZE_EXTENDED, response_packet.response.c_str());
 
 	response_packet_dll.err_server_code = response_packet.err_server_code;
-	strcpy(response_packet_dll.err_server_description, response_packet.err_server_description.c_str());
+	copyText(response_packet_dll.err_server_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_server_description.c_str());
 
 	response_packet_dll.err_client_code = response_packet.err_client_code;
-	strcpy(response_packet_dll.err_client_description, response_packet.err_client_description.c_str());
+	copyText(response_packet_dll.err_client_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_client_description.c_str());
 
 	response_packet_dll.err_terminal_code = response_packet.err_terminal_code;
-	strcpy(response_packet_dll.err_terminal_description, response_packet.err_terminal_description.c_str());
+	copyText(response_packet_dll.err_terminal_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_terminal_description.c_str());
 
 	response_packet_dll.err_card_code = response_packet.err_card_code;
-	strcpy(response_packet_dll.err_card_description, response_packet.err_card_description.c_str());
+	copyText(response_packet_dll.err_card_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_card_description.c_str());
+}
+
+ResultHandle acquireResult(ResponsePacket response_packet, ResultDLL& result) {
+	ResultSlot* slot = NULL;
+	{
+		std::lock_guard<std::mutex> guard(result_pool_mutex);
+		if (!result_pool.empty()) {
+			slot = result_pool.back();
+			result_pool.pop_back();
+		}
+	}
+	if (slot == NULL) {
+		slot = new ResultSlot();
+	}
+	slot->response_packet = std::move(response_packet);
+
+	result.err_server_code = slot->response_packet.err_server_code;
+	result.err_client_code = slot->response_packet.err_client_code;
+	result.err_terminal_code = slot->response_packet.err_terminal_code;
+	result.err_card_code = slot->response_packet.err_card_code;
+	for (int field = 0; field < RESULT_FIELD_COUNT; field++) {
+		std::size_t length;
+		resultText(slot, field, &length);
+		result.lengths[field] = length;
+	}
+	return slot;
+}
+
+ResultHandle initClientResult(client::ClientAPI* client, const char* jsonConfig, ResultDLL& result) {
+	return acquireResult(initClientWithDefaults(client, jsonConfig), result);
+}
+
+ResultHandle loadAndListReadersResult(client::ClientAPI* client, ResultDLL& result) {
+	return acquireResult(client->loadAndListReaders(), result);
+}
+
+ResultHandle connectClientResult(client::ClientAPI* client, const char* reader, const char* ip, const char* port, ResultDLL& result) {
+	return acquireResult(client->connectClient(reader, ip, port), result);
+}
+
+ResultHandle connectAllReadersResult(client::ClientAPI* client, const char* ip, const char* port, ResultDLL& result) {
+	return acquireResult(client->connectAllReaders(ip, port), result);
+}
+
+ResultHandle disconnectClientResult(client::ClientAPI* client, ResultDLL& result) {
+	return acquireResult(client->disconnectClient(), result);
+}
+
+unsigned long getResultBytes(ResultHandle handle, unsigned char* buffer, unsigned long length) {
+	const std::string& response = handle->response_packet.response;
+	// decoded straight into the caller's buffer: a buffer too short is not written, the size it needs is returned
+	unsigned long int capacity = utils::hexDecodedCapacity(response.size());
+	if (length < capacity) {
+		return capacity;
+	}
+	unsigned long int decoded;
+	return utils::hexDecode(response.data(), response.size(), buffer, &decoded) ? decoded : 0;
+}
+
+unsigned long getResultText(ResultHandle handle, int field, char* buffer, unsigned long size) {
+	std::size_t length;
+	const char* text = resultText(handle, field, &length);
+	if (size > 0) {
+		std::size_t copied = std::min<std::size_t>(length, size - 1);
+		std::memcpy(buffer, text, copied);
+		buffer[copied] = '\0';
+	}
+	return length;
+}
+
+const char* getResultView(ResultHandle handle, int field) {
+	std::size_t length;
+	return resultText(handle, field, &length);
+}
+
+void releaseResult(ResultHandle handle) {
+	if (handle == NULL) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(result_pool_mutex);
+		if (result_pool.size() < DEFAULT_DLL_RESULT_POOL_SIZE) {
+			result_pool.push_back(handle);
+			return;
+		}
+	}
+	delete handle;
 }
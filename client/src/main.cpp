@@ -26,6 +26,8 @@
 #include "client/requests/request.hpp"
 #include "client/requests/request.hpp"
 #include "client/requests/restart_target.hpp"
+#include "client/requests/script_load.hpp"
+#include "client/requests/script_run.hpp"
 #include "client/requests/send_typeA.hpp"
 #include "client/requests/send_typeB.hpp"
 #include "client/requests/send_typeF.hpp"
@@ -33,6 +35,8 @@
 #include "constants/request_code.hpp"
 #include "terminal/factories/example_factory_pcsc_contact.hpp"
 #include "terminal/factories/example_factory_pcsc_contactless.hpp"
+#include "terminal/factories/replay_factory.hpp"
+#include "terminal/factories/simulated_factory.hpp"
 #include "terminal/flyweight_terminal_factory.hpp"
 #include "terminal/terminals/example_pcsc_contact.hpp"
 
@@ -43,6 +47,8 @@ int __cdecl main(void) {
 	FlyweightTerminalFactory available_terminals;
 	available_terminals.addFactory("EXAMPLE_PCSC_CONTACT", new ExamplePCSCContactFactory());
 	available_terminals.addFactory("EXAMPLE_PCSC_CONTACTLESS", new ExamplePCSCContactlessFactory());
+	available_terminals.addFactory("SIMULATED", new SimulatedFactory());
+	available_terminals.addFactory("REPLAY", new ReplayFactory());
 
 	// config all requests the client can handle
 	FlyweightRequests available_requests;
@@ -58,6 +64,8 @@ int __cdecl main(void) {
 	available_requests.addRequest(REQ_WARM_RESET, new WarmReset());
 	available_requests.addRequest(REQ_POWER_OFF_FIELD, new PowerOffField());
 	available_requests.addRequest(REQ_POWER_ON_FIELD, new PowerOnField());
+	available_requests.addRequest(REQ_SCRIPT_LOAD, new ScriptLoad());
+	available_requests.addRequest(REQ_SCRIPT_RUN, new ScriptRun());
 
 	ClientAPI* client = new ClientAPI(0, 0, 0);
 	client->initClient("./config/init.json", available_terminals, available_requests);
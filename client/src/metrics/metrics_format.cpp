@@ -0,0 +1,155 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "metrics/metrics_format.hpp"
+
+#include <cstdio>
+
+namespace client {
+
+nlohmann::json histogramToJson(const LatencyHistogram& histogram) {
+	return {
+		{ "count", histogram.getCount() }, { "mean", histogram.getMean() },
+		{ "p50", histogram.getPercentile(50) }, { "p90", histogram.getPercentile(90) }, { "p99", histogram.getPercentile(99) },
+		{ "p999", histogram.getPercentile(99.9) }, { "max", histogram.getMax() }
+	};
+}
+
+nlohmann::json requestStatsToJson(const RequestStats& stats) {
+	return {
+		{ "requests", stats.requests.load(std::memory_order_relaxed) }, { "errors", stats.errors.load(std::memory_order_relaxed) },
+		{ "timeouts", stats.timeouts.load(std::memory_order_relaxed) }, { "in_flight", stats.in_flight.load(std::memory_order_relaxed) },
+		{ "latency", histogramToJson(stats.latency) }
+	};
+}
+
+nlohmann::json contentionToJson() {
+	nlohmann::json jlocks = nlohmann::json::array();
+	for (const auto &lock : LockRegistry::getInstance().snapshot()) {
+		jlocks.push_back({ { "name", lock->name }, { "acquisitions", lock->acquisitions.load(std::memory_order_relaxed) },
+				{ "contended", lock->contended.load(std::memory_order_relaxed) }, { "wait_ns", histogramToJson(lock->wait) },
+				{ "hold_ns", histogramToJson(lock->hold) } });
+	}
+
+	uint64_t live = 0;
+	nlohmann::json jthreads = nlohmann::json::array();
+	for (const ThreadUsage& usage : ThreadRegistry::getInstance().snapshot()) {
+		const ThreadStats& stats = *usage.stats;
+		live += stats.live.load(std::memory_order_relaxed);
+		jthreads.push_back({ { "name", stats.name }, { "started", stats.started.load(std::memory_order_relaxed) },
+				{ "live", stats.live.load(std::memory_order_relaxed) }, { "peak", stats.peak.load(std::memory_order_relaxed) },
+				{ "cpu_us", usage.cpu_time }, { "lifetime_us", histogramToJson(stats.lifetime) } });
+	}
+	return { { "locks", jlocks }, { "threads", jthreads }, { "live_threads", live } };
+}
+
+void PrometheusWriter::family(const char* name, const char* type, const char* help) {
+	text_.append("# HELP ").append(name).append(" ").append(help).append("\n");
+	text_.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+void PrometheusWriter::sample(const char* name, const std::string& labels, uint64_t value) {
+	char buffer[24];
+	snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long) value);
+	text_.append(name);
+	if (!labels.empty()) {
+		text_.append("{").append(labels).append("}");
+	}
+	text_.append(" ").append(buffer).append("\n");
+}
+
+void PrometheusWriter::sample(const char* name, const std::string& labels, double value) {
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.9g", value);
+	text_.append(name);
+	if (!labels.empty()) {
+		text_.append("{").append(labels).append("}");
+	}
+	text_.append(" ").append(buffer).append("\n");
+}
+
+void PrometheusWriter::summary(const char* name, const std::string& labels, const LatencyHistogram& histogram, double scale) {
+	static const char* QUANTILES[] = { "0.5", "0.9", "0.99", "0.999" };
+	static const double PERCENTILES[] = { 50, 90, 99, 99.9 };
+	std::string separator = labels.empty() ? "" : ",";
+	for (int i = 0; i < 4; i++) {
+		sample(name, labels + separator + label("quantile", QUANTILES[i]), histogram.getPercentile(PERCENTILES[i]) * scale);
+	}
+	std::string metric = name;
+	sample((metric + "_sum").c_str(), labels, histogram.getSum() * scale);
+	sample((metric + "_count").c_str(), labels, histogram.getCount());
+}
+
+std::string PrometheusWriter::label(const char* key, const std::string& value) {
+	std::string text = key;
+	text.append("=\"");
+	for (char c : value) {
+		if (c == '\\' || c == '"') {
+			text.push_back('\\');
+			text.push_back(c);
+		} else if (c == '\n') {
+			text.append("\\n");
+		} else {
+			text.push_back(c);
+		}
+	}
+	text.push_back('"');
+	return text;
+}
+
+void writeContention(PrometheusWriter* writer, const std::string& prefix) {
+	std::vector<std::shared_ptr<LockStats>> locks = LockRegistry::getInstance().snapshot();
+	std::string acquisitions = prefix + "_lock_acquisitions_total";
+	writer->family(acquisitions.c_str(), "counter", "Acquisitions of the instrumented locks.");
+	for (const auto &lock : locks) {
+		writer->sample(acquisitions.c_str(), PrometheusWriter::label("lock", lock->name), lock->acquisitions.load(std::memory_order_relaxed));
+	}
+	std::string contended = prefix + "_lock_contended_total";
+	writer->family(contended.c_str(), "counter", "Acquisitions of the instrumented locks which waited for another thread.");
+	for (const auto &lock : locks) {
+		writer->sample(contended.c_str(), PrometheusWriter::label("lock", lock->name), lock->contended.load(std::memory_order_relaxed));
+	}
+	std::string wait = prefix + "_lock_wait_seconds";
+	writer->family(wait.c_str(), "summary", "Waiting time of the contended acquisitions.");
+	for (const auto &lock : locks) {
+		writer->summary(wait.c_str(), PrometheusWriter::label("lock", lock->name), lock->wait, 1e-9);
+	}
+	std::string hold = prefix + "_lock_hold_seconds";
+	writer->family(hold.c_str(), "summary", "Time the instrumented locks are held.");
+	for (const auto &lock : locks) {
+		writer->summary(hold.c_str(), PrometheusWriter::label("lock", lock->name), lock->hold, 1e-9);
+	}
+
+	std::vector<ThreadUsage> threads = ThreadRegistry::getInstance().snapshot();
+	std::string started = prefix + "_threads_started_total";
+	writer->family(started.c_str(), "counter", "Threads started, by purpose.");
+	for (const ThreadUsage& usage : threads) {
+		writer->sample(started.c_str(), PrometheusWriter::label("thread", usage.stats->name), usage.stats->started.load(std::memory_order_relaxed));
+	}
+	std::string live = prefix + "_threads";
+	writer->family(live.c_str(), "gauge", "Live threads, by purpose.");
+	for (const ThreadUsage& usage : threads) {
+		writer->sample(live.c_str(), PrometheusWriter::label("thread", usage.stats->name), usage.stats->live.load(std::memory_order_relaxed));
+	}
+	std::string cpu = prefix + "_thread_cpu_seconds_total";
+	writer->family(cpu.c_str(), "counter", "CPU time of the threads, by purpose.");
+	for (const ThreadUsage& usage : threads) {
+		writer->sample(cpu.c_str(), PrometheusWriter::label("thread", usage.stats->name), usage.cpu_time * 1e-6);
+	}
+}
+
+} /* namespace client */
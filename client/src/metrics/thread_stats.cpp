@@ -0,0 +1,101 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "metrics/thread_stats.hpp"
+
+namespace client {
+
+namespace {
+
+uint64_t threadCpuTime(HANDLE thread) {
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(thread, &creation, &exit, &kernel, &user)) {
+		return 0;
+	}
+	// in units of 100 nanoseconds
+	uint64_t kernel_time = ((uint64_t) kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	uint64_t user_time = ((uint64_t) user.dwHighDateTime << 32) | user.dwLowDateTime;
+	return (kernel_time + user_time) / 10;
+}
+
+} // namespace
+
+std::atomic<bool> ThreadRegistry::enabled_ { false };
+
+unsigned long ThreadRegistry::enter(const char* name) {
+	// the pseudo handle of GetCurrentThread is only valid on the thread itself
+	HANDLE handle = NULL;
+	DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &handle, 0, FALSE, DUPLICATE_SAME_ACCESS);
+
+	std::lock_guard<std::mutex> guard(mutex_);
+	ThreadStats* stats = find(name);
+	stats->started.fetch_add(1, std::memory_order_relaxed);
+	uint64_t live = stats->live.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (live > stats->peak.load(std::memory_order_relaxed)) {
+		stats->peak.store(live, std::memory_order_relaxed);
+	}
+	unsigned long id = ++next_id_;
+	live_[id] = { stats, handle, std::chrono::steady_clock::now() };
+	return id;
+}
+
+void ThreadRegistry::exit(unsigned long id) {
+	uint64_t cpu_time = threadCpuTime(GetCurrentThread());
+
+	std::lock_guard<std::mutex> guard(mutex_);
+	auto it = live_.find(id);
+	if (it == live_.end()) {
+		return;
+	}
+	LiveThread thread = it->second;
+	live_.erase(it);
+	thread.stats->cpu_time.fetch_add(cpu_time, std::memory_order_relaxed);
+	thread.stats->lifetime.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - thread.start).count());
+	thread.stats->live.fetch_sub(1, std::memory_order_relaxed);
+	if (thread.handle != NULL) {
+		CloseHandle(thread.handle);
+	}
+}
+
+std::vector<ThreadUsage> ThreadRegistry::snapshot() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	std::vector<ThreadUsage> usages;
+	for (const auto &stats : threads_) {
+		usages.push_back({ stats, stats->cpu_time.load(std::memory_order_relaxed) });
+	}
+	// the live threads cannot exit meanwhile, their handles are closed under the same lock
+	for (const auto &p : live_) {
+		for (ThreadUsage& usage : usages) {
+			if (usage.stats.get() == p.second.stats && p.second.handle != NULL) {
+				usage.cpu_time += threadCpuTime(p.second.handle);
+			}
+		}
+	}
+	return usages;
+}
+
+ThreadStats* ThreadRegistry::find(const std::string& name) {
+	for (const auto &stats : threads_) {
+		if (stats->name == name) {
+			return stats.get();
+		}
+	}
+	threads_.push_back(std::make_shared<ThreadStats>(name));
+	return threads_.back().get();
+}
+
+} /* namespace client */
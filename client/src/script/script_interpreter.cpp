@@ -0,0 +1,217 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "script/script_interpreter.hpp"
+#include "constants/script_opcode.hpp"
+#include "terminal/terminals/utils/type_converter.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <set>
+
+namespace client {
+
+/**
+ * operandsLength - return the size of the operands following the given opcode, -1 for an unknown opcode.
+ */
+static int operandsLength(const std::vector<unsigned char>& program, std::size_t opcode_address) {
+	switch (program[opcode_address]) {
+	case OP_END:
+	case OP_SEND:
+	case OP_COLD_RESET:
+	case OP_WARM_RESET:
+		return 0;
+	case OP_APPEND:
+		return opcode_address + 1 < program.size() ? 1 + program[opcode_address + 1] : 1;
+	case OP_APPEND_VAR:
+		return 1;
+	case OP_JUMP:
+		return 2;
+	case OP_EXPECT_SW:
+	case OP_EXTRACT:
+		return 3;
+	case OP_JUMP_IF_SW:
+	case OP_JUMP_IF_NOT_SW:
+		return 5;
+	default:
+		return -1;
+	}
+}
+
+/**
+ * toBytes - convert the hexadecimal response of a terminal to bytes, the buffer being reused from a response to the next.
+ */
+static void toBytes(const std::string& hex, std::vector<unsigned char>* bytes) {
+	unsigned long int length;
+	bytes->resize(utils::hexDecodedCapacity(hex.size()));
+	if (!utils::hexDecode(hex.data(), hex.size(), bytes->data(), &length)) {
+		length = 0;
+	}
+	bytes->resize(length);
+}
+
+bool ScriptInterpreter::validate(const std::vector<unsigned char>& program, std::string* error) {
+	if (program.empty() || program[0] != SCRIPT_FORMAT_VERSION) {
+		*error = "Unsupported script format";
+		return false;
+	}
+
+	// every jump must land on an instruction
+	std::set<std::size_t> instructions;
+	std::vector<std::size_t> targets;
+	std::size_t address = 1;
+	std::size_t last_instruction = 0;
+	while (address < program.size()) {
+		int length = operandsLength(program, address);
+		if (length < 0) {
+			*error = "Unknown opcode at " + std::to_string(address);
+			return false;
+		}
+		if (address + length >= program.size()) {
+			*error = "Truncated instruction at " + std::to_string(address);
+			return false;
+		}
+
+		const unsigned char* operands = &program[address + 1];
+		switch (program[address]) {
+		case OP_APPEND_VAR:
+		case OP_EXTRACT:
+			if (operands[0] >= SCRIPT_MAX_VARIABLES) {
+				*error = "Invalid variable at " + std::to_string(address);
+				return false;
+			}
+			break;
+		case OP_JUMP:
+			targets.push_back((operands[0] << 8) | operands[1]);
+			break;
+		case OP_JUMP_IF_SW:
+		case OP_JUMP_IF_NOT_SW:
+			targets.push_back((operands[3] << 8) | operands[4]);
+			break;
+		}
+		instructions.insert(address);
+		last_instruction = address;
+		address += 1 + length;
+	}
+	// an operand may be 00: the last decoded instruction must be END, not the last byte
+	if (last_instruction == 0 || program[last_instruction] != OP_END) {
+		*error = "The script must end with END";
+		return false;
+	}
+
+	for (std::size_t target : targets) {
+		if (instructions.find(target) == instructions.end()) {
+			*error = "Invalid jump address " + std::to_string(target);
+			return false;
+		}
+	}
+	return true;
+}
+
+ResponsePacket ScriptInterpreter::run(ITerminalLayer* terminal, const std::vector<unsigned char>& program, std::vector<std::vector<unsigned char>> variables) {
+	std::string transcript;
+	std::vector<unsigned char> command;
+	std::vector<unsigned char> last_response;
+	variables.resize(SCRIPT_MAX_VARIABLES);
+
+	std::size_t address = 1;
+	for (unsigned long step = 0; step < max_steps_; step++) {
+		if (address >= program.size()) {
+			return scriptError(transcript, "Script ended without END");
+		}
+		unsigned char opcode = program[address];
+		const unsigned char* operands = program.data() + address + 1;
+		address += 1 + operandsLength(program, address);
+
+		switch (opcode) {
+		case OP_END: {
+			LOG_DEBUG << "Script executed [steps:" << step << "]";
+			ResponsePacket response_packet = { .response = transcript };
+			return response_packet;
+		}
+		case OP_APPEND:
+			command.insert(command.end(), operands + 1, operands + 1 + operands[0]);
+			break;
+		case OP_APPEND_VAR:
+			command.insert(command.end(), variables[operands[0]].begin(), variables[operands[0]].end());
+			break;
+		case OP_SEND:
+		case OP_COLD_RESET:
+		case OP_WARM_RESET: {
+			ResponsePacket response_packet;
+			if (opcode == OP_SEND) {
+				transcript += utils::unsignedCharToString(command.data(), command.size()) + "|";
+				response_packet = terminal->sendCommand(Apdu(command.data(), command.size()));
+				command.clear();
+			} else {
+				transcript += std::string(opcode == OP_COLD_RESET ? "COLD_RESET" : "WARM_RESET") + "|";
+				response_packet = opcode == OP_COLD_RESET ? terminal->coldReset() : terminal->warmReset();
+			}
+			if (response_packet.err_terminal_code < 0 || response_packet.err_card_code < 0) {
+				response_packet.response = transcript;
+				return response_packet;
+			}
+			transcript += response_packet.response + "|";
+			toBytes(response_packet.response, &last_response);
+			break;
+		}
+		case OP_EXPECT_SW:
+			if (!matchStatusWord(last_response, operands)) {
+				return scriptError(transcript, "Unexpected status word");
+			}
+			break;
+		case OP_JUMP:
+			address = (operands[0] << 8) | operands[1];
+			break;
+		case OP_JUMP_IF_SW:
+		case OP_JUMP_IF_NOT_SW:
+			if (matchStatusWord(last_response, operands) == (opcode == OP_JUMP_IF_SW)) {
+				address = (operands[3] << 8) | operands[4];
+			}
+			break;
+		case OP_EXTRACT: {
+			// the status word is not part of the response data
+			std::size_t data_length = last_response.size() >= 2 ? last_response.size() - 2 : 0;
+			std::size_t offset = operands[1];
+			std::size_t length = operands[2] == 0 && offset <= data_length ? data_length - offset : operands[2];
+			if (offset + length > data_length) {
+				return scriptError(transcript, "Response too short to extract data");
+			}
+			variables[operands[0]].assign(last_response.begin() + offset, last_response.begin() + offset + length);
+			break;
+		}
+		}
+	}
+
+	return scriptError(transcript, "Script step limit reached");
+}
+
+bool ScriptInterpreter::matchStatusWord(const std::vector<unsigned char>& response, const unsigned char* pattern) {
+	if (response.size() < 2) {
+		return false;
+	}
+	unsigned char sw1 = response[response.size() - 2];
+	unsigned char sw2 = response[response.size() - 1];
+	return (!(pattern[2] & SCRIPT_SW1_MASK) || sw1 == pattern[0]) && (!(pattern[2] & SCRIPT_SW2_MASK) || sw2 == pattern[1]);
+}
+
+ResponsePacket ScriptInterpreter::scriptError(std::string transcript, std::string description) {
+	LOG_DEBUG << "Script failed: " << description;
+	ResponsePacket response_packet = { .response = transcript, .err_client_code = ERR_SCRIPT, .err_client_description = description };
+	return response_packet;
+}
+
+} /* namespace client */
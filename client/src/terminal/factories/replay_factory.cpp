@@ -0,0 +1,32 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
+#include "terminal/factories/replay_factory.hpp"
+#include "terminal/terminals/replay_terminal.hpp"
+#include "terminal/terminals/utils/terminal_record.hpp"
+
+namespace client {
+
+ITerminalLayer* ReplayFactory::create() {
+	// terminals are created in the same order as when they were recorded
+	std::string path = ConfigWrapper::getInstance().getValue("replay_file", DEFAULT_REPLAY_FILE);
+	return new ReplayTerminal(utils::recordingPath(path, created_++));
+}
+
+} /* namespace client */
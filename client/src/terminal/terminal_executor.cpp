@@ -0,0 +1,233 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "terminal/terminal_executor.hpp"
+#include "constants/response_packet.hpp"
+#include "metrics/thread_stats.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <cassert>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace client {
+
+TerminalExecutor::~TerminalExecutor() {
+	stop();
+}
+
+void TerminalExecutor::start() {
+	if (started_.exchange(true)) {
+		return;
+	}
+	stop_ = false;
+	worker_ = std::thread(&TerminalExecutor::run, this);
+	watchdog_ = std::thread(&TerminalExecutor::watch, this);
+	LOG_DEBUG << "Terminal executor started";
+}
+
+void TerminalExecutor::stop() {
+	if (!started_.load()) {
+		return;
+	}
+
+	{
+		std::lock_guard<InstrumentedMutex> guard(queue_mutex_);
+		stop_ = true;
+	}
+	queue_cv_.notify_all();
+	watchdog_cv_.notify_all();
+
+	// the worker runs on this executor, it cannot be detached nor join itself: its owner stops it
+	assert(!isWorkerThread());
+	if (isWorkerThread()) {
+		LOG_ERROR << "Terminal executor stopped from its worker thread, the worker exits after the current task";
+		return;
+	}
+	if (worker_.joinable()) {
+		worker_.join();
+	}
+	if (watchdog_.joinable()) {
+		watchdog_.join();
+	}
+	{
+		std::lock_guard<InstrumentedMutex> guard(queue_mutex_);
+		watched_.clear();
+	}
+	started_ = false;
+	LOG_DEBUG << "Terminal executor stopped";
+}
+
+TerminalExecutor::TaskHandle TerminalExecutor::submit(std::function<ResponsePacket()> work, std::chrono::milliseconds timeout, std::function<void(ResponsePacket)> on_complete) {
+	TaskHandle task = std::make_shared<Task>();
+	task->work = work;
+	task->on_complete = on_complete;
+	task->deadline = std::chrono::steady_clock::now() + timeout;
+	task->result = task->promise.get_future();
+
+	{
+		std::lock_guard<InstrumentedMutex> guard(queue_mutex_);
+		if (!stop_.load() && started_.load()) {
+			queue_.push_back(task);
+			queue_cv_.notify_one();
+			if (on_complete) {
+				watched_.insert(std::make_pair(task->deadline, task));
+				watchdog_cv_.notify_one();
+			}
+			return task;
+		}
+	}
+
+	task->state = TaskState::CANCELLED;
+	ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_INVALID_STATE, .err_client_description = "Terminal executor is not running" };
+	complete(task, response_packet);
+	return task;
+}
+
+ResponsePacket TerminalExecutor::execute(std::function<ResponsePacket()> work) {
+	if (!started_.load() || isWorkerThread()) {
+		return work();
+	}
+	TaskHandle task = submit(work, std::chrono::hours(24));
+	return task->result.get();
+}
+
+bool TerminalExecutor::cancel(TaskHandle task) {
+	TaskState expected = TaskState::QUEUED;
+	if (!task->state.compare_exchange_strong(expected, TaskState::CANCELLED)) {
+		return expected == TaskState::CANCELLED || expected == TaskState::EXPIRED;
+	}
+
+	// the worker skips cancelled tasks, the waiting side still gets a result
+	ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_TIMEOUT, .err_client_description = "Request cancelled before execution" };
+	complete(task, response_packet);
+	return true;
+}
+
+void TerminalExecutor::setIdleHandler(std::function<void()> idle_handler, std::chrono::milliseconds idle_delay) {
+	std::lock_guard<InstrumentedMutex> guard(queue_mutex_);
+	idle_handler_ = idle_handler;
+	idle_delay_ = idle_delay;
+}
+
+std::size_t TerminalExecutor::getQueueDepth() {
+	std::lock_guard<InstrumentedMutex> guard(queue_mutex_);
+	return queue_.size();
+}
+
+bool TerminalExecutor::isWorkerThread() {
+	return std::this_thread::get_id() == worker_.get_id();
+}
+
+void TerminalExecutor::run() {
+	ThreadScope scope("terminal_executor");
+	bool idle_pending = false;
+	while (true) {
+		TaskHandle task;
+		{
+			std::unique_lock<InstrumentedMutex> lock(queue_mutex_);
+			auto has_work = [this] { return stop_.load() || !queue_.empty(); };
+			if (idle_pending && idle_handler_) {
+				if (!queue_cv_.wait_for(lock, idle_delay_, has_work)) {
+					std::function<void()> idle_handler = idle_handler_;
+					lock.unlock();
+					idle_pending = false;
+					idle_handler();
+					continue;
+				}
+			} else {
+				queue_cv_.wait(lock, has_work);
+			}
+			if (queue_.empty()) {
+				break; // stop requested and nothing left
+			}
+			task = queue_.front();
+			queue_.pop_front();
+			if (stop_.load()) {
+				lock.unlock();
+				cancel(task);
+				continue;
+			}
+		}
+
+		TaskState expected = TaskState::QUEUED;
+		if (std::chrono::steady_clock::now() > task->deadline) {
+			if (task->state.compare_exchange_strong(expected, TaskState::EXPIRED)) {
+				LOG_DEBUG << "Terminal work item dropped: deadline exceeded before execution";
+				ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_TIMEOUT, .err_client_description = "Request deadline exceeded before execution" };
+				complete(task, response_packet);
+			}
+			continue;
+		}
+		if (!task->state.compare_exchange_strong(expected, TaskState::RUNNING)) {
+			continue; // cancelled while queued
+		}
+
+		ResponsePacket response_packet = task->work();
+		task->state = TaskState::DONE;
+		complete(task, response_packet);
+		idle_pending = true;
+	}
+}
+
+void TerminalExecutor::watch() {
+	ThreadScope scope("terminal_watchdog");
+	std::unique_lock<InstrumentedMutex> lock(queue_mutex_);
+	while (!stop_.load()) {
+		if (watched_.empty()) {
+			watchdog_cv_.wait(lock);
+			continue;
+		}
+		auto deadline = watched_.begin()->first;
+		if (std::chrono::steady_clock::now() < deadline) {
+			watchdog_cv_.wait_until(lock, deadline);
+			continue;
+		}
+		TaskHandle task = watched_.begin()->second;
+		watched_.erase(watched_.begin());
+		if (task->completed.load()) {
+			continue;
+		}
+
+		// the callback sends the result: it is called without the lock
+		lock.unlock();
+		TaskState expected = TaskState::QUEUED;
+		if (task->state.compare_exchange_strong(expected, TaskState::EXPIRED)) {
+			ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_TIMEOUT, .err_client_description = "Request deadline exceeded before execution" };
+			complete(task, response_packet);
+		} else if (expected == TaskState::RUNNING) {
+			LOG_DEBUG << "Terminal work item still running at its deadline, its result will be dropped";
+			ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_TIMEOUT, .err_client_description = "Response time from terminal has elapsed" };
+			complete(task, response_packet);
+		}
+		lock.lock();
+	}
+}
+
+void TerminalExecutor::complete(TaskHandle task, ResponsePacket response_packet) {
+	if (task->completed.exchange(true)) {
+		return; // already completed at its deadline
+	}
+	if (task->on_complete) {
+		task->on_complete(response_packet);
+	}
+	task->promise.set_value(response_packet);
+}
+
+} /* namespace client */
@@ -0,0 +1,170 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "terminal/terminal_state.hpp"
+#include "constants/request_code.hpp"
+#include "nlohmann/json.hpp"
+
+#include <mutex>
+
+namespace client {
+
+void TerminalStateCache::reset(std::string reader) {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	state_ = TerminalState();
+	state_.reader = reader;
+	status_known_ = false;
+	monitored_ = false;
+}
+
+void TerminalStateCache::setMonitored(bool monitored) {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	monitored_ = monitored;
+}
+
+bool TerminalStateCache::isMonitored() {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	return monitored_;
+}
+
+void TerminalStateCache::invalidate() {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	status_known_ = false;
+}
+
+void TerminalStateCache::setStatus(TerminalState status) {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	state_.card_state = status.card_state;
+	state_.protocol = status.protocol;
+	state_.atr = status.atr;
+	status_known_ = true;
+}
+
+void TerminalStateCache::recordResult(int request, ResponsePacket response_packet) {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	switch (request) {
+	case REQ_COMMAND:
+	case REQ_COMMAND_A:
+	case REQ_COMMAND_B:
+	case REQ_COMMAND_F:
+		state_.commands++;
+		break;
+	case REQ_COLD_RESET:
+	case REQ_WARM_RESET:
+	case REQ_RESTART:
+		state_.resets++;
+		break;
+	}
+
+	if (response_packet.err_terminal_code < 0 || response_packet.err_card_code < 0) {
+		state_.errors++;
+		state_.last_error_code = response_packet.err_terminal_code < 0 ? response_packet.err_terminal_code : response_packet.err_card_code;
+		state_.last_error_description = response_packet.err_terminal_code < 0 ? response_packet.err_terminal_description : response_packet.err_card_description;
+		status_known_ = false; // the card may have been removed or reset
+		return;
+	}
+	if (request == REQ_COLD_RESET || request == REQ_WARM_RESET) {
+		state_.atr = response_packet.response;
+	}
+}
+
+void TerminalStateCache::recordEvent(EventType event, std::string data) {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	switch (event) {
+	case EVT_CARD_INSERTED:
+		state_.card_insertions++;
+		state_.card_state = CARD_PRESENT;
+		state_.protocol = PROTOCOL_UNKNOWN;
+		state_.atr = data;
+		status_known_ = false; // the protocol is read from the terminal again
+		break;
+	case EVT_CARD_REMOVED:
+		state_.card_removals++;
+		state_.card_state = CARD_ABSENT;
+		state_.protocol = PROTOCOL_UNKNOWN;
+		state_.atr.clear();
+		break;
+	case EVT_READER_ERROR:
+		state_.errors++;
+		state_.last_error_code = ERR_INVALID_TERMINAL;
+		state_.last_error_description = data;
+		status_known_ = false;
+		break;
+	default:
+		break;
+	}
+}
+
+bool TerminalStateCache::diag(bool structured, ResponsePacket* response_packet) {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	// without the card events, a removal would not be seen
+	if (!status_known_ || !monitored_) {
+		return false;
+	}
+
+	if (structured) {
+		nlohmann::json jstate = state_;
+		response_packet->response = jstate.dump();
+	} else {
+		response_packet->response = "Readers: " + state_.reader + " | Status: " + cardStateToString(state_.card_state) + " | Protocol: " + cardProtocolToString(state_.protocol);
+	}
+	return true;
+}
+
+bool TerminalStateCache::isStatusKnown() {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	return status_known_;
+}
+
+TerminalState TerminalStateCache::getState() {
+	std::lock_guard<InstrumentedMutex> guard(mutex_);
+	return state_;
+}
+
+std::string cardStateToString(CardState card_state) {
+	switch (card_state) {
+	case CARD_ABSENT:
+		return "Card absent";
+	case CARD_PRESENT:
+		return "Card present";
+	case CARD_SWALLOWED:
+		return "Card swallowed";
+	case CARD_POWERED:
+		return "Card has power";
+	case CARD_NEGOTIABLE:
+		return "Card reset and waiting PTS negotiation";
+	case CARD_SPECIFIC:
+		return "Card has specific communication protocols set";
+	default:
+		return "Unknown or unexpected card state";
+	}
+}
+
+std::string cardProtocolToString(CardProtocol protocol) {
+	switch (protocol) {
+	case PROTOCOL_RAW:
+		return "The Raw Transfer protocol is in use";
+	case PROTOCOL_T0:
+		return "The ISO 7816/3 T=0 protocol is in use";
+	case PROTOCOL_T1:
+		return "The ISO 7816/3 T=1 protocol is in use";
+	default:
+		return "Unknown or unexpected protocol in use";
+	}
+}
+
+} /* namespace client */
@@ -15,13 +15,18 @@
  limitations under the License.
  *********************************************************************************/
 
+#include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
 #include "constants/response_packet.hpp"
 #include "terminal/terminals/example_pcsc_contact.hpp"
+#include "terminal/terminals/utils/apdu_chaining.hpp"
+#include "terminal/terminals/utils/pcsc_status.hpp"
 #include "terminal/terminals/utils/type_converter.hpp"
 #include "plog/include/plog/Log.h"
 
 #include <iostream>
 #include <winscard.h>
+#include <functional>
 #include <map>
 
 #define TRIES_LIMIT 2
@@ -51,6 +56,7 @@ ResponsePacket ExampleTerminalPCSCContact::init() {
 		return handleErrorResponse("Failed to establish context", resp);
 	}
 
+	t0_chaining_ = ConfigWrapper::getInstance().getValue("t0_chaining", DEFAULT_T0_CHAINING).compare("true") == 0;
 	LOG_INFO << "Terminal PCSC initialized";
 	return response;
 }
@@ -135,22 +141,29 @@ ResponsePacket ExampleTerminalPCSCContact::connect(const char* reader) {
 	return response;
 }
 
-ResponsePacket ExampleTerminalPCSCContact::sendCommand(unsigned char command[], DWORD command_length) {
+ResponsePacket ExampleTerminalPCSCContact::sendCommand(const Apdu& command) {
+	if (t0_chaining_) {
+		return utils::transmitWithChaining(std::bind(&ExampleTerminalPCSCContact::transmit, this, std::placeholders::_1), command);
+	}
+	return transmit(command);
+}
+
+ResponsePacket ExampleTerminalPCSCContact::transmit(const Apdu& command) {
 	LONG resp = SCARD_SWALLOWED;
-	std::string strCommand = utils::unsignedCharToString(command, command_length);
+	std::string strCommand = command.toHex();
 	dwRecvLength_ = sizeof(pbRecvBuffer_);
 
 	int tries = 0;
 	LOG_INFO << "SCardTransmit called";
-	if ((resp = SCardTransmit(hCard, &pioSendPci_, command, command_length, NULL, pbRecvBuffer_, &dwRecvLength_)) != SCARD_S_SUCCESS) {
+	if ((resp = SCardTransmit(hCard, &pioSendPci_, command.data(), command.size(), NULL, pbRecvBuffer_, &dwRecvLength_)) != SCARD_S_SUCCESS) {
 		while (resp != SCARD_S_SUCCESS && tries < TRIES_LIMIT) {
 			resp = handleRetry();
 			LOG_INFO << "[Retry] SCardTransmit called";
-			resp = SCardTransmit(hCard, &pioSendPci_, command, command_length, NULL, pbRecvBuffer_, &dwRecvLength_);
+			resp = SCardTransmit(hCard, &pioSendPci_, command.data(), command.size(), NULL, pbRecvBuffer_, &dwRecvLength_);
 			tries++;
 		}
 		if (resp != SCARD_S_SUCCESS) {
-			LOG_DEBUG << "Failed to call SCardTransmit() [error:" << errorToString(resp) << "]" << "[card:" << hCard << "][pbSendBuffer:" << command << "][cbSendLength:" << command_length << "]"
+			LOG_DEBUG << "Failed to call SCardTransmit() [error:" << errorToString(resp) << "]" << "[card:" << hCard << "][pbSendBuffer:" << strCommand << "][cbSendLength:" << command.size() << "]"
 					  << "[recvbuffer:" << pbRecvBuffer_ << "][recvlength:" << dwRecvLength_ << "]";
 			return handleErrorResponse("Failed to send command", resp);
 		}
@@ -161,27 +174,27 @@ ResponsePacket ExampleTerminalPCSCContact::sendCommand(unsigned char command[],
 	return response;
 }
 
-ResponsePacket ExampleTerminalPCSCContact::sendTypeA(unsigned char command[],  unsigned long int command_length) {
+ResponsePacket ExampleTerminalPCSCContact::sendTypeA(const Apdu& command) {
 	ResponsePacket response;
 	response.response = "Not supported";
 	return response;
 }
 
-ResponsePacket ExampleTerminalPCSCContact::sendTypeB(unsigned char command[],  unsigned long int command_length) {
+ResponsePacket ExampleTerminalPCSCContact::sendTypeB(const Apdu& command) {
 	ResponsePacket response;
 	response.response = "Not supported";
 	return response;
 }
 
-ResponsePacket ExampleTerminalPCSCContact::sendTypeF(unsigned char command[],  unsigned long int command_length) {
+ResponsePacket ExampleTerminalPCSCContact::sendTypeF(const Apdu& command) {
 	ResponsePacket response;
 	response.response = "Not supported";
 	return response;
 }
 
 ResponsePacket ExampleTerminalPCSCContact::isAlive() {
-	unsigned char command[] = { 0x00, 0x00, 0x00, 0x00 };
-	return sendCommand(command, sizeof(command));
+	Apdu command = { 0x00, 0x00, 0x00, 0x00 };
+	return sendCommand(command);
 }
 
 ResponsePacket ExampleTerminalPCSCContact::diag() {
@@ -426,6 +439,36 @@ ResponsePacket ExampleTerminalPCSCContact::powerONField() {
 	return response;
 }
 
+ResponsePacket ExampleTerminalPCSCContact::getStatus(TerminalState* state) {
+	ResponsePacket response;
+	LONG resp;
+	CHAR szReader[200];
+	DWORD cch = 200;
+	BYTE bAttr[32];
+	DWORD cByte = 32;
+	DWORD dwState, dwProtocol;
+
+	// no retry: a failure only means that the diagnostic is performed by diag
+	LOG_INFO << "SCardStatus called";
+	if ((resp = SCardStatus(hCard, szReader, &cch, &dwState, &dwProtocol, (LPBYTE) &bAttr, &cByte)) != SCARD_S_SUCCESS) {
+		LOG_DEBUG << "Failed to call SCardStatus() [error:" << errorToString(resp) << "][card:" << hCard << "]";
+		return handleErrorResponse("Failed to retrieve card status", resp);
+	}
+
+	state->card_state = utils::toCardState(dwState);
+	state->protocol = utils::toCardProtocol(dwProtocol);
+	state->atr = utils::unsignedCharToString(bAttr, cByte);
+	return response;
+}
+
+ResponsePacket ExampleTerminalPCSCContact::startMonitoring(EventHandler on_event, bool watch_readers) {
+	return monitor_.start(current_reader_, watch_readers, on_event);
+}
+
+void ExampleTerminalPCSCContact::stopMonitoring() {
+	monitor_.stop();
+}
+
 std::string ExampleTerminalPCSCContact::errorToString(LONG error) {
 	switch (error) {
 	case ERROR_INVALID_PARAMETER:
@@ -15,17 +15,28 @@
  limitations under the License.
  *********************************************************************************/
 
+#include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
 #include "constants/response_packet.hpp"
 #include "terminal/terminals/example_pcsc_contactless.hpp"
+#include "terminal/terminals/utils/apdu_chaining.hpp"
+#include "terminal/terminals/utils/pcsc_status.hpp"
 #include "terminal/terminals/utils/type_converter.hpp"
 #include "plog/include/plog/Log.h"
 
 #include <iostream>
 #include <winscard.h>
+#include <algorithm>
+#include <functional>
 #include <map>
 
 #define TRIES_LIMIT 3
 
+// polling commands: type A only, type B only, default polling (type A + type B + FeliCa)
+static const unsigned char POLLING_TYPE_A[] = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x95, 0x00 };
+static const unsigned char POLLING_TYPE_B[] = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x95, 0x01 };
+static const unsigned char POLLING_DEFAULT[] = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x95, 0x1B };
+
 namespace client {
 
 ExampleTerminalPCSCContactless::~ExampleTerminalPCSCContactless() {
@@ -47,6 +58,7 @@ ResponsePacket ExampleTerminalPCSCContactless::init() {
 		return handleErrorResponse("Failed to establish context", resp);
 	}
 
+	t0_chaining_ = ConfigWrapper::getInstance().getValue("t0_chaining", DEFAULT_T0_CHAINING).compare("true") == 0;
 	LOG_INFO << "Terminal PCSC initialized";
 	return response;
 }
@@ -90,6 +102,7 @@ ResponsePacket ExampleTerminalPCSCContactless::loadAndListReaders() {
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::connect(const char* reader) {
+	polling_mode_ = PollingMode::DEFAULT;
 	ResponsePacket response;
 	LONG resp;
 
@@ -123,20 +136,27 @@ ResponsePacket ExampleTerminalPCSCContactless::connect(const char* reader) {
 	return response;
 }
 
-ResponsePacket ExampleTerminalPCSCContactless::sendCommand(unsigned char command[], DWORD command_length) {
+ResponsePacket ExampleTerminalPCSCContactless::sendCommand(const Apdu& command) {
+	if (t0_chaining_) {
+		return utils::transmitWithChaining(std::bind(&ExampleTerminalPCSCContactless::transmit, this, std::placeholders::_1), command);
+	}
+	return transmit(command);
+}
+
+ResponsePacket ExampleTerminalPCSCContactless::transmit(const Apdu& command) {
 	LONG resp = SCARD_SWALLOWED;
-	std::string strCommand = utils::unsignedCharToString(command, command_length);
+	std::string strCommand = command.toHex();
 	dwRecvLength_ = sizeof(pbRecvBuffer_);
 
 	int tries = 0;
-	if ((resp = SCardTransmit(hCard_, &pioSendPci_, command, command_length, NULL, pbRecvBuffer_, &dwRecvLength_)) != SCARD_S_SUCCESS) {
+	if ((resp = SCardTransmit(hCard_, &pioSendPci_, command.data(), command.size(), NULL, pbRecvBuffer_, &dwRecvLength_)) != SCARD_S_SUCCESS) {
 		while (resp != SCARD_S_SUCCESS && tries < TRIES_LIMIT) {
 			resp = handleRetry();
-			resp = SCardTransmit(hCard_, &pioSendPci_, command, command_length, NULL, pbRecvBuffer_, &dwRecvLength_);
+			resp = SCardTransmit(hCard_, &pioSendPci_, command.data(), command.size(), NULL, pbRecvBuffer_, &dwRecvLength_);
 			tries++;
 		}
 		if (resp != SCARD_S_SUCCESS) {
-			LOG_DEBUG << "Failed to call SCardTransmit() [error:" << errorToString(resp) << "]" << "[card:" << hCard_ << "][pbSendBuffer:" << command << "][cbSendLength:" << command_length << "]"
+			LOG_DEBUG << "Failed to call SCardTransmit() [error:" << errorToString(resp) << "]" << "[card:" << hCard_ << "][pbSendBuffer:" << strCommand << "][cbSendLength:" << command.size() << "]"
 					  << "[recvbuffer:" << pbRecvBuffer_ << "][recvlength:" << dwRecvLength_ << "]";
 			return handleErrorResponse("Failed to send command", resp);
 		}
@@ -147,61 +167,23 @@ ResponsePacket ExampleTerminalPCSCContactless::sendCommand(unsigned char command
 	return response;
 }
 
-ResponsePacket ExampleTerminalPCSCContactless::sendTypeA(unsigned char command[],  unsigned long int command_length) {
-	ResponsePacket response;
-
-	// poll for type A only
-	unsigned long int length;
-	unsigned char* command_rawA = utils::stringToUnsignedChar("FF CC 00 00 02 95 00", &length);
-	response = sendCommand(command_rawA, length);
-	if (response.response.compare("KO") == 0) {
-		return response;
-	}
-
-	// send requested command
-	response = sendCommand(command, command_length);
-	if (response.response.compare("KO") == 0) {
-		return response;
-	}
-
-	// reset default polling (type A + type B + FeliCa)
-	unsigned char* command_default_type = utils::stringToUnsignedChar("FF CC 00 00 02 95 1B", &length);
-	sendCommand(command_default_type, length);
-	return response;
+ResponsePacket ExampleTerminalPCSCContactless::sendTypeA(const Apdu& command) {
+	return sendTyped(PollingMode::TYPE_A, command);
 }
 
-ResponsePacket ExampleTerminalPCSCContactless::sendTypeB(unsigned char command[],  unsigned long int command_length) {
-	ResponsePacket response;
-
-	// poll for type B only
-	unsigned long int length;
-	unsigned char* command_rawB = utils::stringToUnsignedChar("FF CC 00 00 02 95 01", &length);
-	response = sendCommand(command_rawB, length);
-	if (response.response.compare("KO") == 0) {
-		return response;
-	}
-
-	// send requested command
-	response = sendCommand(command, command_length);
-	if (response.response.compare("KO") == 0) {
-		return response;
-	}
-
-	// reset default polling (type A + type B + FeliCa)
-	unsigned char* command_default_type = utils::stringToUnsignedChar("FF CC 00 00 02 95 1B", &length);
-	sendCommand(command_default_type, length);
-	return response;
+ResponsePacket ExampleTerminalPCSCContactless::sendTypeB(const Apdu& command) {
+	return sendTyped(PollingMode::TYPE_B, command);
 }
 
-ResponsePacket ExampleTerminalPCSCContactless::sendTypeF(unsigned char command[],  unsigned long int command_length) {
+ResponsePacket ExampleTerminalPCSCContactless::sendTypeF(const Apdu& command) {
 	ResponsePacket response;
 	response.response = "Not implemented";
 	return response;
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::isAlive() {
-	unsigned char command[] = { 0x00, 0x00, 0x00, 0x00 };
-	return sendCommand(command, sizeof(command));
+	Apdu command = { 0x00, 0x00, 0x00, 0x00 };
+	return sendCommand(command);
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::diag() {
@@ -273,6 +255,7 @@ ResponsePacket ExampleTerminalPCSCContactless::diag() {
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::disconnect() {
+	switchPollingMode(PollingMode::DEFAULT);
 	ResponsePacket response;
 	LONG resp;
 
@@ -295,6 +278,7 @@ ResponsePacket ExampleTerminalPCSCContactless::disconnect() {
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::restart() {
+	switchPollingMode(PollingMode::DEFAULT);
 	ResponsePacket response;
 	LONG resp;
 	DWORD dwProtocol;
@@ -354,8 +338,8 @@ ResponsePacket ExampleTerminalPCSCContactless::retrieveAtr(BYTE* bAttr, DWORD* c
 
 ResponsePacket ExampleTerminalPCSCContactless::powerOFFField() {
 	ResponsePacket response;
-	unsigned char command[] = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x96, 0x00 };
-	return sendCommand(command, sizeof command);
+	Apdu command = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x96, 0x00 };
+	return sendCommand(command);
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::powerONField() {
@@ -380,8 +364,8 @@ ResponsePacket ExampleTerminalPCSCContactless::powerONField() {
 	}
 
 	// set RF field on
-	unsigned char command[] = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x96, 0x01 };
-	response = sendCommand(command, sizeof command);
+	Apdu command = { 0xFF, 0xCC, 0x00, 0x00, 0x02, 0x96, 0x01 };
+	response = sendCommand(command);
 	if (response.response.compare("KO") == 0) {
 		return response;
 	}
@@ -392,6 +376,7 @@ ResponsePacket ExampleTerminalPCSCContactless::powerONField() {
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::coldReset() {
+	switchPollingMode(PollingMode::DEFAULT);
 	ResponsePacket response;
 	LONG resp;
 	DWORD dwProtocol;
@@ -430,6 +415,7 @@ ResponsePacket ExampleTerminalPCSCContactless::coldReset() {
 }
 
 ResponsePacket ExampleTerminalPCSCContactless::warmReset() {
+	switchPollingMode(PollingMode::DEFAULT);
 	ResponsePacket response;
 	LONG resp;
 	DWORD dwProtocol;
@@ -467,6 +453,36 @@ ResponsePacket ExampleTerminalPCSCContactless::warmReset() {
 	return response;
 }
 
+ResponsePacket ExampleTerminalPCSCContactless::getStatus(TerminalState* state) {
+	ResponsePacket response;
+	LONG resp;
+	CHAR szReader[200];
+	DWORD cch = 200;
+	BYTE bAttr[32];
+	DWORD cByte = 32;
+	DWORD dwState, dwProtocol;
+
+	// no retry: a failure only means that the diagnostic is performed by diag
+	LOG_INFO << "SCardStatus called";
+	if ((resp = SCardStatus(hCard_, szReader, &cch, &dwState, &dwProtocol, (LPBYTE) &bAttr, &cByte)) != SCARD_S_SUCCESS) {
+		LOG_DEBUG << "Failed to call SCardStatus() [error:" << errorToString(resp) << "][card:" << hCard_ << "]";
+		return handleErrorResponse("Failed to retrieve card status", resp);
+	}
+
+	state->card_state = utils::toCardState(dwState);
+	state->protocol = utils::toCardProtocol(dwProtocol);
+	state->atr = utils::unsignedCharToString(bAttr, cByte);
+	return response;
+}
+
+ResponsePacket ExampleTerminalPCSCContactless::startMonitoring(EventHandler on_event, bool watch_readers) {
+	return monitor_.start(current_reader_, watch_readers, on_event);
+}
+
+void ExampleTerminalPCSCContactless::stopMonitoring() {
+	monitor_.stop();
+}
+
 std::string ExampleTerminalPCSCContactless::errorToString(LONG error) {
 	switch (error) {
 	case ERROR_INVALID_PARAMETER:
@@ -606,6 +622,56 @@ std::string ExampleTerminalPCSCContactless::errorToString(LONG error) {
 	}
 }
 
+void ExampleTerminalPCSCContactless::onIdle() {
+	if (polling_mode_ != PollingMode::DEFAULT) {
+		switchPollingMode(PollingMode::DEFAULT);
+		LOG_DEBUG << "Default polling restored [avoided transmits:" << getAvoidedPollingTransmits() << "]";
+	}
+}
+
+unsigned long int ExampleTerminalPCSCContactless::getAvoidedPollingTransmits() {
+	// each typed command used to cost two polling commands
+	return polling_transmits_ < 2 * typed_commands_ ? 2 * typed_commands_ - polling_transmits_ : 0;
+}
+
+ResponsePacket ExampleTerminalPCSCContactless::sendTyped(PollingMode mode, const Apdu& command) {
+	ResponsePacket response = switchPollingMode(mode);
+	if (response.response.compare("KO") == 0) {
+		return response;
+	}
+	typed_commands_++;
+
+	// the polling mode is kept for the next typed commands, it is restored on idle or reset
+	return sendCommand(command);
+}
+
+ResponsePacket ExampleTerminalPCSCContactless::switchPollingMode(PollingMode mode) {
+	ResponsePacket response;
+	if (mode == polling_mode_) {
+		return response;
+	}
+
+	const unsigned char* polling_command;
+	switch (mode) {
+	case PollingMode::TYPE_A:
+		polling_command = POLLING_TYPE_A;
+		break;
+	case PollingMode::TYPE_B:
+		polling_command = POLLING_TYPE_B;
+		break;
+	default:
+		polling_command = POLLING_DEFAULT;
+		break;
+	}
+
+	response = transmit(Apdu(polling_command, sizeof(POLLING_DEFAULT)));
+	polling_transmits_++;
+
+	// the reader's mode is not known anymore if the command failed, it will be sent again
+	polling_mode_ = response.response.compare("KO") == 0 ? PollingMode::UNKNOWN : mode;
+	return response;
+}
+
 ResponsePacket ExampleTerminalPCSCContactless::handleErrorResponse(std::string context_message, LONG error) {
 	std::string message = context_message + ": " + errorToString(error);
 	ResponsePacket response = { .response = "KO", .err_terminal_code = error, .err_terminal_description = message };
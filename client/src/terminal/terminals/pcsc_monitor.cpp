@@ -0,0 +1,186 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "terminal/terminals/pcsc_monitor.hpp"
+#include "constants/event_type.hpp"
+#include "constants/response_packet.hpp"
+#include "metrics/thread_stats.hpp"
+#include "terminal/terminals/utils/type_converter.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <winscard.h>
+
+#define PNP_NOTIFICATION "\\\\?PnP?\\Notification"
+#define MONITOR_TIMEOUT 1000 // milliseconds, bounds the time to notice a stop requested right before SCardGetStatusChange is called
+#define MONITOR_RETRY_DELAY 1000 // milliseconds before watching again after an error of the resource manager
+
+namespace client {
+
+PCSCMonitor::~PCSCMonitor() {
+	stop();
+}
+
+ResponsePacket PCSCMonitor::start(std::string reader, bool watch_readers, ITerminalLayer::EventHandler on_event) {
+	stop();
+
+	LONG resp;
+	LOG_INFO << "SCardEstablishContext called [monitor]";
+	if ((resp = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext_)) != SCARD_S_SUCCESS) {
+		LOG_DEBUG << "Failed to call SCardEstablishContext() [error:" << resp << "][reader:" << reader << "]";
+		ResponsePacket response = { .response = "KO", .err_terminal_code = resp, .err_terminal_description = "Failed to establish the monitoring context" };
+		return response;
+	}
+
+	reader_ = reader;
+	watch_readers_ = watch_readers;
+	on_event_ = on_event;
+	stop_ = false;
+	thread_ = std::thread(&PCSCMonitor::run, this);
+
+	LOG_INFO << "Reader monitoring started [reader:" << reader << "][watch_readers:" << watch_readers << "]";
+	ResponsePacket response;
+	return response;
+}
+
+void PCSCMonitor::stop() {
+	if (!thread_.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		stop_ = true;
+		SCardCancel(hContext_);
+	}
+	stop_cv_.notify_all();
+	thread_.join();
+
+	LOG_INFO << "SCardReleaseContext called [monitor]";
+	if (SCardReleaseContext(hContext_) != SCARD_S_SUCCESS) {
+		LOG_DEBUG << "Failed to call SCardReleaseContext() [hContext:" << hContext_ << "]";
+	}
+	LOG_INFO << "Reader monitoring stopped [reader:" << reader_ << "]";
+}
+
+void PCSCMonitor::run() {
+	ThreadScope scope("pcsc_monitor");
+	// the first call returns the current states, which are the reference for the next events
+	std::vector<SCARD_READERSTATE> states(watch_readers_ ? 2 : 1);
+	std::memset(states.data(), 0, states.size() * sizeof(SCARD_READERSTATE));
+	states[0].szReader = reader_.c_str();
+	states[0].dwCurrentState = SCARD_STATE_UNAWARE;
+	if (watch_readers_) {
+		states[1].szReader = PNP_NOTIFICATION;
+		states[1].dwCurrentState = SCARD_STATE_UNAWARE;
+	}
+
+	std::set<std::string> readers;
+	bool card_present = false;
+	bool first = true;
+	LONG last_error = SCARD_S_SUCCESS;
+	while (!stop_.load()) {
+		LONG resp = SCardGetStatusChange(hContext_, MONITOR_TIMEOUT, states.data(), states.size());
+		if (stop_.load() || resp == SCARD_E_CANCELLED) {
+			break;
+		}
+		if (resp == SCARD_E_TIMEOUT) {
+			continue;
+		}
+		if (resp != SCARD_S_SUCCESS) {
+			LOG_DEBUG << "Failed to call SCardGetStatusChange() [error:" << resp << "][reader:" << reader_ << "]";
+			// notified once until the monitoring works again
+			if (resp != last_error) {
+				std::stringstream description;
+				description << "Failed to monitor the reader [error:0x" << std::hex << (unsigned long) resp << "]";
+				on_event_(EVT_READER_ERROR, reader_, description.str());
+			}
+			last_error = resp;
+			waitBeforeRetry();
+			continue;
+		}
+		last_error = SCARD_S_SUCCESS;
+
+		// a reader unplugged reports an unavailable state, which is a card removal
+		bool present = (states[0].dwEventState & SCARD_STATE_PRESENT) != 0;
+		if (!first && present != card_present) {
+			LOG_INFO << "Card " << (present ? "inserted" : "removed") << " [reader:" << reader_ << "]";
+			on_event_(present ? EVT_CARD_INSERTED : EVT_CARD_REMOVED, reader_, present ? utils::unsignedCharToString(states[0].rgbAtr, states[0].cbAtr) : "");
+		}
+		card_present = present;
+		states[0].dwCurrentState = states[0].dwEventState & ~SCARD_STATE_CHANGED;
+
+		if (watch_readers_ && (first || (states[1].dwEventState & SCARD_STATE_CHANGED))) {
+			std::set<std::string> current_readers;
+			if (listReaders(&current_readers) == SCARD_S_SUCCESS) {
+				for (const std::string &reader : current_readers) {
+					if (!first && readers.count(reader) == 0) {
+						LOG_INFO << "Reader added [reader:" << reader << "]";
+						on_event_(EVT_READER_ADDED, reader, "");
+					}
+				}
+				for (const std::string &reader : readers) {
+					if (current_readers.count(reader) == 0) {
+						LOG_INFO << "Reader removed [reader:" << reader << "]";
+						on_event_(EVT_READER_REMOVED, reader, "");
+					}
+				}
+				readers = current_readers;
+			}
+			states[1].dwCurrentState = states[1].dwEventState & ~SCARD_STATE_CHANGED;
+		}
+		first = false;
+	}
+}
+
+LONG PCSCMonitor::listReaders(std::set<std::string>* readers) {
+	LPTSTR mszReaders = NULL;
+	DWORD dwReaders = SCARD_AUTOALLOCATE;
+
+	readers->clear();
+	LONG resp = SCardListReaders(hContext_, NULL, (LPTSTR) &mszReaders, &dwReaders);
+	if (resp == SCARD_E_NO_READERS_AVAILABLE) {
+		return SCARD_S_SUCCESS;
+	}
+	if (resp != SCARD_S_SUCCESS) {
+		LOG_DEBUG << "Failed to call SCardListReaders() [error:" << resp << "]";
+		return resp;
+	}
+
+	for (LPTSTR pReader = mszReaders; '\0' != *pReader; pReader = pReader + strlen((const char*) pReader) + 1) {
+		readers->insert(std::string((const char*) pReader));
+	}
+	SCardFreeMemory(hContext_, mszReaders);
+	return SCARD_S_SUCCESS;
+}
+
+void PCSCMonitor::waitBeforeRetry() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	stop_cv_.wait_for(lock, std::chrono::milliseconds(MONITOR_RETRY_DELAY), [this] { return stop_.load(); });
+
+	// the context does not survive a restart of the resource manager
+	if (!stop_.load() && SCardIsValidContext(hContext_) != SCARD_S_SUCCESS) {
+		SCardReleaseContext(hContext_);
+		LOG_INFO << "SCardEstablishContext called [monitor]";
+		SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext_);
+	}
+}
+
+} /* namespace client */
@@ -0,0 +1,137 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "terminal/terminals/recording_terminal.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace client {
+
+RecordingTerminal::RecordingTerminal(ITerminalLayer* terminal, std::string path) : file_(path, std::ios::binary | std::ios::trunc) {
+	this->terminal_ = terminal;
+	if (!file_.is_open()) {
+		LOG_INFO << "Failed to open the recording file, calls are not recorded [file:" << path << "]";
+		return;
+	}
+	utils::writeRecordHeader(file_);
+	LOG_INFO << "Terminal calls recorded [file:" << path << "]";
+}
+
+RecordingTerminal::~RecordingTerminal() {
+	delete terminal_;
+}
+
+ResponsePacket RecordingTerminal::init() {
+	return record(utils::RECORD_INIT, {}, [this]() { return terminal_->init(); });
+}
+
+ResponsePacket RecordingTerminal::loadAndListReaders() {
+	return record(utils::RECORD_LOAD_AND_LIST_READERS, {}, [this]() { return terminal_->loadAndListReaders(); });
+}
+
+ResponsePacket RecordingTerminal::connect(const char* reader) {
+	return record(utils::RECORD_CONNECT, std::vector<unsigned char>(reader, reader + strlen(reader)), [this, reader]() { return terminal_->connect(reader); });
+}
+
+ResponsePacket RecordingTerminal::sendCommand(const Apdu& command) {
+	return record(utils::RECORD_SEND_COMMAND, std::vector<unsigned char>(command.data(), command.data() + command.size()), [this, &command]() {
+		return terminal_->sendCommand(command);
+	});
+}
+
+ResponsePacket RecordingTerminal::sendTypeA(const Apdu& command) {
+	return record(utils::RECORD_SEND_TYPE_A, std::vector<unsigned char>(command.data(), command.data() + command.size()), [this, &command]() {
+		return terminal_->sendTypeA(command);
+	});
+}
+
+ResponsePacket RecordingTerminal::sendTypeB(const Apdu& command) {
+	return record(utils::RECORD_SEND_TYPE_B, std::vector<unsigned char>(command.data(), command.data() + command.size()), [this, &command]() {
+		return terminal_->sendTypeB(command);
+	});
+}
+
+ResponsePacket RecordingTerminal::sendTypeF(const Apdu& command) {
+	return record(utils::RECORD_SEND_TYPE_F, std::vector<unsigned char>(command.data(), command.data() + command.size()), [this, &command]() {
+		return terminal_->sendTypeF(command);
+	});
+}
+
+ResponsePacket RecordingTerminal::diag() {
+	return record(utils::RECORD_DIAG, {}, [this]() { return terminal_->diag(); });
+}
+
+ResponsePacket RecordingTerminal::disconnect() {
+	ResponsePacket response = record(utils::RECORD_DISCONNECT, {}, [this]() { return terminal_->disconnect(); });
+	file_.flush();
+	return response;
+}
+
+ResponsePacket RecordingTerminal::isAlive() {
+	return record(utils::RECORD_IS_ALIVE, {}, [this]() { return terminal_->isAlive(); });
+}
+
+ResponsePacket RecordingTerminal::restart() {
+	return record(utils::RECORD_RESTART, {}, [this]() { return terminal_->restart(); });
+}
+
+ResponsePacket RecordingTerminal::coldReset() {
+	return record(utils::RECORD_COLD_RESET, {}, [this]() { return terminal_->coldReset(); });
+}
+
+ResponsePacket RecordingTerminal::warmReset() {
+	return record(utils::RECORD_WARM_RESET, {}, [this]() { return terminal_->warmReset(); });
+}
+
+ResponsePacket RecordingTerminal::powerOFFField() {
+	return record(utils::RECORD_POWER_OFF_FIELD, {}, [this]() { return terminal_->powerOFFField(); });
+}
+
+ResponsePacket RecordingTerminal::powerONField() {
+	return record(utils::RECORD_POWER_ON_FIELD, {}, [this]() { return terminal_->powerONField(); });
+}
+
+void RecordingTerminal::onIdle() {
+	// not recorded: idle notifications depend on the timing of the requests, not on the card
+	terminal_->onIdle();
+	file_.flush();
+}
+
+ResponsePacket RecordingTerminal::startMonitoring(EventHandler on_event, bool watch_readers) {
+	// not recorded: events come from the monitoring thread, independently of the requests
+	return terminal_->startMonitoring(on_event, watch_readers);
+}
+
+void RecordingTerminal::stopMonitoring() {
+	terminal_->stopMonitoring();
+}
+
+ResponsePacket RecordingTerminal::record(utils::RecordMethod method, std::vector<unsigned char> argument, std::function<ResponsePacket()> call) {
+	auto start = std::chrono::steady_clock::now();
+	ResponsePacket response = call();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	if (file_.is_open()) {
+		utils::TerminalRecord terminal_record = { .method = (unsigned char) method, .duration_us = (std::uint32_t) duration.count(), .argument = argument, .response = response };
+		utils::writeRecord(file_, terminal_record);
+	}
+	return response;
+}
+
+} /* namespace client */
@@ -0,0 +1,155 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
+#include "terminal/terminals/replay_terminal.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace client {
+
+/**
+ * loadRecords - read the given recording, recordings being read once and shared by all the terminals.
+ */
+static std::shared_ptr<const std::vector<utils::TerminalRecord>> loadRecords(std::string path, std::string* error) {
+	static std::mutex recordings_mutex;
+	static std::map<std::string, std::shared_ptr<const std::vector<utils::TerminalRecord>>> recordings;
+
+	std::lock_guard<std::mutex> guard(recordings_mutex);
+	auto it = recordings.find(path);
+	if (it != recordings.end()) {
+		return it->second;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open() || !utils::readRecordHeader(file)) {
+		*error = "Failed to open the recording " + path;
+		return nullptr;
+	}
+
+	std::shared_ptr<std::vector<utils::TerminalRecord>> records = std::make_shared<std::vector<utils::TerminalRecord>>();
+	utils::TerminalRecord record;
+	while (utils::readRecord(file, &record)) {
+		records->push_back(record);
+	}
+
+	LOG_DEBUG << "Recording loaded [file:" << path << "][records:" << records->size() << "]";
+	recordings[path] = records;
+	return records;
+}
+
+ResponsePacket ReplayTerminal::init() {
+	ConfigWrapper& config = ConfigWrapper::getInstance();
+	std::string error;
+	records_ = loadRecords(path_, &error);
+	if (records_ == nullptr) {
+		return handleErrorResponse("Failed to initialize the replay terminal: " + error, ERR_REPLAY_FILE);
+	}
+	recorded_timing_ = config.getValue("replay_timing", DEFAULT_REPLAY_TIMING).compare("recorded") == 0;
+	position_ = 0;
+
+	LOG_INFO << "Terminal replay initialized";
+	return replay(utils::RECORD_INIT, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::loadAndListReaders() {
+	return replay(utils::RECORD_LOAD_AND_LIST_READERS, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::connect(const char* reader) {
+	return replay(utils::RECORD_CONNECT, (const unsigned char*) reader, strlen(reader));
+}
+
+ResponsePacket ReplayTerminal::sendCommand(const Apdu& command) {
+	return replay(utils::RECORD_SEND_COMMAND, command.data(), command.size());
+}
+
+ResponsePacket ReplayTerminal::sendTypeA(const Apdu& command) {
+	return replay(utils::RECORD_SEND_TYPE_A, command.data(), command.size());
+}
+
+ResponsePacket ReplayTerminal::sendTypeB(const Apdu& command) {
+	return replay(utils::RECORD_SEND_TYPE_B, command.data(), command.size());
+}
+
+ResponsePacket ReplayTerminal::sendTypeF(const Apdu& command) {
+	return replay(utils::RECORD_SEND_TYPE_F, command.data(), command.size());
+}
+
+ResponsePacket ReplayTerminal::diag() {
+	return replay(utils::RECORD_DIAG, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::disconnect() {
+	return replay(utils::RECORD_DISCONNECT, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::isAlive() {
+	return replay(utils::RECORD_IS_ALIVE, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::restart() {
+	return replay(utils::RECORD_RESTART, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::coldReset() {
+	return replay(utils::RECORD_COLD_RESET, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::warmReset() {
+	return replay(utils::RECORD_WARM_RESET, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::powerOFFField() {
+	return replay(utils::RECORD_POWER_OFF_FIELD, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::powerONField() {
+	return replay(utils::RECORD_POWER_ON_FIELD, NULL, 0);
+}
+
+ResponsePacket ReplayTerminal::replay(utils::RecordMethod method, const unsigned char* argument, unsigned long int argument_length) {
+	if (position_ >= records_->size()) {
+		return handleErrorResponse("End of the recording reached", ERR_REPLAY_END);
+	}
+
+	const utils::TerminalRecord& record = (*records_)[position_];
+	if (record.method != method || record.argument.size() != argument_length || !std::equal(record.argument.begin(), record.argument.end(), argument)) {
+		LOG_DEBUG << "Call differs from the recording [position:" << position_ << "][method:" << method << "][recorded method:" << (int) record.method << "]";
+		return handleErrorResponse("Call differs from the recording at position " + std::to_string(position_), ERR_REPLAY_MISMATCH);
+	}
+	position_++;
+
+	if (recorded_timing_) {
+		std::this_thread::sleep_for(std::chrono::microseconds(record.duration_us));
+	}
+	return record.response;
+}
+
+ResponsePacket ReplayTerminal::handleErrorResponse(std::string context_message, long int error) {
+	ResponsePacket response = { .response = "KO", .err_terminal_code = error, .err_terminal_description = context_message };
+	return response;
+}
+
+} /* namespace client */
@@ -0,0 +1,356 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
+#include "terminal/terminals/simulated_terminal.hpp"
+#include "terminal/terminals/utils/type_converter.hpp"
+#include "nlohmann/json.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace client {
+
+/**
+ * parseLatency - read a latency distribution from the rule file.
+ * A distribution whose parameters are not valid (max lower than min, stddev not positive) falls back to a fixed latency.
+ */
+static SimulatedLatency parseLatency(const nlohmann::json& jlatency) {
+	SimulatedLatency latency;
+	latency.distribution = jlatency.value("distribution", "fixed");
+	if (latency.distribution == "uniform") {
+		latency.first = jlatency.value("min", 0.0);
+		latency.second = jlatency.value("max", 0.0);
+		if (latency.second < latency.first) {
+			LOG_DEBUG << "Invalid uniform latency, fixed latency used [min:" << latency.first << "][max:" << latency.second << "]";
+			latency.distribution = "fixed";
+		}
+	} else if (latency.distribution == "normal") {
+		latency.first = jlatency.value("mean", 0.0);
+		latency.second = jlatency.value("stddev", 0.0);
+		if (!(latency.second > 0)) {
+			LOG_DEBUG << "Invalid normal latency, fixed latency used [mean:" << latency.first << "][stddev:" << latency.second << "]";
+			latency.distribution = "fixed";
+		}
+	} else if (latency.distribution == "exponential") {
+		latency.first = jlatency.value("mean", 0.0);
+	} else {
+		latency.first = jlatency.value("value", 0.0);
+	}
+	return latency;
+}
+
+/**
+ * parsePattern - read a command pattern such as "00 A4 04 00 *" or "80 CA XX XX 00".
+ */
+static bool parsePattern(std::string text, SimulatedRule* rule) {
+	std::string pattern;
+	for (char c : text) {
+		if (!std::isspace((unsigned char) c)) {
+			pattern += std::toupper((unsigned char) c);
+		}
+	}
+	if (!pattern.empty() && pattern.back() == '*') {
+		rule->prefix = true;
+		pattern.pop_back();
+	}
+	if (pattern.size() % 2 != 0) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < pattern.size(); i += 2) {
+		std::string byte = pattern.substr(i, 2);
+		if (byte == "XX") {
+			rule->pattern.push_back(0x00);
+			rule->wildcards.push_back(true);
+		} else if (std::isxdigit((unsigned char) byte[0]) && std::isxdigit((unsigned char) byte[1])) {
+			rule->pattern.push_back(std::stoul(byte, nullptr, 16));
+			rule->wildcards.push_back(false);
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * formatHex - normalize an hexadecimal string to the format used by the terminals' responses ("90 00").
+ */
+static std::string formatHex(std::string hex) {
+	unsigned long int length;
+	unsigned char* bytes = utils::stringToUnsignedChar(hex, &length);
+	std::string formatted = utils::unsignedCharToString(bytes, length);
+	delete[] bytes;
+	return formatted;
+}
+
+/**
+ * loadCard - parse the given rule file, an empty path giving a card answering "90 00" to every command.
+ * Rule files are parsed once and shared by all the terminals.
+ */
+static std::shared_ptr<const SimulatedCard> loadCard(std::string path, std::string* error) {
+	static std::mutex cards_mutex;
+	static std::map<std::string, std::shared_ptr<const SimulatedCard>> cards;
+
+	std::lock_guard<std::mutex> guard(cards_mutex);
+	auto it = cards.find(path);
+	if (it != cards.end()) {
+		return it->second;
+	}
+
+	nlohmann::json jcard = nlohmann::json::object();
+	if (!path.empty()) {
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			*error = "Failed to open the rule file " + path;
+			return nullptr;
+		}
+		try {
+			file >> jcard;
+		} catch (nlohmann::detail::exception& e) {
+			*error = "Failed to parse the rule file: " + std::string(e.what());
+			return nullptr;
+		}
+	}
+
+	std::shared_ptr<SimulatedCard> card = std::make_shared<SimulatedCard>();
+	try {
+		card->readers = jcard.value("readers", std::vector<std::string> { "Simulated reader 0" });
+		card->atr = formatHex(jcard.value("atr", "3B 80 80 01 01"));
+		card->warm_atr = formatHex(jcard.value("warm_atr", card->atr));
+		card->default_response = formatHex(jcard.value("default_response", "90 00"));
+		card->error_rate = jcard.value("error_rate", 0.0);
+		if (jcard.find("latency") != jcard.end()) {
+			card->latency = parseLatency(jcard["latency"]);
+		}
+
+		for (const nlohmann::json& jrule : jcard.value("rules", nlohmann::json::array())) {
+			SimulatedRule rule;
+			if (!parsePattern(jrule.at("command").get<std::string>(), &rule)) {
+				*error = "Invalid command pattern " + jrule.at("command").get<std::string>();
+				return nullptr;
+			}
+			rule.response = formatHex(jrule.at("response").get<std::string>());
+			rule.state = jrule.value("state", "");
+			rule.next_state = jrule.value("next_state", "");
+			if (jrule.find("latency") != jrule.end()) {
+				rule.has_latency = true;
+				rule.latency = parseLatency(jrule["latency"]);
+			}
+			card->rules.push_back(rule);
+		}
+	} catch (nlohmann::detail::exception& e) {
+		*error = "Invalid rule file: " + std::string(e.what());
+		return nullptr;
+	}
+
+	LOG_DEBUG << "Simulated card loaded [file:" << path << "][rules:" << card->rules.size() << "]";
+	cards[path] = card;
+	return card;
+}
+
+SimulatedTerminal::SimulatedTerminal() : generator_(std::random_device()()) {
+}
+
+ResponsePacket SimulatedTerminal::init() {
+	std::string error;
+	card_ = loadCard(ConfigWrapper::getInstance().getValue("simulated_card", DEFAULT_SIMULATED_CARD), &error);
+	if (card_ == nullptr) {
+		return handleErrorResponse("Failed to initialize the simulated terminal: " + error, ERR_SIMULATED_CARD_FILE);
+	}
+
+	LOG_INFO << "Terminal simulated initialized";
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::loadAndListReaders() {
+	ResponsePacket response;
+	std::string list_readers;
+	for (std::size_t i = 0; i < card_->readers.size(); i++) {
+		list_readers += std::to_string(i) + "|" + card_->readers[i] + "|";
+	}
+	response.response = list_readers;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::connect(const char* reader) {
+	if (std::find(card_->readers.begin(), card_->readers.end(), reader) == card_->readers.end()) {
+		return handleErrorResponse("Failed to connect: unknown reader", ERR_SIMULATED_NO_READER);
+	}
+
+	current_reader_ = reader;
+	connected_ = true;
+	field_on_ = true;
+	state_.clear();
+	LOG_DEBUG << "Reader connected: " << reader;
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::sendCommand(const Apdu& command) {
+	ResponsePacket response = checkCard();
+	if (response.err_terminal_code < 0) {
+		return response;
+	}
+
+	const SimulatedRule* rule = findRule(command);
+	simulateLatency(rule != NULL && rule->has_latency ? rule->latency : card_->latency);
+	if (card_->error_rate > 0 && std::uniform_real_distribution<double>(0, 1)(generator_) < card_->error_rate) {
+		return handleErrorResponse("Failed to send command", ERR_SIMULATED_INJECTED);
+	}
+
+	if (rule == NULL) {
+		response.response = card_->default_response;
+		return response;
+	}
+	if (!rule->next_state.empty()) {
+		state_ = rule->next_state;
+	}
+	response.response = rule->response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::sendTypeA(const Apdu& command) {
+	return sendCommand(command);
+}
+
+ResponsePacket SimulatedTerminal::sendTypeB(const Apdu& command) {
+	return sendCommand(command);
+}
+
+ResponsePacket SimulatedTerminal::sendTypeF(const Apdu& command) {
+	return sendCommand(command);
+}
+
+ResponsePacket SimulatedTerminal::diag() {
+	ResponsePacket response;
+	std::string status = !connected_ ? "Not connected" : field_on_ ? "Card present and powered" : "Field off";
+	response.response = "Readers: " + current_reader_ + " | Status: " + status + " | Protocol: Simulated";
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::disconnect() {
+	connected_ = false;
+	LOG_INFO << "Terminal simulated disconnected successfully";
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::isAlive() {
+	return checkCard();
+}
+
+ResponsePacket SimulatedTerminal::restart() {
+	state_.clear();
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::coldReset() {
+	field_on_ = true;
+	return reset(card_->atr);
+}
+
+ResponsePacket SimulatedTerminal::warmReset() {
+	return reset(card_->warm_atr);
+}
+
+ResponsePacket SimulatedTerminal::powerOFFField() {
+	field_on_ = false;
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::powerONField() {
+	field_on_ = true;
+	state_.clear(); // the card is powered again
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::checkCard() {
+	if (!connected_) {
+		return handleErrorResponse("Terminal not connected", ERR_SIMULATED_NO_READER);
+	}
+	if (!field_on_) {
+		return handleErrorResponse("No card in the field", ERR_SIMULATED_NO_FIELD);
+	}
+	ResponsePacket response;
+	return response;
+}
+
+ResponsePacket SimulatedTerminal::reset(std::string atr) {
+	ResponsePacket response = checkCard();
+	if (response.err_terminal_code < 0) {
+		return response;
+	}
+
+	simulateLatency(card_->latency);
+	state_.clear();
+	response.response = atr;
+	return response;
+}
+
+const SimulatedRule* SimulatedTerminal::findRule(const Apdu& command) {
+	for (const SimulatedRule& rule : card_->rules) {
+		if (!rule.state.empty() && rule.state != state_) {
+			continue;
+		}
+		if (command.size() < rule.pattern.size() || (!rule.prefix && command.size() != rule.pattern.size())) {
+			continue;
+		}
+
+		bool match = true;
+		for (std::size_t i = 0; i < rule.pattern.size() && match; i++) {
+			match = rule.wildcards[i] || rule.pattern[i] == command[i];
+		}
+		if (match) {
+			return &rule;
+		}
+	}
+	return NULL;
+}
+
+void SimulatedTerminal::simulateLatency(const SimulatedLatency& latency) {
+	double delay = latency.first;
+	if (latency.distribution == "uniform") {
+		delay = std::uniform_real_distribution<double>(latency.first, latency.second)(generator_);
+	} else if (latency.distribution == "normal") {
+		delay = std::normal_distribution<double>(latency.first, latency.second)(generator_);
+	} else if (latency.distribution == "exponential" && latency.first > 0) {
+		delay = std::exponential_distribution<double>(1 / latency.first)(generator_);
+	}
+
+	if (delay > 0) {
+		std::this_thread::sleep_for(std::chrono::microseconds((long long) (delay * 1000)));
+	}
+}
+
+ResponsePacket SimulatedTerminal::handleErrorResponse(std::string context_message, long int error) {
+	ResponsePacket response = { .response = "KO", .err_terminal_code = error, .err_terminal_description = context_message };
+	return response;
+}
+
+} /* namespace client */
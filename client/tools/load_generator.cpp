@@ -0,0 +1,594 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+/**
+ * Load generator opening many virtual clients from one process, each one a ClientAPI with the SIMULATED terminal,
+ * to find the limits of a server under test: number of connections, handshake rate and memory per client.
+ * It is not part of the client's build, compile it from the client's directory with:
+ *   g++ -std=gnu++1y -O2 -Iinclude -Ilibraries tools/load_generator.cpp $(find src -name "*.cpp" ! -name main.cpp ! -path "src/dll/*") -lWs2_32 -lWinSCard
+ * Usage: load_generator <profile>
+ * The profile (see config/load_profile.json) is a sequence of stages. During a stage, the number of connected clients
+ * moves linearly from the target of the previous stage to the stage's "clients", and the connected clients send
+ * "event_rate" events per second in total to the server. The requests are sent by the server: the virtual clients
+ * answer the ones the test tool sends them.
+ * A json line is printed every "report_interval" seconds, with the counters since the start and the accept latencies
+ * (connection and handshake, in microseconds) of the interval. When "metrics" is set to the ip:port of the server's
+ * metrics endpoint, the line also holds the server's clients, memory, threads, handles and errors. The last line,
+ * with "summary":true, holds the error rates and the server's memory growth per client.
+ */
+
+#define PSAPI_VERSION 2 // GetProcessMemoryInfo from kernel32, without linking psapi
+
+#include "client/client_api.hpp"
+#include "client/requests/cold_reset.hpp"
+#include "client/requests/command.hpp"
+#include "client/requests/diag.hpp"
+#include "client/requests/disconnect.hpp"
+#include "client/requests/echo.hpp"
+#include "client/requests/power_off_field.hpp"
+#include "client/requests/power_on_field.hpp"
+#include "client/requests/restart_target.hpp"
+#include "client/requests/script_load.hpp"
+#include "client/requests/script_run.hpp"
+#include "client/requests/send_typeA.hpp"
+#include "client/requests/send_typeB.hpp"
+#include "client/requests/send_typeF.hpp"
+#include "client/requests/warm_reset.hpp"
+#include "constants/event_type.hpp"
+#include "constants/request_code.hpp"
+#include "constants/response_packet.hpp"
+#include "metrics/latency_histogram.hpp"
+#include "terminal/factories/simulated_factory.hpp"
+#include "terminal/flyweight_terminal_factory.hpp"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <psapi.h>
+
+using namespace client;
+
+namespace {
+
+struct Stage {
+	double duration; // seconds
+	int clients;
+	double event_rate; // events per second sent by all the connected clients
+};
+
+struct Profile {
+	std::string ip = "127.0.0.1";
+	std::string port = "62111";
+	std::string reader = "Simulated reader 0";
+	std::string simulated_card;
+	std::string metrics_ip;
+	std::string metrics_port;
+	double report_interval = 1;
+	int connect_threads = 8;
+	std::vector<Stage> stages;
+};
+
+/**
+ * VirtualClient - a client of the generator. Its mutex is held while it is connected, disconnected or sends an event.
+ */
+struct VirtualClient {
+	ClientAPI* api = NULL;
+	std::mutex mutex;
+	bool connected = false;
+};
+
+/**
+ * Counters - the generator's counters since the start, the accept latencies being also kept for the current interval.
+ */
+struct Counters {
+	std::atomic<uint64_t> connects { 0 };
+	std::atomic<uint64_t> connect_errors { 0 };
+	std::atomic<uint64_t> disconnects { 0 };
+	std::atomic<uint64_t> events { 0 };
+	std::atomic<uint64_t> event_errors { 0 };
+	LatencyHistogram accept_latency; // microseconds
+	LatencyHistogram interval_accept_latency;
+};
+
+std::atomic<uint64_t> connection_ends { 0 }; // disconnections seen by the clients, the ones requested by the generator included
+
+void __stdcall onConnectionLost(const char* text) {
+	connection_ends.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool loadProfile(const char* path, Profile* profile) {
+	try {
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			std::fprintf(stderr, "Cannot open %s\n", path);
+			return false;
+		}
+		nlohmann::json jprofile;
+		file >> jprofile;
+		profile->ip = jprofile.value("ip", profile->ip);
+		profile->port = jprofile.value("port", profile->port);
+		profile->reader = jprofile.value("reader", profile->reader);
+		profile->simulated_card = jprofile.value("simulated_card", profile->simulated_card);
+		profile->report_interval = jprofile.value("report_interval", profile->report_interval);
+		profile->connect_threads = std::max(1, jprofile.value("connect_threads", profile->connect_threads));
+		std::string metrics = jprofile.value("metrics", "");
+		std::size_t separator = metrics.rfind(':');
+		if (separator != std::string::npos) {
+			profile->metrics_ip = metrics.substr(0, separator);
+			profile->metrics_port = metrics.substr(separator + 1);
+		}
+		for (const nlohmann::json& jstage : jprofile.at("stages")) {
+			Stage stage = { jstage.at("duration").get<double>(), jstage.at("clients").get<int>(), jstage.value("event_rate", 0.0) };
+			profile->stages.push_back(stage);
+		}
+	} catch (std::exception& e) {
+		std::fprintf(stderr, "Invalid profile %s: %s\n", path, e.what());
+		return false;
+	}
+	if (profile->stages.empty()) {
+		std::fprintf(stderr, "The profile has no stage\n");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * scrapeMetrics - read the metrics endpoint of the server, summing the samples of each metric whatever their labels.
+ */
+bool scrapeMetrics(const Profile& profile, std::map<std::string, double>* metrics) {
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* address = NULL;
+	if (getaddrinfo(profile.metrics_ip.c_str(), profile.metrics_port.c_str(), &hints, &address) != 0) {
+		return false;
+	}
+	SOCKET scrape_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+	bool connected = scrape_socket != INVALID_SOCKET && connect(scrape_socket, address->ai_addr, (int) address->ai_addrlen) != SOCKET_ERROR;
+	freeaddrinfo(address);
+	std::string response;
+	if (connected) {
+		const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+		send(scrape_socket, request, sizeof(request) - 1, 0);
+		char buffer[4096];
+		int received;
+		while ((received = recv(scrape_socket, buffer, sizeof(buffer), 0)) > 0) {
+			response.append(buffer, received);
+		}
+	}
+	if (scrape_socket != INVALID_SOCKET) {
+		closesocket(scrape_socket);
+	}
+
+	std::size_t body = response.find("\r\n\r\n");
+	if (body == std::string::npos) {
+		return false;
+	}
+	std::istringstream lines(response.substr(body + 4));
+	std::string line;
+	while (std::getline(lines, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::size_t value = line.rfind(' ');
+		std::size_t name_end = std::min(line.find('{'), line.find(' '));
+		if (value == std::string::npos || name_end == std::string::npos) {
+			continue;
+		}
+		(*metrics)[line.substr(0, name_end)] += std::atof(line.c_str() + value + 1);
+	}
+	return true;
+}
+
+uint64_t workingSet() {
+	PROCESS_MEMORY_COUNTERS counters;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+}
+
+/**
+ * Generator - the virtual clients and the threads connecting them and sending their events.
+ */
+class Generator {
+private:
+	const Profile& profile_;
+	std::vector<std::unique_ptr<VirtualClient>> clients_;
+	Counters counters_;
+	std::atomic<int> active_ { 0 }; // clients connected or being connected
+	std::atomic<int> connected_ { 0 };
+	std::atomic<double> event_rate_ { 0 };
+	std::atomic<bool> stop_ { false };
+	std::mutex tasks_mutex_;
+	std::condition_variable tasks_cv_;
+	std::deque<bool> tasks_; // true to connect a client, false to disconnect one
+	std::vector<std::thread> workers_;
+	std::thread event_thread_;
+	std::atomic<std::size_t> next_ { 0 };
+public:
+	explicit Generator(const Profile& profile) : profile_(profile) {}
+
+	/**
+	 * init - create and initialize the virtual clients.
+	 * The clients share the configuration of the process: they are all initialized before any of them is connected.
+	 */
+	bool init(int count) {
+		FlyweightTerminalFactory available_terminals;
+		available_terminals.addFactory("SIMULATED", new SimulatedFactory());
+
+		FlyweightRequests available_requests;
+		available_requests.addRequest(REQ_COMMAND, new Command());
+		available_requests.addRequest(REQ_COMMAND_A, new SendTypeA());
+		available_requests.addRequest(REQ_COMMAND_B, new SendTypeB());
+		available_requests.addRequest(REQ_COMMAND_F, new SendTypeF());
+		available_requests.addRequest(REQ_DIAG, new Diag());
+		available_requests.addRequest(REQ_DISCONNECT, new Disconnect());
+		available_requests.addRequest(REQ_ECHO, new Echo());
+		available_requests.addRequest(REQ_RESTART, new RestartTarget());
+		available_requests.addRequest(REQ_COLD_RESET, new ColdReset());
+		available_requests.addRequest(REQ_WARM_RESET, new WarmReset());
+		available_requests.addRequest(REQ_POWER_OFF_FIELD, new PowerOffField());
+		available_requests.addRequest(REQ_POWER_ON_FIELD, new PowerOnField());
+		available_requests.addRequest(REQ_SCRIPT_LOAD, new ScriptLoad());
+		available_requests.addRequest(REQ_SCRIPT_RUN, new ScriptRun());
+
+		// the clients send events so that the server answers their handshake: the accept latency includes the registration
+		nlohmann::json jconfig = {
+			{ "name", "load_generator" },
+			{ "terminal", "SIMULATED" },
+			{ "simulated_card", profile_.simulated_card },
+			{ "log_level", "info" },
+			{ "log_async", "true" },
+			{ "log_filename", "load_generator" },
+			{ "monitor_events", "true" }
+		};
+		std::string config = jconfig.dump();
+		for (int i = 0; i < count; i++) {
+			std::unique_ptr<VirtualClient> client(new VirtualClient());
+			client->api = new ClientAPI(onConnectionLost, 0, 0);
+			ResponsePacket response_packet = client->api->initClient(config, available_terminals, available_requests);
+			if (response_packet.err_client_code != SUCCESS || response_packet.err_terminal_code != SUCCESS) {
+				std::fprintf(stderr, "Failed to initialize the virtual client %d: %s%s\n", i, response_packet.err_client_description.c_str(),
+						response_packet.err_terminal_description.c_str());
+				delete client->api;
+				return false;
+			}
+			clients_.push_back(std::move(client));
+		}
+		return true;
+	}
+
+	void start() {
+		for (int i = 0; i < profile_.connect_threads; i++) {
+			workers_.push_back(std::thread(&Generator::runTasks, this));
+		}
+		event_thread_ = std::thread(&Generator::sendEvents, this);
+	}
+
+	/**
+	 * stop - disconnect all the clients and stop the threads.
+	 */
+	void stop() {
+		setTarget(0, 0);
+		{
+			std::lock_guard<std::mutex> guard(tasks_mutex_);
+			stop_ = true;
+		}
+		tasks_cv_.notify_all();
+		for (std::thread& worker : workers_) {
+			worker.join();
+		}
+		event_thread_.join();
+		for (std::unique_ptr<VirtualClient>& client : clients_) {
+			std::lock_guard<std::mutex> guard(client->mutex);
+			if (client->connected) {
+				client->api->disconnectClient();
+			}
+			delete client->api;
+		}
+	}
+
+	/**
+	 * setTarget - queue the connections or disconnections reaching the given number of clients, and set the event rate.
+	 */
+	void setTarget(int target, double event_rate) {
+		event_rate_ = event_rate;
+		target = std::min<int>(target, clients_.size());
+		std::lock_guard<std::mutex> guard(tasks_mutex_);
+		while (active_.load() < target) {
+			tasks_.push_back(true);
+			active_++;
+		}
+		while (active_.load() > target) {
+			tasks_.push_back(false);
+			active_--;
+		}
+		tasks_cv_.notify_all();
+	}
+
+	Counters& getCounters() {
+		return counters_;
+	}
+
+	int getConnected() {
+		return connected_.load();
+	}
+private:
+	/**
+	 * lockClient - lock the next client which is connected, or not, and not used by another thread.
+	 * @return the locked client, NULL if there is none once the generator is stopped.
+	 */
+	VirtualClient* lockClient(bool connected) {
+		while (true) {
+			for (std::size_t i = 0; i < clients_.size(); i++) {
+				VirtualClient* client = clients_[next_++ % clients_.size()].get();
+				if (client->mutex.try_lock()) {
+					if (client->connected == connected) {
+						return client;
+					}
+					client->mutex.unlock();
+				}
+			}
+			if (stop_.load()) {
+				break;
+			}
+			// the clients are being connected or disconnected by the other threads
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return NULL;
+	}
+
+	/**
+	 * runTasks - connect and disconnect clients in the order the tasks were queued.
+	 */
+	void runTasks() {
+		while (true) {
+			bool connect;
+			{
+				std::unique_lock<std::mutex> lock(tasks_mutex_);
+				tasks_cv_.wait(lock, [this] { return stop_.load() || !tasks_.empty(); });
+				if (tasks_.empty()) {
+					return;
+				}
+				connect = tasks_.front();
+				tasks_.pop_front();
+			}
+
+			VirtualClient* client = lockClient(!connect);
+			if (client == NULL) {
+				continue;
+			}
+			std::lock_guard<std::mutex> guard(client->mutex, std::adopt_lock);
+			if (connect) {
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				ResponsePacket response_packet = client->api->connectClient(profile_.reader.c_str(), profile_.ip.c_str(), profile_.port.c_str());
+				long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+				if (response_packet.err_client_code == SUCCESS && response_packet.err_terminal_code == SUCCESS) {
+					client->connected = true;
+					connected_++;
+					counters_.connects.fetch_add(1, std::memory_order_relaxed);
+					counters_.accept_latency.record(elapsed);
+					counters_.interval_accept_latency.record(elapsed);
+				} else {
+					counters_.connect_errors.fetch_add(1, std::memory_order_relaxed);
+					active_--;
+				}
+			} else {
+				client->connected = false;
+				connected_--;
+				if (client->api->disconnectClient().err_client_code == SUCCESS) {
+					counters_.disconnects.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	/**
+	 * sendEvents - send the events of the current rate, each one by the next connected client.
+	 * A client failing to send its event has lost its connection: it is connected again by the next ramp.
+	 */
+	void sendEvents() {
+		double budget = 0;
+		std::size_t next = 0;
+		std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+		while (!stop_.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			budget += event_rate_.load() * std::chrono::duration<double>(now - last).count();
+			last = now;
+
+			std::size_t skipped = 0;
+			while (budget >= 1 && skipped < clients_.size()) {
+				VirtualClient* client = clients_[next++ % clients_.size()].get();
+				std::unique_lock<std::mutex> lock(client->mutex, std::try_to_lock);
+				if (!lock.owns_lock() || !client->connected) {
+					skipped++;
+					continue;
+				}
+				skipped = 0;
+				budget--;
+				if (client->api->sendEvent(EVT_LOAD, "0").err_client_code == SUCCESS) {
+					counters_.events.fetch_add(1, std::memory_order_relaxed);
+					continue;
+				}
+				counters_.event_errors.fetch_add(1, std::memory_order_relaxed);
+				client->connected = false;
+				connected_--;
+				client->api->disconnectClient();
+				active_--;
+			}
+			if (skipped >= clients_.size()) {
+				budget = 0; // no client to send the events
+			}
+		}
+	}
+};
+
+double ratio(uint64_t part, uint64_t total) {
+	return total > 0 ? (double) part / total : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::fprintf(stderr, "Usage: load_generator <profile>\n");
+		return 2;
+	}
+	Profile profile;
+	if (!loadProfile(argv[1], &profile)) {
+		return 2;
+	}
+	WSADATA wsa_data;
+	WSAStartup(MAKEWORD(2, 2), &wsa_data);
+	bool scrape = !profile.metrics_port.empty();
+
+	int max_clients = 0;
+	for (const Stage& stage : profile.stages) {
+		max_clients = std::max(max_clients, stage.clients);
+	}
+	uint64_t initial_working_set = workingSet();
+	std::map<std::string, double> initial_metrics;
+	if (scrape && !scrapeMetrics(profile, &initial_metrics)) {
+		std::fprintf(stderr, "Cannot read the metrics of the server on %s:%s\n", profile.metrics_ip.c_str(), profile.metrics_port.c_str());
+		return 1;
+	}
+
+	Generator generator(profile);
+	if (!generator.init(max_clients)) {
+		return 1;
+	}
+	std::fprintf(stderr, "%d virtual clients initialized, %.1f KB each\n", max_clients, max_clients > 0 ? (workingSet() - initial_working_set) / 1024.0 / max_clients : 0.0);
+	generator.start();
+
+	Counters& counters = generator.getCounters();
+	std::map<std::string, double> metrics = initial_metrics;
+	double peak_server_clients = 0;
+	double peak_memory_per_client = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point next_report = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(profile.report_interval));
+	int previous_target = 0;
+	for (std::size_t i = 0; i < profile.stages.size(); i++) {
+		const Stage& stage = profile.stages[i];
+		std::chrono::steady_clock::time_point stage_start = std::chrono::steady_clock::now();
+		double elapsed = 0;
+		while (elapsed < stage.duration) {
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - stage_start).count();
+			double progress = stage.duration > 0 ? std::min(1.0, elapsed / stage.duration) : 1.0;
+			int target = previous_target + (int) ((stage.clients - previous_target) * progress);
+			generator.setTarget(target, stage.event_rate);
+
+			if (std::chrono::steady_clock::now() >= next_report) {
+				next_report += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(profile.report_interval));
+				uint64_t disconnects = counters.disconnects.load();
+				uint64_t ends = connection_ends.load();
+				nlohmann::json jreport = {
+					{ "time", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() },
+					{ "stage", i },
+					{ "target", target },
+					{ "connected", generator.getConnected() },
+					{ "connects", counters.connects.load() },
+					{ "connect_errors", counters.connect_errors.load() },
+					{ "disconnects", disconnects },
+					{ "lost", ends > disconnects ? ends - disconnects : 0 },
+					{ "events", counters.events.load() },
+					{ "event_errors", counters.event_errors.load() },
+					{ "accept_us", { { "count", counters.interval_accept_latency.getCount() },
+							{ "p50", counters.interval_accept_latency.getPercentile(50) },
+							{ "p99", counters.interval_accept_latency.getPercentile(99) },
+							{ "max", counters.interval_accept_latency.getMax() } } },
+					{ "generator_working_set", workingSet() }
+				};
+				counters.interval_accept_latency.reset();
+				std::map<std::string, double> sample;
+				if (scrape && scrapeMetrics(profile, &sample)) {
+					metrics = sample;
+					double clients = metrics["gp_server_clients"];
+					double growth = metrics["gp_server_private_memory_bytes"] - initial_metrics["gp_server_private_memory_bytes"];
+					double per_client = clients > 0 ? growth / clients : 0;
+					peak_server_clients = std::max(peak_server_clients, clients);
+					peak_memory_per_client = std::max(peak_memory_per_client, per_client);
+					jreport["server"] = {
+						{ "clients", clients },
+						{ "resident_memory", metrics["gp_server_resident_memory_bytes"] },
+						{ "private_memory", metrics["gp_server_private_memory_bytes"] },
+						{ "memory_per_client", per_client },
+						{ "threads", metrics["gp_server_threads"] },
+						{ "handles", metrics["gp_server_handles"] },
+						{ "connections", metrics["gp_server_connections_total"] - initial_metrics["gp_server_connections_total"] },
+						{ "events", metrics["gp_server_events_total"] - initial_metrics["gp_server_events_total"] },
+						{ "request_errors", metrics["gp_server_request_errors_total"] - initial_metrics["gp_server_request_errors_total"] },
+						{ "request_timeouts", metrics["gp_server_request_timeouts_total"] - initial_metrics["gp_server_request_timeouts_total"] }
+					};
+				} else if (scrape) {
+					jreport["server"] = nullptr; // the server does not answer anymore
+				}
+				std::printf("%s\n", jreport.dump().c_str());
+				std::fflush(stdout);
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		previous_target = stage.clients;
+	}
+	generator.stop();
+
+	uint64_t connects = counters.connects.load();
+	uint64_t connect_errors = counters.connect_errors.load();
+	uint64_t events = counters.events.load();
+	uint64_t event_errors = counters.event_errors.load();
+	uint64_t disconnects = counters.disconnects.load();
+	uint64_t ends = connection_ends.load();
+	nlohmann::json jsummary = {
+		{ "summary", true },
+		{ "duration", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() },
+		{ "virtual_clients", max_clients },
+		{ "connects", connects },
+		{ "connect_error_rate", ratio(connect_errors, connects + connect_errors) },
+		{ "lost", ends > disconnects ? ends - disconnects : 0 },
+		{ "events", events },
+		{ "event_error_rate", ratio(event_errors, events + event_errors) },
+		{ "accept_us", { { "count", counters.accept_latency.getCount() },
+				{ "p50", counters.accept_latency.getPercentile(50) },
+				{ "p99", counters.accept_latency.getPercentile(99) },
+				{ "p999", counters.accept_latency.getPercentile(99.9) },
+				{ "max", counters.accept_latency.getMax() } } }
+	};
+	if (scrape) {
+		jsummary["server"] = {
+			{ "peak_clients", peak_server_clients },
+			{ "peak_memory_per_client", peak_memory_per_client },
+			{ "private_memory_growth", metrics["gp_server_private_memory_bytes"] - initial_metrics["gp_server_private_memory_bytes"] }
+		};
+	}
+	std::printf("%s\n", jsummary.dump().c_str());
+	WSACleanup();
+	return 0;
+}
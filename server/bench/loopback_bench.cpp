@@ -0,0 +1,449 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+/**
+ * End-to-end benchmark over the loopback interface: a ServerEngine of this process sends commands to clients created
+ * in the same process from the client's DLL, with the SIMULATED terminal, so that the whole stack is measured without reader.
+ * The client is used through the functions exported by its DLL because the sources of the client and of the server cannot
+ * be compiled together. It is not part of the server's build, compile it from the server's directory with:
+ *   g++ -std=gnu++1y -O2 -Iinclude -Ilibraries bench/loopback_bench.cpp $(find src -name "*.cpp" ! -name main.cpp ! -path "src/dll/*") -lWs2_32
+ * and run it next to GpTcpClient.dll.
+ * Usage: loopback_bench [--workload ping|pipeline|batch|fanout] [--clients N] [--depth N] [--batch N] [--size bytes]
+ *                       [--duration seconds] [--warmup seconds] [--card rule_file] [--port port] [--dll path] [--events] [--timing]
+ * Workloads:
+ *   ping      one thread per client sending one command at a time.
+ *   pipeline  --depth threads per client sharing its connection, which is multiplexed (as with --events).
+ *   batch     one thread per client sending --batch commands at a time with sendBatch.
+ *   fanout    one thread sending a batch of one command to every client.
+ * The result is printed as a single json line. The latencies are those of the operations (a command, or a batch for
+ * batch and fanout) completed during the measured duration, in microseconds. The CPU time is the one of the whole
+ * process, server and clients, divided by the number of commands. With --timing, "stages" holds getStageTimings.
+ */
+
+#include "server/server_api.hpp"
+#include "constants/batch_request.hpp"
+#include "constants/default_values.hpp"
+#include "constants/request_code.hpp"
+#include "constants/response_packet.hpp"
+#include "metrics/latency_histogram.hpp"
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <windows.h>
+
+namespace {
+
+/**
+ * ClientResultDLL - the ResultDLL struct of the client's dll/dll_client_api_wrapper.h.
+ */
+struct ClientResultDLL {
+	long int err_server_code;
+	long int err_client_code;
+	long int err_terminal_code;
+	long int err_card_code;
+	unsigned long int lengths[5];
+};
+
+typedef void* ClientHandle;
+typedef void* ClientResultHandle;
+typedef ClientHandle (__cdecl *CreateClientAPIFn)();
+typedef void (__cdecl *DisposeClientAPIFn)(ClientHandle client);
+typedef ClientResultHandle (__cdecl *InitClientResultFn)(ClientHandle client, const char* jsonConfig, ClientResultDLL& result);
+typedef ClientResultHandle (__cdecl *ConnectClientResultFn)(ClientHandle client, const char* reader, const char* ip, const char* port, ClientResultDLL& result);
+typedef ClientResultHandle (__cdecl *DisconnectClientResultFn)(ClientHandle client, ClientResultDLL& result);
+typedef unsigned long (__cdecl *GetResultTextFn)(ClientResultHandle handle, int field, char* buffer, unsigned long size);
+typedef void (__cdecl *ReleaseResultFn)(ClientResultHandle handle);
+
+/**
+ * ClientLibrary - the functions of the client's DLL used by the benchmark.
+ */
+struct ClientLibrary {
+	CreateClientAPIFn createClientAPI;
+	DisposeClientAPIFn disposeClientAPI;
+	InitClientResultFn initClientResult;
+	ConnectClientResultFn connectClientResult;
+	DisconnectClientResultFn disconnectClientResult;
+	GetResultTextFn getResultText;
+	ReleaseResultFn releaseResult;
+};
+
+struct Options {
+	std::string workload = "ping";
+	int clients = 1;
+	int depth = 4;
+	int batch = 16;
+	int size = 16;
+	double duration = 5;
+	double warmup = 1;
+	std::string card;
+	std::string port = "62112";
+	std::string dll = "GpTcpClient.dll";
+	bool events = false;
+	bool timing = false;
+};
+
+std::mutex accepted_mutex;
+std::vector<int> accepted_ids;
+
+void __stdcall onConnectionAccepted(int id_client, const char* name_client) {
+	std::lock_guard<std::mutex> guard(accepted_mutex);
+	accepted_ids.push_back(id_client);
+}
+
+template<typename F>
+bool loadFunction(HMODULE module, const char* name, F* function) {
+	*function = (F) GetProcAddress(module, name);
+	if (*function == NULL) {
+		std::fprintf(stderr, "Function %s not found in the client's DLL\n", name);
+	}
+	return *function != NULL;
+}
+
+bool loadClientLibrary(const std::string& path, ClientLibrary* library) {
+	// never freed: the client's logging thread lives until the process exits
+	HMODULE module = LoadLibrary(path.c_str());
+	if (module == NULL) {
+		std::fprintf(stderr, "Cannot load %s [error:%lu]\n", path.c_str(), GetLastError());
+		return false;
+	}
+	return loadFunction(module, "createClientAPI", &library->createClientAPI)
+			&& loadFunction(module, "disposeClientAPI", &library->disposeClientAPI)
+			&& loadFunction(module, "initClientResult", &library->initClientResult)
+			&& loadFunction(module, "connectClientResult", &library->connectClientResult)
+			&& loadFunction(module, "disconnectClientResult", &library->disconnectClientResult)
+			&& loadFunction(module, "getResultText", &library->getResultText)
+			&& loadFunction(module, "releaseResult", &library->releaseResult);
+}
+
+/**
+ * checkClientResult - release a result of the client's DLL, printing its descriptions if it holds an error.
+ */
+bool checkClientResult(const ClientLibrary& library, ClientResultHandle handle, const ClientResultDLL& result, const char* step) {
+	bool success = result.err_server_code == server::SUCCESS && result.err_client_code == server::SUCCESS
+			&& result.err_terminal_code == server::SUCCESS && result.err_card_code == server::SUCCESS;
+	if (!success) {
+		char client_description[DEFAULT_DLL_BUFFER_SIZE];
+		char terminal_description[DEFAULT_DLL_BUFFER_SIZE];
+		library.getResultText(handle, 2, client_description, sizeof(client_description));
+		library.getResultText(handle, 3, terminal_description, sizeof(terminal_description));
+		std::fprintf(stderr, "Client %s failed [client:%ld %s][terminal:%ld %s]\n", step, result.err_client_code, client_description,
+				result.err_terminal_code, terminal_description);
+	}
+	library.releaseResult(handle);
+	return success;
+}
+
+bool isSuccess(const server::ResponsePacket& response_packet) {
+	return response_packet.err_server_code == server::SUCCESS && response_packet.err_client_code == server::SUCCESS
+			&& response_packet.err_terminal_code == server::SUCCESS && response_packet.err_card_code == server::SUCCESS;
+}
+
+bool parseOptions(int argc, char* argv[], Options* options) {
+	for (int i = 1; i < argc; i++) {
+		std::string name = argv[i];
+		if (name == "--events") {
+			options->events = true;
+			continue;
+		}
+		if (name == "--timing") {
+			options->timing = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "Missing value of %s\n", name.c_str());
+			return false;
+		}
+		std::string value = argv[++i];
+		if (name == "--workload") {
+			options->workload = value;
+		} else if (name == "--clients") {
+			options->clients = std::atoi(value.c_str());
+		} else if (name == "--depth") {
+			options->depth = std::atoi(value.c_str());
+		} else if (name == "--batch") {
+			options->batch = std::atoi(value.c_str());
+		} else if (name == "--size") {
+			options->size = std::atoi(value.c_str());
+		} else if (name == "--duration") {
+			options->duration = std::atof(value.c_str());
+		} else if (name == "--warmup") {
+			options->warmup = std::atof(value.c_str());
+		} else if (name == "--card") {
+			options->card = value;
+		} else if (name == "--port") {
+			options->port = value;
+		} else if (name == "--dll") {
+			options->dll = value;
+		} else {
+			std::fprintf(stderr, "Unknown option %s\n", name.c_str());
+			return false;
+		}
+	}
+	if (options->workload != "ping" && options->workload != "pipeline" && options->workload != "batch" && options->workload != "fanout") {
+		std::fprintf(stderr, "Unknown workload %s\n", options->workload.c_str());
+		return false;
+	}
+	if (options->clients < 1 || options->depth < 1 || options->batch < 1 || options->size < 0 || options->size > 255 || options->duration <= 0) {
+		std::fprintf(stderr, "Invalid option value\n");
+		return false;
+	}
+	options->events = options->events || options->workload == "pipeline";
+	return true;
+}
+
+/**
+ * buildCommand - a case 3 command APDU carrying the given number of bytes, or a case 1 one without data.
+ */
+std::string buildCommand(int size) {
+	static const char HEX_DIGITS[] = "0123456789ABCDEF";
+	std::string command = "80CA9F7F";
+	if (size > 0) {
+		command.push_back(HEX_DIGITS[size >> 4]);
+		command.push_back(HEX_DIGITS[size & 0x0F]);
+		command.append(size * 2, 'A');
+	}
+	return command;
+}
+
+unsigned long long processCpuTime() {
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	ULARGE_INTEGER kernel_time, user_time;
+	kernel_time.LowPart = kernel.dwLowDateTime;
+	kernel_time.HighPart = kernel.dwHighDateTime;
+	user_time.LowPart = user.dwLowDateTime;
+	user_time.HighPart = user.dwHighDateTime;
+	return (kernel_time.QuadPart + user_time.QuadPart) / 10; // 100 ns units to microseconds
+}
+
+/**
+ * Run - the state shared by the threads sending the operations.
+ */
+struct Run {
+	std::atomic<bool> stop { false };
+	std::atomic<bool> measuring { false };
+	std::atomic<unsigned long long> operations { 0 };
+	std::atomic<unsigned long long> requests { 0 };
+	std::atomic<unsigned long long> errors { 0 };
+	server::LatencyHistogram latency; // nanoseconds
+};
+
+/**
+ * runOperations - send operations until the run is stopped, each operation returning its number of commands and of errors.
+ */
+template<typename F>
+void runOperations(Run* run, F operation) {
+	while (!run->stop.load()) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		unsigned long errors = 0;
+		unsigned long requests = operation(&errors);
+		long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		if (!run->measuring.load()) {
+			continue;
+		}
+		run->operations.fetch_add(1, std::memory_order_relaxed);
+		run->requests.fetch_add(requests, std::memory_order_relaxed);
+		run->errors.fetch_add(errors, std::memory_order_relaxed);
+		if (errors == 0) {
+			run->latency.record(elapsed);
+		}
+	}
+}
+
+double microseconds(uint64_t nanoseconds) {
+	return nanoseconds / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	using namespace server;
+	Options options;
+	if (!parseOptions(argc, argv, &options)) {
+		return 2;
+	}
+	ClientLibrary library;
+	if (!loadClientLibrary(options.dll, &library)) {
+		return 1;
+	}
+
+	nlohmann::json jserver_config = {
+		{ "timeout", "5000" },
+		{ "log_level", "info" },
+		{ "log_async", "true" },
+		{ "log_filename", "loopback_bench.csv" },
+		{ "request_timing", options.timing ? "true" : "false" }
+	};
+	ServerAPI* server = new ServerAPI(onConnectionAccepted);
+	ResponsePacket response_packet = server->initServer(jserver_config.dump());
+	if (isSuccess(response_packet)) {
+		response_packet = server->startServer("127.0.0.1", options.port.c_str());
+	}
+	if (!isSuccess(response_packet)) {
+		std::fprintf(stderr, "Failed to start the server: %s\n", response_packet.err_server_description.c_str());
+		return 1;
+	}
+
+	// the clients of the DLL share its configuration: they are all initialized before any of them is connected
+	nlohmann::json jclient_config = {
+		{ "name", "loopback_bench" },
+		{ "terminal", "SIMULATED" },
+		{ "simulated_card", options.card },
+		{ "log_level", "info" },
+		{ "log_async", "true" },
+		{ "log_filename", "loopback_bench_client" },
+		{ "monitor_events", options.events ? "true" : "false" }
+	};
+	std::string client_config = jclient_config.dump();
+	std::vector<ClientHandle> clients;
+	bool ready = true;
+	for (int i = 0; ready && i < options.clients; i++) {
+		ClientHandle client = library.createClientAPI();
+		clients.push_back(client);
+		ClientResultDLL result;
+		ready = checkClientResult(library, library.initClientResult(client, client_config.c_str(), result), result, "initialization");
+	}
+	for (std::size_t i = 0; ready && i < clients.size(); i++) {
+		ClientResultDLL result;
+		ready = checkClientResult(library, library.connectClientResult(clients[i], "Simulated reader 0", "127.0.0.1", options.port.c_str(), result), result, "connection");
+	}
+
+	std::vector<int> ids;
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (ready) {
+		{
+			std::lock_guard<std::mutex> guard(accepted_mutex);
+			ids = accepted_ids;
+		}
+		if ((int) ids.size() >= options.clients || std::chrono::steady_clock::now() > deadline) {
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	if (ready && (int) ids.size() < options.clients) {
+		std::fprintf(stderr, "Only %d of the %d clients were accepted by the server\n", (int) ids.size(), options.clients);
+		ready = false;
+	}
+
+	Run run;
+	std::vector<std::thread> threads;
+	std::string command = buildCommand(options.size);
+	DWORD timeout = DEFAULT_REQUEST_TIMEOUT;
+	for (std::size_t c = 0; ready && c < ids.size(); c++) {
+		int id_client = ids[c];
+		if (options.workload == "ping" || options.workload == "pipeline") {
+			int count = options.workload == "ping" ? 1 : options.depth;
+			for (int i = 0; i < count; i++) {
+				threads.push_back(std::thread([&run, server, id_client, &command, timeout] {
+					runOperations(&run, [server, id_client, &command, timeout](unsigned long* errors) {
+						*errors = isSuccess(server->sendCommand(id_client, command, timeout)) ? 0 : 1;
+						return 1UL;
+					});
+				}));
+			}
+		} else if (options.workload == "batch") {
+			std::vector<BatchRequest> requests(options.batch, BatchRequest { id_client, REQ_COMMAND, command });
+			threads.push_back(std::thread([&run, server, requests, timeout] {
+				runOperations(&run, [server, &requests, timeout](unsigned long* errors) {
+					for (const ResponsePacket& response : server->sendBatch(requests, timeout)) {
+						*errors += isSuccess(response) ? 0 : 1;
+					}
+					return (unsigned long) requests.size();
+				});
+			}));
+		}
+	}
+	if (ready && options.workload == "fanout") {
+		std::vector<BatchRequest> requests;
+		for (int id_client : ids) {
+			requests.push_back(BatchRequest { id_client, REQ_COMMAND, command });
+		}
+		threads.push_back(std::thread([&run, server, requests, timeout] {
+			runOperations(&run, [server, &requests, timeout](unsigned long* errors) {
+				for (const ResponsePacket& response : server->sendBatch(requests, timeout)) {
+					*errors += isSuccess(response) ? 0 : 1;
+				}
+				return (unsigned long) requests.size();
+			});
+		}));
+	}
+
+	nlohmann::json jresult;
+	if (ready) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(options.warmup));
+		unsigned long long cpu_start = processCpuTime();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		run.measuring = true;
+		std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+		run.measuring = false;
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		unsigned long long cpu = processCpuTime() - cpu_start;
+		unsigned long long requests = run.requests.load();
+
+		jresult["workload"] = options.workload;
+		jresult["clients"] = options.clients;
+		jresult["threads"] = threads.size();
+		jresult["depth"] = options.workload == "pipeline" ? options.depth : 1;
+		jresult["batch"] = options.workload == "batch" ? options.batch : options.workload == "fanout" ? options.clients : 1;
+		jresult["size"] = options.size;
+		jresult["events"] = options.events;
+		jresult["duration_s"] = elapsed;
+		jresult["operations"] = run.operations.load();
+		jresult["requests"] = requests;
+		jresult["errors"] = run.errors.load();
+		jresult["throughput_rps"] = requests / elapsed;
+		jresult["latency_us"] = {
+			{ "mean", run.latency.getMean() / 1000.0 },
+			{ "p50", microseconds(run.latency.getPercentile(50)) },
+			{ "p99", microseconds(run.latency.getPercentile(99)) },
+			{ "p999", microseconds(run.latency.getPercentile(99.9)) },
+			{ "max", microseconds(run.latency.getMax()) }
+		};
+		jresult["cpu_us"] = cpu;
+		jresult["cpu_us_per_request"] = requests > 0 ? (double) cpu / requests : 0.0;
+		jresult["cpu_utilization"] = cpu / (elapsed * 1000000.0);
+		if (options.timing) {
+			jresult["stages"] = nlohmann::json::parse(server->getStageTimings().response, nullptr, false);
+		}
+	}
+
+	run.stop = true;
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	for (ClientHandle client : clients) {
+		ClientResultDLL result;
+		library.releaseResult(library.disconnectClientResult(client, result));
+		library.disposeClientAPI(client);
+	}
+	server->stopServer();
+	delete server;
+
+	if (!ready) {
+		return 1;
+	}
+	std::printf("%s\n", jresult.dump().c_str());
+	return 0;
+}
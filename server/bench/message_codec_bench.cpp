@@ -0,0 +1,101 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+/**
+ * Microbenchmark of the fixed-schema request encoder and response decoder of server/message_codec.hpp against the
+ * nlohmann path they replace. It is not part of the server's build, compile it from the server's directory with:
+ *   g++ -std=c++11 -O2 -Iinclude -Ilibraries bench/message_codec_bench.cpp src/server/message_codec.cpp
+ * Usage: message_codec_bench [iterations]
+ */
+
+#include "server/message_codec.hpp"
+#include "constants/response_packet.hpp"
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+template<typename F>
+double nanosecondsPerCall(unsigned long int iterations, F f) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned long int i = 0; i < iterations; i++) {
+		f();
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+std::string randomHex(unsigned long int bytes) {
+	static const char HEX_DIGITS[] = "0123456789ABCDEF";
+	std::string hex;
+	for (unsigned long int i = 0; i < bytes; i++) {
+		hex.push_back(HEX_DIGITS[std::rand() & 0x0F]);
+		hex.push_back(HEX_DIGITS[std::rand() & 0x0F]);
+	}
+	return hex;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	using namespace server;
+	unsigned long int iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+	volatile unsigned long int sink = 0; // keeps the conversions from being optimized out
+
+	std::printf("%-8s %14s %14s %14s %14s %10s\n", "bytes", "encode json", "encode", "decode json", "decode", "identical");
+	const unsigned long int sizes[] = { 5, 16, 261, 1024, 65536 };
+	for (unsigned long int size : sizes) {
+		std::string data = randomHex(size);
+		ResponsePacket sent = { .response = randomHex(size) + "9000" };
+		nlohmann::json jsent = sent;
+		jsent["id"] = 123456UL;
+		std::string response = jsent.dump();
+		unsigned long int count = std::max(1UL, iterations * 16 / size);
+
+		std::string json_text;
+		double encode_json = nanosecondsPerCall(count, [&] {
+			nlohmann::json j;
+			j["id"] = 123456UL;
+			j["request"] = 4;
+			j["data"] = data;
+			j["timeout"] = 30000;
+			json_text = j.dump();
+			sink += json_text.size();
+		});
+		std::string text;
+		double encode = nanosecondsPerCall(count, [&] {
+			encodeRequest(123456UL, 4, data, 30000, -1, false, &text);
+			sink += text.size();
+		});
+		double decode_json = nanosecondsPerCall(count, [&] {
+			nlohmann::json jresponse = nlohmann::json::parse(response.c_str());
+			ResponsePacket response_packet = jresponse.get<ResponsePacket>();
+			sink += jresponse.value("id", 0UL) + response_packet.response.size();
+		});
+		ResponsePacket response_packet;
+		double decode = nanosecondsPerCall(count, [&] {
+			unsigned long id;
+			sink += decodeResponse(response.c_str(), &response_packet, &id) ? id + response_packet.response.size() : 0;
+		});
+		std::printf("%-8lu %11.1f ns %11.1f ns %11.1f ns %11.1f ns %10s\n", size, encode_json, encode, decode_json, decode, text == json_text ? "yes" : "NO");
+	}
+	return sink == 0;
+}
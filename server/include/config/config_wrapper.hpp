@@ -18,8 +18,11 @@
 #ifndef SRC_CONFIG_WRAPPER_HPP_
 #define SRC_CONFIG_WRAPPER_HPP_
 
+#include "config/server_config.hpp"
 #include "nlohmann/json.hpp"
 
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace server {
@@ -58,9 +61,27 @@ public:
 	 * @return the retrieved value or the given default value.
 	 */
 	std::string getValue(std::string key, std::string default_value);
+
+	/**
+	 * getConfig - retrieve the typed configuration values.
+	 * The returned snapshot stays valid and unchanged even if the configuration is reloaded meanwhile.
+	 * @return the current configuration.
+	 */
+	std::shared_ptr<const ServerConfig> getConfig();
+
+	/**
+	 * reload - read the configuration again and publish it, in-flight requests keep the configuration they started with.
+	 * The current configuration is kept if the new one cannot be read.
+	 * @param source the configuration file or a string containing the json configuration, empty to read the file given to init again.
+	 * @return true if the configuration has been reloaded.
+	 */
+	bool reload(std::string source);
 private:
-	ConfigWrapper() {}
-	nlohmann::json config_;
+	ConfigWrapper() : server_config_(std::make_shared<const ServerConfig>()) {}
+	void publish(nlohmann::json config);
+	std::shared_ptr<const ServerConfig> server_config_; // swapped atomically, never modified once published
+	std::string path_;
+	std::mutex reload_mutex_;
 public:
 	ConfigWrapper(ConfigWrapper const&) = delete;
 	void operator=(ConfigWrapper const&) = delete;
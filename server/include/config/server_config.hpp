@@ -0,0 +1,43 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_SERVER_CONFIG_HPP_
+#define SRC_SERVER_CONFIG_HPP_
+
+#include "nlohmann/json.hpp"
+
+#include <windows.h>
+
+#include <cstddef>
+
+namespace server {
+
+/**
+ * ServerConfig - configuration values used while serving requests, parsed once from the configuration file.
+ * A published ServerConfig is never modified: a reload publishes a new one, the json and its typed values together.
+ */
+struct ServerConfig {
+	nlohmann::json values = nlohmann::json::object(); // the whole configuration, read by ConfigWrapper::getValue
+	DWORD timeout = 0; // socket timeout in milliseconds
+	std::size_t event_queue_size = 0;
+	bool debug_log = false;
+	bool request_timing = false; // clients asked for the instants of each request's stages, see constants/request_timing.hpp
+};
+
+} /* namespace server */
+
+#endif /* SRC_SERVER_CONFIG_HPP_ */
@@ -0,0 +1,172 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+#ifndef SRC_APDU_HPP_
+#define SRC_APDU_HPP_
+
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#define APDU_INLINE_CAPACITY 261 // short APDU: header, Lc, 255 bytes of data and Le
+
+namespace server {
+
+/**
+ * Apdu - command sent to a client's terminal, same layout as the client's Apdu.
+ * Short APDUs are stored inline so that no allocation is made per command, extended length APDUs fall back to the heap.
+ */
+class Apdu {
+private:
+	unsigned char inline_[APDU_INLINE_CAPACITY];
+	std::vector<unsigned char> extended_; // used when the APDU does not fit inline
+	unsigned long int length_ = 0;
+public:
+	Apdu() = default;
+
+	Apdu(const unsigned char* bytes, unsigned long int length) {
+		assign(bytes, length);
+	}
+
+	Apdu(std::initializer_list<unsigned char> bytes) {
+		assign(bytes.begin(), bytes.size());
+	}
+
+	Apdu(const Apdu& other) {
+		assign(other.data(), other.size());
+	}
+
+	Apdu& operator=(const Apdu& other) {
+		if (this != &other) {
+			assign(other.data(), other.size());
+		}
+		return *this;
+	}
+
+	/**
+	 * assign - replace the content of the APDU.
+	 * @param bytes the APDU's bytes.
+	 * @param length the number of bytes.
+	 */
+	void assign(const unsigned char* bytes, unsigned long int length) {
+		if (length > APDU_INLINE_CAPACITY) {
+			extended_.assign(bytes, bytes + length);
+		} else {
+			extended_.clear();
+			if (length > 0) {
+				memcpy(inline_, bytes, length);
+			}
+		}
+		length_ = length;
+	}
+
+	/**
+	 * toHex - return the APDU as the hexadecimal string sent to the client ("00A40400").
+	 * @return the hexadecimal string.
+	 */
+	std::string toHex() const {
+		static const char digits[] = "0123456789ABCDEF";
+		std::string hex(2 * length_, '0');
+		const unsigned char* bytes = data();
+		for (unsigned long int i = 0; i < length_; i++) {
+			hex[2 * i] = digits[bytes[i] >> 4];
+			hex[2 * i + 1] = digits[bytes[i] & 0x0F];
+		}
+		return hex;
+	}
+
+	const unsigned char* data() const {
+		return length_ > APDU_INLINE_CAPACITY ? extended_.data() : inline_;
+	}
+
+	unsigned long int size() const {
+		return length_;
+	}
+
+	bool empty() const {
+		return length_ == 0;
+	}
+
+	unsigned char operator[](unsigned long int i) const {
+		return data()[i];
+	}
+
+	/**
+	 * isExtended - check whether the APDU uses the extended length encoding (ISO 7816-4 cases 2E, 3E and 4E).
+	 */
+	bool isExtended() const {
+		return length_ >= 7 && data()[4] == 0x00;
+	}
+
+	unsigned char cla() const {
+		return length_ > 0 ? data()[0] : 0x00;
+	}
+
+	unsigned char ins() const {
+		return length_ > 1 ? data()[1] : 0x00;
+	}
+
+	unsigned char p1() const {
+		return length_ > 2 ? data()[2] : 0x00;
+	}
+
+	unsigned char p2() const {
+		return length_ > 3 ? data()[3] : 0x00;
+	}
+
+	/**
+	 * lc - return the length of the command data.
+	 * @return 0 if the APDU has no command data or is malformed.
+	 */
+	unsigned long int lc() const {
+		if (length_ <= 5) {
+			return 0;
+		}
+		const unsigned char* bytes = data();
+		if (!isExtended()) {
+			return length_ == 5u + bytes[4] || length_ == 6u + bytes[4] ? bytes[4] : 0;
+		}
+		unsigned long int lc = (bytes[5] << 8) | bytes[6];
+		return length_ == 7 + lc || length_ == 9 + lc ? lc : 0;
+	}
+
+	/**
+	 * le - return the maximum length of the response data, Le = 00 meaning 256 (65536 for extended length).
+	 * @return 0 if the APDU has no Le field or is malformed.
+	 */
+	unsigned long int le() const {
+		if (length_ <= 4) {
+			return 0;
+		}
+		const unsigned char* bytes = data();
+		if (!isExtended()) {
+			if (length_ != 5 && length_ != 6u + bytes[4]) {
+				return 0;
+			}
+			return bytes[length_ - 1] == 0x00 ? 256 : bytes[length_ - 1];
+		}
+		if (length_ != 7 && length_ != 9u + ((bytes[5] << 8) | bytes[6])) {
+			return 0;
+		}
+		unsigned long int le = (bytes[length_ - 2] << 8) | bytes[length_ - 1];
+		return le == 0 ? 65536 : le;
+	}
+};
+
+} /* namespace server */
+
+#endif /* SRC_APDU_HPP_ */
@@ -0,0 +1,40 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_BATCH_REQUEST_HPP_
+#define SRC_BATCH_REQUEST_HPP_
+
+#include "constants/request_code.hpp"
+
+#include <string>
+
+namespace server {
+
+/**
+ * BatchRequest - a request of a batch sent with ServerAPI::sendBatch.
+ * The data is the one expected by the matching ServerAPI function: the command as a hexadecimal string,
+ * the script's text for REQ_SCRIPT_LOAD or Handle|Parameters for REQ_SCRIPT_RUN.
+ */
+struct BatchRequest {
+	int id_client;
+	RequestCode request;
+	std::string data;
+};
+
+} /* namespace server */
+
+#endif /* SRC_BATCH_REQUEST_HPP_ */
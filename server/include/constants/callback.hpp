@@ -21,6 +21,7 @@
 namespace server {
 
 typedef void (__stdcall *Callback)(int id_client, const char* name_client);
+typedef void (__stdcall *EventCallback)(int id_client, int event, const char* reader, const char* data);
 
 } /* namespace server */
 
@@ -26,10 +26,18 @@ namespace server {
 #define DEFAULT_BUFLEN 1024 * 64
 #define DEFAULT_SOCKET_TIMEOUT "5500" // timer for socket operations recv/send in milliseconds
 #define DEFAULT_ADDED_TIME 500
+#define DEFAULT_RESUME_TOKEN_SIZE 16 // random bytes in the token given to clients supporting session resumption
+
+/* events */
+#define DEFAULT_EVENT_QUEUE_SIZE "1000" // events kept until they are polled, the oldest ones are dropped beyond
+
+/* batches */
+#define DEFAULT_BATCH_WORKERS 16 // clients served in parallel by a batch of requests
 
 /* DLL Buffer Size */
 #define DEFAULT_DLL_BUFFER_SIZE 2*1024
 #define DEFAULT_DLL_BUFFER_SIZE_EXTENDED 2*4096
+#define DEFAULT_DLL_RESULT_POOL_SIZE 64 // released results kept for reuse by the handle-based functions
 
 /* logs */
 #define DEFAULT_LOG_LEVEL "info" // debug level - info or debug (more verbose)
@@ -37,6 +45,25 @@ namespace server {
 #define DEFAULT_LOG_FILENAME "basics.csv"
 #define DEFAULT_LOG_MAX_SIZE "1000000" // maximum bytes for each log file
 #define DEFAULT_LOG_MAX_FILES "10" // log files number for the rolling
+#define DEFAULT_LOG_ASYNC "true" // records written by a background thread instead of the logging threads
+#define DEFAULT_LOG_BUFFER_SIZE "1024" // records waiting to be written for each logging thread, the next ones are dropped
+#define DEFAULT_LOG_FLUSH_INTERVAL 20 // milliseconds between two writes of the waiting records
+
+/* flight recorder */
+#define DEFAULT_RECORDER_SIZE 65536 // records kept in memory, must be a power of two
+#define DEFAULT_RECORDER_FILE "./logs/flight_recorder.bin" // written when a request fails on a timeout or a network error
+#define DEFAULT_RECORDER_DUMP_ON_ERROR "true"
+#define DEFAULT_RECORDER_DUMP_INTERVAL 60 // minimum seconds between two dumps on error
+
+/* request timing */
+#define DEFAULT_REQUEST_TIMING "false" // clients send the instants of each request's stages, aggregated by stage
+
+/* metrics */
+#define DEFAULT_METRICS_PORT "" // port of the Prometheus endpoint, empty to disable it
+#define DEFAULT_METRICS_IP "127.0.0.1" // keeps the metrics local unless another address is configured
+#define DEFAULT_METRICS_TIMEOUT 2000 // waiting time in ms for the request of a metrics scraper
+#define DEFAULT_CONTENTION_STATS "false" // wait and hold times of the locks, CPU time of the threads, read at initialization
+#define DEFAULT_CONTENTION_REPORT_INTERVAL "60" // seconds between two summaries in the logs, 0 for none
 
 /* timeouts */
 #define DEFAULT_REQUEST_TIMEOUT 5500 // waiting time used client's side for the terminal response
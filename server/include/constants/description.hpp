@@ -0,0 +1,205 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_DESCRIPTION_HPP_
+#define SRC_DESCRIPTION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace server {
+
+/**
+ * INTERNED_DESCRIPTIONS - descriptions sent by their index in compact responses instead of their text.
+ * The index is part of the protocol and shared with the client: descriptions must only be appended.
+ */
+static constexpr const char* INTERNED_DESCRIPTIONS[] = {
+	"OK",
+	"Client must be initialized correctly",
+	"Error while parsing the request",
+	"Failed to connect: check the server",
+	"Failed to connect: client is already connected",
+	"Failed to connect: client must be initialized correctly",
+	"Failed to connect: failed to perform handshake",
+	"Failed to connect: initialization failed",
+	"Failed to connect: no reader available",
+	"Failed to disconnect: not connected yet",
+	"Failed to establish the monitoring context",
+	"Failed to initialize the client: terminal not found",
+	"Invalid hexadecimal data",
+	"Malformed script parameters",
+	"Network error on send response",
+	"Request cancelled before execution",
+	"Request deadline exceeded before execution",
+	"Response time from terminal has elapsed",
+	"Terminal executor is not running",
+	"The reader is not connected",
+	"The request doesn't exist",
+	"Unknown script handle"
+};
+
+static constexpr int INTERNED_DESCRIPTIONS_COUNT = sizeof(INTERNED_DESCRIPTIONS) / sizeof(INTERNED_DESCRIPTIONS[0]);
+static_assert(INTERNED_DESCRIPTIONS_COUNT <= 64, "interned descriptions are selected with a 64 bits mask");
+
+/**
+ * internedDescriptionsOfLength - select at compile time the interned descriptions of the given length.
+ * @param length the description's length.
+ * @return a mask whose bit i is set if INTERNED_DESCRIPTIONS[i] has the given length.
+ */
+constexpr std::uint64_t internedDescriptionsOfLength(std::size_t length) {
+	std::uint64_t mask = 0;
+	for (int id = 0; id < INTERNED_DESCRIPTIONS_COUNT; id++) {
+		std::size_t interned_length = 0;
+		while (INTERNED_DESCRIPTIONS[id][interned_length] != '\0') {
+			interned_length++;
+		}
+		if (interned_length == length) {
+			mask |= std::uint64_t(1) << id;
+		}
+	}
+	return mask;
+}
+
+/**
+ * findInternedDescription - retrieve the index of the given description in INTERNED_DESCRIPTIONS.
+ * @param text the description to look for.
+ * @param length the description's length.
+ * @return the description's index, -1 if the description is not interned.
+ */
+inline int findInternedDescription(const char* text, std::size_t length) {
+	for (int id = 0; id < INTERNED_DESCRIPTIONS_COUNT; id++) {
+		const char* interned = INTERNED_DESCRIPTIONS[id];
+		if (interned == text || (std::strncmp(interned, text, length) == 0 && interned[length] == '\0')) {
+			return id;
+		}
+	}
+	return -1;
+}
+
+class Description;
+inline Description internedDescription(int id);
+
+/**
+ * Description - error description of a ResponsePacket.
+ * The texts of INTERNED_DESCRIPTIONS, among them the default "OK", are referenced without being copied. Other descriptions
+ * are built once and shared between the copies of the ResponsePacket, so that copying a ResponsePacket never copies its descriptions.
+ */
+class Description {
+private:
+	const char* text_;
+	std::size_t length_;
+	std::shared_ptr<const std::string> owned_;
+
+	struct Interned {};
+
+	Description(Interned, const char* text) : text_(text), length_(std::strlen(text)) {}
+
+	friend Description internedDescription(int id);
+public:
+	Description() : text_("OK"), length_(2) {}
+
+	/**
+	 * Description - build a description from a character array, referenced only when it is an interned description.
+	 * Any other array may be a buffer filled at runtime or a local array, so its text is copied.
+	 * Only the interned descriptions of the array's length, selected at compile time, are compared.
+	 */
+	template<std::size_t N>
+	Description(const char (&text)[N]) {
+		constexpr std::uint64_t candidates = internedDescriptionsOfLength(N - 1);
+		int id = -1;
+		for (int candidate = 0; candidate < INTERNED_DESCRIPTIONS_COUNT && (candidates >> candidate) != 0; candidate++) {
+			if (((candidates >> candidate) & 1) && std::memcmp(INTERNED_DESCRIPTIONS[candidate], text, N) == 0) {
+				id = candidate;
+				break;
+			}
+		}
+		std::size_t length = std::strlen(text);
+		if (id >= 0) {
+			text_ = INTERNED_DESCRIPTIONS[id];
+			length_ = length;
+		} else {
+			owned_ = std::make_shared<const std::string>(text, length);
+			text_ = owned_->c_str();
+			length_ = length;
+		}
+	}
+
+	Description(std::string text) : owned_(std::make_shared<const std::string>(std::move(text))) {
+		text_ = owned_->c_str();
+		length_ = owned_->size();
+	}
+
+	const char* c_str() const {
+		return text_;
+	}
+
+	std::size_t size() const {
+		return length_;
+	}
+
+	bool empty() const {
+		return length_ == 0;
+	}
+
+	std::string str() const {
+		return std::string(text_, length_);
+	}
+
+	operator std::string() const {
+		return str();
+	}
+
+	/**
+	 * isDefault - check whether the description is the default "OK" description.
+	 * @return true if the description is "OK".
+	 */
+	bool isDefault() const {
+		return length_ == 2 && text_[0] == 'O' && text_[1] == 'K';
+	}
+
+	bool operator==(const Description& other) const {
+		return length_ == other.length_ && (text_ == other.text_ || std::memcmp(text_, other.text_, length_) == 0);
+	}
+
+	bool operator!=(const Description& other) const {
+		return !(*this == other);
+	}
+
+	friend std::ostream& operator<<(std::ostream& out, const Description& description) {
+		return out.write(description.text_, description.length_);
+	}
+};
+
+/**
+ * internedDescription - retrieve the description of the given index in INTERNED_DESCRIPTIONS.
+ * @param id the description's index.
+ * @return the interned description, a generic description if the index is unknown.
+ */
+inline Description internedDescription(int id) {
+	if (id < 0 || id >= INTERNED_DESCRIPTIONS_COUNT) {
+		return Description("Unknown description " + std::to_string(id));
+	}
+	return Description(Description::Interned(), INTERNED_DESCRIPTIONS[id]);
+}
+
+} // Namespace server
+
+#endif /* SRC_DESCRIPTION_HPP_ */
@@ -0,0 +1,74 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_EVENT_TYPE_HPP_
+#define SRC_EVENT_TYPE_HPP_
+
+#include <string>
+
+namespace server {
+
+/**
+ * EventType - unsolicited events sent by the client when the state of a reader or of the client changes.
+ * Events are sent this way: {"event":EventType,"reader":ReaderName,"data":Data[,"channel":Channel]}
+ */
+enum EventType {
+	EVT_CARD_INSERTED = 0, // data: the card's ATR
+	EVT_CARD_REMOVED,
+	EVT_READER_ADDED,
+	EVT_READER_REMOVED,
+	EVT_READER_ERROR, // data: the error's description
+	EVT_LOAD // data: the number of requests waiting for the terminals
+};
+
+/**
+ * ClientEvent - an event received from a client, kept until it is polled.
+ */
+struct ClientEvent {
+	int id_client = 0;
+	EventType event = EVT_CARD_INSERTED;
+	std::string reader;
+	std::string data;
+};
+
+/**
+ * eventTypeToString - convert an enum value to the matching string description.
+ * @param e the event type to be converted.
+ * @return the matching string description.
+ */
+inline const std::string eventTypeToString(EventType e) {
+	switch (e) {
+	case EVT_CARD_INSERTED:
+		return "EVT_CARD_INSERTED";
+	case EVT_CARD_REMOVED:
+		return "EVT_CARD_REMOVED";
+	case EVT_READER_ADDED:
+		return "EVT_READER_ADDED";
+	case EVT_READER_REMOVED:
+		return "EVT_READER_REMOVED";
+	case EVT_READER_ERROR:
+		return "EVT_READER_ERROR";
+	case EVT_LOAD:
+		return "EVT_LOAD";
+	default:
+		return "[Unknown Event Type]";
+	}
+}
+
+} /* namespace server */
+
+#endif /* SRC_EVENT_TYPE_HPP_ */
@@ -36,7 +36,10 @@ enum RequestCode {
 	REQ_COLD_RESET,
 	REQ_WARM_RESET,
 	REQ_POWER_OFF_FIELD,
-	REQ_POWER_ON_FIELD
+	REQ_POWER_ON_FIELD,
+	REQ_SCRIPT_LOAD,
+	REQ_SCRIPT_RUN,
+	REQ_COUNT // number of request codes, not a request
 };
 
 /**
@@ -60,6 +63,24 @@ inline const std::string requestCodeToString(RequestCode r) {
 		return "REQ_RESTART";
 	case REQ_COMMAND:
 		return "REQ_COMMAND";
+	case REQ_COMMAND_A:
+		return "REQ_COMMAND_A";
+	case REQ_COMMAND_B:
+		return "REQ_COMMAND_B";
+	case REQ_COMMAND_F:
+		return "REQ_COMMAND_F";
+	case REQ_COLD_RESET:
+		return "REQ_COLD_RESET";
+	case REQ_WARM_RESET:
+		return "REQ_WARM_RESET";
+	case REQ_POWER_OFF_FIELD:
+		return "REQ_POWER_OFF_FIELD";
+	case REQ_POWER_ON_FIELD:
+		return "REQ_POWER_ON_FIELD";
+	case REQ_SCRIPT_LOAD:
+		return "REQ_SCRIPT_LOAD";
+	case REQ_SCRIPT_RUN:
+		return "REQ_SCRIPT_RUN";
 	default:
 		return "[Unknown Request Code]";
 	}
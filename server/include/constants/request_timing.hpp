@@ -0,0 +1,121 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef CONSTANTS_REQUEST_TIMING_HPP_
+#define CONSTANTS_REQUEST_TIMING_HPP_
+
+#include <chrono>
+
+namespace server {
+
+#define TIMING_NOT_STAMPED -1
+
+/**
+ * TimingStage - the stages of a request, measured from the instants of its RequestTiming.
+ */
+enum TimingStage {
+	TIMING_SERVER_QUEUE = 0, // from the submission of the request to its sending
+	TIMING_NETWORK, // round trip on the network, the time spent by the client excluded
+	TIMING_CLIENT_QUEUE, // from the reception of the request by the client to the start of the terminal: decoding and waiting for the terminal
+	TIMING_TERMINAL, // the terminal's work, SCardTransmit for the PC/SC terminals
+	TIMING_CLIENT_REPLY, // from the end of the terminal's work to the sending of the response by the client
+	TIMING_SERVER_RECEIVE, // from the reception of the response to the return of the request: decoding and waking the caller
+	TIMING_TOTAL, // from the submission of the request to its return
+	TIMING_STAGE_COUNT
+};
+
+/**
+ * RequestTiming - the instants at which a request went through each stage, in microseconds.
+ * The server's instants are read from its steady clock. The client's instants are relative to the reception of the request
+ * by the client, as the clocks of the client and of the server are not related. The client only sends its instants when
+ * the server enables "request_timing". The stages a request did not go through are TIMING_NOT_STAMPED.
+ */
+struct RequestTiming {
+	long long server_submit = TIMING_NOT_STAMPED;
+	long long server_send = TIMING_NOT_STAMPED;
+	long long server_receive = TIMING_NOT_STAMPED;
+	long long server_end = TIMING_NOT_STAMPED;
+
+	long long terminal_start = TIMING_NOT_STAMPED;
+	long long terminal_end = TIMING_NOT_STAMPED;
+	long long client_send = TIMING_NOT_STAMPED;
+};
+
+/**
+ * timingNow - return the current instant of the steady clock in microseconds.
+ */
+inline long long timingNow() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline long long timingElapsed(long long from, long long to) {
+	return (from == TIMING_NOT_STAMPED || to == TIMING_NOT_STAMPED) ? TIMING_NOT_STAMPED : to - from;
+}
+
+/**
+ * timingStageDuration - return the duration of a stage of a request.
+ * @param timing the instants of the request.
+ * @param stage the TimingStage.
+ * @return the duration in microseconds, TIMING_NOT_STAMPED if the request did not go through the stage.
+ */
+inline long long timingStageDuration(const RequestTiming& timing, int stage) {
+	switch (stage) {
+	case TIMING_SERVER_QUEUE:
+		return timingElapsed(timing.server_submit, timing.server_send);
+	case TIMING_NETWORK: {
+		long long round_trip = timingElapsed(timing.server_send, timing.server_receive);
+		return (round_trip == TIMING_NOT_STAMPED || timing.client_send == TIMING_NOT_STAMPED) ? TIMING_NOT_STAMPED : round_trip - timing.client_send;
+	}
+	case TIMING_CLIENT_QUEUE:
+		return timing.terminal_start;
+	case TIMING_TERMINAL:
+		return timingElapsed(timing.terminal_start, timing.terminal_end);
+	case TIMING_CLIENT_REPLY:
+		return timingElapsed(timing.terminal_end, timing.client_send);
+	case TIMING_SERVER_RECEIVE:
+		return timingElapsed(timing.server_receive, timing.server_end);
+	case TIMING_TOTAL:
+		return timingElapsed(timing.server_submit, timing.server_end);
+	default:
+		return TIMING_NOT_STAMPED;
+	}
+}
+
+inline const char* timingStageToString(int stage) {
+	switch (stage) {
+	case TIMING_SERVER_QUEUE:
+		return "server_queue";
+	case TIMING_NETWORK:
+		return "network";
+	case TIMING_CLIENT_QUEUE:
+		return "client_queue";
+	case TIMING_TERMINAL:
+		return "terminal";
+	case TIMING_CLIENT_REPLY:
+		return "client_reply";
+	case TIMING_SERVER_RECEIVE:
+		return "server_receive";
+	case TIMING_TOTAL:
+		return "total";
+	default:
+		return "unknown";
+	}
+}
+
+} /* namespace server */
+
+#endif /* CONSTANTS_REQUEST_TIMING_HPP_ */
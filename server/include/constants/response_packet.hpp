@@ -18,6 +18,8 @@
 #ifndef SRC_RESPONSE_PACKET_HPP_
 #define SRC_RESPONSE_PACKET_HPP_
 
+#include "constants/description.hpp"
+#include "constants/request_timing.hpp"
 #include "nlohmann/json.hpp"
 using nlohmann::json;
 
@@ -31,12 +33,14 @@ enum ErrorCode {
 	ERR_NETWORK = -2,
 	ERR_CLIENT_CLOSED = -3,
 	ERR_INVALID_STATE = -4,
-	ERR_JSON_PARSING = -5
+	ERR_JSON_PARSING = -5,
+	ERR_SCRIPT = -8 // same value as on the client's side
 };
 
 /**
  * ResponsePacket struct used as a response of all function calls.
  * By default all error field are set to "SUCCESS" and description to "OK".
+ * The descriptions are Description values, so that a ResponsePacket without error copies no description.
  * In case of error, the responsible layer must set the adequate error code and a description.
  * The response field is only valid if there is no negative error code.
  */
@@ -44,18 +48,45 @@ struct ResponsePacket {
 	std::string response = "OK";
 
 	long int err_server_code = SUCCESS;
-	std::string err_server_description = "OK";
+	Description err_server_description;
 
 	long int err_client_code = SUCCESS;
-	std::string err_client_description = "OK";
+	Description err_client_description;
 
 	long int err_terminal_code = SUCCESS;
-	std::string err_terminal_description = "OK";
+	Description err_terminal_description;
 
 	long int err_card_code = SUCCESS;
-	std::string err_card_description = "OK";
+	Description err_card_description;
+
+	std::string transcript = ""; // intermediate exchanges performed locally by the client, only serialized when not empty
+
+	RequestTiming timing; // instants of the request's stages, see constants/request_timing.hpp
 };
 
+/**
+ * firstErrorCode - return the error code of the first layer in error.
+ * @param response_packet the result to inspect.
+ * @return the first error code under 0, or 0.
+ */
+inline long firstErrorCode(const ResponsePacket& response_packet) {
+	if (response_packet.err_server_code < 0) return response_packet.err_server_code;
+	if (response_packet.err_client_code < 0) return response_packet.err_client_code;
+	if (response_packet.err_terminal_code < 0) return response_packet.err_terminal_code;
+	if (response_packet.err_card_code < 0) return response_packet.err_card_code;
+	return 0;
+}
+
+// https://github.com/nlohmann/json#arbitrary-types-conversions
+// Used to serialize the descriptions as plain strings.
+inline void to_json(nlohmann::json& j, const Description& e) {
+	j = e.str();
+}
+
+inline void from_json(const nlohmann::json& j, Description& e) {
+	e = Description(j.get<std::string>());
+}
+
 // https://github.com/nlohmann/json#arbitrary-types-conversions
 // Used to serialize the ResponsePacket struct in JSON format.
 inline void to_json(nlohmann::json& j, const ResponsePacket& e) {
@@ -66,20 +97,51 @@ inline void to_json(nlohmann::json& j, const ResponsePacket& e) {
 		{ "err_terminal_code", e.err_terminal_code }, { "terminal_description", e.err_terminal_description },
 		{ "err_card_code", e.err_card_code }, { "err_card_description", e.err_card_description }
 	};
+	if (!e.transcript.empty()) {
+		j["transcript"] = e.transcript;
+	}
+}
+
+/**
+ * readDescription - read a description sent either as a text or, in compact responses, as the index of an interned description.
+ * The description keeps its value if the json contains neither.
+ */
+inline void readDescription(const nlohmann::json& j, const char* key, const char* id_key, Description* description) {
+	auto it = j.find(key);
+	if (it != j.end()) {
+		it->get_to(*description);
+	} else if ((it = j.find(id_key)) != j.end()) {
+		*description = internedDescription(it->get<int>());
+	}
+}
+
+/**
+ * readTiming - read the client's instants sent as [terminal_start, terminal_end, client_send] when the server enables "request_timing".
+ */
+inline void readTiming(const nlohmann::json& j, RequestTiming* timing) {
+	auto it = j.find("timing");
+	if (it != j.end() && it->is_array() && it->size() == 3) {
+		timing->terminal_start = (*it)[0].get<long long>();
+		timing->terminal_end = (*it)[1].get<long long>();
+		timing->client_send = (*it)[2].get<long long>();
+	}
 }
 
 // https://github.com/nlohmann/json#arbitrary-types-conversions
-// Used to convert the json.
+// Used to convert the json. Compact responses omit the fields holding their default value.
 inline void from_json(const nlohmann::json& j, ResponsePacket& e) {
-	j.at("response").get_to(e.response);
-	j.at("err_server_code").get_to(e.err_server_code);
-	j.at("err_server_description").get_to(e.err_server_description);
-	j.at("err_client_code").get_to(e.err_client_code);
-	j.at("client_description").get_to(e.err_client_description);
-	j.at("err_terminal_code").get_to(e.err_terminal_code);
-	j.at("terminal_description").get_to(e.err_terminal_description);
-	j.at("err_card_code").get_to(e.err_card_code);
-	j.at("err_card_description").get_to(e.err_card_description);
+	e = ResponsePacket();
+	e.response = j.value("response", e.response);
+	e.err_server_code = j.value("err_server_code", e.err_server_code);
+	readDescription(j, "err_server_description", "err_server_description_id", &e.err_server_description);
+	e.err_client_code = j.value("err_client_code", e.err_client_code);
+	readDescription(j, "client_description", "client_description_id", &e.err_client_description);
+	e.err_terminal_code = j.value("err_terminal_code", e.err_terminal_code);
+	readDescription(j, "terminal_description", "terminal_description_id", &e.err_terminal_description);
+	e.err_card_code = j.value("err_card_code", e.err_card_code);
+	readDescription(j, "err_card_description", "err_card_description_id", &e.err_card_description);
+	e.transcript = j.value("transcript", e.transcript);
+	readTiming(j, &e.timing);
 }
 
 } // namespace server
@@ -0,0 +1,52 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_SCRIPT_OPCODE_HPP_
+#define SRC_SCRIPT_OPCODE_HPP_
+
+namespace server {
+
+/**
+ * Compiled APDU script format, shared by the server compiling the scripts and the client executing them.
+ * A program starts with the format version, followed by instructions made of an opcode and its operands.
+ * Variables are byte strings: the script's parameters are $0..$n, EXTRACT can overwrite any of them.
+ * Jump addresses are 2-byte big-endian offsets from the start of the program.
+ */
+#define SCRIPT_FORMAT_VERSION 0x01
+#define SCRIPT_MAX_VARIABLES 16
+
+enum ScriptOpcode {
+	OP_END = 0x00, // stop the script successfully
+	OP_APPEND = 0x01, // length(1) bytes(length): append bytes to the command being built
+	OP_APPEND_VAR = 0x02, // variable(1): append a variable to the command being built
+	OP_SEND = 0x03, // send the command being built to the terminal, then start a new command
+	OP_EXPECT_SW = 0x04, // sw1(1) sw2(1) mask(1): stop the script with an error if the last status word differs
+	OP_JUMP = 0x05, // address(2)
+	OP_JUMP_IF_SW = 0x06, // sw1(1) sw2(1) mask(1) address(2): jump if the last status word matches
+	OP_JUMP_IF_NOT_SW = 0x07, // sw1(1) sw2(1) mask(1) address(2): jump if the last status word differs
+	OP_EXTRACT = 0x08, // variable(1) offset(1) length(1): copy bytes of the last response data, length 0 up to the status word
+	OP_COLD_RESET = 0x09,
+	OP_WARM_RESET = 0x0A
+};
+
+/* status word mask: bytes compared by OP_EXPECT_SW, OP_JUMP_IF_SW and OP_JUMP_IF_NOT_SW */
+#define SCRIPT_SW1_MASK 0x01
+#define SCRIPT_SW2_MASK 0x02
+
+} /* namespace server */
+
+#endif /* SRC_SCRIPT_OPCODE_HPP_ */
@@ -0,0 +1,84 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+#ifndef SRC_TERMINAL_STATE_HPP_
+#define SRC_TERMINAL_STATE_HPP_
+
+#include "nlohmann/json.hpp"
+
+#include <string>
+
+namespace server {
+
+/**
+ * CardState - state of the card as seen by the client's reader.
+ */
+enum CardState {
+	CARD_UNKNOWN = 0,
+	CARD_ABSENT,
+	CARD_PRESENT,
+	CARD_SWALLOWED,
+	CARD_POWERED,
+	CARD_NEGOTIABLE,
+	CARD_SPECIFIC
+};
+
+/**
+ * CardProtocol - protocol used by the client's reader to communicate with the card.
+ */
+enum CardProtocol {
+	PROTOCOL_UNKNOWN = 0,
+	PROTOCOL_RAW,
+	PROTOCOL_T0,
+	PROTOCOL_T1
+};
+
+/**
+ * TerminalState - structured diagnostic of a client's terminal, answered by the client without accessing the reader when possible.
+ */
+struct TerminalState {
+	std::string reader;
+	CardState card_state = CARD_UNKNOWN;
+	CardProtocol protocol = PROTOCOL_UNKNOWN;
+	std::string atr;
+	long int last_error_code = 0;
+	std::string last_error_description = "OK";
+	unsigned long int commands = 0;
+	unsigned long int errors = 0;
+	unsigned long int resets = 0;
+	unsigned long int card_insertions = 0;
+	unsigned long int card_removals = 0;
+};
+
+// https://github.com/nlohmann/json#arbitrary-types-conversions
+// Used to deserialize the TerminalState struct from JSON format.
+inline void from_json(const nlohmann::json& j, TerminalState& e) {
+	e.reader = j.at("reader").get<std::string>();
+	e.card_state = j.at("card_state").get<CardState>();
+	e.protocol = j.at("protocol").get<CardProtocol>();
+	e.atr = j.at("atr").get<std::string>();
+	e.last_error_code = j.at("last_error_code").get<long int>();
+	e.last_error_description = j.at("last_error_description").get<std::string>();
+	e.commands = j.at("commands").get<unsigned long int>();
+	e.errors = j.at("errors").get<unsigned long int>();
+	e.resets = j.at("resets").get<unsigned long int>();
+	e.card_insertions = j.at("card_insertions").get<unsigned long int>();
+	e.card_removals = j.at("card_removals").get<unsigned long int>();
+}
+
+} /* namespace server */
+
+#endif /* SRC_TERMINAL_STATE_HPP_ */
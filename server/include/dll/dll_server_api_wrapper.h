@@ -40,13 +40,68 @@ struct ResponseDLL {
 	char err_card_description[DEFAULT_DLL_BUFFER_SIZE];
 };
 
+/**
+ * ResultField - the texts of a result, read with getResultBytes, getResultText or getResultView.
+ */
+enum ResultField {
+	RESULT_RESPONSE = 0,
+	RESULT_SERVER_DESCRIPTION,
+	RESULT_CLIENT_DESCRIPTION,
+	RESULT_TERMINAL_DESCRIPTION,
+	RESULT_CARD_DESCRIPTION,
+	RESULT_FIELD_COUNT
+};
+
+/**
+ * ResultDLL - codes and text lengths of a result of the handle-based functions (the functions suffixed with "Result").
+ * The texts are not copied into the structure: they stay in the result designated by the returned handle
+ * until the result is released with releaseResult.
+ */
+struct ResultDLL {
+	long int err_server_code;
+	long int err_client_code;
+	long int err_terminal_code;
+	long int err_card_code;
+	unsigned long int lengths[RESULT_FIELD_COUNT]; // length of each ResultField's text, without the terminating null character
+};
+
+struct ResultSlot;
+typedef ResultSlot* ResultHandle;
+
+/**
+ * BatchRequestDLL - a request of a batch sent with sendBatch.
+ * The data is the one of the matching function (the command as a hexadecimal string, the script's text for REQ_SCRIPT_LOAD,
+ * Handle|Parameters for REQ_SCRIPT_RUN), NULL when the request has no data.
+ */
+struct BatchRequestDLL {
+	int id_client;
+	int request;
+	const char* data;
+};
+
+struct TerminalStateDLL {
+	char reader[DEFAULT_DLL_BUFFER_SIZE];
+	int card_state;
+	int protocol;
+	char atr[DEFAULT_DLL_BUFFER_SIZE];
+	long int last_error_code;
+	char last_error_description[DEFAULT_DLL_BUFFER_SIZE];
+	unsigned long int commands;
+	unsigned long int errors;
+	unsigned long int resets;
+	unsigned long int card_insertions;
+	unsigned long int card_removals;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 server::Callback notifyConnectionAccepted = 0;
+server::EventCallback notifyEventReceived = 0;
 
 ADDAPI void setCallbackConnectionAccepted(server::Callback handler);
+ADDAPI void setCallbackEventReceived(server::EventCallback handler);
 
 ADDAPI server::ServerAPI* createServerAPI();
 ADDAPI void disposeServerAPI(server::ServerAPI* server);
@@ -61,6 +116,7 @@ ADDAPI void restartTarget(server::ServerAPI* server, int id_client, ResponseDLL&
 ADDAPI void listClients(server::ServerAPI* server, ResponseDLL& response_packet);
 ADDAPI void echoClient(server::ServerAPI* server, int id_client, DWORD timeout, ResponseDLL& response_packet);
 ADDAPI void diagClient(server::ServerAPI* server, int id_client, DWORD timeout, ResponseDLL& response_packet);
+ADDAPI void diagClientState(server::ServerAPI* server, int id_client, DWORD timeout, TerminalStateDLL& state, ResponseDLL& response_packet);
 
 ADDAPI void sendCommand(server::ServerAPI* server, int id_client, char* command, DWORD timeout, ResponseDLL& response_packet);
 ADDAPI void sendTypeA(server::ServerAPI* server, int id_client, char* command, DWORD timeout, ResponseDLL& response_packet);
@@ -71,6 +127,103 @@ ADDAPI void coldReset(server::ServerAPI* server, int id_client, DWORD timeout, R
 ADDAPI void warmReset(server::ServerAPI* server, int id_client, DWORD timeout, ResponseDLL& response_packet);
 ADDAPI void powerOFFField(server::ServerAPI* server, int id_client, DWORD timeout, ResponseDLL& response_packet);
 ADDAPI void powerONField(server::ServerAPI* server, int id_client, ResponseDLL& response_packet);
+ADDAPI void loadScript(server::ServerAPI* server, int id_client, char* script, DWORD timeout, ResponseDLL& response_packet);
+ADDAPI void runScript(server::ServerAPI* server, int id_client, int handle, char* parameters, DWORD timeout, ResponseDLL& response_packet);
+ADDAPI void pollEvent(server::ServerAPI* server, DWORD timeout, ResponseDLL& response_packet);
+ADDAPI void reloadConfig(server::ServerAPI* server, const char* jsonConfig, ResponseDLL& response_packet);
+ADDAPI void dumpFlightRecorder(server::ServerAPI* server, const char* path, ResponseDLL& response_packet);
+ADDAPI void getStageTimings(server::ServerAPI* server, ResponseDLL& response_packet);
+ADDAPI void getStats(server::ServerAPI* server, ResponseDLL& response_packet);
+
+/*
+ * Handle-based functions: they fill the given ResultDLL with the codes and text lengths of the result and return its handle.
+ * The texts are read from the handle, which must be released with releaseResult once read.
+ */
+ResultHandle acquireResult(server::ResponsePacket response_packet, ResultDLL& result);
+
+ADDAPI ResultHandle listClientsResult(server::ServerAPI* server, ResultDLL& result);
+ADDAPI ResultHandle echoClientResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle diagClientResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendCommandResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendTypeAResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendTypeBResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendTypeFResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendCommandBytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendTypeABytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendTypeBBytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle sendTypeFBytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle restartTargetResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle stopClientResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle coldResetResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle warmResetResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle powerOFFFieldResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle powerONFieldResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle loadScriptResult(server::ServerAPI* server, int id_client, const char* script, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle runScriptResult(server::ServerAPI* server, int id_client, int handle, const char* parameters, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle pollEventResult(server::ServerAPI* server, DWORD timeout, ResultDLL& result);
+ADDAPI ResultHandle getStatsResult(server::ServerAPI* server, ResultDLL& result); // the counters of many clients may not fit a ResponseDLL
+
+/**
+ * sendBatch - send several requests in one call, the clients are served in parallel and the requests to a same client in order.
+ * @param server the server.
+ * @param requests the requests to send.
+ * @param count the number of requests.
+ * @param timeout the waiting time of the execution of each request.
+ * @param results filled with the codes and text lengths of each request's result, in the order of the requests.
+ * @param handles filled with the handle of each request's result, to be released with releaseResult or releaseResults.
+ * @return the number of requests whose result contains an error code.
+ */
+ADDAPI unsigned long sendBatch(server::ServerAPI* server, const BatchRequestDLL* requests, unsigned long count, DWORD timeout, ResultDLL* results, ResultHandle* handles);
+
+/**
+ * getResultBytes - copy the payload of a result, the bytes encoded by its hexadecimal response.
+ * @param handle the result.
+ * @param buffer the destination, at least half the response's length (lengths[RESULT_RESPONSE] / 2) long.
+ * @param length the size of the destination, nothing is copied if it is shorter than half the response's length.
+ * @return the length of the payload, or the size needed (greater than length) if the destination is too short, 0 if the response is not hexadecimal data (read it with getResultText).
+ */
+ADDAPI unsigned long getResultBytes(ResultHandle handle, unsigned char* buffer, unsigned long length);
+
+/**
+ * getResultText - copy a text of a result followed by a null character.
+ * @param handle the result.
+ * @param field the ResultField to copy.
+ * @param buffer the destination.
+ * @param size the size of the destination, the text is truncated if it is longer than size - 1.
+ * @return the length of the whole text.
+ */
+ADDAPI unsigned long getResultText(ResultHandle handle, int field, char* buffer, unsigned long size);
+
+/**
+ * getResultView - access a text of a result without copying it.
+ * @param handle the result.
+ * @param field the ResultField to access.
+ * @return the null-terminated text, valid until the result is released.
+ */
+ADDAPI const char* getResultView(ResultHandle handle, int field);
+
+/**
+ * getResultTiming - return the duration of each stage of the request of a result, see constants/request_timing.hpp.
+ * The client's stages are only measured when the server's "request_timing" configuration value is true.
+ * @param handle the result.
+ * @param durations filled with the duration in microseconds of each TimingStage, TIMING_NOT_STAMPED for the stages the request did not go through.
+ * @param count the size of durations, the stages beyond are not returned.
+ * @return the number of durations filled.
+ */
+ADDAPI unsigned long getResultTiming(ResultHandle handle, long long* durations, unsigned long count);
+
+/**
+ * releaseResult - release a result, which is kept in a pool for the next calls.
+ * @param handle the result, ignored if NULL.
+ */
+ADDAPI void releaseResult(ResultHandle handle);
+
+/**
+ * releaseResults - release the results of a batch.
+ * @param handles the results, the NULL ones are ignored.
+ * @param count the number of results.
+ */
+ADDAPI void releaseResults(ResultHandle* handles, unsigned long count);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,148 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef LOGGER_ASYNC_APPENDER_HPP_
+#define LOGGER_ASYNC_APPENDER_HPP_
+
+#include "metrics/lock_stats.hpp"
+#include "plog/include/plog/Appenders/IAppender.h"
+#include "plog/include/plog/Record.h"
+#include "plog/include/plog/Util.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logger {
+
+/**
+ * LogEntry - the content of a plog record, captured on the logging thread and formatted later by the writer thread.
+ */
+struct LogEntry {
+	plog::util::Time time;
+	plog::Severity severity = plog::none;
+	unsigned int tid = 0;
+	const void* object = nullptr;
+	std::size_t line = 0;
+	std::string func;
+	const char* file = "";
+	plog::util::nstring message;
+};
+
+/**
+ * LogBuffer - bounded ring of log entries written by a single thread and read by the writer thread, without lock.
+ */
+class LogBuffer {
+private:
+	std::vector<LogEntry> entries_;
+	std::atomic<std::size_t> head_ { 0 }; // next entry to read, only moved by the writer thread
+	std::atomic<std::size_t> tail_ { 0 }; // next entry to write, only moved by the owning thread
+	std::atomic<bool> retired_ { false };
+public:
+	explicit LogBuffer(std::size_t capacity) : entries_(capacity) {}
+
+	/**
+	 * push - append an entry, called by the owning thread only.
+	 * @return false if the buffer is full, the entry is then left untouched.
+	 */
+	bool push(LogEntry& entry);
+
+	/**
+	 * pop - remove the oldest entry, called by the writer thread only.
+	 * @return false if the buffer is empty.
+	 */
+	bool pop(LogEntry* entry);
+
+	bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+	bool isRetired() const { return retired_.load(std::memory_order_acquire); }
+	void setRetired(bool retired) { retired_.store(retired, std::memory_order_release); }
+};
+
+/**
+ * AsyncAppender - plog appender moving the formatting and the writing of the records out of the logging threads.
+ * Each logging thread pushes its records into its own LogBuffer; a writer thread collects them periodically, in time order,
+ * and passes them to the sinks (file and console appenders), which also perform the rotation of the files.
+ * A record logged while the buffer of its thread is full is dropped and counted, the writer logs the number of dropped records.
+ */
+class AsyncAppender : public plog::IAppender {
+private:
+	std::vector<plog::IAppender*> sinks_;
+	std::size_t buffer_size_;
+	std::chrono::milliseconds flush_interval_;
+	std::vector<std::shared_ptr<LogBuffer>> buffers_;
+	std::vector<std::shared_ptr<LogBuffer>> free_buffers_; // buffers of exited threads, reused by the next threads
+	server::InstrumentedMutex buffers_mutex_ { "log_buffers_mutex" }; // taken by a logging thread when it logs for the first time
+	std::mutex drain_mutex_;
+	std::vector<LogEntry> batch_;
+	std::thread writer_;
+	std::mutex writer_mutex_;
+	std::condition_variable writer_cv_;
+	bool stop_ = false;
+	std::atomic<unsigned long long> written_ { 0 };
+	std::atomic<unsigned long long> dropped_ { 0 };
+	unsigned long long reported_dropped_ = 0;
+public:
+	/**
+	 * AsyncAppender - start the writer thread.
+	 * @param buffer_size the maximum number of records waiting to be written for each logging thread.
+	 * @param flush_interval the time between two collections of the records.
+	 */
+	AsyncAppender(std::size_t buffer_size, std::chrono::milliseconds flush_interval);
+	~AsyncAppender();
+
+	/**
+	 * addSink - add an appender writing the records, must be called before logging.
+	 * @param sink the appender.
+	 */
+	void addSink(plog::IAppender* sink);
+
+	/**
+	 * write - queue a record in the buffer of the calling thread.
+	 * @param record the record to be written.
+	 */
+	virtual void write(const plog::Record& record);
+
+	/**
+	 * flush - write the queued records from the calling thread.
+	 * @param wait false to give up if the writer thread is writing, as when the process exits.
+	 */
+	void flush(bool wait = true);
+
+	/**
+	 * getWrittenRecords - return the number of records passed to the sinks.
+	 * @return the written records.
+	 */
+	unsigned long long getWrittenRecords() const { return written_.load(std::memory_order_relaxed); }
+
+	/**
+	 * getDroppedRecords - return the number of records dropped because the buffer of their thread was full.
+	 * @return the dropped records.
+	 */
+	unsigned long long getDroppedRecords() const { return dropped_.load(std::memory_order_relaxed); }
+private:
+	LogBuffer* threadBuffer();
+	void run();
+	void drain(bool wait = true);
+};
+
+} /* namespace logger */
+
+#endif /* LOGGER_ASYNC_APPENDER_HPP_ */
@@ -17,6 +17,7 @@
 
 #include "config/config_wrapper.hpp"
 #include "constants/default_values.hpp"
+#include "logger/async_appender.hpp"
 #include "plog/include/plog/Log.h"
 #include "plog/include/plog/Appenders/ColorConsoleAppender.h"
 
@@ -30,5 +31,16 @@ namespace logger {
  */
 void setup(server::ConfigWrapper* config);
 
+/**
+ * getAsyncAppender - return the appender writing the records in the background.
+ * @return the appender, NULL if the records are written synchronously.
+ */
+AsyncAppender* getAsyncAppender();
+
+/**
+ * flush - write the records waiting in the background appender, if any.
+ */
+void flush();
+
 } /* namespace logger */
 
@@ -0,0 +1,60 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_CONTENTION_REPORTER_HPP_
+#define METRICS_CONTENTION_REPORTER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace server {
+
+/**
+ * ContentionReporter - logs periodically the statistics of the instrumented locks and of the registered threads.
+ */
+class ContentionReporter {
+private:
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable stop_cv_;
+	bool stop_ = false;
+public:
+	ContentionReporter() = default;
+	~ContentionReporter();
+
+	/**
+	 * start - log the statistics at the given interval on a background thread.
+	 * @param interval the time between two summaries.
+	 */
+	void start(std::chrono::seconds interval);
+
+	/**
+	 * stop - log a last summary and wait for the thread.
+	 */
+	void stop();
+
+	/**
+	 * report - log the statistics once, one line per lock and per thread's purpose.
+	 */
+	static void report();
+};
+
+} /* namespace server */
+
+#endif /* METRICS_CONTENTION_REPORTER_HPP_ */
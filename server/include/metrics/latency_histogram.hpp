@@ -0,0 +1,97 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_LATENCY_HISTOGRAM_HPP_
+#define METRICS_LATENCY_HISTOGRAM_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace server {
+
+/**
+ * LatencyHistogram - lock-free histogram of durations with a bounded relative error, in the manner of HdrHistogram.
+ * The values below 32 have their own bucket, the larger ones fall into 16 buckets per power of two, so that a bucket
+ * is at most 1/16th of its values wide. Recording is a few relaxed atomic increments, the histogram can be read
+ * while it is recorded to: a reader sees every complete record but not a consistent snapshot of all of them.
+ */
+class LatencyHistogram {
+public:
+	static const int SUB_BUCKET_BITS = 4; // buckets per power of two: 2^SUB_BUCKET_BITS
+	static const int MAX_VALUE_BITS = 40; // values are clamped to 2^40 - 1, 12 days in microseconds
+	static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+private:
+	std::atomic<uint64_t> buckets_[BUCKET_COUNT];
+	std::atomic<uint64_t> count_ { 0 };
+	std::atomic<uint64_t> sum_ { 0 };
+	std::atomic<uint64_t> max_ { 0 };
+public:
+	LatencyHistogram();
+
+	/**
+	 * record - add a value to the histogram.
+	 * @param value the value, the negative ones are ignored.
+	 */
+	void record(long long value);
+
+	/**
+	 * reset - remove all the values.
+	 */
+	void reset();
+
+	/**
+	 * getCount - return the number of recorded values.
+	 */
+	uint64_t getCount() const;
+
+	/**
+	 * getMean - return the mean of the recorded values, 0 if there is none.
+	 */
+	double getMean() const;
+
+	/**
+	 * getSum - return the sum of the recorded values.
+	 */
+	uint64_t getSum() const;
+
+	/**
+	 * getMax - return the largest recorded value, 0 if there is none.
+	 */
+	uint64_t getMax() const;
+
+	/**
+	 * getPercentile - return the value below which the given percentage of the recorded values fall.
+	 * @param percentile the percentage, between 0 and 100.
+	 * @return the highest value of the bucket holding the percentile, capped by the largest recorded value, 0 if there is none.
+	 */
+	uint64_t getPercentile(double percentile) const;
+
+	/**
+	 * bucketIndex - return the bucket of a value.
+	 */
+	static int bucketIndex(uint64_t value);
+
+	/**
+	 * bucketUpperBound - return the highest value falling into a bucket.
+	 */
+	static uint64_t bucketUpperBound(int index);
+};
+
+} /* namespace server */
+
+#endif /* METRICS_LATENCY_HISTOGRAM_HPP_ */
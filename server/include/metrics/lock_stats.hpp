@@ -0,0 +1,153 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_LOCK_STATS_HPP_
+#define METRICS_LOCK_STATS_HPP_
+
+#include "metrics/latency_histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace server {
+
+/**
+ * LockStats - acquisitions, wait and hold times in nanoseconds of the locks sharing a name, updated without lock.
+ */
+struct LockStats {
+	std::string name;
+	std::atomic<uint64_t> acquisitions { 0 };
+	std::atomic<uint64_t> contended { 0 }; // acquisitions which had to wait for another thread
+	LatencyHistogram wait; // waiting time of the contended acquisitions only
+	LatencyHistogram hold; // time between the acquisition and the release
+
+	explicit LockStats(const std::string& name) : name(name) {}
+};
+
+/**
+ * LockRegistry - statistics of the instrumented locks by name, kept until the process exits.
+ * The instrumentation is disabled by default, an instrumented lock then only costs a relaxed load more than a std::mutex.
+ */
+class LockRegistry {
+private:
+	static std::atomic<bool> enabled_;
+	std::mutex mutex_;
+	std::vector<std::shared_ptr<LockStats>> locks_;
+	LockRegistry() = default;
+public:
+	static LockRegistry& getInstance() {
+		static LockRegistry instance;
+		return instance;
+	}
+
+	static bool isEnabled() {
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * setEnabled - start or stop measuring the locks, the locks held meanwhile are measured from their next acquisition.
+	 */
+	static void setEnabled(bool enabled) {
+		enabled_.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * find - return the statistics of the locks of the given name, created on first use.
+	 * @param name the name of the lock.
+	 * @return the statistics, valid until the process exits.
+	 */
+	LockStats* find(const std::string& name);
+
+	/**
+	 * snapshot - return the statistics of all the names, in the order of their creation.
+	 */
+	std::vector<std::shared_ptr<LockStats>> snapshot();
+
+	LockRegistry(LockRegistry const&) = delete;
+	void operator=(LockRegistry const&) = delete;
+};
+
+/**
+ * InstrumentedMutex - std::mutex measuring its wait and hold times in the LockStats of its name when the instrumentation is enabled.
+ * It is used with std::lock_guard and std::unique_lock, and with std::condition_variable_any instead of std::condition_variable.
+ */
+class InstrumentedMutex {
+private:
+	std::mutex mutex_;
+	LockStats* stats_;
+	long long acquired_ = 0; // instant of the acquisition in nanoseconds, 0 if it was not measured
+public:
+	/**
+	 * InstrumentedMutex - create a lock whose times are aggregated with the other locks of the same name.
+	 * @param name the name of the lock, such as the member it protects.
+	 */
+	explicit InstrumentedMutex(const char* name) : stats_(LockRegistry::getInstance().find(name)) {}
+
+	InstrumentedMutex(InstrumentedMutex const&) = delete;
+	void operator=(InstrumentedMutex const&) = delete;
+
+	void lock() {
+		if (!LockRegistry::isEnabled()) {
+			mutex_.lock();
+			acquired_ = 0;
+			return;
+		}
+		if (mutex_.try_lock()) {
+			acquired_ = now();
+		} else {
+			long long start = now();
+			mutex_.lock();
+			acquired_ = now();
+			stats_->contended.fetch_add(1, std::memory_order_relaxed);
+			stats_->wait.record(acquired_ - start);
+		}
+		stats_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	bool try_lock() {
+		if (!mutex_.try_lock()) {
+			return false;
+		}
+		acquired_ = LockRegistry::isEnabled() ? now() : 0;
+		if (acquired_ != 0) {
+			stats_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	void unlock() {
+		long long acquired = acquired_; // read while the lock is still held
+		long long released = (acquired != 0) ? now() : 0;
+		mutex_.unlock();
+		if (acquired != 0) {
+			stats_->hold.record(released - acquired);
+		}
+	}
+private:
+	static long long now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+} /* namespace server */
+
+#endif /* METRICS_LOCK_STATS_HPP_ */
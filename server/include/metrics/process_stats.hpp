@@ -0,0 +1,44 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef METRICS_PROCESS_STATS_HPP_
+#define METRICS_PROCESS_STATS_HPP_
+
+#include <cstdint>
+
+namespace server {
+
+/**
+ * ProcessStats - the resources used by the process, to follow their growth with the number of clients.
+ */
+struct ProcessStats {
+	uint64_t working_set = 0; // bytes of physical memory
+	uint64_t peak_working_set = 0;
+	uint64_t private_bytes = 0; // bytes of memory committed for the process only
+	uint64_t handles = 0;
+	uint64_t threads = 0;
+};
+
+/**
+ * readProcessStats - read the resources currently used by the process.
+ * @return the resources, the ones which cannot be read being 0.
+ */
+ProcessStats readProcessStats();
+
+} /* namespace server */
+
+#endif /* METRICS_PROCESS_STATS_HPP_ */
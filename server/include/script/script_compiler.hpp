@@ -0,0 +1,77 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_SCRIPT_COMPILER_HPP_
+#define SRC_SCRIPT_COMPILER_HPP_
+
+#include "constants/response_packet.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace server {
+
+/**
+ * ScriptCompiler - compile APDU scripts into the binary format executed by the clients (see constants/script_opcode.hpp).
+ * A script is a list of instructions, one per line, "#" starting a comment:
+ *   SEND 00 A4 04 00 $0    send a command, "$n" inserting the variable n
+ *   EXPECT 9000            stop the script with an error if the last status word differs, "XX" matching any byte (61XX)
+ *   EXTRACT $1 0 8         copy 8 bytes at offset 0 of the last response data to the variable 1, length 0 up to the status word
+ *   LABEL retry            define a jump target
+ *   JUMP retry             jump to a label
+ *   JUMPIF 6310 retry      jump if the last status word matches
+ *   JUMPIFNOT 9000 retry   jump if the last status word differs
+ *   COLD_RESET, WARM_RESET reset the card, the ATR becomes the last response
+ *   END                    stop the script
+ */
+class ScriptCompiler {
+private:
+	std::vector<unsigned char> program_;
+	std::map<std::string, unsigned int> labels_;
+	std::vector<std::pair<unsigned int, std::string>> jumps_;
+public:
+	ScriptCompiler() = default;
+	~ScriptCompiler() = default;
+
+	/**
+	 * compile - compile the given script.
+	 * @param source the script's text.
+	 * @return a ResponsePacket struct containing either the program as an hexadecimal string or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket compile(std::string source);
+
+	/**
+	 * encodeParameters - encode the data of a REQ_SCRIPT_RUN request.
+	 * @param handle the handle returned by the client when the script has been loaded.
+	 * @param parameters the script's parameters as hexadecimal strings separated by '|', assigned to the variables $0..$n.
+	 * @return a ResponsePacket struct containing either the request's data as an hexadecimal string or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket encodeParameters(int handle, std::string parameters);
+private:
+	bool compileLine(std::vector<std::string> tokens, std::string* error);
+	bool compileCommand(std::string command, std::string* error);
+	bool compileStatusWord(std::string status_word, std::string* error);
+	bool parseVariable(std::string token, unsigned char* variable, std::string* error);
+	bool parseHex(std::string hex, std::vector<unsigned char>* bytes, std::string* error);
+	void emitAddress(unsigned int address);
+	std::string toHex(std::vector<unsigned char> bytes);
+};
+
+} /* namespace server */
+
+#endif /* SRC_SCRIPT_COMPILER_HPP_ */
@@ -0,0 +1,111 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SRC_CLIENT_CONNECTION_HPP_
+#define SRC_CLIENT_CONNECTION_HPP_
+
+#include "constants/response_packet.hpp"
+#include "metrics/lock_stats.hpp"
+#include "server/server_tcp_socket.hpp"
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <winsock2.h>
+
+namespace server {
+
+/**
+ * ClientConnection - connection shared by the virtual clients of a multi-reader client.
+ * Requests of several virtual clients are sent on the same socket, a receiver thread
+ * dispatches the responses to the waiting requests using their id.
+ * The connection is also used by a single-reader client sending events, which can arrive at any time.
+ */
+class ClientConnection {
+private:
+	SOCKET socket_;
+	ServerTCPSocket* tcp_socket_;
+	std::thread receiver_thread_;
+	InstrumentedMutex send_mutex_ { "connection_send_mutex" };
+	InstrumentedMutex pending_mutex_ { "connection_pending_mutex" };
+	std::map<unsigned long, std::promise<ResponsePacket>> pending_;
+	std::atomic<bool> closed_ { false };
+	std::once_flag teardown_flag_; // the receiver thread is joined and the socket closed once, whoever closes the connection
+	std::function<void(nlohmann::json jevent)> on_event_;
+public:
+	ClientConnection(SOCKET socket, ServerTCPSocket* tcp_socket);
+	~ClientConnection();
+
+	/**
+	 * setEventHandler - set the function called by the receiver thread with the events sent by the client.
+	 * Must be called before start.
+	 * @param on_event the function to call with each event.
+	 */
+	void setEventHandler(std::function<void(nlohmann::json jevent)> on_event);
+
+	/**
+	 * start - launch the thread receiving the responses.
+	 */
+	void start();
+
+	/**
+	 * close - close the connection, requests waiting for a response fail with a network error.
+	 * Concurrent calls return once the receiver thread is joined. Called from the receiver thread (by an event handler),
+	 * the connection is only shut down: the thread cannot join itself, its owner joins it later.
+	 */
+	void close();
+
+	/**
+	 * sendRequest - send a request and register it to receive its response.
+	 * @param id the request's id, echoed by the client in its response.
+	 * @param to_send the actual data to be sent.
+	 * @param sent filled with the instant the request was sent at, see constants/request_timing.hpp (optional).
+	 * @return a future holding the request's result.
+	 */
+	std::future<ResponsePacket> sendRequest(unsigned long id, std::string to_send, long long* sent = NULL);
+
+	/**
+	 * abandon - stop waiting for the response of the given request, a late response is dropped.
+	 * @param id the request's id.
+	 */
+	void abandon(unsigned long id);
+
+	/**
+	 * getSocket - return the socket of the connection.
+	 * @return the connection's socket.
+	 */
+	SOCKET getSocket();
+
+	/**
+	 * isClosed - check whether the connection has been lost or closed.
+	 * @return true if the connection cannot be used anymore.
+	 */
+	bool isClosed();
+private:
+	void receiveResponses();
+	void completePending(unsigned long id, ResponsePacket response_packet);
+	void failPending(ResponsePacket response_packet);
+};
+
+} /* namespace server */
+
+#endif /* SRC_CLIENT_CONNECTION_HPP_ */
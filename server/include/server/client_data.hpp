@@ -20,6 +20,10 @@
 
 #define DEFAULT_NAME "no name"
 
+#include "metrics/request_stats.hpp"
+#include "server/client_connection.hpp"
+
+#include <memory>
 #include <string>
 #include <winsock2.h>
 
@@ -30,6 +34,10 @@ private:
 	int id_;
 	SOCKET socket_ = INVALID_SOCKET;
 	std::string name_ = DEFAULT_NAME;
+	std::string token_;
+	std::shared_ptr<ClientConnection> connection_;
+	int channel_ = 0;
+	std::shared_ptr<RequestStats> stats_ = std::make_shared<RequestStats>();
 protected:
 public:
 	ClientData() {}
@@ -54,6 +62,30 @@ public:
 	 */
 	SOCKET getSocket();
 
+	/**
+	 * getToken - return the token used by the client to resume its session after a reconnection.
+	 * @return the client's resume token, empty if the client does not support session resumption.
+	 */
+	std::string getToken();
+
+	/**
+	 * getConnection - return the connection shared with the other readers of a multi-reader client.
+	 * @return the client's shared connection, empty if the client owns its socket.
+	 */
+	std::shared_ptr<ClientConnection> getConnection();
+
+	/**
+	 * getChannel - return the index of the client's reader on its shared connection.
+	 * @return the client's channel.
+	 */
+	int getChannel();
+
+	/**
+	 * getStats - return the counters of the requests sent to the client, kept when the client reconnects.
+	 * @return the client's request counters.
+	 */
+	std::shared_ptr<RequestStats> getStats();
+
 	/**
 	 * setId - set client's id.
 	 * The given id must be unique and stay unique.
@@ -72,6 +104,24 @@ public:
 	 * @param socket the socket to be set.
 	 */
 	void setSocket(SOCKET socket);
+
+	/**
+	 * setToken - set the client's resume token.
+	 * @param token the token to be set.
+	 */
+	void setToken(std::string token);
+
+	/**
+	 * setConnection - set the connection shared with the other readers of a multi-reader client.
+	 * @param connection the connection to be set.
+	 */
+	void setConnection(std::shared_ptr<ClientConnection> connection);
+
+	/**
+	 * setChannel - set the index of the client's reader on its shared connection.
+	 * @param channel the channel to be set.
+	 */
+	void setChannel(int channel);
 };
 
 } /* namespace server */
@@ -0,0 +1,56 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#ifndef SERVER_MESSAGE_CODEC_HPP_
+#define SERVER_MESSAGE_CODEC_HPP_
+
+#include "constants/response_packet.hpp"
+
+#include <string>
+#include <windows.h>
+
+namespace server {
+
+/**
+ * encodeRequest - serialize a request in the format produced by nlohmann for { "id", "request", "data", "timeout" }.
+ * The keys are written in nlohmann's order so that both paths produce the same text.
+ * @param id the id of the request.
+ * @param request the request's code.
+ * @param data the request's data.
+ * @param timeout the waiting time of the execution of the request.
+ * @param channel the reader of a multi-reader client the request is addressed to, omitted if negative.
+ * @param timing true to ask the client for the instants of the request's stages, omitted if false.
+ * @param text filled with the serialized request, its capacity is reused.
+ */
+void encodeRequest(unsigned long id, int request, const std::string& data, DWORD timeout, int channel, bool timing, std::string* text);
+
+/**
+ * decodeResponse - decode a client's response with a hand-written parser of the ResponsePacket's fixed schema.
+ * Missing fields keep their default value and descriptions may be sent by their interned index, as in compact responses.
+ * The client's instants sent when the request asked for them fill the client's part of the response's timing.
+ * Messages with unknown fields (events among others), non-integer numbers or escapes outside the BMP
+ * are not decoded and must be parsed with nlohmann instead.
+ * @param text the message received from the client.
+ * @param response_packet filled with the response.
+ * @param id filled with the id of the request the response answers, 0 if the response has no id.
+ * @return true if the response was decoded, false if it must be parsed with nlohmann.
+ */
+bool decodeResponse(const char* text, ResponsePacket* response_packet, unsigned long* id);
+
+} /* namespace server */
+
+#endif /* SERVER_MESSAGE_CODEC_HPP_ */
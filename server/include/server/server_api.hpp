@@ -18,20 +18,25 @@
 #ifndef SERVER_HPP_
 #define SERVER_HPP_
 
+#include "constants/apdu.hpp"
+#include "constants/batch_request.hpp"
 #include "constants/callback.hpp"
 #include "constants/default_values.hpp"
 #include "constants/request_code.hpp"
+#include "constants/terminal_state.hpp"
 #include "server/client_data.hpp"
 #include "server/server_engine.hpp"
 
+#include <vector>
+
 namespace server {
 
 class ServerAPI {
 private:
 	ServerEngine* engine_;
 public:
-	ServerAPI(Callback notifyConnectionAccepted) {
-		this->engine_ = new ServerEngine(notifyConnectionAccepted);
+	ServerAPI(Callback notifyConnectionAccepted, EventCallback notifyEventReceived = 0) {
+		this->engine_ = new ServerEngine(notifyConnectionAccepted, notifyEventReceived);
 	}
 
 	~ServerAPI() {
@@ -88,6 +93,17 @@ public:
 	 */
 	ResponsePacket diagClient(int id_client, DWORD timeout);
 
+	/**
+	 * diagClientState - return the structured state of the client's terminal.
+	 * The client answers from its cached state and only accesses the reader when the card state is unknown.
+	 * The "response" field contains the state formatted in json.
+	 * @param id_client the client's id to send request to.
+	 * @param timeout the waiting time of the execution of the request.
+	 * @param state filled with the terminal's state.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket diagClientState(int id_client, DWORD timeout, TerminalState* state);
+
 	/**
 	 * sendCommand - return a ResponsePacket struct containing the target's response in the "response" field.
 	 * @param id_client the client's id to send request to.
@@ -97,6 +113,11 @@ public:
 	 */
 	ResponsePacket sendCommand(int id_client, std::string command, DWORD timeout);
 
+	/**
+	 * sendCommand - same as above, with the command given as bytes.
+	 */
+	ResponsePacket sendCommand(int id_client, const Apdu& command, DWORD timeout);
+
 	/**
 	 * sendTypeA - send an APDU command over RF Type A.
 	 * @param id_client the client's id to send request to.
@@ -105,6 +126,7 @@ public:
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
 	ResponsePacket sendTypeA(int id_client, std::string command, DWORD timeout);
+	ResponsePacket sendTypeA(int id_client, const Apdu& command, DWORD timeout);
 
 	/**
 	 * sendTypeB - send an APDU command over RF Type B.
@@ -114,6 +136,7 @@ public:
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
 	ResponsePacket sendTypeB(int id_client, std::string command, DWORD timeout);
+	ResponsePacket sendTypeB(int id_client, const Apdu& command, DWORD timeout);
 
 	/**
 	 * sendTypeF - send an APDU command over RF Type F.
@@ -123,6 +146,7 @@ public:
 	 * @return a ResponsePacket struct containing either the smartcard's response or error codes and error descriptions in case of error.
 	 */
 	ResponsePacket sendTypeF(int id_client, std::string command, DWORD timeout);
+	ResponsePacket sendTypeF(int id_client, const Apdu& command, DWORD timeout);
 
 	/**
 	 * restartTarget - restart the given target.
@@ -172,11 +196,90 @@ public:
 	 */
 	ResponsePacket powerONField(int id_client, DWORD timeout);
 
+	/**
+	 * loadScript - compile an APDU script and upload it to the client, which keeps it until it is disconnected.
+	 * See script/script_compiler.hpp for the script's syntax.
+	 * @param id_client the client's id to send request to.
+	 * @param script the script's text.
+	 * @param timeout the waiting time of the execution of the request.
+	 * @return a ResponsePacket struct containing either the script's handle or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket loadScript(int id_client, std::string script, DWORD timeout);
+
+	/**
+	 * runScript - execute a script previously loaded on the client.
+	 * The "response" field contains the transcript of the script formatted this way: Command|Response|...|...
+	 * @param id_client the client's id to send request to.
+	 * @param handle the handle returned by loadScript.
+	 * @param parameters the script's parameters as hexadecimal strings separated by '|', assigned to the variables $0..$n.
+	 * @param timeout the waiting time of the execution of the whole script.
+	 * @return a ResponsePacket struct containing either the script's transcript or error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket runScript(int id_client, int handle, std::string parameters, DWORD timeout);
+
+	/**
+	 * pollEvent - retrieve the oldest event sent by the clients (card inserted or removed, reader added, removed or in error, load).
+	 * The events are also passed to the event callback when they are received.
+	 * The "response" field will be formatted this way: ClientID|EventType|ReaderName|Data
+	 * @param timeout the maximum waiting time in milliseconds if no event is queued, 0 to return immediately.
+	 * @return a ResponsePacket struct containing either the event or ERR_TIMEOUT if no event was received.
+	 */
+	ResponsePacket pollEvent(DWORD timeout);
+
+	/**
+	 * sendBatch - send several requests and wait for all their results.
+	 * The requests to a same client are sent in order, the clients are served in parallel.
+	 * REQ_CONNECT and REQ_INIT cannot be part of a batch.
+	 * @param requests the requests to send.
+	 * @param timeout the waiting time of the execution of each request.
+	 * @return the ResponsePacket of each request, in the order of the requests.
+	 */
+	std::vector<ResponsePacket> sendBatch(const std::vector<BatchRequest>& requests, DWORD timeout);
+
+	/**
+	 * reloadConfig - read the configuration again without restarting the server or waiting for the requests being processed.
+	 * The socket timeout, the event queue size and the log level are taken into account for the next requests.
+	 * @param source the configuration file or a string containing the json configuration, empty to read the initial file again.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket reloadConfig(std::string source);
+
+	/**
+	 * dumpFlightRecorder - write the last requests' events kept by the flight recorder to a file.
+	 * The file is decoded by tools/flight_decoder.cpp into text or into a Chrome trace.
+	 * @param path the file to write.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket dumpFlightRecorder(std::string path);
+
+	/**
+	 * getStageTimings - return the distribution of the durations of each stage of the requests, when "request_timing" is enabled.
+	 * The "response" field contains, for each stage of constants/request_timing.hpp, the count, mean, percentiles (p50, p90, p99, p999)
+	 * and maximum in microseconds formatted in json. The instants of a single request are in the "timing" field of its ResponsePacket.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket getStageTimings();
+
+	/**
+	 * getStats - return the counters of the server since it started.
+	 * The "response" field contains, formatted in json, the number of requests, errors, timeouts and requests in flight with the latency
+	 * percentiles in microseconds, as a whole, by request code ("requests_by_code") and by client ("by_client"), the results by error code
+	 * ("errors_by_code"), the bytes exchanged with the clients ("wire") and the number of clients with the memory, handles and threads
+	 * used by the process ("process").
+	 * When "contention_stats" is enabled, "contention" holds the wait and hold times of the instrumented locks and the threads'
+	 * counts and CPU times, by purpose.
+	 * The same counters are served in the Prometheus text format when "metrics_port" is set.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket getStats();
+
 	/**
 	 * stopServer - stop the server and all its clients and their underlying layers.
 	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
 	 */
 	ResponsePacket stopServer();
+private:
+	ResponsePacket sendRequest(const BatchRequest& request, DWORD timeout);
 };
 
 }  // namespace server
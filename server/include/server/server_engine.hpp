@@ -21,16 +21,30 @@
 #include "config/config_wrapper.hpp"
 #include "constants/callback.hpp"
 #include "constants/default_values.hpp"
+#include "constants/event_type.hpp"
 #include "constants/request_code.hpp"
+#include "constants/request_timing.hpp"
 #include "constants/response_packet.hpp"
+#include "metrics/contention_reporter.hpp"
+#include "metrics/latency_histogram.hpp"
+#include "metrics/lock_stats.hpp"
+#include "metrics/metrics_http_server.hpp"
+#include "metrics/request_stats.hpp"
+#include "recorder/flight_recorder.hpp"
+#include "server/client_connection.hpp"
 #include "server/client_data.hpp"
 #include "server/server_tcp_socket.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace server {
 
@@ -39,21 +53,40 @@ private:
 	enum class State { INSTANCIED, INITIALIZED, STARTED, DISCONNECTED };
 	State state_;
 	ConfigWrapper& config_ = ConfigWrapper::getInstance();
+	FlightRecorder& recorder_ = FlightRecorder::getInstance();
 	ServerTCPSocket* socket_;
 	std::map<int, ClientData*> clients_;
 	std::thread connection_thread_;
-	std::mutex insert_client_mutex_;
+	InstrumentedMutex insert_client_mutex_ { "insert_client_mutex" };
+	std::condition_variable_any client_reattached_cv_;
 	std::vector<std::future<ResponsePacket>> pending_futures_;
+	InstrumentedMutex pending_futures_mutex_ { "pending_futures_mutex" };
 	int next_client_id_ = 0;
+	std::atomic<unsigned long> next_request_id_ { 0 };
 	std::atomic<bool> stop_ { false };
+	std::deque<ClientEvent> events_;
+	InstrumentedMutex events_mutex_ { "events_mutex" };
+	std::condition_variable_any events_cv_;
+	LatencyHistogram stage_timings_[TIMING_STAGE_COUNT]; // durations of the stages of the requests in microseconds, when "request_timing" is enabled
+	RequestStats total_stats_; // all the requests, the requests of each client are counted in its ClientData
+	RequestStats request_stats_[REQ_COUNT]; // requests by RequestCode
+	ErrorStats error_stats_;
+	std::atomic<uint64_t> connections_ { 0 }; // clients registered since the server started, reconnections included
+	std::atomic<uint64_t> events_received_ { 0 };
+	std::chrono::steady_clock::time_point started_ = std::chrono::steady_clock::now();
+	MetricsHttpServer metrics_server_;
+	ContentionReporter contention_reporter_;
 	Callback notifyConnectionAccepted_;
+	EventCallback notifyEventReceived_;
 public:
-	ServerEngine(Callback notifyConnectionAccepted) {
+	ServerEngine(Callback notifyConnectionAccepted, EventCallback notifyEventReceived) {
 		state_ = State::INSTANCIED;
 		this->notifyConnectionAccepted_ = notifyConnectionAccepted;
+		this->notifyEventReceived_ = notifyEventReceived;
 	}
 
 	~ServerEngine() {
+		metrics_server_.stop();
 		delete socket_;
 	}
 
@@ -103,7 +136,59 @@ public:
 	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
 	 */
 	ResponsePacket stopAllClients();
+	/**
+	 * pollEvent - retrieve the oldest event received from the clients, waiting for one during the given time if there is none.
+	 * The "response" field will be formatted this way: ClientID|EventType|ReaderName|Data
+	 * @param timeout the maximum waiting time in milliseconds, 0 to return immediately.
+	 * @return a ResponsePacket struct containing either the event or ERR_TIMEOUT if no event was received.
+	 */
+	ResponsePacket pollEvent(DWORD timeout);
+
+	/**
+	 * reloadConfig - read the configuration again without restarting the server.
+	 * The requests being processed complete with the configuration they started with.
+	 * @param source the configuration file or a string containing the json configuration, empty to read the initial file again.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket reloadConfig(std::string source);
+
+	/**
+	 * getStageTimings - return the distribution of the durations of each stage of the requests since the server started.
+	 * The "response" field contains, for each TimingStage, the count, mean, percentiles and maximum in microseconds formatted in json.
+	 * @return a ResponsePacket struct containing either the durations or ERR_INVALID_STATE if "request_timing" is not enabled.
+	 */
+	ResponsePacket getStageTimings();
+
+	/**
+	 * getStats - return the counters of the server since it started: requests, errors by code, timeouts, requests in flight,
+	 * bytes on the wire and latency percentiles, as a whole, by RequestCode and by client.
+	 * The "response" field contains the counters formatted in json, the latencies are in microseconds.
+	 * @return a ResponsePacket struct containing the counters.
+	 */
+	ResponsePacket getStats();
 private:
+	/**
+	 * renderMetrics - format the counters of getStats in the Prometheus text format, served by the metrics endpoint.
+	 * @return the metrics page.
+	 */
+	std::string renderMetrics();
+
+	/**
+	 * startStats - count a request being sent.
+	 * @param client_stats the counters of the request's client.
+	 * @param request the request's code.
+	 */
+	void startStats(RequestStats* client_stats, RequestCode request);
+
+	/**
+	 * endStats - count the result of a request started with startStats.
+	 * @param client_stats the counters of the request's client.
+	 * @param request the request's code.
+	 * @param response_packet the request's result.
+	 * @param duration the request's duration in microseconds.
+	 */
+	void endStats(RequestStats* client_stats, RequestCode request, const ResponsePacket& response_packet, long long duration);
+
 	/**
 	 * handleConnections - handle connections request and use helper function "connectionHandshake" at each connection request.
 	 * @param listen_socket the socket used to listen for connections.
@@ -118,16 +203,90 @@ private:
 	 */
 	ResponsePacket connectionHandshake(SOCKET client_socket);
 
+	/**
+	 * resumableHandshake - helper function used to handle the json handshake of clients supporting session resumption.
+	 * A client sending a known token gets its previous id back and its socket is replaced, otherwise a new client is created.
+	 * The client's id and token are sent back to the client.
+	 * A client sending events gets a connection receiving its responses and events on a separate thread.
+	 * @param client_socket the socket of the incoming connection.
+	 * @param handshake the json handshake received from the client.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket resumableHandshake(SOCKET client_socket, std::string handshake);
+
+	/**
+	 * multiplexedHandshake - helper function used to handle the handshake of a multi-reader client.
+	 * Each reader is registered as a client sharing the connection, the client's ids are sent back in the order of its readers.
+	 * @param client_socket the socket of the incoming connection.
+	 * @param jhandshake the json handshake received from the client.
+	 * @return a ResponsePacket struct containing possible error codes (under 0) and error descriptions.
+	 */
+	ResponsePacket multiplexedHandshake(SOCKET client_socket, nlohmann::json jhandshake);
+
+	/**
+	 * handleEvent - helper function called by the receiver thread of a connection with an event sent by the client.
+	 * The event is passed to the event callback and queued until it is polled.
+	 * @param id_client the id of the client which sent the event.
+	 * @param jevent the event, formatted this way: {"event":EventType,"reader":ReaderName[,"channel":Channel]}
+	 */
+	void handleEvent(int id_client, nlohmann::json jevent);
+
+	/**
+	 * findClient - retrieve the connection data of the given client.
+	 * @param id_client the client's id.
+	 * @param client_socket the client's socket.
+	 * @param connection the client's shared connection, empty if the client owns its socket.
+	 * @param channel the client's reader on its shared connection.
+	 * @param stats the client's counters (optional).
+	 * @return false if the client is not found.
+	 */
+	bool findClient(int id_client, SOCKET* client_socket, std::shared_ptr<ClientConnection>* connection, int* channel, std::shared_ptr<RequestStats>* stats = NULL);
+
+	/**
+	 * eraseClient - delete the given client and remove it from the clients, the caller must hold insert_client_mutex_.
+	 * @param id_client the client's id.
+	 */
+	void eraseClient(int id_client);
+
+	/**
+	 * generateResumeToken - generate a random token identifying a client session.
+	 * @return the token as an hexadecimal string.
+	 */
+	std::string generateResumeToken();
+
+	/**
+	 * waitForReattach - wait for a client supporting session resumption to reconnect on a new socket.
+	 * @param id_client the client's id.
+	 * @param old_socket the socket on which the connection has been lost.
+	 * @param deadline the time after which the client is considered lost.
+	 * @return the new client's socket, INVALID_SOCKET if the client did not reconnect in time.
+	 */
+	SOCKET waitForReattach(int id_client, SOCKET old_socket, std::chrono::steady_clock::time_point deadline);
+
+	/**
+	 * sendAndWait - send the given request with the help of the function "asyncRequest" and wait for its result.
+	 * Requests to a multi-reader client go through its shared connection instead.
+	 * @param client_socket the socket to send data on.
+	 * @param connection the client's shared connection, empty if the client owns its socket.
+	 * @param id the request's id.
+	 * @param to_send the actual data to be sent.
+	 * @param timeout the timeout in ms used to elapse the request.
+	 * @param isExpectedRes bool to mention if resp is expected
+	 * @return a ResponsePacket struct containing the request's result.
+	 */
+	ResponsePacket sendAndWait(SOCKET client_socket, std::shared_ptr<ClientConnection> connection, unsigned long id, std::string to_send, DWORD timeout, bool isExpectedRes);
+
 	/**
 	 * asyncRequest - helper function to send asynchronously the given data on the given socket.
 	 * The request elapses is no response is received after the given timeout.
 	 * @param client_socket the socket to send data on.
+	 * @param id the request's id, the responses with another id are dropped.
 	 * @param to_send the actual data to be sent.
 	 * @param timeout the timeout in ms used to elapse the request.
 	 * @param isExpectedRes bool to mention if resp is expected
 	 * @return a ResponsePacket struct containing the request's result.
 	 */
-	ResponsePacket asyncRequest(SOCKET client_socket, std::string to_send, DWORD timeout, bool isExpectedRes);
+	ResponsePacket asyncRequest(SOCKET client_socket, unsigned long id, std::string to_send, DWORD timeout, bool isExpectedRes);
 };
 
 } /* namespace server */
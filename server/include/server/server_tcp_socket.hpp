@@ -18,6 +18,8 @@
 #ifndef INCLUDE_SERVER_SERVER_TCP_SOCKET_HPP_
 #define INCLUDE_SERVER_SERVER_TCP_SOCKET_HPP_
 
+#include "metrics/request_stats.hpp"
+
 #include <ws2tcpip.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -36,6 +38,7 @@ private:
 	const char* port_;
 	struct addrinfo* result_;
 	struct addrinfo hints_;
+	WireCounters counters_;
 public:
 	ServerTCPSocket() = default;
 	~ServerTCPSocket() = default;
@@ -75,6 +78,14 @@ public:
 	 * closeServer - cleanup and close the server.
 	 */
 	void closeServer();
+
+	/**
+	 * getCounters - return the bytes and packets exchanged on the socket.
+	 * @return the socket's counters.
+	 */
+	const WireCounters& getCounters() const {
+		return counters_;
+	}
 private:
 	bool sendData(SOCKET socket, const char* data, int size);
 };
@@ -16,6 +16,7 @@
  *********************************************************************************/
 
 #include "config/config_wrapper.hpp"
+#include "constants/default_values.hpp"
 #include "nlohmann/json.hpp"
 
 #include <fstream>
@@ -26,20 +27,76 @@ namespace server {
 
 void ConfigWrapper::init(std::string path) {
 	std::ifstream i(path);
-	i >> config_;
+	nlohmann::json config;
+	i >> config;
 	i.close();
+	path_ = path;
+	publish(config);
 }
 
 void ConfigWrapper::initFromJson(std::string jsonConfig) {
-    config_ = nlohmann::json::parse(jsonConfig);
+	publish(nlohmann::json::parse(jsonConfig));
 }
 
 std::string ConfigWrapper::getValue(std::string key) {
-	return config_[key];
+	std::shared_ptr<const ServerConfig> config = std::atomic_load(&server_config_);
+	return config->values.at(key).get<std::string>();
 }
 
 std::string ConfigWrapper::getValue(std::string key, std::string default_value) {
-	return config_[key].is_null() ? default_value : config_[key].get<std::string>();
+	std::shared_ptr<const ServerConfig> config = std::atomic_load(&server_config_);
+	auto it = config->values.find(key); // a lookup on the shared json must not insert the missing keys
+	return (it == config->values.end() || it->is_null()) ? default_value : it->get<std::string>();
+}
+
+std::shared_ptr<const ServerConfig> ConfigWrapper::getConfig() {
+	return std::atomic_load(&server_config_);
+}
+
+bool ConfigWrapper::reload(std::string source) {
+	std::lock_guard<std::mutex> guard(reload_mutex_);
+	// inline json may be indented or start on a new line
+	std::size_t first = source.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos) {
+		source.clear();
+	} else {
+		source.erase(0, first);
+		source.erase(source.find_last_not_of(" \t\r\n") + 1);
+	}
+	try {
+		if ((source.size() > 1) && (source.at(0) == '{')) {
+			publish(nlohmann::json::parse(source));
+		} else {
+			std::ifstream i(source.empty() ? path_ : source);
+			if (!i.is_open()) {
+				return false;
+			}
+			nlohmann::json config;
+			i >> config;
+			publish(config);
+		}
+	} catch (std::exception &err) {
+		return false;
+	}
+	return true;
+}
+
+void ConfigWrapper::publish(nlohmann::json config) {
+	auto value = [&config](const char* key, std::string default_value) {
+		auto it = config.find(key);
+		return (it == config.end() || it->is_null()) ? default_value : it->get<std::string>();
+	};
+
+	// parsed before anything is published: an invalid value leaves the current configuration in place
+	std::shared_ptr<ServerConfig> server_config = std::make_shared<ServerConfig>();
+	server_config->timeout = std::stoul(value("timeout", DEFAULT_SOCKET_TIMEOUT));
+	server_config->event_queue_size = std::stoul(value("event_queue_size", DEFAULT_EVENT_QUEUE_SIZE));
+	server_config->debug_log = value("log_level", DEFAULT_LOG_LEVEL).compare("debug") == 0;
+	server_config->request_timing = value("request_timing", DEFAULT_REQUEST_TIMING).compare("true") == 0;
+	server_config->values = std::move(config);
+
+	// a single pointer: readers never see the new json with the previous typed values
+	std::atomic_store(&server_config_, std::shared_ptr<const ServerConfig>(server_config));
 }
 
 } /* namespace server */
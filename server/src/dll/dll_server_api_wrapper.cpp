@@ -18,13 +18,64 @@
 #include "constants/request_code.hpp"
 #include "dll/dll_server_api_wrapper.h"
 #include "server/server_api.hpp"
+#include "utils/type_converter.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 using namespace server;
 
+/**
+ * ResultSlot - a result of the handle-based functions, kept in a pool once released.
+ */
+struct ResultSlot {
+	ResponsePacket response_packet;
+};
+
+namespace {
+
+std::mutex result_pool_mutex;
+std::vector<ResultSlot*> result_pool;
+
+/**
+ * copyText - bounded copy of a text into a fixed-size buffer of the ResponseDLL struct.
+ */
+void copyText(char* destination, std::size_t size, const char* text) {
+	strncpy(destination, text, size - 1);
+	destination[size - 1] = '\0';
+}
+
+const char* resultText(ResultHandle handle, int field, std::size_t* length) {
+	const ResponsePacket& response_packet = handle->response_packet;
+	switch (field) {
+	case RESULT_RESPONSE:
+		*length = response_packet.response.size();
+		return response_packet.response.c_str();
+	case RESULT_SERVER_DESCRIPTION:
+		*length = response_packet.err_server_description.size();
+		return response_packet.err_server_description.c_str();
+	case RESULT_CLIENT_DESCRIPTION:
+		*length = response_packet.err_client_description.size();
+		return response_packet.err_client_description.c_str();
+	case RESULT_TERMINAL_DESCRIPTION:
+		*length = response_packet.err_terminal_description.size();
+		return response_packet.err_terminal_description.c_str();
+	case RESULT_CARD_DESCRIPTION:
+		*length = response_packet.err_card_description.size();
+		return response_packet.err_card_description.c_str();
+	default:
+		*length = 0;
+		return "";
+	}
+}
+
+} // namespace
+
  server::ServerAPI* createServerAPI() {
-	ServerAPI* server = new ServerAPI(notifyConnectionAccepted);
+	ServerAPI* server = new ServerAPI(notifyConnectionAccepted, notifyEventReceived);
 	return server;
 }
 
@@ -32,6 +83,10 @@ using namespace server;
 	notifyConnectionAccepted = handler;
 }
 
+ void setCallbackEventReceived(EventCallback handler) {
+	notifyEventReceived = handler;
+}
+
  void initServer(server::ServerAPI* server, const char* jsonConfig, ResponseDLL& response_packet) {
 	 ResponsePacket response = server->initServer((jsonConfig != NULL) ? jsonConfig : "config/init.json");
 	responsePacketForDll(response, response_packet);
@@ -62,6 +117,26 @@ using namespace server;
 	responsePacketForDll(response, response_packet);
 }
 
+ void diagClientState(server::ServerAPI* server, int id_client, DWORD timeout, TerminalStateDLL& state, ResponseDLL& response_packet) {
+	TerminalState terminal_state;
+	ResponsePacket response = server->diagClientState(id_client, timeout, &terminal_state);
+	strncpy(state.reader, terminal_state.reader.c_str(), DEFAULT_DLL_BUFFER_SIZE - 1);
+	state.reader[DEFAULT_DLL_BUFFER_SIZE - 1] = '\0';
+	state.card_state = terminal_state.card_state;
+	state.protocol = terminal_state.protocol;
+	strncpy(state.atr, terminal_state.atr.c_str(), DEFAULT_DLL_BUFFER_SIZE - 1);
+	state.atr[DEFAULT_DLL_BUFFER_SIZE - 1] = '\0';
+	state.last_error_code = terminal_state.last_error_code;
+	strncpy(state.last_error_description, terminal_state.last_error_description.c_str(), DEFAULT_DLL_BUFFER_SIZE - 1);
+	state.last_error_description[DEFAULT_DLL_BUFFER_SIZE - 1] = '\0';
+	state.commands = terminal_state.commands;
+	state.errors = terminal_state.errors;
+	state.resets = terminal_state.resets;
+	state.card_insertions = terminal_state.card_insertions;
+	state.card_removals = terminal_state.card_removals;
+	responsePacketForDll(response, response_packet);
+}
+
  void sendCommand(server::ServerAPI* server, int id_client, char* command, DWORD timeout, ResponseDLL& response_packet) {
 	ResponsePacket response = server->sendCommand(id_client, command, timeout);
 	responsePacketForDll(response, response_packet);
@@ -112,6 +187,41 @@ using namespace server;
 	responsePacketForDll(response, response_packet);
 }
 
+ void loadScript(server::ServerAPI* server, int id_client, char* script, DWORD timeout, ResponseDLL& response_packet) {
+	ResponsePacket response = server->loadScript(id_client, script, timeout);
+	responsePacketForDll(response, response_packet);
+}
+
+ void runScript(server::ServerAPI* server, int id_client, int handle, char* parameters, DWORD timeout, ResponseDLL& response_packet) {
+	ResponsePacket response = server->runScript(id_client, handle, parameters, timeout);
+	responsePacketForDll(response, response_packet);
+}
+
+ void pollEvent(server::ServerAPI* server, DWORD timeout, ResponseDLL& response_packet) {
+	ResponsePacket response = server->pollEvent(timeout);
+	responsePacketForDll(response, response_packet);
+}
+
+ void reloadConfig(server::ServerAPI* server, const char* jsonConfig, ResponseDLL& response_packet) {
+	ResponsePacket response = server->reloadConfig((jsonConfig != NULL) ? jsonConfig : "");
+	responsePacketForDll(response, response_packet);
+}
+
+ void dumpFlightRecorder(server::ServerAPI* server, const char* path, ResponseDLL& response_packet) {
+	ResponsePacket response = server->dumpFlightRecorder((path != NULL) ? path : DEFAULT_RECORDER_FILE);
+	responsePacketForDll(response, response_packet);
+}
+
+ void getStageTimings(server::ServerAPI* server, ResponseDLL& response_packet) {
+	ResponsePacket response = server->getStageTimings();
+	responsePacketForDll(response, response_packet);
+}
+
+ void getStats(server::ServerAPI* server, ResponseDLL& response_packet) {
+	ResponsePacket response = server->getStats();
+	responsePacketForDll(response, response_packet);
+}
+
  void stopServer(server::ServerAPI* server, ResponseDLL& response_packet) {
 	ResponsePacket response = server->stopServer();
 	responsePacketForDll(response, response_packet);
@@ -122,17 +232,201 @@ using namespace server;
 }
 
 void responsePacketForDll(ResponsePacket response_packet, ResponseDLL& response_packet_dll) {
-	strcpy(response_packet_dll.response, response_packet.response.c_str());
+	copyText(response_packet_dll.response, DEFAULT_DLL_BUFFER_SIZE_EXTENDED, response_packet.response.c_str());
 
 	response_packet_dll.err_server_code = response_packet.err_server_code;
-	strcpy(response_packet_dll.err_server_description, response_packet.err_server_description.c_str());
+	copyText(response_packet_dll.err_server_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_server_description.c_str());
 
 	response_packet_dll.err_client_code = response_packet.err_client_code;
-	strcpy(response_packet_dll.err_client_description, response_packet.err_client_description.c_str());
+	copyText(response_packet_dll.err_client_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_client_description.c_str());
 
 	response_packet_dll.err_terminal_code = response_packet.err_terminal_code;
-	strcpy(response_packet_dll.err_terminal_description, response_packet.err_terminal_description.c_str());
+	copyText(response_packet_dll.err_terminal_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_terminal_description.c_str());
 
 	response_packet_dll.err_card_code = response_packet.err_card_code;
-	strcpy(response_packet_dll.err_card_description, response_packet.err_card_description.c_str());
+	copyText(response_packet_dll.err_card_description, DEFAULT_DLL_BUFFER_SIZE, response_packet.err_card_description.c_str());
+}
+
+ResultHandle acquireResult(ResponsePacket response_packet, ResultDLL& result) {
+	ResultSlot* slot = NULL;
+	{
+		std::lock_guard<std::mutex> guard(result_pool_mutex);
+		if (!result_pool.empty()) {
+			slot = result_pool.back();
+			result_pool.pop_back();
+		}
+	}
+	if (slot == NULL) {
+		slot = new ResultSlot();
+	}
+	slot->response_packet = std::move(response_packet);
+
+	result.err_server_code = slot->response_packet.err_server_code;
+	result.err_client_code = slot->response_packet.err_client_code;
+	result.err_terminal_code = slot->response_packet.err_terminal_code;
+	result.err_card_code = slot->response_packet.err_card_code;
+	for (int field = 0; field < RESULT_FIELD_COUNT; field++) {
+		std::size_t length;
+		resultText(slot, field, &length);
+		result.lengths[field] = length;
+	}
+	return slot;
+}
+
+ResultHandle listClientsResult(server::ServerAPI* server, ResultDLL& result) {
+	return acquireResult(server->listClients(), result);
+}
+
+ResultHandle echoClientResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->echoClient(id_client, timeout), result);
+}
+
+ResultHandle diagClientResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->diagClient(id_client, timeout), result);
+}
+
+ResultHandle sendCommandResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendCommand(id_client, command, timeout), result);
+}
+
+ResultHandle sendTypeAResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendTypeA(id_client, command, timeout), result);
+}
+
+ResultHandle sendTypeBResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendTypeB(id_client, command, timeout), result);
+}
+
+ResultHandle sendTypeFResult(server::ServerAPI* server, int id_client, const char* command, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendTypeF(id_client, command, timeout), result);
+}
+
+ResultHandle sendCommandBytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendCommand(id_client, Apdu(command, length), timeout), result);
+}
+
+ResultHandle sendTypeABytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendTypeA(id_client, Apdu(command, length), timeout), result);
+}
+
+ResultHandle sendTypeBBytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendTypeB(id_client, Apdu(command, length), timeout), result);
+}
+
+ResultHandle sendTypeFBytesResult(server::ServerAPI* server, int id_client, const unsigned char* command, unsigned long length, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->sendTypeF(id_client, Apdu(command, length), timeout), result);
+}
+
+ResultHandle restartTargetResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->restartTarget(id_client, timeout), result);
+}
+
+ResultHandle stopClientResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->stopClient(id_client, timeout), result);
+}
+
+ResultHandle coldResetResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->coldReset(id_client, timeout), result);
+}
+
+ResultHandle warmResetResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->warmReset(id_client, timeout), result);
+}
+
+ResultHandle powerOFFFieldResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->powerOFFField(id_client, timeout), result);
+}
+
+ResultHandle powerONFieldResult(server::ServerAPI* server, int id_client, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->powerONField(id_client, timeout), result);
+}
+
+ResultHandle loadScriptResult(server::ServerAPI* server, int id_client, const char* script, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->loadScript(id_client, script, timeout), result);
+}
+
+ResultHandle runScriptResult(server::ServerAPI* server, int id_client, int handle, const char* parameters, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->runScript(id_client, handle, parameters, timeout), result);
+}
+
+ResultHandle pollEventResult(server::ServerAPI* server, DWORD timeout, ResultDLL& result) {
+	return acquireResult(server->pollEvent(timeout), result);
+}
+
+ResultHandle getStatsResult(server::ServerAPI* server, ResultDLL& result) {
+	return acquireResult(server->getStats(), result);
+}
+
+unsigned long sendBatch(server::ServerAPI* server, const BatchRequestDLL* requests, unsigned long count, DWORD timeout, ResultDLL* results, ResultHandle* handles) {
+	std::vector<BatchRequest> batch(count);
+	for (unsigned long i = 0; i < count; i++) {
+		batch[i].id_client = requests[i].id_client;
+		batch[i].request = (RequestCode) requests[i].request;
+		batch[i].data = (requests[i].data != NULL) ? requests[i].data : "";
+	}
+
+	std::vector<ResponsePacket> responses = server->sendBatch(batch, timeout);
+	unsigned long errors = 0;
+	for (unsigned long i = 0; i < count; i++) {
+		handles[i] = acquireResult(std::move(responses[i]), results[i]);
+		if (results[i].err_server_code < 0 || results[i].err_client_code < 0 || results[i].err_terminal_code < 0 || results[i].err_card_code < 0) {
+			errors++;
+		}
+	}
+	return errors;
+}
+
+unsigned long getResultBytes(ResultHandle handle, unsigned char* buffer, unsigned long length) {
+	const std::string& response = handle->response_packet.response;
+	// decoded straight into the caller's buffer: a buffer too short is not written, the size it needs is returned
+	unsigned long int capacity = utils::hexDecodedCapacity(response.size());
+	if (length < capacity) {
+		return capacity;
+	}
+	unsigned long int decoded;
+	return utils::hexDecode(response.data(), response.size(), buffer, &decoded) ? decoded : 0;
+}
+
+unsigned long getResultText(ResultHandle handle, int field, char* buffer, unsigned long size) {
+	std::size_t length;
+	const char* text = resultText(handle, field, &length);
+	if (size > 0) {
+		std::size_t copied = std::min<std::size_t>(length, size - 1);
+		std::memcpy(buffer, text, copied);
+		buffer[copied] = '\0';
+	}
+	return length;
+}
+
+const char* getResultView(ResultHandle handle, int field) {
+	std::size_t length;
+	return resultText(handle, field, &length);
+}
+
+unsigned long getResultTiming(ResultHandle handle, long long* durations, unsigned long count) {
+	unsigned long filled = std::min(count, (unsigned long) TIMING_STAGE_COUNT);
+	for (unsigned long stage = 0; stage < filled; stage++) {
+		durations[stage] = timingStageDuration(handle->response_packet.timing, stage);
+	}
+	return filled;
+}
+
+void releaseResult(ResultHandle handle) {
+	if (handle == NULL) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(result_pool_mutex);
+		if (result_pool.size() < DEFAULT_DLL_RESULT_POOL_SIZE) {
+			result_pool.push_back(handle);
+			return;
+		}
+	}
+	delete handle;
+}
+
+void releaseResults(ResultHandle* handles, unsigned long count) {
+	for (unsigned long i = 0; i < count; i++) {
+		releaseResult(handles[i]);
+	}
 }
@@ -0,0 +1,223 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "logger/async_appender.hpp"
+#include "metrics/thread_stats.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace logger {
+
+namespace {
+
+/**
+ * DeferredRecord - a plog record answering with the values captured on the logging thread.
+ */
+class DeferredRecord : public plog::Record {
+private:
+	const LogEntry& entry_;
+public:
+	explicit DeferredRecord(const LogEntry& entry) : plog::Record(entry.severity, entry.func.c_str(), entry.line, entry.file, entry.object), entry_(entry) {}
+
+	virtual const plog::util::Time& getTime() const { return entry_.time; }
+	virtual unsigned int getTid() const { return entry_.tid; }
+	virtual const plog::util::nchar* getMessage() const { return entry_.message.c_str(); }
+	virtual const char* getFunc() const { return entry_.func.c_str(); }
+};
+
+/**
+ * ThreadBuffer - the buffer of the calling thread, retired when the thread exits.
+ */
+struct ThreadBuffer {
+	std::shared_ptr<LogBuffer> buffer;
+	const AsyncAppender* owner = nullptr;
+
+	~ThreadBuffer() {
+		if (buffer) {
+			buffer->setRetired(true);
+		}
+	}
+};
+
+thread_local ThreadBuffer thread_buffer;
+
+bool isBefore(const LogEntry& a, const LogEntry& b) {
+	return a.time.time < b.time.time || (a.time.time == b.time.time && a.time.millitm < b.time.millitm);
+}
+
+} // namespace
+
+bool LogBuffer::push(LogEntry& entry) {
+	std::size_t tail = tail_.load(std::memory_order_relaxed);
+	if (tail - head_.load(std::memory_order_acquire) == entries_.size()) {
+		return false;
+	}
+	std::swap(entries_[tail % entries_.size()], entry);
+	tail_.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogBuffer::pop(LogEntry* entry) {
+	std::size_t head = head_.load(std::memory_order_relaxed);
+	if (head == tail_.load(std::memory_order_acquire)) {
+		return false;
+	}
+	std::swap(entries_[head % entries_.size()], *entry);
+	head_.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+AsyncAppender::AsyncAppender(std::size_t buffer_size, std::chrono::milliseconds flush_interval)
+	: buffer_size_(std::max<std::size_t>(buffer_size, 1)), flush_interval_(flush_interval) {
+	writer_ = std::thread(&AsyncAppender::run, this);
+}
+
+AsyncAppender::~AsyncAppender() {
+	{
+		std::lock_guard<std::mutex> guard(writer_mutex_);
+		stop_ = true;
+	}
+	writer_cv_.notify_all();
+	if (writer_.joinable()) {
+		writer_.join();
+	}
+	drain();
+}
+
+void AsyncAppender::addSink(plog::IAppender* sink) {
+	std::lock_guard<std::mutex> guard(drain_mutex_);
+	sinks_.push_back(sink);
+}
+
+void AsyncAppender::write(const plog::Record& record) {
+	LogEntry entry;
+	entry.time = record.getTime();
+	entry.severity = record.getSeverity();
+	entry.tid = record.getTid();
+	entry.object = record.getObject();
+	entry.line = record.getLine();
+	entry.file = record.getFile();
+	entry.message = record.getMessage();
+	entry.func = record.getFunc();
+	if (!threadBuffer()->push(entry)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void AsyncAppender::flush(bool wait) {
+	drain(wait);
+}
+
+LogBuffer* AsyncAppender::threadBuffer() {
+	if (thread_buffer.owner == this && thread_buffer.buffer) {
+		return thread_buffer.buffer.get();
+	}
+
+	std::lock_guard<server::InstrumentedMutex> guard(buffers_mutex_);
+	if (thread_buffer.buffer) {
+		thread_buffer.buffer->setRetired(true);
+	}
+	if (!free_buffers_.empty()) {
+		thread_buffer.buffer = free_buffers_.back();
+		free_buffers_.pop_back();
+		thread_buffer.buffer->setRetired(false);
+	} else {
+		thread_buffer.buffer = std::make_shared<LogBuffer>(buffer_size_);
+	}
+	thread_buffer.owner = this;
+	buffers_.push_back(thread_buffer.buffer);
+	return thread_buffer.buffer.get();
+}
+
+void AsyncAppender::run() {
+	server::ThreadScope scope("log_writer");
+	std::unique_lock<std::mutex> lock(writer_mutex_);
+	while (!stop_) {
+		writer_cv_.wait_for(lock, flush_interval_, [this] { return stop_; });
+		lock.unlock();
+		drain();
+		lock.lock();
+	}
+}
+
+void AsyncAppender::drain(bool wait) {
+	std::unique_lock<std::mutex> guard(drain_mutex_, std::defer_lock);
+	if (wait) {
+		guard.lock();
+	} else if (!guard.try_lock()) {
+		return;
+	}
+
+	std::vector<std::shared_ptr<LogBuffer>> buffers;
+	{
+		std::lock_guard<server::InstrumentedMutex> buffers_guard(buffers_mutex_);
+		buffers = buffers_;
+	}
+
+	// a retired buffer checked before being read cannot receive entries anymore
+	std::vector<LogBuffer*> retired;
+	for (auto &buffer : buffers) {
+		if (buffer->isRetired()) {
+			retired.push_back(buffer.get());
+		}
+		LogEntry entry;
+		while (buffer->pop(&entry)) {
+			batch_.push_back(std::move(entry));
+		}
+	}
+
+	unsigned long long dropped = dropped_.load(std::memory_order_relaxed);
+	if (dropped != reported_dropped_) {
+		LogEntry entry;
+		plog::util::ftime(&entry.time);
+		entry.severity = plog::warning;
+		entry.tid = plog::util::gettid();
+		entry.object = this;
+		entry.line = __LINE__;
+		entry.func = "logger::AsyncAppender::drain";
+		entry.file = __FILE__;
+		plog::util::nostringstream message;
+		message << "Log records dropped, the logging threads' buffers were full [dropped:" << (dropped - reported_dropped_) << "][total:" << dropped << "]";
+		entry.message = message.str();
+		batch_.push_back(std::move(entry));
+		reported_dropped_ = dropped;
+	}
+
+	std::stable_sort(batch_.begin(), batch_.end(), isBefore);
+	for (const LogEntry& entry : batch_) {
+		DeferredRecord record(entry);
+		for (plog::IAppender* sink : sinks_) {
+			sink->write(record);
+		}
+	}
+	written_.fetch_add(batch_.size(), std::memory_order_relaxed);
+	batch_.clear();
+
+	if (!retired.empty()) {
+		std::lock_guard<server::InstrumentedMutex> buffers_guard(buffers_mutex_);
+		for (LogBuffer* buffer : retired) {
+			auto it = std::find_if(buffers_.begin(), buffers_.end(), [buffer](const std::shared_ptr<LogBuffer>& b) { return b.get() == buffer; });
+			if (it != buffers_.end() && buffer->empty()) {
+				free_buffers_.push_back(*it);
+				buffers_.erase(it);
+			}
+		}
+	}
+}
+
+} /* namespace logger */
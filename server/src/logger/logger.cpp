@@ -17,13 +17,34 @@
 
 #include "config/config_wrapper.hpp"
 #include "constants/default_values.hpp"
+#include "logger/async_appender.hpp"
+#include "logger/logger.hpp"
 #include "plog/include/plog/Log.h"
 #include "plog/include/plog/Appenders/ColorConsoleAppender.h"
 
 #include <windows.h>
 
+#include <chrono>
+#include <cstdlib>
+
 namespace logger {
 
+namespace {
+
+AsyncAppender* async_appender = NULL;
+
+template<class Formatter>
+plog::IAppender* fileAppender(const char* log_path, int log_max_size, int log_max_files) {
+	static plog::RollingFileAppender<Formatter> appender(log_path, log_max_size, log_max_files);
+	return &appender;
+}
+
+void flushAtExit() {
+	async_appender->flush(false); // the writer thread may have been terminated while writing
+}
+
+} // namespace
+
 void setup(server::ConfigWrapper* config) {
 	std::string log_level = config->getValue("log_level", DEFAULT_LOG_LEVEL);
 	int log_max_size = std::stoi(config->getValue("log_max_size", DEFAULT_LOG_MAX_SIZE));
@@ -37,12 +58,32 @@ void setup(server::ConfigWrapper* config) {
 
 	CreateDirectory(log_directory.c_str(), NULL);
 
-	if (log_level.compare("debug") == 0) {
-		plog::init(plog::debug, log_path.c_str(), log_max_size, log_max_files);
-	} else {
-		plog::init(plog::info, log_path.c_str(), log_max_size, log_max_files);
+	plog::Severity severity = (log_level.compare("debug") == 0) ? plog::debug : plog::info;
+	if (config->getValue("log_async", DEFAULT_LOG_ASYNC).compare("true") != 0) {
+		plog::init(severity, log_path.c_str(), log_max_size, log_max_files);
+		return;
 	}
+
+	if (async_appender != NULL) {
+		plog::get()->setMaxSeverity(severity);
+		return;
+	}
+	// never deleted: joining the writer thread while the DLL is unloaded would dead-lock
+	async_appender = new AsyncAppender(std::stoul(config->getValue("log_buffer_size", DEFAULT_LOG_BUFFER_SIZE)), std::chrono::milliseconds(DEFAULT_LOG_FLUSH_INTERVAL));
+	bool csv = log_path.size() >= 4 && log_path.compare(log_path.size() - 4, 4, ".csv") == 0;
+	async_appender->addSink(csv ? fileAppender<plog::CsvFormatter>(log_path.c_str(), log_max_size, log_max_files) : fileAppender<plog::TxtFormatter>(log_path.c_str(), log_max_size, log_max_files));
+	std::atexit(flushAtExit);
+	plog::init(severity, async_appender);
 }
 
-} /* namespace logger */
+AsyncAppender* getAsyncAppender() {
+	return async_appender;
+}
 
+void flush() {
+	if (async_appender != NULL) {
+		async_appender->flush();
+	}
+}
+
+} /* namespace logger */
@@ -0,0 +1,76 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "metrics/contention_reporter.hpp"
+#include "metrics/lock_stats.hpp"
+#include "metrics/thread_stats.hpp"
+#include "plog/include/plog/Log.h"
+
+namespace server {
+
+ContentionReporter::~ContentionReporter() {
+	stop();
+}
+
+void ContentionReporter::start(std::chrono::seconds interval) {
+	if (thread_.joinable()) {
+		return;
+	}
+	stop_ = false;
+	thread_ = std::thread([this, interval]() {
+		ThreadScope scope("contention_reporter");
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (!stop_cv_.wait_for(lock, interval, [this] { return stop_; })) {
+			lock.unlock();
+			report();
+			lock.lock();
+		}
+	});
+}
+
+void ContentionReporter::stop() {
+	if (!thread_.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		stop_ = true;
+	}
+	stop_cv_.notify_all();
+	thread_.join();
+	report();
+}
+
+void ContentionReporter::report() {
+	for (const auto &lock : LockRegistry::getInstance().snapshot()) {
+		if (lock->acquisitions.load(std::memory_order_relaxed) == 0) {
+			continue;
+		}
+		LOG_INFO << "Lock contention [lock:" << lock->name << "][acquisitions:" << lock->acquisitions.load(std::memory_order_relaxed)
+				 << "][contended:" << lock->contended.load(std::memory_order_relaxed) << "][wait_p99_ns:" << lock->wait.getPercentile(99)
+				 << "][wait_max_ns:" << lock->wait.getMax() << "][hold_p99_ns:" << lock->hold.getPercentile(99)
+				 << "][hold_max_ns:" << lock->hold.getMax() << "]";
+	}
+	for (const ThreadUsage& usage : ThreadRegistry::getInstance().snapshot()) {
+		const ThreadStats& stats = *usage.stats;
+		LOG_INFO << "Thread usage [thread:" << stats.name << "][started:" << stats.started.load(std::memory_order_relaxed)
+				 << "][live:" << stats.live.load(std::memory_order_relaxed) << "][peak:" << stats.peak.load(std::memory_order_relaxed)
+				 << "][cpu_us:" << usage.cpu_time << "][lifetime_p50_us:" << stats.lifetime.getPercentile(50) << "]";
+	}
+}
+
+} /* namespace server */
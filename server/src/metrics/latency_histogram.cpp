@@ -0,0 +1,114 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "metrics/latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace server {
+
+LatencyHistogram::LatencyHistogram() {
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		buckets_[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void LatencyHistogram::record(long long value) {
+	if (value < 0) {
+		return;
+	}
+	uint64_t clamped = std::min((uint64_t) value, (((uint64_t) 1) << MAX_VALUE_BITS) - 1);
+	buckets_[bucketIndex(clamped)].fetch_add(1, std::memory_order_relaxed);
+	count_.fetch_add(1, std::memory_order_relaxed);
+	sum_.fetch_add(clamped, std::memory_order_relaxed);
+
+	uint64_t max = max_.load(std::memory_order_relaxed);
+	while (clamped > max && !max_.compare_exchange_weak(max, clamped, std::memory_order_relaxed)) {
+	}
+}
+
+void LatencyHistogram::reset() {
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		buckets_[i].store(0, std::memory_order_relaxed);
+	}
+	count_.store(0, std::memory_order_relaxed);
+	sum_.store(0, std::memory_order_relaxed);
+	max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const {
+	return count_.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMean() const {
+	uint64_t count = count_.load(std::memory_order_relaxed);
+	return (count == 0) ? 0 : (double) sum_.load(std::memory_order_relaxed) / count;
+}
+
+uint64_t LatencyHistogram::getSum() const {
+	return sum_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getMax() const {
+	return max_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const {
+	// the buckets are summed rather than using count_, which may be ahead of them while values are recorded
+	uint64_t total = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		total += buckets_[i].load(std::memory_order_relaxed);
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	percentile = std::max(0.0, std::min(100.0, percentile));
+	uint64_t rank = std::max((uint64_t) 1, (uint64_t) std::ceil(percentile / 100 * total));
+	uint64_t seen = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		seen += buckets_[i].load(std::memory_order_relaxed);
+		if (seen >= rank) {
+			return std::min(bucketUpperBound(i), getMax());
+		}
+	}
+	return getMax();
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+	if (value < (((uint64_t) 2) << SUB_BUCKET_BITS)) {
+		return (int) value;
+	}
+	int shift = 1;
+	while ((value >> shift) >= (((uint64_t) 2) << SUB_BUCKET_BITS)) {
+		shift++;
+	}
+	// value >> shift keeps the SUB_BUCKET_BITS + 1 highest bits of the value, the first of them always set
+	return (shift << SUB_BUCKET_BITS) + (int) (value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+	if (index < (2 << SUB_BUCKET_BITS)) {
+		return index;
+	}
+	int shift = (index >> SUB_BUCKET_BITS) - 1;
+	uint64_t mantissa = (index & ((1 << SUB_BUCKET_BITS) - 1)) + (1 << SUB_BUCKET_BITS);
+	return ((mantissa + 1) << shift) - 1;
+}
+
+} /* namespace server */
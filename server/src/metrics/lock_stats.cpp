@@ -0,0 +1,40 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "metrics/lock_stats.hpp"
+
+namespace server {
+
+std::atomic<bool> LockRegistry::enabled_ { false };
+
+LockStats* LockRegistry::find(const std::string& name) {
+	std::lock_guard<std::mutex> guard(mutex_);
+	for (const auto &lock : locks_) {
+		if (lock->name == name) {
+			return lock.get();
+		}
+	}
+	locks_.push_back(std::make_shared<LockStats>(name));
+	return locks_.back().get();
+}
+
+std::vector<std::shared_ptr<LockStats>> LockRegistry::snapshot() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	return locks_;
+}
+
+} /* namespace server */
@@ -0,0 +1,151 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#define _WIN32_WINNT 0x601
+#define WIN32_LEAN_AND_MEAN
+
+#include "metrics/metrics_http_server.hpp"
+#include "constants/default_values.hpp"
+#include "metrics/thread_stats.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <cstring>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+
+namespace server {
+
+MetricsHttpServer::~MetricsHttpServer() {
+	stop();
+}
+
+bool MetricsHttpServer::start(const char* ip, const char* port, std::function<std::string()> render) {
+	if (thread_.joinable()) {
+		return false;
+	}
+
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		LOG_DEBUG << "Failed to call WSAStartup()";
+		return false;
+	}
+
+	struct addrinfo hints;
+	struct addrinfo* result;
+	ZeroMemory(&hints, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE;
+	if (getaddrinfo(ip, port, &hints, &result) != 0) {
+		LOG_DEBUG << "Failed to call getaddrinfo() " << "[ip:" << ip << "][port:" << port << "]";
+		WSACleanup();
+		return false;
+	}
+
+	listen_socket_ = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (listen_socket_ == INVALID_SOCKET || bind(listen_socket_, result->ai_addr, (int) result->ai_addrlen) == SOCKET_ERROR
+			|| listen(listen_socket_, SOMAXCONN) == SOCKET_ERROR) {
+		LOG_DEBUG << "Failed to listen for the metrics " << "[ip:" << ip << "][port:" << port << "][WSAError:" << WSAGetLastError() << "]";
+		if (listen_socket_ != INVALID_SOCKET) {
+			closesocket(listen_socket_);
+			listen_socket_ = INVALID_SOCKET;
+		}
+		freeaddrinfo(result);
+		WSACleanup();
+		return false;
+	}
+	freeaddrinfo(result);
+
+	render_ = render;
+	stop_ = false;
+	thread_ = std::thread(&MetricsHttpServer::serve, this);
+	LOG_INFO << "Metrics available on http://" << ip << ":" << port << "/metrics";
+	return true;
+}
+
+void MetricsHttpServer::stop() {
+	if (!thread_.joinable()) {
+		return;
+	}
+	stop_ = true;
+	closesocket(listen_socket_); // wakes the pending accept
+	thread_.join();
+	listen_socket_ = INVALID_SOCKET;
+	WSACleanup();
+}
+
+void MetricsHttpServer::serve() {
+	ThreadScope scope("metrics_http");
+	while (!stop_.load()) {
+		SOCKET socket = accept(listen_socket_, NULL, NULL);
+		if (socket == INVALID_SOCKET) {
+			continue;
+		}
+		DWORD timeout = DEFAULT_METRICS_TIMEOUT;
+		setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char*) &timeout, sizeof(timeout));
+		setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (char*) &timeout, sizeof(timeout));
+		answer(socket);
+		shutdown(socket, SD_SEND);
+		closesocket(socket);
+	}
+}
+
+void MetricsHttpServer::answer(SOCKET socket) {
+	// only the request line matters, the headers are read and ignored
+	char request[2048];
+	int size = 0;
+	while (size < (int) sizeof(request) - 1) {
+		int retval = recv(socket, request + size, sizeof(request) - 1 - size, 0);
+		if (retval <= 0) {
+			return;
+		}
+		size += retval;
+		request[size] = '\0';
+		if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL) {
+			break;
+		}
+	}
+
+	std::string status = "200 OK";
+	std::string body;
+	if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+		body = render_();
+	} else if (strncmp(request, "GET ", 4) == 0) {
+		status = "404 Not Found";
+		body = "Not found, the metrics are on /metrics\n";
+	} else {
+		status = "405 Method Not Allowed";
+		body = "Only GET is supported\n";
+	}
+
+	std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: "
+			+ std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+	const char* data = response.data();
+	int remaining = response.size();
+	while (remaining > 0) {
+		int retval = send(socket, data, remaining, 0);
+		if (retval == SOCKET_ERROR) {
+			return;
+		}
+		data += retval;
+		remaining -= retval;
+	}
+}
+
+} /* namespace server */
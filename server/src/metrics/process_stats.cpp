@@ -0,0 +1,66 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#define PSAPI_VERSION 2 // GetProcessMemoryInfo from kernel32, without linking psapi
+
+#include "metrics/process_stats.hpp"
+
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+
+namespace server {
+
+namespace {
+
+uint64_t countThreads(DWORD process_id) {
+	HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+	if (snapshot == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+	uint64_t threads = 0;
+	THREADENTRY32 entry;
+	entry.dwSize = sizeof(entry);
+	for (BOOL found = Thread32First(snapshot, &entry); found; found = Thread32Next(snapshot, &entry)) {
+		if (entry.th32OwnerProcessID == process_id) {
+			threads++;
+		}
+	}
+	CloseHandle(snapshot);
+	return threads;
+}
+
+} // namespace
+
+ProcessStats readProcessStats() {
+	ProcessStats stats;
+	HANDLE process = GetCurrentProcess();
+	PROCESS_MEMORY_COUNTERS_EX counters;
+	if (GetProcessMemoryInfo(process, (PROCESS_MEMORY_COUNTERS*) &counters, sizeof(counters))) {
+		stats.working_set = counters.WorkingSetSize;
+		stats.peak_working_set = counters.PeakWorkingSetSize;
+		stats.private_bytes = counters.PrivateUsage;
+	}
+	DWORD handles = 0;
+	if (GetProcessHandleCount(process, &handles)) {
+		stats.handles = handles;
+	}
+	stats.threads = countThreads(GetCurrentProcessId());
+	return stats;
+}
+
+} /* namespace server */
@@ -0,0 +1,123 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "recorder/flight_recorder.hpp"
+#include "constants/default_values.hpp"
+#include "metrics/thread_stats.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace server {
+
+namespace {
+
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord is written as is in the dumps");
+static_assert((DEFAULT_RECORDER_SIZE & (DEFAULT_RECORDER_SIZE - 1)) == 0, "DEFAULT_RECORDER_SIZE must be a power of two");
+
+std::atomic<std::uint16_t> next_thread { 0 };
+thread_local std::uint16_t thread_number = ++next_thread;
+
+} // namespace
+
+FlightRecorder::FlightRecorder() : slots_(new Slot[DEFAULT_RECORDER_SIZE]) {
+}
+
+void FlightRecorder::record(RecorderStage stage, unsigned long id_client, unsigned long id_request, long code, std::size_t size) {
+	std::uint64_t n = next_.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = slots_[n & (DEFAULT_RECORDER_SIZE - 1)];
+
+	slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.record.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	slot.record.id_client = id_client;
+	slot.record.id_request = id_request;
+	slot.record.stage = stage;
+	slot.record.thread = thread_number;
+	slot.record.code = code;
+	slot.record.size = size;
+	slot.record.reserved = 0;
+	slot.sequence.store(2 * n + 2, std::memory_order_release);
+}
+
+bool FlightRecorder::dump(std::string path) {
+	std::uint64_t end = next_.load(std::memory_order_acquire);
+	std::uint64_t begin = (end > DEFAULT_RECORDER_SIZE) ? end - DEFAULT_RECORDER_SIZE : 0;
+
+	std::vector<FlightRecord> records;
+	records.reserve(end - begin);
+	for (std::uint64_t n = begin; n < end; n++) {
+		Slot& slot = slots_[n & (DEFAULT_RECORDER_SIZE - 1)];
+		std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+		FlightRecord record = slot.record;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		std::uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+		// skip the records being written or already overwritten by a newer one
+		if (before == after && before == 2 * n + 2) {
+			records.push_back(record);
+		}
+	}
+
+	FlightRecorderHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, FLIGHT_RECORDER_MAGIC, sizeof(header.magic));
+	header.version = FLIGHT_RECORDER_VERSION;
+	header.record_size = sizeof(FlightRecord);
+	std::strncpy(header.origin, "server", sizeof(header.origin));
+	header.count = records.size();
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		LOG_INFO << "Failed to write the flight recorder [path:" << path << "]";
+		return false;
+	}
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && (records.empty() || fwrite(records.data(), sizeof(FlightRecord), records.size(), file) == records.size());
+	fclose(file);
+	LOG_INFO << "Flight recorder written [path:" << path << "][records:" << records.size() << "]";
+	return written;
+}
+
+void FlightRecorder::setErrorDump(std::string path) {
+	std::lock_guard<std::mutex> guard(error_dump_mutex_);
+	error_dump_path_ = path;
+}
+
+void FlightRecorder::dumpOnError() {
+	std::string path;
+	{
+		std::lock_guard<std::mutex> guard(error_dump_mutex_);
+		std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		if (error_dump_path_.empty() || (last_error_dump_ != 0 && now - last_error_dump_ < DEFAULT_RECORDER_DUMP_INTERVAL) || dumping_.exchange(true)) {
+			return;
+		}
+		last_error_dump_ = now;
+		path = error_dump_path_;
+	}
+
+	// the request in error is not delayed by the writing of the file
+	std::thread([this, path]() {
+		ThreadScope scope("recorder_dump");
+		dump(path);
+		dumping_ = false;
+	}).detach();
+}
+
+} /* namespace server */
@@ -0,0 +1,284 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "script/script_compiler.hpp"
+#include "constants/script_opcode.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace server {
+
+ResponsePacket ScriptCompiler::compile(std::string source) {
+	program_.clear();
+	labels_.clear();
+	jumps_.clear();
+	program_.push_back(SCRIPT_FORMAT_VERSION);
+
+	std::istringstream lines(source);
+	std::string line;
+	std::string error;
+	for (int line_number = 1; std::getline(lines, line); line_number++) {
+		std::size_t comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+
+		std::istringstream words(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (words >> token) {
+			tokens.push_back(token);
+		}
+		if (tokens.empty()) {
+			continue;
+		}
+
+		if (!compileLine(tokens, &error)) {
+			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_SCRIPT, .err_server_description = "Script error at line " + std::to_string(line_number) + ": " + error };
+			return response_packet;
+		}
+	}
+	program_.push_back(OP_END);
+
+	// resolve the jumps once all the labels are known
+	for (const auto &jump : jumps_) {
+		if (labels_.find(jump.second) == labels_.end()) {
+			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_SCRIPT, .err_server_description = "Script error: unknown label " + jump.second };
+			return response_packet;
+		}
+		program_[jump.first] = (labels_.at(jump.second) >> 8) & 0xFF;
+		program_[jump.first + 1] = labels_.at(jump.second) & 0xFF;
+	}
+
+	if (program_.size() > 0xFFFF) {
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_SCRIPT, .err_server_description = "Script error: script too long" };
+		return response_packet;
+	}
+
+	LOG_DEBUG << "Script compiled [size:" << program_.size() << "]";
+	ResponsePacket response_packet = { .response = toHex(program_) };
+	return response_packet;
+}
+
+ResponsePacket ScriptCompiler::encodeParameters(int handle, std::string parameters) {
+	std::vector<unsigned char> data;
+	data.push_back((handle >> 8) & 0xFF);
+	data.push_back(handle & 0xFF);
+
+	std::string error;
+	std::size_t start = 0, end;
+	while (start < parameters.size()) {
+		end = parameters.find('|', start);
+		if (end == std::string::npos) {
+			end = parameters.size();
+		}
+
+		std::vector<unsigned char> parameter;
+		if (!parseHex(parameters.substr(start, end - start), &parameter, &error) || parameter.size() > 0xFF) {
+			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_SCRIPT, .err_server_description = "Invalid script parameter: " + parameters.substr(start, end - start) };
+			return response_packet;
+		}
+		data.push_back(parameter.size());
+		data.insert(data.end(), parameter.begin(), parameter.end());
+		start = end + 1;
+	}
+
+	ResponsePacket response_packet = { .response = toHex(data) };
+	return response_packet;
+}
+
+bool ScriptCompiler::compileLine(std::vector<std::string> tokens, std::string* error) {
+	std::string instruction = tokens[0];
+	std::transform(instruction.begin(), instruction.end(), instruction.begin(), ::toupper);
+	unsigned int operands = tokens.size() - 1;
+
+	if (instruction == "SEND" && operands >= 1) {
+		std::string command;
+		for (unsigned int i = 1; i < tokens.size(); i++) {
+			command += tokens[i] + " "; // a space ends a variable: "$1 00"
+		}
+		if (!compileCommand(command, error)) {
+			return false;
+		}
+		program_.push_back(OP_SEND);
+	} else if (instruction == "EXPECT" && operands == 1) {
+		program_.push_back(OP_EXPECT_SW);
+		return compileStatusWord(tokens[1], error);
+	} else if (instruction == "EXTRACT" && operands == 3) {
+		unsigned char variable;
+		if (!parseVariable(tokens[1], &variable, error)) {
+			return false;
+		}
+		int offset = std::atoi(tokens[2].c_str());
+		int length = std::atoi(tokens[3].c_str());
+		if (offset < 0 || offset > 0xFF || length < 0 || length > 0xFF) {
+			*error = "invalid offset or length";
+			return false;
+		}
+		program_.push_back(OP_EXTRACT);
+		program_.push_back(variable);
+		program_.push_back(offset);
+		program_.push_back(length);
+	} else if (instruction == "LABEL" && operands == 1) {
+		if (labels_.find(tokens[1]) != labels_.end()) {
+			*error = "label already defined";
+			return false;
+		}
+		labels_[tokens[1]] = program_.size();
+	} else if (instruction == "JUMP" && operands == 1) {
+		program_.push_back(OP_JUMP);
+		jumps_.push_back(std::make_pair(program_.size(), tokens[1]));
+		emitAddress(0);
+	} else if ((instruction == "JUMPIF" || instruction == "JUMPIFNOT") && operands == 2) {
+		program_.push_back(instruction == "JUMPIF" ? OP_JUMP_IF_SW : OP_JUMP_IF_NOT_SW);
+		if (!compileStatusWord(tokens[1], error)) {
+			return false;
+		}
+		jumps_.push_back(std::make_pair(program_.size(), tokens[2]));
+		emitAddress(0);
+	} else if (instruction == "COLD_RESET" && operands == 0) {
+		program_.push_back(OP_COLD_RESET);
+	} else if (instruction == "WARM_RESET" && operands == 0) {
+		program_.push_back(OP_WARM_RESET);
+	} else if (instruction == "END" && operands == 0) {
+		program_.push_back(OP_END);
+	} else {
+		*error = "unknown instruction or wrong number of operands: " + tokens[0];
+		return false;
+	}
+	return true;
+}
+
+bool ScriptCompiler::compileCommand(std::string command, std::string* error) {
+	std::vector<unsigned char> literal;
+	std::size_t i = 0;
+	while (i <= command.size()) {
+		bool variable = i < command.size() && command[i] == '$';
+
+		// literal bytes are flushed before a variable and at the end of the command
+		if (variable || i == command.size()) {
+			std::vector<unsigned char> bytes;
+			if (!parseHex(std::string(literal.begin(), literal.end()), &bytes, error)) {
+				return false;
+			}
+			for (std::size_t chunk = 0; chunk < bytes.size(); chunk += 0xFF) {
+				std::size_t size = std::min<std::size_t>(0xFF, bytes.size() - chunk);
+				program_.push_back(OP_APPEND);
+				program_.push_back(size);
+				program_.insert(program_.end(), bytes.begin() + chunk, bytes.begin() + chunk + size);
+			}
+			literal.clear();
+		}
+		if (i == command.size()) {
+			break;
+		}
+
+		if (variable) {
+			std::size_t end = i + 1;
+			while (end < command.size() && std::isdigit((unsigned char) command[end])) {
+				end++;
+			}
+			unsigned char index;
+			if (!parseVariable(command.substr(i, end - i), &index, error)) {
+				return false;
+			}
+			program_.push_back(OP_APPEND_VAR);
+			program_.push_back(index);
+			i = end;
+		} else {
+			if (!std::isspace((unsigned char) command[i])) {
+				literal.push_back(command[i]);
+			}
+			i++;
+		}
+	}
+	return true;
+}
+
+bool ScriptCompiler::compileStatusWord(std::string status_word, std::string* error) {
+	if (status_word.size() != 4) {
+		*error = "invalid status word: " + status_word;
+		return false;
+	}
+
+	unsigned char mask = 0;
+	unsigned char sw[2] = { 0, 0 };
+	for (int i = 0; i < 2; i++) {
+		std::string byte = status_word.substr(i * 2, 2);
+		if (byte == "XX" || byte == "xx") {
+			continue; // any value matches
+		}
+		std::vector<unsigned char> bytes;
+		if (!parseHex(byte, &bytes, error)) {
+			return false;
+		}
+		sw[i] = bytes[0];
+		mask |= (i == 0) ? SCRIPT_SW1_MASK : SCRIPT_SW2_MASK;
+	}
+
+	program_.push_back(sw[0]);
+	program_.push_back(sw[1]);
+	program_.push_back(mask);
+	return true;
+}
+
+bool ScriptCompiler::parseVariable(std::string token, unsigned char* variable, std::string* error) {
+	if (token.size() < 2 || token[0] != '$' || !std::all_of(token.begin() + 1, token.end(), ::isdigit)) {
+		*error = "invalid variable: " + token;
+		return false;
+	}
+	int index = std::atoi(token.c_str() + 1);
+	if (index >= SCRIPT_MAX_VARIABLES) {
+		*error = "variable out of range: " + token;
+		return false;
+	}
+	*variable = index;
+	return true;
+}
+
+bool ScriptCompiler::parseHex(std::string hex, std::vector<unsigned char>* bytes, std::string* error) {
+	hex.erase(std::remove_if(hex.begin(), hex.end(), ::isspace), hex.end());
+	if (hex.size() % 2 != 0 || !std::all_of(hex.begin(), hex.end(), ::isxdigit)) {
+		*error = "invalid hexadecimal data: " + hex;
+		return false;
+	}
+	for (std::size_t i = 0; i < hex.size(); i += 2) {
+		bytes->push_back(std::stoi(hex.substr(i, 2), NULL, 16));
+	}
+	return true;
+}
+
+void ScriptCompiler::emitAddress(unsigned int address) {
+	program_.push_back((address >> 8) & 0xFF);
+	program_.push_back(address & 0xFF);
+}
+
+std::string ScriptCompiler::toHex(std::vector<unsigned char> bytes) {
+	static const char digits[] = "0123456789ABCDEF";
+	std::string hex;
+	hex.reserve(bytes.size() * 2);
+	for (unsigned char byte : bytes) {
+		hex.push_back(digits[byte >> 4]);
+		hex.push_back(digits[byte & 0x0F]);
+	}
+	return hex;
+}
+
+} /* namespace server */
@@ -0,0 +1,185 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "server/client_connection.hpp"
+#include "server/message_codec.hpp"
+#include "constants/default_values.hpp"
+#include "metrics/thread_stats.hpp"
+#include "nlohmann/json.hpp"
+#include "plog/include/plog/Log.h"
+
+#include <utility>
+
+namespace server {
+
+ClientConnection::ClientConnection(SOCKET socket, ServerTCPSocket* tcp_socket) {
+	this->socket_ = socket;
+	this->tcp_socket_ = tcp_socket;
+}
+
+ClientConnection::~ClientConnection() {
+	close();
+}
+
+void ClientConnection::setEventHandler(std::function<void(nlohmann::json jevent)> on_event) {
+	on_event_ = on_event;
+}
+
+void ClientConnection::start() {
+	// the receiver waits for responses as long as the connection is alive
+	DWORD no_timeout = 0;
+	if (setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, (char*) &no_timeout, sizeof(no_timeout)) < 0) {
+		LOG_DEBUG << "Failed to call setsockopt() " << "[socket:" << socket_ << "][WSAError:" << WSAGetLastError() << "]";
+	}
+	receiver_thread_ = std::thread(&ClientConnection::receiveResponses, this);
+}
+
+void ClientConnection::close() {
+	if (std::this_thread::get_id() == receiver_thread_.get_id()) {
+		LOG_DEBUG << "Connection closed from its receiver thread, the thread is joined by its owner [socket:" << socket_ << "]";
+		closed_ = true;
+		shutdown(socket_, SD_BOTH);
+		return;
+	}
+
+	// stopClient, the handshakes and the destructor may close the connection at the same time
+	std::call_once(teardown_flag_, [this]() {
+		closed_ = true;
+		shutdown(socket_, SD_BOTH);
+		if (receiver_thread_.joinable()) {
+			receiver_thread_.join();
+			closesocket(socket_);
+		}
+	});
+}
+
+std::future<ResponsePacket> ClientConnection::sendRequest(unsigned long id, std::string to_send, long long* sent_at) {
+	std::promise<ResponsePacket> promise;
+	std::future<ResponsePacket> future = promise.get_future();
+
+	{
+		std::lock_guard<InstrumentedMutex> guard(pending_mutex_);
+		if (closed_.load()) {
+			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on send request" };
+			promise.set_value(response_packet);
+			return future;
+		}
+		pending_.insert(std::make_pair(id, std::move(promise)));
+	}
+
+	bool sent;
+	{
+		std::lock_guard<InstrumentedMutex> guard(send_mutex_);
+		if (sent_at != NULL) {
+			*sent_at = timingNow();
+		}
+		sent = tcp_socket_->sendPacket(socket_, to_send.c_str());
+	}
+	if (!sent) {
+		std::lock_guard<InstrumentedMutex> guard(pending_mutex_);
+		auto it = pending_.find(id);
+		if (it != pending_.end()) {
+			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on send request" };
+			it->second.set_value(response_packet);
+			pending_.erase(it);
+		}
+		return future;
+	}
+	LOG_INFO << "Data sent to client: " << to_send.c_str();
+	return future;
+}
+
+void ClientConnection::abandon(unsigned long id) {
+	std::lock_guard<InstrumentedMutex> guard(pending_mutex_);
+	pending_.erase(id);
+}
+
+SOCKET ClientConnection::getSocket() {
+	return socket_;
+}
+
+bool ClientConnection::isClosed() {
+	return closed_.load();
+}
+
+void ClientConnection::receiveResponses() {
+	ThreadScope scope("connection_receiver");
+	char recvbuf[DEFAULT_BUFLEN];
+	nlohmann::json jresponse;
+
+	while (tcp_socket_->receivePacket(socket_, recvbuf) == RES_SOCKET_OK) {
+		long long received = timingNow();
+
+		// responses of the fixed schema are decoded without building a json document
+		ResponsePacket response_packet;
+		unsigned long id;
+		if (decodeResponse(recvbuf, &response_packet, &id)) {
+			response_packet.timing.server_receive = received;
+			completePending(id, response_packet);
+			continue;
+		}
+
+		try {
+			jresponse = nlohmann::json::parse(recvbuf);
+		} catch (json::parse_error &err) {
+			LOG_DEBUG << "Error while parsing the response [recvbuf:" << recvbuf << "]";
+			continue;
+		}
+
+		// events are not answers to a request
+		if (jresponse.find("event") != jresponse.end()) {
+			if (on_event_) {
+				on_event_(jresponse);
+			}
+			continue;
+		}
+
+		try {
+			response_packet = jresponse.get<ResponsePacket>();
+		} catch (json::exception &err) {
+			response_packet = { .response = "KO", .err_client_code = ERR_JSON_PARSING, .err_client_description = "Error while parsing the request" };
+		}
+		response_packet.timing.server_receive = received;
+		completePending(jresponse.value("id", 0UL), response_packet);
+	}
+
+	LOG_DEBUG << "Connection closed [socket:" << socket_ << "]";
+	closed_ = true;
+	ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on receive" };
+	failPending(response_packet);
+}
+
+void ClientConnection::completePending(unsigned long id, ResponsePacket response_packet) {
+	std::lock_guard<InstrumentedMutex> guard(pending_mutex_);
+	auto it = pending_.find(id);
+	if (it == pending_.end()) {
+		LOG_DEBUG << "Response dropped, no request waiting for it [id:" << id << "]";
+		return;
+	}
+	it->second.set_value(response_packet);
+	pending_.erase(it);
+}
+
+void ClientConnection::failPending(ResponsePacket response_packet) {
+	std::lock_guard<InstrumentedMutex> guard(pending_mutex_);
+	for (auto &p : pending_) {
+		p.second.set_value(response_packet);
+	}
+	pending_.clear();
+}
+
+} /* namespace server */
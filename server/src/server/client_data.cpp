@@ -37,6 +37,22 @@ SOCKET ClientData::getSocket() {
 	return socket_;
 }
 
+std::string ClientData::getToken() {
+	return token_;
+}
+
+std::shared_ptr<ClientConnection> ClientData::getConnection() {
+	return connection_;
+}
+
+int ClientData::getChannel() {
+	return channel_;
+}
+
+std::shared_ptr<RequestStats> ClientData::getStats() {
+	return stats_;
+}
+
 void ClientData::setId(int id) {
 	this->id_ = id;
 }
@@ -49,4 +65,16 @@ void ClientData::setSocket(SOCKET socket) {
 	this->socket_ = socket;
 }
 
+void ClientData::setToken(std::string token) {
+	this->token_ = token;
+}
+
+void ClientData::setConnection(std::shared_ptr<ClientConnection> connection) {
+	this->connection_ = connection;
+}
+
+void ClientData::setChannel(int channel) {
+	this->channel_ = channel;
+}
+
 } /* namespace server */
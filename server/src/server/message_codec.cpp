@@ -0,0 +1,395 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+#include "server/message_codec.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace server {
+
+namespace {
+
+/**
+ * Scanner - cursor over a json text.
+ * Each method returns false on input the fixed-schema decoder does not handle, the caller then falls back to nlohmann.
+ */
+class Scanner {
+private:
+	const char* current_;
+	const char* end_;
+public:
+	Scanner(const char* begin, const char* end) : current_(begin), end_(end) {}
+
+	void skipSpaces() {
+		while (current_ < end_ && (*current_ == ' ' || *current_ == '\t' || *current_ == '\n' || *current_ == '\r')) {
+			current_++;
+		}
+	}
+
+	bool consume(char expected) {
+		skipSpaces();
+		if (current_ < end_ && *current_ == expected) {
+			current_++;
+			return true;
+		}
+		return false;
+	}
+
+	bool atEnd() {
+		skipSpaces();
+		return current_ == end_;
+	}
+
+	/**
+	 * readKey - read a key without escapes in place.
+	 */
+	bool readKey(const char** key, std::size_t* length) {
+		if (!consume('"')) {
+			return false;
+		}
+		const char* begin = current_;
+		while (current_ < end_ && *current_ != '"') {
+			if (*current_ == '\\') {
+				return false;
+			}
+			current_++;
+		}
+		if (current_ == end_) {
+			return false;
+		}
+		*key = begin;
+		*length = current_++ - begin;
+		return consume(':');
+	}
+
+	bool readString(std::string* value) {
+		if (!consume('"')) {
+			return false;
+		}
+		value->clear();
+		while (current_ < end_) {
+			const char* run = current_;
+			while (current_ < end_ && *current_ != '"' && *current_ != '\\' && (unsigned char) *current_ >= 0x20) {
+				current_++;
+			}
+			value->append(run, current_ - run);
+			if (current_ == end_ || (unsigned char) *current_ < 0x20) {
+				return false;
+			}
+			if (*current_++ == '"') {
+				return true;
+			}
+			if (current_ == end_) {
+				return false;
+			}
+			char escaped = *current_++;
+			switch (escaped) {
+			case '"':
+			case '\\':
+			case '/':
+				value->push_back(escaped);
+				break;
+			case 'b':
+				value->push_back('\b');
+				break;
+			case 'f':
+				value->push_back('\f');
+				break;
+			case 'n':
+				value->push_back('\n');
+				break;
+			case 'r':
+				value->push_back('\r');
+				break;
+			case 't':
+				value->push_back('\t');
+				break;
+			case 'u':
+				if (!readCodePoint(value)) {
+					return false;
+				}
+				break;
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+
+	template<typename T>
+	bool readInteger(T* value) {
+		skipSpaces();
+		bool negative = current_ < end_ && *current_ == '-';
+		if (negative) {
+			current_++;
+		}
+		if (current_ == end_ || *current_ < '0' || *current_ > '9') {
+			return false;
+		}
+		if (*current_ == '0' && current_ + 1 < end_ && current_[1] >= '0' && current_[1] <= '9') {
+			return false; // leading zeros are not valid json
+		}
+		unsigned long long magnitude = 0;
+		int digits = 0;
+		while (current_ < end_ && *current_ >= '0' && *current_ <= '9') {
+			if (++digits > 18) {
+				return false;
+			}
+			magnitude = magnitude * 10 + (*current_++ - '0');
+		}
+		if (current_ < end_ && (*current_ == '.' || *current_ == 'e' || *current_ == 'E')) {
+			return false;
+		}
+		long long signed_value = negative ? -(long long) magnitude : (long long) magnitude;
+		if (signed_value < (long long) std::numeric_limits<T>::min() || (!negative && magnitude > (unsigned long long) std::numeric_limits<T>::max())) {
+			return false;
+		}
+		*value = (T) signed_value;
+		return true;
+	}
+private:
+	bool readCodePoint(std::string* value) {
+		if (end_ - current_ < 4) {
+			return false;
+		}
+		unsigned int code = 0;
+		for (int i = 0; i < 4; i++) {
+			char digit = *current_++;
+			code <<= 4;
+			if (digit >= '0' && digit <= '9') {
+				code |= digit - '0';
+			} else if (digit >= 'a' && digit <= 'f') {
+				code |= digit - 'a' + 10;
+			} else if (digit >= 'A' && digit <= 'F') {
+				code |= digit - 'A' + 10;
+			} else {
+				return false;
+			}
+		}
+		if (code >= 0xD800 && code <= 0xDFFF) {
+			return false; // surrogate pairs are left to nlohmann
+		}
+		if (code < 0x80) {
+			value->push_back((char) code);
+		} else if (code < 0x800) {
+			value->push_back((char) (0xC0 | (code >> 6)));
+			value->push_back((char) (0x80 | (code & 0x3F)));
+		} else {
+			value->push_back((char) (0xE0 | (code >> 12)));
+			value->push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+			value->push_back((char) (0x80 | (code & 0x3F)));
+		}
+		return true;
+	}
+};
+
+inline bool isKey(const char* key, std::size_t length, const char* expected) {
+	return std::strlen(expected) == length && std::memcmp(key, expected, length) == 0;
+}
+
+inline void appendUnsigned(std::string* text, unsigned long long value) {
+	char buffer[24];
+	char* position = buffer + sizeof(buffer);
+	do {
+		*--position = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	text->append(position, buffer + sizeof(buffer) - position);
+}
+
+inline void appendInteger(std::string* text, long long value) {
+	if (value < 0) {
+		text->push_back('-');
+		appendUnsigned(text, 0ULL - (unsigned long long) value);
+	} else {
+		appendUnsigned(text, (unsigned long long) value);
+	}
+}
+
+/**
+ * appendString - append a json string escaped the way nlohmann does.
+ */
+inline void appendString(std::string* text, const std::string& value) {
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	text->push_back('"');
+	const char* run = value.data();
+	const char* end = run + value.size();
+	for (const char* current = run; current < end; current++) {
+		unsigned char byte = (unsigned char) *current;
+		if (byte >= 0x20 && byte != '"' && byte != '\\') {
+			continue;
+		}
+		text->append(run, current - run);
+		run = current + 1;
+		switch (byte) {
+		case '"':
+			text->append("\\\"", 2);
+			break;
+		case '\\':
+			text->append("\\\\", 2);
+			break;
+		case '\b':
+			text->append("\\b", 2);
+			break;
+		case '\f':
+			text->append("\\f", 2);
+			break;
+		case '\n':
+			text->append("\\n", 2);
+			break;
+		case '\r':
+			text->append("\\r", 2);
+			break;
+		case '\t':
+			text->append("\\t", 2);
+			break;
+		default:
+			char escaped[6] = { '\\', 'u', '0', '0', HEX_DIGITS[byte >> 4], HEX_DIGITS[byte & 0x0F] };
+			text->append(escaped, sizeof(escaped));
+			break;
+		}
+	}
+	text->append(run, end - run);
+	text->push_back('"');
+}
+
+/**
+ * scanDescription - read a description sent as a text, the interned descriptions reference their static text.
+ */
+inline bool scanDescription(Scanner* scanner, std::string* text, Description* description) {
+	if (!scanner->readString(text)) {
+		return false;
+	}
+	int id = findInternedDescription(text->c_str(), text->size());
+	*description = id >= 0 ? internedDescription(id) : Description(*text);
+	return true;
+}
+
+/**
+ * scanDescriptionId - read a description sent by its index in INTERNED_DESCRIPTIONS.
+ */
+inline bool scanDescriptionId(Scanner* scanner, Description* description) {
+	int id;
+	if (!scanner->readInteger(&id)) {
+		return false;
+	}
+	*description = internedDescription(id);
+	return true;
+}
+
+/**
+ * scanTiming - read the client's instants sent as [terminal_start, terminal_end, client_send].
+ */
+inline bool scanTiming(Scanner* scanner, RequestTiming* timing) {
+	return scanner->consume('[') && scanner->readInteger(&timing->terminal_start) && scanner->consume(',') && scanner->readInteger(&timing->terminal_end)
+			&& scanner->consume(',') && scanner->readInteger(&timing->client_send) && scanner->consume(']');
+}
+
+} // namespace
+
+void encodeRequest(unsigned long id, int request, const std::string& data, DWORD timeout, int channel, bool timing, std::string* text) {
+	text->clear();
+	text->push_back('{');
+	if (channel >= 0) {
+		text->append("\"channel\":");
+		appendInteger(text, channel);
+		text->push_back(',');
+	}
+	text->append("\"data\":");
+	appendString(text, data);
+	text->append(",\"id\":");
+	appendUnsigned(text, id);
+	text->append(",\"request\":");
+	appendInteger(text, request);
+	text->append(",\"timeout\":");
+	appendUnsigned(text, timeout);
+	if (timing) {
+		text->append(",\"timing\":true");
+	}
+	text->push_back('}');
+}
+
+bool decodeResponse(const char* text, ResponsePacket* response_packet, unsigned long* id) {
+	thread_local std::string description; // descriptions are mostly interned and then not copied
+	Scanner scanner(text, text + std::strlen(text));
+	int channel;
+	*id = 0;
+	*response_packet = ResponsePacket(); // compact responses omit the fields holding their default value
+
+	if (!scanner.consume('{')) {
+		return false;
+	}
+	if (!scanner.consume('}')) {
+		do {
+			const char* key;
+			std::size_t length;
+			if (!scanner.readKey(&key, &length)) {
+				return false;
+			}
+			bool valid;
+			if (isKey(key, length, "response")) {
+				valid = scanner.readString(&response_packet->response);
+			} else if (isKey(key, length, "err_server_code")) {
+				valid = scanner.readInteger(&response_packet->err_server_code);
+			} else if (isKey(key, length, "err_server_description")) {
+				valid = scanDescription(&scanner, &description, &response_packet->err_server_description);
+			} else if (isKey(key, length, "err_server_description_id")) {
+				valid = scanDescriptionId(&scanner, &response_packet->err_server_description);
+			} else if (isKey(key, length, "err_client_code")) {
+				valid = scanner.readInteger(&response_packet->err_client_code);
+			} else if (isKey(key, length, "client_description")) {
+				valid = scanDescription(&scanner, &description, &response_packet->err_client_description);
+			} else if (isKey(key, length, "client_description_id")) {
+				valid = scanDescriptionId(&scanner, &response_packet->err_client_description);
+			} else if (isKey(key, length, "err_terminal_code")) {
+				valid = scanner.readInteger(&response_packet->err_terminal_code);
+			} else if (isKey(key, length, "terminal_description")) {
+				valid = scanDescription(&scanner, &description, &response_packet->err_terminal_description);
+			} else if (isKey(key, length, "terminal_description_id")) {
+				valid = scanDescriptionId(&scanner, &response_packet->err_terminal_description);
+			} else if (isKey(key, length, "err_card_code")) {
+				valid = scanner.readInteger(&response_packet->err_card_code);
+			} else if (isKey(key, length, "err_card_description")) {
+				valid = scanDescription(&scanner, &description, &response_packet->err_card_description);
+			} else if (isKey(key, length, "err_card_description_id")) {
+				valid = scanDescriptionId(&scanner, &response_packet->err_card_description);
+			} else if (isKey(key, length, "transcript")) {
+				valid = scanner.readString(&response_packet->transcript);
+			} else if (isKey(key, length, "timing")) {
+				valid = scanTiming(&scanner, &response_packet->timing);
+			} else if (isKey(key, length, "id")) {
+				valid = scanner.readInteger(id);
+			} else if (isKey(key, length, "channel")) {
+				valid = scanner.readInteger(&channel);
+			} else {
+				return false; // unknown field, events among others
+			}
+			if (!valid) {
+				return false;
+			}
+		} while (scanner.consume(','));
+		if (!scanner.consume('}')) {
+			return false;
+		}
+	}
+	return scanner.atEnd();
+}
+
+} /* namespace server */
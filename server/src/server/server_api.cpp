@@ -17,16 +17,23 @@
 
 #include "constants/request_code.hpp"
 #include "constants/response_packet.hpp"
+#include "metrics/thread_stats.hpp"
+#include "recorder/flight_recorder.hpp"
 #include "server/server_api.hpp"
 #include "server/server_engine.hpp"
+#include "script/script_compiler.hpp"
 #include "nlohmann/json.hpp"
 
 #include "plog/include/plog/Log.h"
 #include "plog/include/plog/Appenders/ColorConsoleAppender.h"
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
 
 namespace server {
 
@@ -52,18 +59,34 @@ ResponsePacket ServerAPI::sendCommand(int id_client, std::string command, DWORD
 	return engine_->handleRequest(id_client, REQ_COMMAND, true, timeout, command);
 }
 
+ResponsePacket ServerAPI::sendCommand(int id_client, const Apdu& command, DWORD timeout) {
+	return engine_->handleRequest(id_client, REQ_COMMAND, true, timeout, command.toHex());
+}
+
 ResponsePacket ServerAPI::sendTypeA(int id_client, std::string command, DWORD timeout) {
 	return engine_->handleRequest(id_client, REQ_COMMAND_A, true, timeout, command);
 }
 
+ResponsePacket ServerAPI::sendTypeA(int id_client, const Apdu& command, DWORD timeout) {
+	return engine_->handleRequest(id_client, REQ_COMMAND_A, true, timeout, command.toHex());
+}
+
 ResponsePacket ServerAPI::sendTypeB(int id_client, std::string command, DWORD timeout) {
 	return engine_->handleRequest(id_client, REQ_COMMAND_B, true, timeout, command);
 }
 
+ResponsePacket ServerAPI::sendTypeB(int id_client, const Apdu& command, DWORD timeout) {
+	return engine_->handleRequest(id_client, REQ_COMMAND_B, true, timeout, command.toHex());
+}
+
 ResponsePacket ServerAPI::sendTypeF(int id_client, std::string command, DWORD timeout) {
 	return engine_->handleRequest(id_client, REQ_COMMAND_F, true, timeout, command);
 }
 
+ResponsePacket ServerAPI::sendTypeF(int id_client, const Apdu& command, DWORD timeout) {
+	return engine_->handleRequest(id_client, REQ_COMMAND_F, true, timeout, command.toHex());
+}
+
 ResponsePacket ServerAPI::restartTarget(int id_client, DWORD timeout) {
 	return engine_->handleRequest(id_client, REQ_RESTART, timeout);
 }
@@ -76,6 +99,22 @@ ResponsePacket ServerAPI::diagClient(int id_client, DWORD timeout) {
 	return engine_->handleRequest(id_client, REQ_DIAG, timeout);
 }
 
+ResponsePacket ServerAPI::diagClientState(int id_client, DWORD timeout, TerminalState* state) {
+	ResponsePacket response = engine_->handleRequest(id_client, REQ_DIAG, true, timeout, "01");
+	if (response.err_server_code < 0 || response.err_client_code < 0 || response.err_terminal_code < 0 || response.err_card_code < 0) {
+		return response;
+	}
+
+	try {
+		*state = nlohmann::json::parse(response.response).get<TerminalState>();
+	} catch (json::exception &err) {
+		LOG_DEBUG << "Error while parsing the terminal state [response:" << response.response << "]";
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_JSON_PARSING, .err_server_description = "Error while parsing the terminal state" };
+		return response_packet;
+	}
+	return response;
+}
+
 ResponsePacket ServerAPI::stopClient(int id_client, DWORD timeout) {
 	ResponsePacket response = engine_->handleRequest(id_client, REQ_DISCONNECT, false, timeout);
 	if (response.err_server_code == ERR_NETWORK) {
@@ -101,6 +140,123 @@ ResponsePacket ServerAPI::powerONField(int id_client, DWORD timeout) {
 	return engine_->handleRequest(id_client, REQ_POWER_ON_FIELD, true, timeout);
 }
 
+ResponsePacket ServerAPI::loadScript(int id_client, std::string script, DWORD timeout) {
+	ScriptCompiler compiler;
+	ResponsePacket program = compiler.compile(script);
+	if (program.err_server_code < 0) {
+		return program;
+	}
+	return engine_->handleRequest(id_client, REQ_SCRIPT_LOAD, true, timeout, program.response);
+}
+
+ResponsePacket ServerAPI::runScript(int id_client, int handle, std::string parameters, DWORD timeout) {
+	ScriptCompiler compiler;
+	ResponsePacket data = compiler.encodeParameters(handle, parameters);
+	if (data.err_server_code < 0) {
+		return data;
+	}
+	return engine_->handleRequest(id_client, REQ_SCRIPT_RUN, true, timeout, data.response);
+}
+
+ResponsePacket ServerAPI::pollEvent(DWORD timeout) {
+	return engine_->pollEvent(timeout);
+}
+
+std::vector<ResponsePacket> ServerAPI::sendBatch(const std::vector<BatchRequest>& requests, DWORD timeout) {
+	std::vector<ResponsePacket> responses(requests.size());
+
+	// the requests of a client are sent one after the other on its socket
+	std::map<int, std::vector<std::size_t>> by_client;
+	for (std::size_t i = 0; i < requests.size(); i++) {
+		by_client[requests[i].id_client].push_back(i);
+	}
+	std::vector<const std::vector<std::size_t>*> groups;
+	for (const auto &p : by_client) {
+		groups.push_back(&p.second);
+	}
+
+	std::atomic<std::size_t> next_group { 0 };
+	auto serve = [&]() {
+		ThreadScope scope("batch_worker");
+		for (std::size_t group = next_group++; group < groups.size(); group = next_group++) {
+			for (std::size_t i : *groups[group]) {
+				responses[i] = sendRequest(requests[i], timeout);
+			}
+		}
+	};
+
+	std::size_t workers = std::min<std::size_t>(groups.size(), DEFAULT_BATCH_WORKERS);
+	std::vector<std::thread> threads;
+	for (std::size_t i = 1; i < workers; i++) {
+		threads.emplace_back(serve);
+	}
+	serve();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	return responses;
+}
+
+ResponsePacket ServerAPI::sendRequest(const BatchRequest& request, DWORD timeout) {
+	switch (request.request) {
+	case REQ_DIAG:
+		return diagClient(request.id_client, timeout);
+	case REQ_DISCONNECT:
+		return stopClient(request.id_client, timeout);
+	case REQ_ECHO:
+		return echoClient(request.id_client, timeout);
+	case REQ_RESTART:
+		return restartTarget(request.id_client, timeout);
+	case REQ_COMMAND:
+		return sendCommand(request.id_client, request.data, timeout);
+	case REQ_COMMAND_A:
+		return sendTypeA(request.id_client, request.data, timeout);
+	case REQ_COMMAND_B:
+		return sendTypeB(request.id_client, request.data, timeout);
+	case REQ_COMMAND_F:
+		return sendTypeF(request.id_client, request.data, timeout);
+	case REQ_COLD_RESET:
+		return coldReset(request.id_client, timeout);
+	case REQ_WARM_RESET:
+		return warmReset(request.id_client, timeout);
+	case REQ_POWER_OFF_FIELD:
+		return powerOFFField(request.id_client, timeout);
+	case REQ_POWER_ON_FIELD:
+		return powerONField(request.id_client, timeout);
+	case REQ_SCRIPT_LOAD:
+		return loadScript(request.id_client, request.data, timeout);
+	case REQ_SCRIPT_RUN: {
+		std::size_t separator = request.data.find('|');
+		std::string parameters = (separator == std::string::npos) ? "" : request.data.substr(separator + 1);
+		return runScript(request.id_client, std::atoi(request.data.substr(0, separator).c_str()), parameters, timeout);
+	}
+	default:
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_INVALID_STATE, .err_server_description = "Request not allowed in a batch" };
+		return response_packet;
+	}
+}
+
+ResponsePacket ServerAPI::reloadConfig(std::string source) {
+	return engine_->reloadConfig(source);
+}
+
+ResponsePacket ServerAPI::dumpFlightRecorder(std::string path) {
+	if (!FlightRecorder::getInstance().dump(path)) {
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_INVALID_STATE, .err_server_description = "Failed to write the flight recorder" };
+		return response_packet;
+	}
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+ResponsePacket ServerAPI::getStageTimings() {
+	return engine_->getStageTimings();
+}
+
+ResponsePacket ServerAPI::getStats() {
+	return engine_->getStats();
+}
+
 ResponsePacket ServerAPI::stopServer() {
 	return engine_->stopAllClients();
 }
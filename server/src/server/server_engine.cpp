@@ -16,21 +16,29 @@
  *********************************************************************************/
 
 #include "server/client_data.hpp"
+#include "server/message_codec.hpp"
 #include "server/server_engine.hpp"
 #include "config/config_wrapper.hpp"
 #include "constants/default_values.hpp"
 #include "constants/request_code.hpp"
 #include "constants/response_packet.hpp"
 #include "logger/logger.hpp"
+#include "metrics/metrics_format.hpp"
+#include "metrics/process_stats.hpp"
+#include "metrics/thread_stats.hpp"
 #include "nlohmann/json.hpp"
 #include "plog/include/plog/Log.h"
 #include "plog/include/plog/Appenders/ColorConsoleAppender.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <future>
 #include <iostream>
 #include <map>
+#include <random>
+#include <sstream>
+#include <iomanip>
 #include <stdio.h>
 #include <stdlib.h>
 #include <thread>
@@ -43,16 +51,32 @@ ResponsePacket ServerEngine::initServer(std::string path) {
 		return response_packet;
 	}
 
-	socket_ = new ServerTCPSocket();
-	if ((path.size() > 1) && (path.at(0) == '{'))
-	{
-		config_.initFromJson(path);
-	}
-	else
-	{
-		config_.init(path);
+	try {
+		if ((path.size() > 1) && (path.at(0) == '{'))
+		{
+			config_.initFromJson(path);
+		}
+		else
+		{
+			config_.init(path);
+		}
+	} catch (std::exception &err) {
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_JSON_PARSING, .err_server_description = "Error while reading the configuration" };
+		return response_packet;
 	}
+	socket_ = new ServerTCPSocket();
 	logger::setup(&config_);
+	recorder_.setErrorDump(config_.getValue("recorder_dump_on_error", DEFAULT_RECORDER_DUMP_ON_ERROR).compare("true") == 0 ? config_.getValue("recorder_file", DEFAULT_RECORDER_FILE) : "");
+
+	// the locks and the threads are measured for the whole process, the threads already running are not registered
+	if (config_.getValue("contention_stats", DEFAULT_CONTENTION_STATS).compare("true") == 0) {
+		LockRegistry::setEnabled(true);
+		ThreadRegistry::setEnabled(true);
+		long interval = std::stol(config_.getValue("contention_report_interval", DEFAULT_CONTENTION_REPORT_INTERVAL));
+		if (interval > 0) {
+			contention_reporter_.start(std::chrono::seconds(interval));
+		}
+	}
 
 	// launch engine
 	LOG_INFO << "Server launched";
@@ -77,6 +101,15 @@ ResponsePacket ServerEngine::startListening(const char* ip, const char* port) {
 	stop_ = false;
 	LOG_INFO << "Start listening on IP " << ip << " and port " << port;
 
+	// the metrics endpoint is optional and does not prevent the server from starting
+	std::string metrics_port = config_.getValue("metrics_port", DEFAULT_METRICS_PORT);
+	if (!metrics_port.empty()) {
+		std::string metrics_ip = config_.getValue("metrics_ip", DEFAULT_METRICS_IP);
+		if (!metrics_server_.start(metrics_ip.c_str(), metrics_port.c_str(), [this] { return renderMetrics(); })) {
+			LOG_WARNING << "Failed to serve the metrics on IP " << metrics_ip << " and port " << metrics_port;
+		}
+	}
+
 	// launch a thread to handle incoming connections
 	std::thread thr(&ServerEngine::handleConnections, this);
 	std::swap(thr, connection_thread_);
@@ -86,13 +119,13 @@ ResponsePacket ServerEngine::startListening(const char* ip, const char* port) {
 }
 
 ResponsePacket ServerEngine::handleConnections() {
-	int default_timeout = std::atoi(config_.getValue("timeout", DEFAULT_SOCKET_TIMEOUT).c_str());
+	ThreadScope scope("connection_listener");
 	std::future<ResponsePacket> future_connection;
 	while (!stop_.load()) {
 		SOCKET client_socket = INVALID_SOCKET;
 
 		// accept incoming connection
-		if (!socket_->acceptConnection(&client_socket, default_timeout)) {
+		if (!socket_->acceptConnection(&client_socket, config_.getConfig()->timeout)) {
 			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Connection with client failed" };
 			return response_packet;
 		}
@@ -106,6 +139,7 @@ ResponsePacket ServerEngine::handleConnections() {
 }
 
 ResponsePacket ServerEngine::connectionHandshake(SOCKET client_socket) {
+	ThreadScope scope("connection_handshake");
 	ResponsePacket response_packet;
 	char client_name[DEFAULT_BUFLEN];
 
@@ -115,13 +149,21 @@ ResponsePacket ServerEngine::connectionHandshake(SOCKET client_socket) {
 		return response_packet;
 	}
 
+	// clients supporting session resumption send a json handshake
+	std::string handshake(client_name);
+	if ((handshake.size() > 1) && (handshake.at(0) == '{')) {
+		return resumableHandshake(client_socket, handshake);
+	}
+
 	ClientData* client = new ClientData(client_socket, ++next_client_id_, client_name);
 	LOG_INFO << "Client connected [id:" << client->getId() << "][name:" << client->getName() << "]";
+	recorder_.record(STAGE_CLIENT_CONNECTED, client->getId(), 0);
+	connections_.fetch_add(1, std::memory_order_relaxed);
 	if (notifyConnectionAccepted_ != 0)  {
 		notifyConnectionAccepted_(client->getId(), client->getName().c_str());
 	}
 
-    std::lock_guard<std::mutex> guard(insert_client_mutex_);
+    std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
 	clients_.insert(std::make_pair(client->getId(), client));
 
 	return response_packet;
@@ -133,32 +175,90 @@ ResponsePacket ServerEngine::handleRequest(int id_client, RequestCode request, b
 		return response_packet;
 	}
 
-	if (clients_.find(id_client) == clients_.end()) {
+	long long submitted = timingNow();
+	SOCKET client_socket = INVALID_SOCKET;
+	std::shared_ptr<ClientConnection> connection;
+	int channel = 0;
+	std::shared_ptr<RequestStats> client_stats;
+	if (!findClient(id_client, &client_socket, &connection, &channel, &client_stats)) {
 		LOG_DEBUG << "Failed to retrieve client [id_client:" << id_client << "][request:" << requestCodeToString(request) << "]";
 		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_CLIENT_CLOSED, .err_server_description = "Client closed or not found" };
+		error_stats_.record(response_packet);
 		return response_packet;
 	}
+	startStats(client_stats.get(), request);
 
-	SOCKET client_socket = clients_.at(id_client)->getSocket();
+	unsigned long id = ++next_request_id_;
+	recorder_.record(STAGE_REQUEST_START, id_client, id, request, data.size());
+	std::shared_ptr<const ServerConfig> config = config_.getConfig();
+	std::string to_send;
+	encodeRequest(id, request, data, request_timeout, connection ? channel : -1, config->request_timing, &to_send); // the channel addresses a reader of a multi-reader client
 
-	nlohmann::json j;
-	j["request"] = request;
-	j["data"] = data;
-	j["timeout"] = request_timeout;
-
-	DWORD socket_timeout = std::atoi(config_.getValue("timeout", DEFAULT_SOCKET_TIMEOUT).c_str());
+	DWORD socket_timeout = config->timeout;
 
 	if (socket_timeout < (request_timeout + DEFAULT_ADDED_TIME))
 	{
 		LOG_DEBUG << "Socket timeout adapted. Previous value of socket_timeout:" << socket_timeout << ". Changed to " << (request_timeout + DEFAULT_ADDED_TIME) << ".]";
 		socket_timeout = request_timeout + DEFAULT_ADDED_TIME;
 	}
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(socket_timeout);
+
+	ResponsePacket response_packet = sendAndWait(client_socket, connection, id, to_send, socket_timeout, isExpectedRes);
+
+	// a client supporting session resumption may reconnect before the deadline: the request is sent again with the same id
+	// and the client replays its response if the request has already been processed
+	while (response_packet.err_server_code == ERR_NETWORK && request != REQ_DISCONNECT) {
+		if (waitForReattach(id_client, client_socket, deadline) == INVALID_SOCKET || !findClient(id_client, &client_socket, &connection, &channel)) {
+			break;
+		}
+		auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+		if (remaining.count() <= 0) {
+			break;
+		}
+		LOG_INFO << "Client reconnected, sending the request again [id_client:" << id_client << "][id:" << id << "]";
+		recorder_.record(STAGE_REQUEST_RESENT, id_client, id, request, data.size());
+		response_packet = sendAndWait(client_socket, connection, id, to_send, remaining.count(), isExpectedRes);
+	}
+
+	response_packet.timing.server_submit = submitted;
+	response_packet.timing.server_end = timingNow();
+	if (config->request_timing) {
+		for (int stage = 0; stage < TIMING_STAGE_COUNT; stage++) {
+			stage_timings_[stage].record(timingStageDuration(response_packet.timing, stage));
+		}
+	}
+	endStats(client_stats.get(), request, response_packet, response_packet.timing.server_end - submitted);
+
+	recorder_.record(STAGE_REQUEST_END, id_client, id, firstErrorCode(response_packet), response_packet.response.size());
+	if (response_packet.err_server_code == ERR_TIMEOUT || response_packet.err_server_code == ERR_NETWORK) {
+		recorder_.dumpOnError();
+	}
+	return response_packet;
+}
+
+ResponsePacket ServerEngine::sendAndWait(SOCKET client_socket, std::shared_ptr<ClientConnection> connection, unsigned long id, std::string to_send, DWORD socket_timeout, bool isExpectedRes) {
+	// a shared connection receives the responses of all its readers on its own thread
+	if (connection) {
+		long long sent = TIMING_NOT_STAMPED;
+		auto future = connection->sendRequest(id, to_send, &sent);
+		if (future.wait_for(std::chrono::milliseconds(socket_timeout)) == std::future_status::timeout) {
+			LOG_DEBUG << "Response time from client has elapsed [client_socket:" << client_socket << "][request:" << to_send << "[timeout:" << socket_timeout << "]";
+			connection->abandon(id);
+			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_TIMEOUT, .err_server_description = "Request time elapsed" };
+			return response_packet;
+		}
+		ResponsePacket response_packet = future.get();
+		response_packet.timing.server_send = sent;
+		return response_packet;
+	}
+
 	// sends async request to client
-	auto future = std::async(std::launch::async, &ServerEngine::asyncRequest, this, client_socket, j.dump(), socket_timeout, isExpectedRes);
+	auto future = std::async(std::launch::async, &ServerEngine::asyncRequest, this, client_socket, id, to_send, socket_timeout, isExpectedRes);
 	// blocks until the timeout has elapsed or the result became available
 	if (future.wait_for(std::chrono::milliseconds(socket_timeout)) == std::future_status::timeout) {
 		// thread has timed out
-		LOG_DEBUG << "Response time from client has elapsed [client_socket:" << client_socket << "][request:" << j.dump() << "[timeout:" << request_timeout << "]";
+		LOG_DEBUG << "Response time from client has elapsed [client_socket:" << client_socket << "][request:" << to_send << "[timeout:" << socket_timeout << "]";
+		std::lock_guard<InstrumentedMutex> guard(pending_futures_mutex_); // requests of a batch time out concurrently
 		pending_futures_.push_back(std::move(future));
 		for (long long unsigned int i = 0; i < pending_futures_.size(); i++) {
 			if (pending_futures_[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
@@ -171,41 +271,540 @@ ResponsePacket ServerEngine::handleRequest(int id_client, RequestCode request, b
 	return future.get();
 }
 
-ResponsePacket ServerEngine::asyncRequest(SOCKET client_socket, std::string to_send, DWORD socket_timeout, bool isExpectedRes) {
+ResponsePacket ServerEngine::resumableHandshake(SOCKET client_socket, std::string handshake) {
+	nlohmann::json jhandshake;
+	try {
+		jhandshake = nlohmann::json::parse(handshake);
+	} catch (json::parse_error &err) {
+		LOG_INFO << "Handshake with client failed: invalid handshake [handshake:" << handshake << "]";
+		closesocket(client_socket);
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_JSON_PARSING, .err_server_description = "Error while parsing the handshake" };
+		return response_packet;
+	}
+	if (jhandshake.find("readers") != jhandshake.end()) {
+		return multiplexedHandshake(client_socket, jhandshake);
+	}
+
+	std::string name = jhandshake.value("name", std::string(DEFAULT_NAME));
+	std::string token = jhandshake.value("token", std::string());
+
+	// look for the session to resume
+	int id_client = 0;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		for (const auto &p : clients_) {
+			if (!token.empty() && p.second->getToken() == token) {
+				id_client = p.first;
+				break;
+			}
+		}
+	}
+	if (id_client == 0) {
+		id_client = ++next_client_id_;
+		token = generateResumeToken();
+	}
+
+	nlohmann::json jreply;
+	jreply["id"] = id_client;
+	jreply["token"] = token;
+	if (!socket_->sendPacket(client_socket, jreply.dump().c_str())) {
+		LOG_INFO << "Handshake with client failed";
+		closesocket(client_socket);
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on send" };
+		return response_packet;
+	}
+
+	// events may arrive between two requests: the socket is read by the connection's receiver thread
+	std::shared_ptr<ClientConnection> connection;
+	if (jhandshake.value("events", false)) {
+		connection = std::make_shared<ClientConnection>(client_socket, socket_);
+		connection->setEventHandler(std::bind(&ServerEngine::handleEvent, this, id_client, std::placeholders::_1));
+		connection->start();
+	}
+
+	std::shared_ptr<ClientConnection> lost_connection;
+	bool reattached = false;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		auto it = clients_.find(id_client);
+		if (it != clients_.end()) {
+			// the previous connection is lost, pending requests are sent again on the new socket
+			lost_connection = it->second->getConnection();
+			if (!lost_connection) {
+				closesocket(it->second->getSocket());
+			}
+			it->second->setSocket(client_socket);
+			it->second->setConnection(connection);
+			LOG_INFO << "Client reconnected [id:" << id_client << "][name:" << it->second->getName() << "]";
+			client_reattached_cv_.notify_all();
+			reattached = true;
+		}
+	}
+	if (lost_connection) {
+		lost_connection->close();
+	}
+	if (reattached) {
+		ResponsePacket response_packet;
+		return response_packet;
+	}
+
+	ClientData* client = new ClientData(client_socket, id_client, name);
+	client->setToken(token);
+	client->setConnection(connection);
+	LOG_INFO << "Client connected [id:" << client->getId() << "][name:" << client->getName() << "]";
+	recorder_.record(STAGE_CLIENT_CONNECTED, client->getId(), 0);
+	connections_.fetch_add(1, std::memory_order_relaxed);
+	if (notifyConnectionAccepted_ != 0)  {
+		notifyConnectionAccepted_(client->getId(), client->getName().c_str());
+	}
+
+	std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+	clients_.insert(std::make_pair(client->getId(), client));
+
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+ResponsePacket ServerEngine::multiplexedHandshake(SOCKET client_socket, nlohmann::json jhandshake) {
+	std::string name = jhandshake.value("name", std::string(DEFAULT_NAME));
+	std::string token = jhandshake.value("token", std::string());
+	std::vector<std::string> readers;
+	try {
+		readers = jhandshake.at("readers").get<std::vector<std::string>>();
+	} catch (json::exception &err) {
+		LOG_INFO << "Handshake with client failed: invalid readers [handshake:" << jhandshake.dump() << "]";
+		closesocket(client_socket);
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_JSON_PARSING, .err_server_description = "Error while parsing the handshake" };
+		return response_packet;
+	}
+
+	// each reader is a virtual client, the readers of a resumed session keep their id
+	std::vector<int> ids(readers.size(), 0);
+	bool resumed = false;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		for (const auto &p : clients_) {
+			int channel = p.second->getChannel();
+			if (!token.empty() && p.second->getToken() == token && p.second->getConnection() && channel < (int) ids.size()) {
+				ids[channel] = p.first;
+				resumed = true;
+			}
+		}
+	}
+	if (!resumed) {
+		token = generateResumeToken();
+	}
+	for (auto &id : ids) {
+		if (id == 0) {
+			id = ++next_client_id_;
+		}
+	}
+
+	nlohmann::json jreply;
+	jreply["ids"] = ids;
+	jreply["token"] = token;
+	if (!socket_->sendPacket(client_socket, jreply.dump().c_str())) {
+		LOG_INFO << "Handshake with client failed";
+		closesocket(client_socket);
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on send" };
+		return response_packet;
+	}
+
+	std::shared_ptr<ClientConnection> connection = std::make_shared<ClientConnection>(client_socket, socket_);
+	connection->setEventHandler([this, ids](nlohmann::json jevent) {
+		int channel = jevent.value("channel", 0);
+		handleEvent(channel >= 0 && channel < (int) ids.size() ? ids[channel] : 0, jevent);
+	});
+	connection->start();
+
+	std::vector<ClientData*> accepted;
+	std::shared_ptr<ClientConnection> lost_connection;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		for (unsigned int channel = 0; channel < ids.size(); channel++) {
+			auto it = clients_.find(ids[channel]);
+			if (it != clients_.end()) {
+				lost_connection = it->second->getConnection();
+				it->second->setSocket(client_socket);
+				it->second->setConnection(connection);
+				LOG_INFO << "Client reconnected [id:" << ids[channel] << "][name:" << it->second->getName() << "]";
+				continue;
+			}
+
+			ClientData* client = new ClientData(client_socket, ids[channel], name + " - " + readers[channel]);
+			client->setToken(token);
+			client->setConnection(connection);
+			client->setChannel(channel);
+			clients_.insert(std::make_pair(client->getId(), client));
+			accepted.push_back(client);
+		}
+		client_reattached_cv_.notify_all();
+	}
+
+	// requests pending on the previous connection fail and are sent again on the new one
+	if (lost_connection) {
+		lost_connection->close();
+	}
+
+	for (ClientData* client : accepted) {
+		LOG_INFO << "Client connected [id:" << client->getId() << "][name:" << client->getName() << "]";
+		recorder_.record(STAGE_CLIENT_CONNECTED, client->getId(), 0);
+		connections_.fetch_add(1, std::memory_order_relaxed);
+		if (notifyConnectionAccepted_ != 0)  {
+			notifyConnectionAccepted_(client->getId(), client->getName().c_str());
+		}
+	}
+
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+void ServerEngine::handleEvent(int id_client, nlohmann::json jevent) {
+	ClientEvent client_event;
+	client_event.id_client = id_client;
+	client_event.event = (EventType) jevent.value("event", -1);
+	client_event.reader = jevent.value("reader", std::string());
+	client_event.data = jevent.value("data", std::string());
+	recorder_.record(STAGE_EVENT, id_client, 0, client_event.event);
+	events_received_.fetch_add(1, std::memory_order_relaxed);
+	LOG_INFO << "Event received from client [id_client:" << id_client << "][event:" << eventTypeToString(client_event.event) << "]"
+			 << "[reader:" << client_event.reader << "][data:" << client_event.data << "]";
+
+	if (notifyEventReceived_ != 0) {
+		notifyEventReceived_(id_client, client_event.event, client_event.reader.c_str(), client_event.data.c_str());
+	}
+
+	std::size_t queue_size = config_.getConfig()->event_queue_size;
+	{
+		std::lock_guard<InstrumentedMutex> guard(events_mutex_);
+		while (!events_.empty() && events_.size() >= queue_size) {
+			LOG_DEBUG << "Event queue full, oldest event dropped [id_client:" << events_.front().id_client << "][event:" << eventTypeToString(events_.front().event) << "]";
+			events_.pop_front();
+		}
+		events_.push_back(client_event);
+	}
+	events_cv_.notify_one();
+}
+
+ResponsePacket ServerEngine::pollEvent(DWORD timeout) {
+	std::unique_lock<InstrumentedMutex> lock(events_mutex_);
+	if (!events_cv_.wait_for(lock, std::chrono::milliseconds(timeout), [this] { return !events_.empty(); })) {
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_TIMEOUT, .err_server_description = "No event received" };
+		return response_packet;
+	}
+
+	ClientEvent client_event = events_.front();
+	events_.pop_front();
+	ResponsePacket response_packet = { .response = std::to_string(client_event.id_client) + "|" + std::to_string(client_event.event) + "|" + client_event.reader + "|" + client_event.data };
+	return response_packet;
+}
+
+ResponsePacket ServerEngine::reloadConfig(std::string source) {
+	if (state_ == State::INSTANCIED) {
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_INVALID_STATE, .err_server_description = "Server must be initialized" };
+		return response_packet;
+	}
+	if (!config_.reload(source)) {
+		LOG_INFO << "Failed to reload the configuration, the current one is kept";
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_JSON_PARSING, .err_server_description = "Error while reading the configuration" };
+		return response_packet;
+	}
+
+	// the log level is the only logger setting applied without restarting
+	plog::get()->setMaxSeverity(config_.getConfig()->debug_log ? plog::debug : plog::info);
+	LOG_INFO << "Configuration reloaded";
+	ResponsePacket response_packet;
+	return response_packet;
+}
+
+ResponsePacket ServerEngine::getStageTimings() {
+	if (!config_.getConfig()->request_timing) {
+		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_INVALID_STATE, .err_server_description = "Request timing is not enabled" };
+		return response_packet;
+	}
+
+	nlohmann::json jtimings;
+	for (int stage = 0; stage < TIMING_STAGE_COUNT; stage++) {
+		jtimings[timingStageToString(stage)] = histogramToJson(stage_timings_[stage]);
+	}
+	ResponsePacket response_packet = { .response = jtimings.dump() };
+	return response_packet;
+}
+
+ResponsePacket ServerEngine::getStats() {
+	nlohmann::json jstats = requestStatsToJson(total_stats_);
+	jstats["uptime"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started_).count();
+	jstats["connections"] = connections_.load(std::memory_order_relaxed);
+	jstats["events"] = events_received_.load(std::memory_order_relaxed);
+
+	nlohmann::json jerrors = { { "server", nlohmann::json::object() }, { "client", nlohmann::json::object() } };
+	for (int code = 1; code < STATS_ERROR_CODES; code++) {
+		jerrors["server"][std::to_string(-code)] = error_stats_.server[code].load(std::memory_order_relaxed);
+		jerrors["client"][std::to_string(-code)] = error_stats_.client[code].load(std::memory_order_relaxed);
+	}
+	jerrors["server"]["other"] = error_stats_.other_server.load(std::memory_order_relaxed);
+	jerrors["client"]["other"] = error_stats_.other_client.load(std::memory_order_relaxed);
+	jerrors["terminal"] = error_stats_.terminal.load(std::memory_order_relaxed);
+	jerrors["card"] = error_stats_.card.load(std::memory_order_relaxed);
+	jstats["errors_by_code"] = jerrors;
+
+	if (socket_ != NULL) {
+		const WireCounters& counters = socket_->getCounters();
+		jstats["wire"] = { { "bytes_sent", counters.bytes_sent.load(std::memory_order_relaxed) },
+				{ "bytes_received", counters.bytes_received.load(std::memory_order_relaxed) },
+				{ "packets_sent", counters.packets_sent.load(std::memory_order_relaxed) },
+				{ "packets_received", counters.packets_received.load(std::memory_order_relaxed) } };
+	}
+
+	nlohmann::json jcodes = nlohmann::json::object();
+	for (int code = 0; code < REQ_COUNT; code++) {
+		if (request_stats_[code].requests.load(std::memory_order_relaxed) > 0) {
+			jcodes[requestCodeToString((RequestCode) code)] = requestStatsToJson(request_stats_[code]);
+		}
+	}
+	jstats["requests_by_code"] = jcodes;
+
+	// the clients' counters are shared pointers so that they are formatted without holding the lock
+	std::vector<std::pair<nlohmann::json, std::shared_ptr<RequestStats>>> clients;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		for (const auto &p : clients_) {
+			nlohmann::json jclient = { { "id", p.second->getId() }, { "name", p.second->getName() } };
+			clients.push_back(std::make_pair(jclient, p.second->getStats()));
+		}
+	}
+	nlohmann::json jclients = nlohmann::json::array();
+	for (auto &client : clients) {
+		client.first.update(requestStatsToJson(*client.second));
+		jclients.push_back(client.first);
+	}
+	jstats["by_client"] = jclients;
+
+	ProcessStats process = readProcessStats();
+	jstats["process"] = { { "clients", clients.size() }, { "working_set", process.working_set }, { "peak_working_set", process.peak_working_set },
+			{ "private_bytes", process.private_bytes }, { "handles", process.handles }, { "threads", process.threads } };
+
+	if (config_.getConfig()->request_timing) {
+		jstats["stages"] = nlohmann::json::parse(getStageTimings().response);
+	}
+	if (LockRegistry::isEnabled()) {
+		jstats["contention"] = contentionToJson();
+	}
+
+	ResponsePacket response_packet = { .response = jstats.dump() };
+	return response_packet;
+}
+
+std::string ServerEngine::renderMetrics() {
+	PrometheusWriter writer;
+	writer.family("gp_server_uptime_seconds", "gauge", "Time since the server started.");
+	writer.sample("gp_server_uptime_seconds", "", (uint64_t) std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started_).count());
+	writer.family("gp_server_connections_total", "counter", "Clients registered, reconnections included.");
+	writer.sample("gp_server_connections_total", "", connections_.load(std::memory_order_relaxed));
+	writer.family("gp_server_events_total", "counter", "Events received from the clients.");
+	writer.sample("gp_server_events_total", "", events_received_.load(std::memory_order_relaxed));
+
+	writer.family("gp_server_requests_total", "counter", "Requests sent to the clients.");
+	for (int code = 0; code < REQ_COUNT; code++) {
+		writer.sample("gp_server_requests_total", PrometheusWriter::label("request", requestCodeToString((RequestCode) code)),
+				request_stats_[code].requests.load(std::memory_order_relaxed));
+	}
+	writer.family("gp_server_request_errors_total", "counter", "Requests whose result holds an error code.");
+	for (int code = 0; code < REQ_COUNT; code++) {
+		writer.sample("gp_server_request_errors_total", PrometheusWriter::label("request", requestCodeToString((RequestCode) code)),
+				request_stats_[code].errors.load(std::memory_order_relaxed));
+	}
+	writer.family("gp_server_request_timeouts_total", "counter", "Requests which timed out.");
+	writer.sample("gp_server_request_timeouts_total", "", total_stats_.timeouts.load(std::memory_order_relaxed));
+	writer.family("gp_server_requests_in_flight", "gauge", "Requests waiting for their result.");
+	writer.sample("gp_server_requests_in_flight", "", (uint64_t) std::max<int64_t>(0, total_stats_.in_flight.load(std::memory_order_relaxed)));
+
+	writer.family("gp_server_errors_total", "counter", "Results by error code of the server and of the client.");
+	for (int code = 1; code < STATS_ERROR_CODES; code++) {
+		writer.sample("gp_server_errors_total", PrometheusWriter::label("layer", "server") + "," + PrometheusWriter::label("code", std::to_string(-code)),
+				error_stats_.server[code].load(std::memory_order_relaxed));
+		writer.sample("gp_server_errors_total", PrometheusWriter::label("layer", "client") + "," + PrometheusWriter::label("code", std::to_string(-code)),
+				error_stats_.client[code].load(std::memory_order_relaxed));
+	}
+	writer.sample("gp_server_errors_total", PrometheusWriter::label("layer", "terminal"), error_stats_.terminal.load(std::memory_order_relaxed));
+	writer.sample("gp_server_errors_total", PrometheusWriter::label("layer", "card"), error_stats_.card.load(std::memory_order_relaxed));
+
+	if (socket_ != NULL) {
+		const WireCounters& counters = socket_->getCounters();
+		writer.family("gp_server_bytes_sent_total", "counter", "Bytes sent to the clients, length prefixes included.");
+		writer.sample("gp_server_bytes_sent_total", "", counters.bytes_sent.load(std::memory_order_relaxed));
+		writer.family("gp_server_bytes_received_total", "counter", "Bytes received from the clients, length prefixes included.");
+		writer.sample("gp_server_bytes_received_total", "", counters.bytes_received.load(std::memory_order_relaxed));
+	}
+
+	writer.family("gp_server_request_duration_seconds", "summary", "Duration of the requests by request code.");
+	for (int code = 0; code < REQ_COUNT; code++) {
+		if (request_stats_[code].requests.load(std::memory_order_relaxed) > 0) {
+			writer.summary("gp_server_request_duration_seconds", PrometheusWriter::label("request", requestCodeToString((RequestCode) code)),
+					request_stats_[code].latency, 1e-6);
+		}
+	}
+
+	std::vector<std::pair<std::string, std::shared_ptr<RequestStats>>> clients;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		for (const auto &p : clients_) {
+			std::string labels = PrometheusWriter::label("client", std::to_string(p.second->getId())) + "," + PrometheusWriter::label("name", p.second->getName());
+			clients.push_back(std::make_pair(labels, p.second->getStats()));
+		}
+	}
+	writer.family("gp_server_client_request_duration_seconds", "summary", "Duration of the requests by client.");
+	for (const auto &client : clients) {
+		writer.summary("gp_server_client_request_duration_seconds", client.first, client.second->latency, 1e-6);
+	}
+
+	ProcessStats process = readProcessStats();
+	writer.family("gp_server_clients", "gauge", "Clients currently registered.");
+	writer.sample("gp_server_clients", "", (uint64_t) clients.size());
+	writer.family("gp_server_resident_memory_bytes", "gauge", "Working set of the server's process.");
+	writer.sample("gp_server_resident_memory_bytes", "", process.working_set);
+	writer.family("gp_server_private_memory_bytes", "gauge", "Memory committed for the server's process only.");
+	writer.sample("gp_server_private_memory_bytes", "", process.private_bytes);
+	writer.family("gp_server_handles", "gauge", "Handles opened by the server's process, sockets included.");
+	writer.sample("gp_server_handles", "", process.handles);
+	writer.family("gp_server_threads", "gauge", "Threads of the server's process.");
+	writer.sample("gp_server_threads", "", process.threads);
+	if (LockRegistry::isEnabled()) {
+		writeContention(&writer, "gp_server");
+	}
+	return writer.str();
+}
+
+void ServerEngine::startStats(RequestStats* client_stats, RequestCode request) {
+	total_stats_.start();
+	client_stats->start();
+	if (request >= 0 && request < REQ_COUNT) {
+		request_stats_[request].start();
+	}
+}
+
+void ServerEngine::endStats(RequestStats* client_stats, RequestCode request, const ResponsePacket& response_packet, long long duration) {
+	total_stats_.end(response_packet, duration);
+	client_stats->end(response_packet, duration);
+	if (request >= 0 && request < REQ_COUNT) {
+		request_stats_[request].end(response_packet, duration);
+	}
+	error_stats_.record(response_packet);
+}
+
+bool ServerEngine::findClient(int id_client, SOCKET* client_socket, std::shared_ptr<ClientConnection>* connection, int* channel, std::shared_ptr<RequestStats>* stats) {
+	std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+	auto it = clients_.find(id_client);
+	if (it == clients_.end()) {
+		return false;
+	}
+	*client_socket = it->second->getSocket();
+	*connection = it->second->getConnection();
+	*channel = it->second->getChannel();
+	if (stats != NULL) {
+		*stats = it->second->getStats();
+	}
+	return true;
+}
+
+std::string ServerEngine::generateResumeToken() {
+	std::random_device generator;
+	std::uniform_int_distribution<int> distribution(0, 0xFF);
+	std::stringstream token;
+	for (int i = 0; i < DEFAULT_RESUME_TOKEN_SIZE; i++) {
+		token << std::hex << std::setw(2) << std::setfill('0') << distribution(generator);
+	}
+	return token.str();
+}
+
+SOCKET ServerEngine::waitForReattach(int id_client, SOCKET old_socket, std::chrono::steady_clock::time_point deadline) {
+	std::unique_lock<InstrumentedMutex> lock(insert_client_mutex_);
+	auto client_lost = [&] {
+		auto it = clients_.find(id_client);
+		return it == clients_.end() || it->second->getToken().empty();
+	};
+	if (client_lost()) {
+		return INVALID_SOCKET;
+	}
+
+	LOG_DEBUG << "Waiting for client to reconnect [id_client:" << id_client << "]";
+	bool reattached = client_reattached_cv_.wait_until(lock, deadline, [&] {
+		return client_lost() || clients_.at(id_client)->getSocket() != old_socket;
+	});
+	if (!reattached || client_lost()) {
+		return INVALID_SOCKET;
+	}
+	return clients_.at(id_client)->getSocket();
+}
+
+ResponsePacket ServerEngine::asyncRequest(SOCKET client_socket, unsigned long id, std::string to_send, DWORD socket_timeout, bool isExpectedRes) {
+	ThreadScope scope("async_request"); // one thread per request sent on a client's own socket
 	char recvbuf[DEFAULT_BUFLEN];
 	nlohmann::json jresponse;
 	int ret = 0;
 
+	long long sent = timingNow();
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(socket_timeout);
 	if (!socket_->sendPacket(client_socket, to_send.c_str())) {
 		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on send request" };
+		return response_packet;
 	}
 	LOG_INFO << "Data sent to client: " << to_send.c_str();
 
-	do {
-		ret = socket_->receivePacket(client_socket, recvbuf);
-		if (ret == RES_SOCKET_ERROR) {
-			ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on receive" };
-			return response_packet;
-		} else if (ret == RES_SOCKET_WARNING){
-			LOG_INFO << "SOCKET Warning Ignored, relaunch waiting socket reception";
-			if (!isExpectedRes){
+	// the response of a request which timed out may still arrive, or be replayed after a reconnection: it is dropped
+	while (true) {
+		do {
+			ret = socket_->receivePacket(client_socket, recvbuf);
+			if (ret == RES_SOCKET_ERROR) {
 				ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on receive" };
 				return response_packet;
+			} else if (ret == RES_SOCKET_WARNING){
+				LOG_INFO << "SOCKET Warning Ignored, relaunch waiting socket reception";
+				if (!isExpectedRes){
+					ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_NETWORK, .err_server_description = "Network error on receive" };
+					return response_packet;
+				}
+				if (std::chrono::steady_clock::now() >= deadline) {
+					ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_TIMEOUT, .err_server_description = "Request time elapsed" };
+					return response_packet;
+				}
 			}
+
+		} while ((ret != RES_SOCKET_OK) && isExpectedRes);
+		long long received = timingNow();
+
+		// responses of the fixed schema are decoded without building a json document
+		ResponsePacket response_packet;
+		unsigned long response_id;
+		bool decoded = decodeResponse(recvbuf, &response_packet, &response_id);
+		if (!decoded) {
+			try {
+				jresponse = nlohmann::json::parse(recvbuf); // parses response to json object
+			} catch (json::parse_error &err) {
+				LOG_DEBUG << "Error while parsing the response [recvbuf:" << recvbuf << "]";
+				ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_JSON_PARSING, .err_client_description = "Error while parsing the request" };
+				return response_packet;
+			}
+			response_id = jresponse.value("id", 0UL);
 		}
 
-	} while ((ret != RES_SOCKET_OK) && isExpectedRes);
+		// a client which could not read the request answers with the id 0
+		if (response_id != id && response_id != 0) {
+			LOG_DEBUG << "Response dropped, no request waiting for it [id:" << response_id << "][expected:" << id << "]";
+			if (std::chrono::steady_clock::now() >= deadline) {
+				ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_TIMEOUT, .err_server_description = "Request time elapsed" };
+				return response_packet;
+			}
+			continue;
+		}
 
-	try {
-		jresponse = nlohmann::json::parse(recvbuf); // parses response to json object
-	} catch (json::parse_error &err) {
-		LOG_DEBUG << "Error while parsing the response [recvbuf:" << recvbuf << "]";
-		ResponsePacket response_packet = { .response = "KO", .err_client_code = ERR_JSON_PARSING, .err_client_description = "Error while parsing the request" };
+		if (!decoded) {
+			response_packet = jresponse.get<ResponsePacket>();
+		}
+		response_packet.timing.server_send = sent;
+		response_packet.timing.server_receive = received;
 		return response_packet;
 	}
-
-	ResponsePacket response_packet = jresponse.get<ResponsePacket>();
-	return response_packet;
 }
 
 ResponsePacket ServerEngine::listClients() {
@@ -232,12 +831,26 @@ ResponsePacket ServerEngine::stopAllClients() {
 	stop_ = true; // stop active threads
 	socket_->closeServer();
 	connection_thread_.join();
+	metrics_server_.stop();
 
-	for (const auto &p : clients_) {
-		stopClient(p.first);
+	// stopClient removes the client from the map
+	std::vector<int> ids;
+	{
+		std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+		for (const auto &p : clients_) {
+			ids.push_back(p.first);
+		}
+	}
+	for (int id : ids) {
+		stopClient(id);
 	}
 
+	if (LockRegistry::isEnabled()) {
+		ContentionReporter::report();
+	}
 	state_ = State::DISCONNECTED;
+	LOG_INFO << "Server stopped";
+	logger::flush();
 	ResponsePacket response_packet;
 	return response_packet;
 }
@@ -248,15 +861,35 @@ ResponsePacket ServerEngine::stopClient(int id_client) {
 		return response_packet;
 	}
 
-	if (clients_.find(id_client) == clients_.end()) {
+	// batches stop clients from several threads, the map is only read under the lock
+	SOCKET client_socket;
+	std::shared_ptr<ClientConnection> connection;
+	int channel;
+	if (!findClient(id_client, &client_socket, &connection, &channel)) {
 		LOG_DEBUG << "Failed to retrieve client [id_client:" << id_client << "]";
 		ResponsePacket response_packet = { .response = "KO", .err_server_code = ERR_CLIENT_CLOSED, .err_server_description = "Client closed or not found" };
 		return response_packet;
 	}
 
-	SOCKET client_socket = clients_.at(id_client)->getSocket();
 	ResponsePacket response_packet = handleRequest(id_client, REQ_DISCONNECT, false);
-	if (response_packet.err_server_code  < 0) {
+	recorder_.record(STAGE_CLIENT_DISCONNECTED, id_client, 0);
+	if (response_packet.err_server_code  < 0 && !connection) {
+		return response_packet;
+	}
+
+	// the connection of a multi-reader client is closed with its last reader
+	if (connection) {
+		{
+			std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+			eraseClient(id_client);
+			for (const auto &p : clients_) {
+				if (p.second->getConnection() == connection) {
+					return response_packet;
+				}
+			}
+		}
+		// the receiver thread is joined without the lock, its event callback may call the API
+		connection->close();
 		return response_packet;
 	}
 
@@ -267,10 +900,20 @@ ResponsePacket ServerEngine::stopClient(int id_client) {
 	}
 
 	closesocket(client_socket);
-	delete clients_.at(id_client);
-	clients_.erase(id_client);
+	std::lock_guard<InstrumentedMutex> guard(insert_client_mutex_);
+	eraseClient(id_client);
 
 	return response_packet;
 }
 
+void ServerEngine::eraseClient(int id_client) {
+	// a concurrent stopClient of the same client may have erased it already
+	auto it = clients_.find(id_client);
+	if (it != clients_.end()) {
+		delete it->second;
+		clients_.erase(it);
+	}
+	client_reattached_cv_.notify_all(); // requests waiting for this client to reconnect give up
+}
+
 } /* namespace server */
@@ -19,6 +19,7 @@
 #define WIN32_LEAN_AND_MEAN
 
 #include "server/server_tcp_socket.hpp"
+#include "recorder/flight_recorder.hpp"
 #include "plog/include/plog/Log.h"
 
 #include <winsock2.h>
@@ -118,13 +119,17 @@ bool ServerTCPSocket::sendPacket(SOCKET client_socket, const char* packet) {
 	int retval = send(client_socket, (char*) &net_packet_size, sizeof(int), 0);
 	if (retval == SOCKET_ERROR || retval == 0) {
 		LOG_DEBUG << "Failed to send data size to client -  " << "[socket:" << client_socket << "][buffer:" << net_packet_size << "][size:" << sizeof(int) << "][flags:" << NULL << "]";
+		FlightRecorder::getInstance().record(STAGE_SOCKET_SEND, client_socket, 0, -1, packet_size);
 		return false;
 	}
 
 	// send packet's content
-	if (!sendData(client_socket, packet, packet_size)) return false;
-
-	return true;
+	bool sent = sendData(client_socket, packet, packet_size);
+	FlightRecorder::getInstance().record(STAGE_SOCKET_SEND, client_socket, 0, sent ? 0 : -1, packet_size);
+	if (sent) {
+		counters_.sent(packet_size);
+	}
+	return sent;
 }
 
 int ServerTCPSocket::receivePacket(SOCKET client_socket, char* packet) {
@@ -143,10 +148,13 @@ int ServerTCPSocket::receivePacket(SOCKET client_socket, char* packet) {
 	retval = recv(client_socket, packet, received_size, MSG_WAITALL); // keep receiving until received_size bytes are received
 	if (retval == SOCKET_ERROR || retval == 0) {
 		LOG_DEBUG << "Failed to receive data size from client -  " << "[socket:" << client_socket << "][buffer:" << received_size << "][size:" << sizeof(int) << "][flags:" << NULL << "]";
+		FlightRecorder::getInstance().record(STAGE_SOCKET_RECEIVE, client_socket, 0, -1, received_size);
 		return RES_SOCKET_ERROR;
 	}
 	packet[retval] = '\0';
 
+	FlightRecorder::getInstance().record(STAGE_SOCKET_RECEIVE, client_socket, 0, 0, retval);
+	counters_.received(retval);
 	return RES_SOCKET_OK;
 }
 
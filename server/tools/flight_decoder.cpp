@@ -0,0 +1,122 @@
+/*********************************************************************************
+ Copyright 2017 GlobalPlatform, Inc.
+
+ Licensed under the GlobalPlatform/Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ https://github.com/GlobalPlatform/SE-test-IP-connector/blob/master/Charter%20and%20Rules%20for%20the%20SE%20IP%20connector.docx
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ *********************************************************************************/
+
+/**
+ * Offline decoder of the flight recorder dumps written by the server and by the client (recorder/flight_recorder.hpp).
+ * It is not part of the server's build, compile it from the server's directory with:
+ *   g++ -std=c++11 -O2 -Iinclude -Ilibraries tools/flight_decoder.cpp
+ * Usage: flight_decoder <dump> [--chrome]
+ * The text output has one line per record. With --chrome, the output is a Chrome trace (chrome://tracing, Perfetto):
+ * each request is an asynchronous slice from its start to its end, the other records are instant events.
+ */
+
+#include "recorder/flight_recorder.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace server;
+
+namespace {
+
+bool readDump(const char* path, FlightRecorderHeader* header, std::vector<FlightRecord>* records) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open %s\n", path);
+		return false;
+	}
+	bool valid = fread(header, sizeof(*header), 1, file) == 1 && std::memcmp(header->magic, FLIGHT_RECORDER_MAGIC, sizeof(header->magic)) == 0
+			&& header->version == FLIGHT_RECORDER_VERSION && header->record_size == sizeof(FlightRecord);
+	if (valid) {
+		records->resize(header->count);
+		valid = records->empty() || fread(records->data(), sizeof(FlightRecord), records->size(), file) == records->size();
+	}
+	fclose(file);
+	if (!valid) {
+		fprintf(stderr, "%s is not a flight recorder dump of version %d\n", path, FLIGHT_RECORDER_VERSION);
+	}
+	return valid;
+}
+
+std::string origin(const FlightRecorderHeader& header) {
+	return std::string(header.origin, strnlen(header.origin, sizeof(header.origin)));
+}
+
+void printText(const FlightRecorderHeader& header, const std::vector<FlightRecord>& records) {
+	printf("# %s, %u records\n", origin(header).c_str(), header.count);
+	printf("# date time.us thread stage client request code size\n");
+	for (const FlightRecord& record : records) {
+		time_t seconds = record.timestamp / 1000000;
+		char date[32];
+		strftime(date, sizeof(date), "%Y/%m/%d %H:%M:%S", gmtime(&seconds));
+		printf("%s.%06llu %5u %-19s %10u %10u %6d %8u\n", date, (unsigned long long) (record.timestamp % 1000000), record.thread,
+				recorderStageToString(record.stage), record.id_client, record.id_request, record.code, record.size);
+	}
+}
+
+void printChrome(const FlightRecorderHeader& header, const std::vector<FlightRecord>& records) {
+	std::string process = origin(header);
+	printf("{\"traceEvents\":[\n");
+	printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}", process.c_str());
+	for (const FlightRecord& record : records) {
+		const char* phase = "i";
+		bool request_slice = false;
+		if ((record.stage == STAGE_REQUEST_START || record.stage == STAGE_REQUEST_RECEIVED) && record.id_request != 0) {
+			phase = "b";
+			request_slice = true;
+		} else if ((record.stage == STAGE_REQUEST_END || record.stage == STAGE_RESPONSE_SENT) && record.id_request != 0) {
+			phase = "e";
+			request_slice = true;
+		}
+
+		// the start and the end of a request are matched by their ids, they are usually recorded by different threads
+		printf(",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%llu,\"pid\":1,\"tid\":%u", request_slice ? "request" : recorderStageToString(record.stage),
+				request_slice ? "request" : "stage", phase, (unsigned long long) record.timestamp, record.thread);
+		if (request_slice) {
+			printf(",\"id\":\"%u-%u\"", record.id_client, record.id_request);
+		} else {
+			printf(",\"s\":\"t\"");
+		}
+		printf(",\"args\":{\"stage\":\"%s\",\"client\":%u,\"request\":%u,\"code\":%d,\"size\":%u}}", recorderStageToString(record.stage), record.id_client,
+				record.id_request, record.code, record.size);
+	}
+	printf("\n]}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <dump> [--chrome]\n", argv[0]);
+		return 2;
+	}
+
+	FlightRecorderHeader header;
+	std::vector<FlightRecord> records;
+	if (!readDump(argv[1], &header, &records)) {
+		return 1;
+	}
+	if (argc > 2 && std::strcmp(argv[2], "--chrome") == 0) {
+		printChrome(header, records);
+	} else {
+		printText(header, records);
+	}
+	return 0;
+}